@@ -0,0 +1,199 @@
+/**
+  ******************************************************************************
+  * @file    main.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   The benchmark scenarios of the CAN driver on the bxCAN model.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+/* Header includes -----------------------------------------------------------*/
+#include "CAN.h"
+#include "Benchmark.h"
+#include "bxCAN.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define IDLE_STEP  (1000)  /* Nanoseconds of bus time per idle loop iteration. */
+
+/* Type definitions ----------------------------------------------------------*/
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+static uint32_t remoteSequence = 0;
+static bool     remoteFlood    = false;
+
+/* Function declarations -----------------------------------------------------*/
+static uint32_t get_time(void);
+static void idle(void);
+static void echo(uint64_t Time, int32_t Node, const CanRxMsg *Message);
+static void setup(CAN_WorkMode WorkMode);
+static bool run(Benchmark_Config *Config, Benchmark_Scenario Scenario, bool Lossless);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Main program.
+  * @param  None.
+  * @return 0 when every run finishes and the lossless ones lose nothing, 1 otherwise.
+  * @note   One line of JSON per run. The model runs handlers in zero bus time, so the
+  *         CPU load is only meaningful on the target.
+  */
+int main(void)
+{
+  Benchmark_Config config = {0};
+  bool             result = true;
+  
+  config.CANx      = CAN1;
+  config.BaudRate  = CAN_BaudRate1000K;
+  config.Frames    = 1000;
+  config.Duration  = 1000;
+  config.Interval  = 1000;
+  config.GetTime   = get_time;
+  config.Frequency = 1000000000;
+  config.Idle      = idle;
+  
+  /* Loop back. */
+  setup(CAN_WorkModeLoopBack);
+  config.LoopBack = true;
+  
+  result &= run(&config, BenchmarkBurstTx, true);
+  result &= run(&config, BenchmarkSaturateRx, true);
+  result &= run(&config, BenchmarkRoundTrip, true);
+  result &= run(&config, BenchmarkMixedPriority, true);
+  
+  /* The remote node of the model as the second board: it echoes, or floods for the receive test. */
+  setup(CAN_WorkModeNormal);
+  config.LoopBack = false;
+  BxCAN_SetBusCallback(echo);
+  
+  result &= run(&config, BenchmarkBurstTx, true);
+  remoteFlood = true;
+  result &= run(&config, BenchmarkSaturateRx, false);
+  remoteFlood = false;
+  result &= run(&config, BenchmarkRoundTrip, true);
+  result &= run(&config, BenchmarkMixedPriority, true);
+  
+  fprintf(stderr, "%s\n", (result == true) ? "PASS" : "FAIL");
+  
+  return (result == true) ? 0 : 1;
+}
+
+/**
+  * @brief  Clock of the benchmark, the model time in nanoseconds.
+  */
+static uint32_t get_time(void)
+{
+  return (uint32_t)BxCAN_GetTime();
+}
+
+/**
+  * @brief  Idle loop hook: advance the bus, keep the remote node flooding if asked.
+  */
+static void idle(void)
+{
+  CanTxMsg canTxMsg = {0};
+  uint32_t time     = get_time();
+  
+  canTxMsg.StdId = BENCHMARK_ID_STREAM;
+  canTxMsg.IDE   = CAN_Id_Standard;
+  canTxMsg.RTR   = CAN_RTR_Data;
+  canTxMsg.DLC   = 8;
+  
+  while((remoteFlood == true) && (BxCAN_GetInjectNumber() < 4))
+  {
+    memcpy(&canTxMsg.Data[0], &time, sizeof(time));
+    memcpy(&canTxMsg.Data[4], &remoteSequence, sizeof(remoteSequence));
+    remoteSequence++;
+    
+    BxCAN_Inject(&canTxMsg);
+  }
+  
+  BxCAN_Run(IDLE_STEP);
+}
+
+/**
+  * @brief  Bus monitor answering every CAN1 frame from the remote node, as Benchmark_Echo() does.
+  */
+static void echo(uint64_t Time, int32_t Node, const CanRxMsg *Message)
+{
+  if((Node == BXCAN_NODE_CAN1) && (remoteFlood != true) && (Message->StdId != BENCHMARK_ID_LOW))
+  {
+    CanTxMsg canTxMsg = {0};
+    
+    canTxMsg.StdId = Message->StdId + BENCHMARK_ID_ECHO;
+    canTxMsg.IDE   = Message->IDE;
+    canTxMsg.RTR   = Message->RTR;
+    canTxMsg.DLC   = Message->DLC;
+    memcpy(canTxMsg.Data, Message->Data, sizeof(canTxMsg.Data));
+    
+    BxCAN_Inject(&canTxMsg);
+  }
+}
+
+/**
+  * @brief  Reset the model and configure CAN1 at 1 Mbit/s, receiving every identifier.
+  * @param  [in] WorkMode: Work mode.
+  * @return None.
+  */
+static void setup(CAN_WorkMode WorkMode)
+{
+  const CAN_FilterId filter[] =
+  {
+    {CAN_Id_Standard, 0, 0},
+    {CAN_Id_Extended, 0, 0}
+  };
+  
+  CAN_Unconfigure(CAN1);
+  BxCAN_Reset();
+  BxCAN_SetBusCallback(0);
+  
+  CAN_Configure(CAN1, WorkMode, CAN_BaudRate1000K, 0, 0);
+  CAN_SetReceiveFilter(CAN1, filter, sizeof(filter) / sizeof(filter[0]));
+}
+
+/**
+  * @brief  Run a scenario and print its result.
+  * @param  [in] Config:   The benchmark configuration.
+  * @param  [in] Scenario: The scenario.
+  * @param  [in] Lossless: Fail if a frame is lost.
+  * @retval true:  Passed.
+  * @retval false: Failed.
+  */
+static bool run(Benchmark_Config *Config, Benchmark_Scenario Scenario, bool Lossless)
+{
+  Benchmark_Result result                    = {0};
+  char             text[BENCHMARK_TEXT_SIZE] = {0};
+  
+  Config->Scenario = Scenario;
+  
+  bool finished = Benchmark_Run(Config, &result);
+  
+  Benchmark_Format(Config, &result, text, sizeof(text));
+  fputs(text, stdout);
+  
+  /* Answers and remote frames still queued go before the next run. */
+  BxCAN_RunIdle(1000000000);
+  
+  return (finished == true) && (result.FramesPerSecond > 0) && ((Lossless != true) || (result.Lost == 0));
+}
@@ -0,0 +1,349 @@
+/**
+  ******************************************************************************
+  * @file    Core.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Host model of the Cortex-M3 interrupt core, RCC and GPIO.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+/* Header includes -----------------------------------------------------------*/
+#include "Core.h"
+#include "bxCAN.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+/* Type definitions ----------------------------------------------------------*/
+/* Variable declarations -----------------------------------------------------*/
+GPIO_TypeDef hostGPIO[4] = {0};
+
+static volatile uint32_t corePrimask = 0;
+static bool              coreHandler = false;
+static bool              coreMonitor = false;
+
+static bool               coreEnable[HOST_IRQn_NUMBER]     = {0};
+static uint8_t            corePriority[HOST_IRQn_NUMBER]   = {0};
+static Core_IRQStatistics coreStatistics[HOST_IRQn_NUMBER] = {0};
+
+/* Variable definitions ------------------------------------------------------*/
+
+/* Handlers of the firmware, weak so a build without one of them still links. */
+#ifdef STM32F10X_CL
+void CAN1_TX_IRQHandler(void) __attribute__((weak));
+void CAN1_RX0_IRQHandler(void) __attribute__((weak));
+#else
+void USB_HP_CAN1_TX_IRQHandler(void) __attribute__((weak));
+void USB_LP_CAN1_RX0_IRQHandler(void) __attribute__((weak));
+#endif /* STM32F10X_CL */
+void CAN1_RX1_IRQHandler(void) __attribute__((weak));
+void CAN1_SCE_IRQHandler(void) __attribute__((weak));
+void CAN2_TX_IRQHandler(void) __attribute__((weak));
+void CAN2_RX0_IRQHandler(void) __attribute__((weak));
+void CAN2_RX1_IRQHandler(void) __attribute__((weak));
+void CAN2_SCE_IRQHandler(void) __attribute__((weak));
+
+/* Function declarations -----------------------------------------------------*/
+static void (*core_get_handler(IRQn_Type IRQn))(void);
+static int32_t core_get_pending(void);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Run the handlers of all pending interrupts.
+  * @param  None.
+  * @return None.
+  * @note   Called by the peripheral models whenever an interrupt line may have changed,
+  *         and when PRIMASK is cleared. Lines are level sensitive, a handler runs again
+  *         as long as its line stays high. Handlers do not preempt each other, and the
+  *         exclusive monitor is cleared on every exception entry and return.
+  */
+void Core_Update(void)
+{
+  uint32_t storm = 0;
+  
+  if((corePrimask != 0) || (coreHandler == true))
+  {
+    return;
+  }
+  
+  coreHandler = true;
+  
+  for(int32_t irq = core_get_pending(); irq >= 0; irq = core_get_pending())
+  {
+    void (*handler)(void) = core_get_handler((IRQn_Type)irq);
+    
+    if(handler == 0)
+    {
+      fprintf(stderr, "Core: IRQ %d enabled without a handler\n", irq);
+      abort();
+    }
+    
+    if(++storm > CORE_IRQ_STORM_LIMIT)
+    {
+      fprintf(stderr, "Core: IRQ %d handler does not clear its interrupt\n", irq);
+      abort();
+    }
+    
+    uint64_t start = Core_GetHostTime();
+    
+    coreMonitor = false;
+    handler();
+    coreMonitor = false;
+    
+    coreStatistics[irq].Count++;
+    coreStatistics[irq].HostTime += Core_GetHostTime() - start;
+  }
+  
+  coreHandler = false;
+}
+
+/**
+  * @brief  Is an interrupt handler running?
+  * @param  None.
+  * @retval true:  Handler mode.
+  * @retval false: Thread mode.
+  */
+bool Core_IsHandlerMode(void)
+{
+  return coreHandler;
+}
+
+/**
+  * @brief  Get the host monotonic time.
+  * @param  None.
+  * @return The host time in nanoseconds.
+  */
+uint64_t Core_GetHostTime(void)
+{
+  struct timespec ts = {0};
+  
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+  * @brief  Get the handler statistics of an interrupt.
+  * @param  [in] IRQn:       The interrupt.
+  * @param  [out] Statistics: The statistics.
+  * @return None.
+  */
+void Core_GetIRQStatistics(IRQn_Type IRQn, Core_IRQStatistics *Statistics)
+{
+  *Statistics = coreStatistics[IRQn];
+}
+
+/**
+  * @brief  Clear the handler statistics of all interrupts.
+  * @param  None.
+  * @return None.
+  */
+void Core_ClearIRQStatistics(void)
+{
+  for(uint32_t i = 0; i < HOST_IRQn_NUMBER; i++)
+  {
+    coreStatistics[i].Count    = 0;
+    coreStatistics[i].HostTime = 0;
+  }
+}
+
+/**
+  * @brief  GPIO has no model, pin configuration is ignored.
+  */
+void GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct)
+{
+}
+
+/**
+  * @brief  Pin remapping is ignored.
+  */
+void GPIO_PinRemapConfig(uint32_t GPIO_Remap, FunctionalState NewState)
+{
+}
+
+/**
+  * @brief  Peripheral clocks are always running.
+  */
+void RCC_APB1PeriphClockCmd(uint32_t RCC_APB1Periph, FunctionalState NewState)
+{
+}
+
+/**
+  * @brief  Peripheral clocks are always running.
+  */
+void RCC_APB2PeriphClockCmd(uint32_t RCC_APB2Periph, FunctionalState NewState)
+{
+}
+
+/**
+  * @brief  Get the clocks of a 72 MHz system with APB1 at 36 MHz.
+  */
+void RCC_GetClocksFreq(RCC_ClocksTypeDef *RCC_Clocks)
+{
+  RCC_Clocks->SYSCLK_Frequency = HOST_PCLK2_FREQUENCY;
+  RCC_Clocks->HCLK_Frequency   = HOST_PCLK2_FREQUENCY;
+  RCC_Clocks->PCLK1_Frequency  = HOST_PCLK1_FREQUENCY;
+  RCC_Clocks->PCLK2_Frequency  = HOST_PCLK2_FREQUENCY;
+  RCC_Clocks->ADCCLK_Frequency = HOST_PCLK2_FREQUENCY / 2;
+}
+
+/**
+  * @brief  Priority grouping is ignored, handlers never preempt each other.
+  */
+void NVIC_PriorityGroupConfig(uint32_t NVIC_PriorityGroup)
+{
+}
+
+/**
+  * @brief  Enable or disable an interrupt and set its priority.
+  */
+void NVIC_Init(NVIC_InitTypeDef *NVIC_InitStruct)
+{
+  uint8_t irq = NVIC_InitStruct->NVIC_IRQChannel;
+  
+  if(irq >= HOST_IRQn_NUMBER)
+  {
+    return;
+  }
+  
+  corePriority[irq] = (NVIC_InitStruct->NVIC_IRQChannelPreemptionPriority << 4) | NVIC_InitStruct->NVIC_IRQChannelSubPriority;
+  coreEnable[irq]   = (NVIC_InitStruct->NVIC_IRQChannelCmd == ENABLE);
+  
+  Core_Update();
+}
+
+/**
+  * @brief  Get the interrupt mask.
+  */
+uint32_t __get_PRIMASK(void)
+{
+  return corePrimask;
+}
+
+/**
+  * @brief  Set the interrupt mask, pending interrupts run when it is cleared.
+  */
+void __set_PRIMASK(uint32_t priMask)
+{
+  corePrimask = priMask & 1;
+  Core_Update();
+}
+
+/**
+  * @brief  Mask interrupts.
+  */
+void __disable_irq(void)
+{
+  corePrimask = 1;
+}
+
+/**
+  * @brief  Unmask interrupts, pending interrupts run now.
+  */
+void __enable_irq(void)
+{
+  corePrimask = 0;
+  Core_Update();
+}
+
+/**
+  * @brief  Exclusive load, sets the exclusive monitor.
+  */
+uint32_t __LDREXW(volatile uint32_t *addr)
+{
+  coreMonitor = true;
+  return *addr;
+}
+
+/**
+  * @brief  Exclusive store, fails with 1 if an interrupt ran since the exclusive load.
+  */
+uint32_t __STREXW(uint32_t value, volatile uint32_t *addr)
+{
+  if(coreMonitor != true)
+  {
+    return 1;
+  }
+  
+  coreMonitor = false;
+  *addr = value;
+  return 0;
+}
+
+/**
+  * @brief  Clear the exclusive monitor.
+  */
+void __CLREX(void)
+{
+  coreMonitor = false;
+}
+
+/**
+  * @brief  Get the handler of an interrupt.
+  * @param  [in] IRQn: The interrupt.
+  * @return The handler, 0 if the firmware does not define it.
+  */
+static void (*core_get_handler(IRQn_Type IRQn))(void)
+{
+  switch(IRQn)
+  {
+#ifdef STM32F10X_CL
+    case CAN1_TX_IRQn:  return CAN1_TX_IRQHandler;
+    case CAN1_RX0_IRQn: return CAN1_RX0_IRQHandler;
+#else
+    case USB_HP_CAN1_TX_IRQn:  return USB_HP_CAN1_TX_IRQHandler;
+    case USB_LP_CAN1_RX0_IRQn: return USB_LP_CAN1_RX0_IRQHandler;
+#endif /* STM32F10X_CL */
+    case CAN1_RX1_IRQn: return CAN1_RX1_IRQHandler;
+    case CAN1_SCE_IRQn: return CAN1_SCE_IRQHandler;
+    case CAN2_TX_IRQn:  return CAN2_TX_IRQHandler;
+    case CAN2_RX0_IRQn: return CAN2_RX0_IRQHandler;
+    case CAN2_RX1_IRQn: return CAN2_RX1_IRQHandler;
+    case CAN2_SCE_IRQn: return CAN2_SCE_IRQHandler;
+    default:            return 0;
+  }
+}
+
+/**
+  * @brief  Get the pending interrupt to run next.
+  * @param  None.
+  * @return The enabled interrupt with a high line and the highest priority, -1 if none.
+  */
+static int32_t core_get_pending(void)
+{
+  int32_t pending = -1;
+  
+  for(int32_t irq = 0; irq < HOST_IRQn_NUMBER; irq++)
+  {
+    if((coreEnable[irq] == true) && (BxCAN_GetIRQLevel((IRQn_Type)irq) == true))
+    {
+      if((pending < 0) || (corePriority[irq] < corePriority[pending]))
+      {
+        pending = irq;
+      }
+    }
+  }
+  
+  return pending;
+}
@@ -0,0 +1,66 @@
+/**
+  ******************************************************************************
+  * @file    Core.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for Core.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __CORE_H
+#define __CORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "stm32f10x.h"
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define CORE_IRQ_STORM_LIMIT  (1000000)  /* Back to back handler calls before the model gives up. */
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Count;     /*!< Handler calls. */
+  uint64_t HostTime;  /*!< Host time spent in the handler, in nanoseconds. */
+}Core_IRQStatistics;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+void Core_Update(void);
+bool Core_IsHandlerMode(void);
+
+uint64_t Core_GetHostTime(void);
+void Core_GetIRQStatistics(IRQn_Type IRQn, Core_IRQStatistics *Statistics);
+void Core_ClearIRQStatistics(void);
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CORE_H */
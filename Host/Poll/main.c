@@ -0,0 +1,259 @@
+/**
+  ******************************************************************************
+  * @file    main.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Fixed-rate superloop driving the CAN driver in polled mode on the bxCAN model.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+/* Header includes -----------------------------------------------------------*/
+#include "CAN.h"
+#include "bxCAN.h"
+#include "Core.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define FRAME_NUMBER     (10000)
+#define LOOP_PERIOD      (50000)    /* Nanoseconds of bus time per superloop pass, under one frame. */
+#define SLOW_PERIOD      (500000)   /* Longer than FIFO 0 lasts at full load. */
+
+#ifdef STM32F10X_CL
+#define TX_IRQn          CAN1_TX_IRQn
+#define RX0_IRQn         CAN1_RX0_IRQn
+#else
+#define TX_IRQn          USB_HP_CAN1_TX_IRQn
+#define RX0_IRQn         USB_LP_CAN1_RX0_IRQn
+#endif /* STM32F10X_CL */
+
+#if CAN_POLL_MODE == 0
+#error "Build with CAN_POLL_MODE=1."
+#endif
+
+/* Type definitions ----------------------------------------------------------*/
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+static void setup(CAN_WorkMode WorkMode);
+static void make_message(CanTxMsg *Message, uint32_t Sequence);
+static uint32_t get_sequence(const CanRxMsg *Message);
+static bool is_interrupt_free(void);
+static void print_poll(void);
+static bool run_loopback(void);
+static bool run_overrun(void);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Main program.
+  * @param  None.
+  * @return 0 when every check passes, 1 otherwise.
+  * @note   The model runs the driver in zero bus time, CAN_Poll() is timed in
+  *         host time here, on the target with the cycle counter.
+  */
+int main(void)
+{
+  bool result = true;
+  
+  result &= run_loopback();
+  result &= run_overrun();
+  
+  printf("%s\n", (result == true) ? "PASS" : "FAIL");
+  
+  return (result == true) ? 0 : 1;
+}
+
+/**
+  * @brief  Reset the model and configure CAN1 at 1 Mbit/s, receiving every identifier.
+  * @param  [in] WorkMode: Work mode.
+  * @return None.
+  */
+static void setup(CAN_WorkMode WorkMode)
+{
+  const CAN_FilterId filter[] =
+  {
+    {CAN_Id_Standard, 0, 0},
+    {CAN_Id_Extended, 0, 0}
+  };
+  
+  CAN_Unconfigure(CAN1);
+  BxCAN_Reset();
+  BxCAN_SetBusCallback(0);
+  Core_ClearIRQStatistics();
+  
+  CAN_Configure(CAN1, WorkMode, CAN_BaudRate1000K, 0, 0);
+  CAN_SetReceiveFilter(CAN1, filter, sizeof(filter) / sizeof(filter[0]));
+}
+
+/**
+  * @brief  Build a message carrying a sequence number.
+  * @param  [out] Message:  The message.
+  * @param  [in] Sequence:  Sequence number, in the first 4 data bytes.
+  * @return None.
+  */
+static void make_message(CanTxMsg *Message, uint32_t Sequence)
+{
+  memset(Message, 0, sizeof(*Message));
+  
+  Message->StdId = 0x200;
+  Message->IDE   = CAN_Id_Standard;
+  Message->RTR   = CAN_RTR_Data;
+  Message->DLC   = 8;
+  
+  memcpy(Message->Data, &Sequence, sizeof(Sequence));
+}
+
+/**
+  * @brief  Get the sequence number of a message.
+  * @param  [in] Message: The message.
+  * @return The sequence number.
+  */
+static uint32_t get_sequence(const CanRxMsg *Message)
+{
+  uint32_t sequence = 0;
+  
+  memcpy(&sequence, Message->Data, sizeof(sequence));
+  
+  return sequence;
+}
+
+/**
+  * @brief  Check that no CAN handler ran as an interrupt.
+  * @param  None.
+  * @retval true:  The handlers only ran from CAN_Poll().
+  * @retval false: An interrupt was taken.
+  */
+static bool is_interrupt_free(void)
+{
+  Core_IRQStatistics tx = {0};
+  Core_IRQStatistics rx = {0};
+  
+  Core_GetIRQStatistics(TX_IRQn, &tx);
+  Core_GetIRQStatistics(RX0_IRQn, &rx);
+  
+  return (tx.Count == 0) && (rx.Count == 0);
+}
+
+/**
+  * @brief  Print the polled mode statistics of CAN1.
+  */
+static void print_poll(void)
+{
+  CAN_PollStatistics statistics = {0};
+  
+  CAN_GetPollStatistics(CAN1, &statistics);
+  
+  printf("  CAN_Poll calls %u, FIFO overruns %u, bus-off %u, longest call %u ns host time\n",
+         statistics.Number, statistics.Overrun, statistics.BusOff, statistics.CyclesMax);
+}
+
+/**
+  * @brief  Send and receive in loopback from a superloop polling faster than a frame.
+  * @param  None.
+  * @retval true:  Every frame received in order, no interrupt taken.
+  * @retval false: Failed.
+  */
+static bool run_loopback(void)
+{
+  CanTxMsg           canTxMsg   = {0};
+  CanRxMsg           canRxMsg   = {0};
+  CAN_PollStatistics statistics = {0};
+  uint32_t           sent       = 0;
+  uint32_t           received   = 0;
+  uint32_t           disorder   = 0;
+  uint32_t           loop       = 0;
+  
+  setup(CAN_WorkModeLoopBack);
+  
+  for(loop = 0; (received < FRAME_NUMBER) && (loop < FRAME_NUMBER * 10); loop++)
+  {
+    while((sent < FRAME_NUMBER) && (CAN_IsTransmitBufferFull(CAN1) != true))
+    {
+      make_message(&canTxMsg, sent++);
+      CAN_SetTransmitMessage(CAN1, &canTxMsg, 1);
+    }
+    
+    BxCAN_Run(LOOP_PERIOD);
+    CAN_Poll(CAN1);
+    
+    while(CAN_GetReceiveMessage(CAN1, &canRxMsg, 1) == 1)
+    {
+      disorder += (get_sequence(&canRxMsg) != received++) ? 1 : 0;
+    }
+  }
+  
+  CAN_GetPollStatistics(CAN1, &statistics);
+  
+  printf("Polled mode, loopback, superloop every %u us\n", LOOP_PERIOD / 1000);
+  printf("  sent %u, received %u, out of order %u, %.1f frames/s, no interrupt %s\n", sent, received, disorder,
+         received * 1e9 / BxCAN_GetTime(), (is_interrupt_free() == true) ? "yes" : "no");
+  print_poll();
+  
+  return (received == FRAME_NUMBER) && (disorder == 0) && (is_interrupt_free() == true) && (statistics.Overrun == 0);
+}
+
+/**
+  * @brief  Receive at full load from a superloop slower than FIFO 0 lasts.
+  * @param  None.
+  * @retval true:  The overruns were counted, the messages not lost all received, no interrupt taken.
+  * @retval false: Failed.
+  */
+static bool run_overrun(void)
+{
+  CanTxMsg           canTxMsg   = {0};
+  CanRxMsg           canRxMsg   = {0};
+  CAN_PollStatistics statistics = {0};
+  BxCAN_Statistics   bus        = {0};
+  uint32_t           injected   = 0;
+  uint32_t           received   = 0;
+  
+  setup(CAN_WorkModeNormal);
+  
+  while((injected < FRAME_NUMBER) || (BxCAN_GetInjectNumber() > 0) || (CAN_MessagePending(CAN1, CAN_FIFO0) > 0))
+  {
+    while((injected < FRAME_NUMBER) && (BxCAN_GetInjectNumber() < BXCAN_REMOTE_QUEUE_SIZE))
+    {
+      make_message(&canTxMsg, injected++);
+      BxCAN_Inject(&canTxMsg);
+    }
+    
+    BxCAN_Run(SLOW_PERIOD);
+    CAN_Poll(CAN1);
+    
+    while(CAN_GetReceiveMessage(CAN1, &canRxMsg, 1) == 1)
+    {
+      received++;
+    }
+  }
+  
+  CAN_GetPollStatistics(CAN1, &statistics);
+  BxCAN_GetStatistics(&bus);
+  
+  printf("Polled mode, receive at full load, superloop every %u us\n", SLOW_PERIOD / 1000);
+  printf("  received %u, lost to FIFO overrun %u, no interrupt %s\n", received, bus.Overrun[0], (is_interrupt_free() == true) ? "yes" : "no");
+  print_poll();
+  
+  return (received + bus.Overrun[0] == FRAME_NUMBER) && (statistics.Overrun > 0) && (statistics.Overrun <= bus.Overrun[0]) &&
+         (is_interrupt_free() == true);
+}
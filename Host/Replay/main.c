@@ -0,0 +1,307 @@
+/**
+  ******************************************************************************
+  * @file    main.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Replay of a candump or ASC log through the CAN driver on the bxCAN model.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+/* Header includes -----------------------------------------------------------*/
+#include "CAN.h"
+#include "CANLog.h"
+#include "bxCAN.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define LOG_PATH     "Replay/example.log"
+#define OUTPUT_PATH  "build/replay.log"
+#define POLL_PERIOD  (10000)  /* Nanoseconds of bus time between two replay polls. */
+#define LINE_SIZE    (256)
+
+/* Type definitions ----------------------------------------------------------*/
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+static CAN_LogEntry *logEntry  = 0;
+static uint32_t      logNumber = 0;
+
+/* Function declarations -----------------------------------------------------*/
+static uint64_t get_time(void);
+static bool load(const char *Path);
+static int compare(const void *A, const void *B);
+static bool is_same(const CanTxMsg *A, const CanTxMsg *B);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Main program.
+  * @param  [in] argc: Argument count.
+  * @param  [in] argv: [-s speed] [-b kbit/s] [-a] [-o output] [log], speed 0 replays as
+  *                    fast as possible, -a writes the output as ASC instead of candump.
+  * @return 0 when every frame came back unchanged, 1 otherwise.
+  */
+int main(int argc, char *argv[])
+{
+  const CAN_FilterId filter[] =
+  {
+    {CAN_Id_Standard, 0, 0},
+    {CAN_Id_Extended, 0, 0}
+  };
+  
+  uint32_t      speed    = 1;
+  uint32_t      bitRate  = 500;
+  CAN_LogFormat format   = CAN_LogFormatCandump;
+  const char   *output   = OUTPUT_PATH;
+  CAN_BaudRate  baudRate = CAN_BaudRate500K;
+  int           option   = 0;
+  
+  while((option = getopt(argc, argv, "s:b:ao:")) != -1)
+  {
+    switch(option)
+    {
+      case 's':
+        speed = strtoul(optarg, 0, 0);
+        break;
+      case 'b':
+        bitRate = strtoul(optarg, 0, 0);
+        break;
+      case 'a':
+        format = CAN_LogFormatAsc;
+        break;
+      case 'o':
+        output = optarg;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-s speed] [-b kbit/s] [-a] [-o output] [log]\n", argv[0]);
+        return 1;
+    }
+  }
+  
+  switch(bitRate)
+  {
+    case 1000: baudRate = CAN_BaudRate1000K; break;
+    case 500:  baudRate = CAN_BaudRate500K;  break;
+    case 250:  baudRate = CAN_BaudRate250K;  break;
+    case 125:  baudRate = CAN_BaudRate125K;  break;
+    default:
+      fprintf(stderr, "bit rate %u kbit/s not supported\n", bitRate);
+      return 1;
+  }
+  
+  const char *path = (optind < argc) ? argv[optind] : LOG_PATH;
+  FILE       *file = fopen(output, "w");
+  
+  if((load(path) != true) || (file == 0))
+  {
+    fprintf(stderr, "cannot read %s or write %s\n", path, output);
+    return 1;
+  }
+  
+  BxCAN_Reset();
+  CAN_Log_Init(get_time);
+  CAN_Configure(CAN1, CAN_WorkModeLoopBack, baudRate, 0, 0);
+  CAN_SetReceiveFilter(CAN1, filter, sizeof(filter) / sizeof(filter[0]));
+  CAN_SetReceiveMessageCallback(CAN1, CAN_Log_Input);
+  
+  char         line[LINE_SIZE] = {0};
+  CAN_LogEntry entry           = {0};
+  CanRxMsg     canRxMsg        = {0};
+  uint32_t     received        = 0;
+  uint32_t     mismatch        = 0;
+  uint64_t     receiveFirst    = 0;
+  int64_t     *error           = calloc(logNumber, sizeof(int64_t));
+  
+  fputs((CAN_Log_FormatHeader(format, line, sizeof(line)) > 0) ? line : "", file);
+  
+  CAN_Log_ReplayStart(logEntry, logNumber, speed);
+  
+  /* Loop back: every replayed frame is logged as received at the end of its frame. */
+  for(bool running = true; running == true; )
+  {
+    running = (CAN_Log_ReplayProcess() == true) || (CAN_IsTransmitMessage(CAN1) == true);
+    
+    BxCAN_Run(POLL_PERIOD);
+    
+    while(CAN_GetReceiveMessage(CAN1, &canRxMsg, 1) == 1);
+    
+    while(CAN_Log_Read(&entry) == true)
+    {
+      CAN_Log_Format(format, &entry, line, sizeof(line));
+      fputs(line, file);
+      
+      if(received == 0)
+      {
+        receiveFirst = entry.Time;
+      }
+      
+      if(received < logNumber)
+      {
+        uint64_t original = logEntry[received].Time - logEntry[0].Time;
+        uint64_t replayed = entry.Time - receiveFirst;
+        
+        mismatch += (is_same(&entry.Message, &logEntry[received].Message) == true) ? 0 : 1;
+        error[received] = (int64_t)replayed - (int64_t)((speed > 0) ? original / speed : 0);
+      }
+      
+      received++;
+    }
+  }
+  
+  fclose(file);
+  
+  CAN_LogReplayStatistics statistics = {0};
+  uint64_t                span       = logEntry[logNumber - 1].Time - logEntry[0].Time;
+  
+  CAN_Log_GetReplayStatistics(&statistics);
+  
+  printf("Replay of %s, %u frames over %.3f s, at %u kbit/s", path, logNumber, span / 1e6, bitRate);
+  
+  if(speed > 0)
+  {
+    printf(", %ux speed\n", speed);
+  }
+  else
+  {
+    printf(", as fast as possible\n");
+  }
+  
+  printf("  sent %u, received %u, changed %u, log overflow %u, transmit buffer full %u times\n",
+         statistics.Frames, received, mismatch, CAN_Log_GetOverflowNumber(), statistics.BufferFull);
+  printf("  replay took %.3f s, %.2fx the original\n", statistics.Duration / 1e6,
+         (statistics.Duration > 0) ? (double)span / statistics.Duration : 0.0);
+  
+  if(speed > 0)
+  {
+    uint32_t number = (received < logNumber) ? received : logNumber;
+    double   total  = 0;
+    
+    for(uint32_t i = 0; i < number; i++)
+    {
+      error[i] = (error[i] < 0) ? -error[i] : error[i];
+      total   += error[i];
+    }
+    
+    qsort(error, number, sizeof(int64_t), compare);
+    
+    printf("  enqueue error avg %.1f us, max %u us, late %u\n",
+           (statistics.Frames > 0) ? (double)statistics.ErrorTotal / statistics.Frames : 0.0, statistics.ErrorMax, statistics.Late);
+    printf("  on-bus timing error avg %.1f us, p99 %lld us, max %lld us\n", (number > 0) ? total / number : 0.0,
+           (number > 0) ? (long long)error[(number * 99) / 100] : 0LL, (number > 0) ? (long long)error[number - 1] : 0LL);
+  }
+  
+  printf("  written to %s\n", output);
+  
+  bool result = (statistics.Frames == logNumber) && (received == logNumber) && (mismatch == 0);
+  
+  if(speed > 0)
+  {
+    result &= (statistics.ErrorMax <= POLL_PERIOD / 1000);
+  }
+  
+  free(error);
+  free(logEntry);
+  
+  printf("%s\n", (result == true) ? "PASS" : "FAIL");
+  
+  return (result == true) ? 0 : 1;
+}
+
+/**
+  * @brief  Clock of the log, the model time in microseconds.
+  */
+static uint64_t get_time(void)
+{
+  return BxCAN_GetTime() / 1000;
+}
+
+/**
+  * @brief  Read the frames of a log, all of them replayed on CAN1.
+  * @param  [in] Path: The candump or ASC log.
+  * @retval true:  At least one frame was read.
+  * @retval false: Failed.
+  */
+static bool load(const char *Path)
+{
+  FILE        *file            = fopen(Path, "r");
+  char         line[LINE_SIZE] = {0};
+  uint32_t     size            = 0;
+  CAN_LogEntry entry           = {0};
+  
+  if(file == 0)
+  {
+    return false;
+  }
+  
+  while(fgets(line, sizeof(line), file) != 0)
+  {
+    if(CAN_Log_Parse(line, &entry) != true)
+    {
+      continue;
+    }
+    
+    if(logNumber == size)
+    {
+      size     = (size > 0) ? (size * 2) : 256;
+      logEntry = realloc(logEntry, size * sizeof(CAN_LogEntry));
+    }
+    
+    entry.Channel         = 0;
+    logEntry[logNumber++] = entry;
+  }
+  
+  fclose(file);
+  
+  return (logNumber > 0);
+}
+
+/**
+  * @brief  Order of two timing errors.
+  */
+static int compare(const void *A, const void *B)
+{
+  int64_t a = *(const int64_t *)A;
+  int64_t b = *(const int64_t *)B;
+  
+  return (a > b) - (a < b);
+}
+
+/**
+  * @brief  Are two frames the same.
+  */
+static bool is_same(const CanTxMsg *A, const CanTxMsg *B)
+{
+  if((A->IDE != B->IDE) || (A->RTR != B->RTR) || (A->DLC != B->DLC))
+  {
+    return false;
+  }
+  
+  if((A->IDE == CAN_Id_Standard) ? (A->StdId != B->StdId) : (A->ExtId != B->ExtId))
+  {
+    return false;
+  }
+  
+  return (A->RTR == CAN_RTR_Remote) || (memcmp(A->Data, B->Data, A->DLC) == 0);
+}
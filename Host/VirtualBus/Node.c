@@ -0,0 +1,133 @@
+/**
+  ******************************************************************************
+  * @file    Node.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Node application of the virtual bus, built into every node shared object.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+/* Header includes -----------------------------------------------------------*/
+#include "Node.h"
+#include <string.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+/* Type definitions ----------------------------------------------------------*/
+/* Variable declarations -----------------------------------------------------*/
+static uint32_t        nodeIndex      = 0;
+static Node_Config     nodeConfig     = {CAN_BaudRate500K, 0, 8, 0, 0};
+static uint64_t        nodeRelease    = 0;
+static uint8_t         nodeSequence   = 0;
+static Node_Statistics nodeStatistics = {0};
+
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Configure CAN1 of the node in normal mode, receiving every identifier.
+  * @param  [in] Index:  The node number, sent in data byte 6.
+  * @param  [in] Config: What the node sends.
+  * @return None.
+  */
+void Node_Init(uint32_t Index, const Node_Config *Config)
+{
+  const CAN_FilterId filter[] =
+  {
+    {CAN_Id_Standard, 0, 0},
+    {CAN_Id_Extended, 0, 0}
+  };
+  
+  nodeIndex    = Index;
+  nodeConfig   = *Config;
+  nodeRelease  = Config->Offset;
+  nodeSequence = 0;
+  
+  memset(&nodeStatistics, 0, sizeof(nodeStatistics));
+  
+  if(nodeConfig.DLC < NODE_RELEASE_TIME_SIZE)
+  {
+    nodeConfig.DLC = NODE_RELEASE_TIME_SIZE;
+  }
+  else if(nodeConfig.DLC > 8)
+  {
+    nodeConfig.DLC = 8;
+  }
+  
+  CAN_Configure(CAN1, CAN_WorkModeNormal, Config->BaudRate, 0, 0);
+  CAN_SetReceiveFilter(CAN1, filter, sizeof(filter) / sizeof(filter[0]));
+}
+
+/**
+  * @brief  Run the application of the node: queue the frames released up to now and
+  *         read the received ones.
+  * @param  [in] Time: The bus time in nanoseconds.
+  * @return None.
+  */
+void Node_Poll(uint64_t Time)
+{
+  CanTxMsg canTxMsg = {0};
+  CanRxMsg canRxMsg = {0};
+  
+  while((nodeConfig.Period > 0) && (nodeRelease <= Time))
+  {
+    canTxMsg.StdId = nodeConfig.StdId;
+    canTxMsg.IDE   = CAN_Id_Standard;
+    canTxMsg.RTR   = CAN_RTR_Data;
+    canTxMsg.DLC   = nodeConfig.DLC;
+    
+    for(uint32_t i = 0; i < NODE_RELEASE_TIME_SIZE; i++)
+    {
+      canTxMsg.Data[i] = (nodeRelease >> (8 * i)) & 0xFF;
+    }
+    
+    canTxMsg.Data[6] = nodeIndex;
+    canTxMsg.Data[7] = nodeSequence++;
+    
+    if(CAN_SetTransmitMessage(CAN1, &canTxMsg, 1) == 1)
+    {
+      nodeStatistics.Queued++;
+    }
+    else
+    {
+      nodeStatistics.BufferFull++;
+    }
+    
+    nodeRelease += nodeConfig.Period;
+  }
+  
+  while(CAN_GetReceiveMessage(CAN1, &canRxMsg, 1) == 1)
+  {
+    nodeStatistics.Received++;
+  }
+}
+
+/**
+  * @brief  Get the application statistics of the node.
+  * @param  [out] Statistics: The statistics.
+  * @return None.
+  */
+void Node_GetStatistics(Node_Statistics *Statistics)
+{
+  *Statistics = nodeStatistics;
+}
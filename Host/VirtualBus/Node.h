@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * @file    Node.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for Node.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+#ifndef __NODE_H
+#define __NODE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "CAN.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define NODE_RELEASE_TIME_SIZE  (6)  /* Data bytes 0 to 5 carry the release time in nanoseconds, LSB first. */
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct
+{
+  CAN_BaudRate BaudRate;
+  uint32_t     StdId;         /*!< Identifier of the frames the node sends. */
+  uint8_t      DLC;           /*!< Data length of those frames, at least 6. */
+  uint64_t     Period;        /*!< Nanoseconds between two frames, 0 to only receive. */
+  uint64_t     Offset;        /*!< Release time of the first frame, in nanoseconds. */
+}Node_Config;
+
+typedef struct
+{
+  uint32_t Queued;            /*!< Frames the driver accepted. */
+  uint32_t BufferFull;        /*!< Frames refused by a full transmit buffer. */
+  uint32_t Received;          /*!< Frames read from the driver. */
+}Node_Statistics;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+void Node_Init(uint32_t Index, const Node_Config *Config);
+void Node_Poll(uint64_t Time);
+void Node_GetStatistics(Node_Statistics *Statistics);
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __NODE_H */
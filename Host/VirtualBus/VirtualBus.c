@@ -0,0 +1,872 @@
+/**
+  ******************************************************************************
+  * @file    VirtualBus.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Virtual CAN bus with several nodes, each running its own copy of the driver.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+/* Header includes -----------------------------------------------------------*/
+#include "VirtualBus.h"
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define VIRTUAL_BUS_FRAME_BITS  (128)  /* Start of frame to CRC of the longest frame, unstuffed. */
+#define VIRTUAL_BUS_FRAME_END   (13)   /* CRC delimiter, ACK slot and delimiter, end of frame, interframe space. */
+
+/* Type definitions ----------------------------------------------------------*/
+
+/* A node: its own copy of the driver, the bxCAN model and the application. */
+typedef struct
+{
+  void     *Handle;
+  
+  void     (*Init)(uint32_t Index, const Node_Config *Config);
+  void     (*Poll)(uint64_t Time);
+  void     (*GetApplicationStatistics)(Node_Statistics *Statistics);
+  void     (*GetControllerStatistics)(BxCAN_Statistics *Statistics);
+  void     (*SetTime)(uint64_t Time);
+  uint64_t (*GetBitTime)(int32_t Node);
+  bool     (*GetRequest)(int32_t Node, BxCAN_Frame *Frame);
+  void     (*TransmitDone)(int32_t Node, BxCAN_TransmitResult Result, uint32_t Lec);
+  bool     (*IsListening)(int32_t Node);
+  void     (*Receive)(int32_t Node, const BxCAN_Frame *Frame, uint32_t Lec);
+  void     (*Recessive)(int32_t Node, uint32_t Number);
+  void     (*SetErrorCounters)(int32_t Node, uint32_t Tec, uint32_t Rec);
+  void     (*GetErrorCounters)(int32_t Node, uint32_t *Tec, uint32_t *Rec);
+  
+  uint64_t    NextPoll;                               /*!< Picoseconds. */
+  bool        Request;                                /*!< Still in the running for the bus. */
+  BxCAN_Frame Frame;
+  uint8_t     Bits[VIRTUAL_BUS_FRAME_BITS];           /*!< Start of frame to CRC, unstuffed. */
+  uint32_t    BitNumber;
+  uint32_t    Arbitration;                            /*!< Bits 1 to Arbitration are the arbitration field. */
+  uint32_t    Lec;                                    /*!< The error the node sees in the current frame. */
+  uint32_t    ErrorBit;                               /*!< The bit flipped in the current frame, UINT32_MAX for none. */
+  bool        BusOff;
+  
+  uint32_t    BitErrorNumber;                         /*!< Own frames still to get a bit error. */
+  uint32_t    BitErrorPosition;
+  uint32_t    AckErrorNumber;                         /*!< Own frames still to go unacknowledged. */
+  
+  VirtualBus_NodeStatistics Statistics;
+  BxCAN_Statistics          ControllerBase;           /*!< Model statistics at the last clear. */
+  Node_Statistics           ApplicationBase;          /*!< Application statistics at the last clear. */
+}VirtualBus_Node;
+
+/* Variable declarations -----------------------------------------------------*/
+static VirtualBus_Node vbusNode[VIRTUAL_BUS_NODE_NUMBER] = {0};
+static uint32_t        vbusNodeNumber                    = 0;
+
+static uint64_t vbusTime    = 0;         /* Picoseconds. */
+static uint64_t vbusBusIdle = 0;         /* Picoseconds, recessive bits before it are counted. */
+static uint64_t vbusBitTime = 2000000;   /* Picoseconds, taken from the first node. */
+
+static VirtualBus_Statistics vbusStatistics = {0};
+
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+static void *vbus_open(const char *Path);
+static void *vbus_symbol(void *Handle, const char *Name, bool *Result);
+static uint32_t vbus_push(uint8_t *Bits, uint32_t Number, uint32_t Value, uint32_t Width);
+static void vbus_frame_bits(VirtualBus_Node *Node);
+static uint32_t vbus_get_stuff_bits(const uint8_t *Bits, uint32_t Number);
+static void vbus_poll(void);
+static void vbus_idle(uint64_t Time);
+static bool vbus_arbitrate(void);
+static void vbus_transfer(void);
+static void vbus_check_bus_off(VirtualBus_Node *Node);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Load a node and start its application.
+  * @param  [in] Path:   The node shared object, built from Node.c, the driver and the models.
+  * @param  [in] Config: What the node sends.
+  * @return The node number, -1 if the node cannot be loaded.
+  * @note   Every node runs CAN1 of its own copy of the shared object. The bus takes its
+  *         bit time from the first node.
+  */
+int32_t VirtualBus_AddNode(const char *Path, const Node_Config *Config)
+{
+  VirtualBus_Node *node   = &vbusNode[vbusNodeNumber];
+  bool             result = true;
+  
+  if(vbusNodeNumber >= VIRTUAL_BUS_NODE_NUMBER)
+  {
+    return -1;
+  }
+  
+  memset(node, 0, sizeof(*node));
+  
+  node->Handle = vbus_open(Path);
+  
+  if(node->Handle == 0)
+  {
+    return -1;
+  }
+  
+  *(void **)&node->Init                     = vbus_symbol(node->Handle, "Node_Init", &result);
+  *(void **)&node->Poll                     = vbus_symbol(node->Handle, "Node_Poll", &result);
+  *(void **)&node->GetApplicationStatistics = vbus_symbol(node->Handle, "Node_GetStatistics", &result);
+  *(void **)&node->GetControllerStatistics  = vbus_symbol(node->Handle, "BxCAN_GetStatistics", &result);
+  *(void **)&node->SetTime                  = vbus_symbol(node->Handle, "BxCAN_PortSetTime", &result);
+  *(void **)&node->GetBitTime               = vbus_symbol(node->Handle, "BxCAN_PortGetBitTime", &result);
+  *(void **)&node->GetRequest               = vbus_symbol(node->Handle, "BxCAN_PortGetRequest", &result);
+  *(void **)&node->TransmitDone             = vbus_symbol(node->Handle, "BxCAN_PortTransmitDone", &result);
+  *(void **)&node->IsListening              = vbus_symbol(node->Handle, "BxCAN_PortIsListening", &result);
+  *(void **)&node->Receive                  = vbus_symbol(node->Handle, "BxCAN_PortReceive", &result);
+  *(void **)&node->Recessive                = vbus_symbol(node->Handle, "BxCAN_PortRecessive", &result);
+  *(void **)&node->SetErrorCounters         = vbus_symbol(node->Handle, "BxCAN_PortSetErrorCounters", &result);
+  *(void **)&node->GetErrorCounters         = vbus_symbol(node->Handle, "BxCAN_PortGetErrorCounters", &result);
+  
+  if(result != true)
+  {
+    dlclose(node->Handle);
+    node->Handle = 0;
+    return -1;
+  }
+  
+  node->SetTime(vbusTime / 1000);
+  node->Init(vbusNodeNumber, Config);
+  node->NextPoll = vbusTime;
+  
+  if(vbusNodeNumber == 0)
+  {
+    vbusBitTime = node->GetBitTime(BXCAN_NODE_CAN1);
+  }
+  
+  return vbusNodeNumber++;
+}
+
+/**
+  * @brief  Unload all nodes and reset the bus.
+  * @param  None.
+  * @return None.
+  */
+void VirtualBus_Close(void)
+{
+  for(uint32_t i = 0; i < vbusNodeNumber; i++)
+  {
+    dlclose(vbusNode[i].Handle);
+  }
+  
+  memset(vbusNode, 0, sizeof(vbusNode));
+  memset(&vbusStatistics, 0, sizeof(vbusStatistics));
+  
+  vbusNodeNumber = 0;
+  vbusTime       = 0;
+  vbusBusIdle    = 0;
+}
+
+/**
+  * @brief  Advance the bus.
+  * @param  [in] Duration: Bus time to simulate, in nanoseconds.
+  * @return None.
+  * @note   Node applications run every VIRTUAL_BUS_POLL_PERIOD, their interrupt handlers
+  *         when their controller changes state. A frame that starts before the end time
+  *         is simulated to its end.
+  */
+void VirtualBus_Run(uint64_t Duration)
+{
+  uint64_t limit = vbusTime + Duration * 1000;
+  
+  while(vbusTime < limit)
+  {
+    vbus_poll();
+    
+    if(vbus_arbitrate() == true)
+    {
+      vbus_transfer();
+    }
+    else
+    {
+      uint64_t next = limit;
+      
+      for(uint32_t i = 0; i < vbusNodeNumber; i++)
+      {
+        if(vbusNode[i].NextPoll < next)
+        {
+          next = vbusNode[i].NextPoll;
+        }
+      }
+      
+      vbusTime = next;
+      vbus_idle(vbusTime);
+    }
+  }
+}
+
+/**
+  * @brief  Get the bus time.
+  * @param  None.
+  * @return The simulated time in nanoseconds.
+  */
+uint64_t VirtualBus_GetTime(void)
+{
+  return vbusTime / 1000;
+}
+
+/**
+  * @brief  Get the bit rate of the bus.
+  * @param  None.
+  * @return Bits per second.
+  */
+uint32_t VirtualBus_GetBitRate(void)
+{
+  return 1000000000000ULL / vbusBitTime;
+}
+
+/**
+  * @brief  Flip a bit in the next frames a node sends.
+  * @param  [in] Node:   The node number.
+  * @param  [in] Number: Frames to destroy.
+  * @param  [in] Bit:    The bit, counted from the start of frame without stuff bits, kept
+  *                      between the arbitration field and the end of the CRC.
+  * @return None.
+  * @note   The sender sees a bit error, the other nodes the error flag that follows.
+  */
+void VirtualBus_InjectBitError(uint32_t Node, uint32_t Number, uint32_t Bit)
+{
+  if(Node < vbusNodeNumber)
+  {
+    vbusNode[Node].BitErrorNumber   = Number;
+    vbusNode[Node].BitErrorPosition = Bit;
+  }
+}
+
+/**
+  * @brief  Leave the next frames a node sends unacknowledged.
+  * @param  [in] Node:   The node number.
+  * @param  [in] Number: Frames to destroy.
+  * @return None.
+  * @note   A frame no other node is listening to is never acknowledged either.
+  */
+void VirtualBus_InjectAckError(uint32_t Node, uint32_t Number)
+{
+  if(Node < vbusNodeNumber)
+  {
+    vbusNode[Node].AckErrorNumber = Number;
+  }
+}
+
+/**
+  * @brief  Put a node in bus-off.
+  * @param  [in] Node: The node number.
+  * @return None.
+  */
+void VirtualBus_InjectBusOff(uint32_t Node)
+{
+  uint32_t tec = 0;
+  uint32_t rec = 0;
+  
+  if(Node < vbusNodeNumber)
+  {
+    vbusNode[Node].GetErrorCounters(BXCAN_NODE_CAN1, &tec, &rec);
+    vbusNode[Node].SetErrorCounters(BXCAN_NODE_CAN1, 256, rec);
+    vbus_check_bus_off(&vbusNode[Node]);
+  }
+}
+
+/**
+  * @brief  Get the bus statistics.
+  * @param  [out] Statistics: The statistics.
+  * @return None.
+  */
+void VirtualBus_GetStatistics(VirtualBus_Statistics *Statistics)
+{
+  *Statistics = vbusStatistics;
+}
+
+/**
+  * @brief  Get the statistics of a node.
+  * @param  [in] Node:        The node number.
+  * @param  [out] Statistics: The statistics, those of the model and the application
+  *                           counted from the last clear as well.
+  * @return None.
+  */
+void VirtualBus_GetNodeStatistics(uint32_t Node, VirtualBus_NodeStatistics *Statistics)
+{
+  VirtualBus_Node  *node        = &vbusNode[Node];
+  BxCAN_Statistics  controller  = {0};
+  Node_Statistics   application = {0};
+  
+  memset(Statistics, 0, sizeof(*Statistics));
+  
+  if(Node >= vbusNodeNumber)
+  {
+    return;
+  }
+  
+  *Statistics = node->Statistics;
+  
+  node->GetErrorCounters(BXCAN_NODE_CAN1, &Statistics->Tec, &Statistics->Rec);
+  node->GetControllerStatistics(&controller);
+  node->GetApplicationStatistics(&application);
+  
+  Statistics->Controller.ArbitrationLost[0] = controller.ArbitrationLost[0] - node->ControllerBase.ArbitrationLost[0];
+  Statistics->Controller.TransmitError[0]   = controller.TransmitError[0] - node->ControllerBase.TransmitError[0];
+  Statistics->Controller.Overrun[0]         = controller.Overrun[0] - node->ControllerBase.Overrun[0];
+  Statistics->Controller.Filtered[0]        = controller.Filtered[0] - node->ControllerBase.Filtered[0];
+  Statistics->Application.Queued            = application.Queued - node->ApplicationBase.Queued;
+  Statistics->Application.BufferFull        = application.BufferFull - node->ApplicationBase.BufferFull;
+  Statistics->Application.Received          = application.Received - node->ApplicationBase.Received;
+}
+
+/**
+  * @brief  Clear the bus and node statistics.
+  * @param  None.
+  * @return None.
+  */
+void VirtualBus_ClearStatistics(void)
+{
+  memset(&vbusStatistics, 0, sizeof(vbusStatistics));
+  
+  for(uint32_t i = 0; i < vbusNodeNumber; i++)
+  {
+    memset(&vbusNode[i].Statistics, 0, sizeof(vbusNode[i].Statistics));
+    
+    vbusNode[i].GetControllerStatistics(&vbusNode[i].ControllerBase);
+    vbusNode[i].GetApplicationStatistics(&vbusNode[i].ApplicationBase);
+  }
+}
+
+/**
+  * @brief  Load a private copy of a shared object.
+  * @param  [in] Path: The shared object.
+  * @return The handle, 0 on failure.
+  * @note   dlopen() hands out the loaded object again for the same file, a copy per node
+  *         gives every node its own driver and model state.
+  */
+static void *vbus_open(const char *Path)
+{
+  char    copy[]     = "/tmp/vbus_node_XXXXXX";
+  char    data[4096] = {0};
+  size_t  size       = 0;
+  void   *handle     = 0;
+  FILE   *in         = fopen(Path, "rb");
+  FILE   *out        = 0;
+  int     fd         = -1;
+  
+  if(in == 0)
+  {
+    fprintf(stderr, "cannot open %s\n", Path);
+    return 0;
+  }
+  
+  fd = mkstemp(copy);
+  
+  if(fd < 0)
+  {
+    fclose(in);
+    return 0;
+  }
+  
+  out = fdopen(fd, "wb");
+  
+  while((size = fread(data, 1, sizeof(data), in)) > 0)
+  {
+    fwrite(data, 1, size, out);
+  }
+  
+  fclose(in);
+  fclose(out);
+  
+  handle = dlopen(copy, RTLD_NOW | RTLD_LOCAL);
+  
+  if(handle == 0)
+  {
+    fprintf(stderr, "%s\n", dlerror());
+  }
+  
+  unlink(copy);
+  
+  return handle;
+}
+
+/**
+  * @brief  Look up a symbol of a node.
+  * @param  [in] Handle:      The node shared object.
+  * @param  [in] Name:        The symbol.
+  * @param  [in,out] Result:  Cleared when the symbol is missing.
+  * @return The address, 0 if missing.
+  */
+static void *vbus_symbol(void *Handle, const char *Name, bool *Result)
+{
+  void *symbol = dlsym(Handle, Name);
+  
+  if(symbol == 0)
+  {
+    fprintf(stderr, "missing %s\n", Name);
+    *Result = false;
+  }
+  
+  return symbol;
+}
+
+/**
+  * @brief  Append a field to a bit stream, most significant bit first.
+  * @param  [out] Bits:  The bit stream.
+  * @param  [in] Number: Bits already in the stream.
+  * @param  [in] Value:  The field.
+  * @param  [in] Width:  Bits of the field.
+  * @return Bits in the stream now.
+  */
+static uint32_t vbus_push(uint8_t *Bits, uint32_t Number, uint32_t Value, uint32_t Width)
+{
+  while(Width > 0)
+  {
+    Width--;
+    Bits[Number++] = (Value >> Width) & 1;
+  }
+  
+  return Number;
+}
+
+/**
+  * @brief  Build the bits of the frame a node puts up, start of frame to CRC.
+  * @param  [in,out] Node: The node, with Frame set.
+  * @return None.
+  * @note   0 is dominant. The CRC is the CAN CRC-15 over the bits before it.
+  */
+static void vbus_frame_bits(VirtualBus_Node *Node)
+{
+  const BxCAN_Frame *frame = &Node->Frame;
+  uint8_t           *bits  = Node->Bits;
+  uint32_t           n     = 0;
+  uint32_t           rtr   = ((frame->IR & CAN_TI0R_RTR) != 0) ? 1 : 0;
+  uint32_t           dlc   = frame->DTR & CAN_TDT0R_DLC;
+  uint32_t           crc   = 0;
+  
+  n = vbus_push(bits, n, 0, 1);
+  n = vbus_push(bits, n, frame->IR >> 21, 11);
+  
+  if((frame->IR & CAN_TI0R_IDE) == 0)
+  {
+    n = vbus_push(bits, n, rtr, 1);
+    n = vbus_push(bits, n, 0, 1);
+    Node->Arbitration = n - 1;
+    n = vbus_push(bits, n, 0, 1);
+  }
+  else
+  {
+    n = vbus_push(bits, n, 3, 2);
+    n = vbus_push(bits, n, (frame->IR >> 3) & 0x3FFFF, 18);
+    n = vbus_push(bits, n, rtr, 1);
+    Node->Arbitration = n - 1;
+    n = vbus_push(bits, n, 0, 2);
+  }
+  
+  n = vbus_push(bits, n, dlc, 4);
+  
+  for(uint32_t i = 0; (rtr == 0) && (i < dlc) && (i < 8); i++)
+  {
+    n = vbus_push(bits, n, (((i < 4) ? frame->DLR : frame->DHR) >> (8 * (i & 3))) & 0xFF, 8);
+  }
+  
+  for(uint32_t i = 0; i < n; i++)
+  {
+    uint32_t next = bits[i] ^ ((crc >> 14) & 1);
+    
+    crc = (crc << 1) & 0x7FFF;
+    
+    if(next != 0)
+    {
+      crc ^= 0x4599;
+    }
+  }
+  
+  Node->BitNumber = vbus_push(bits, n, crc, 15);
+}
+
+/**
+  * @brief  Count the stuff bits a transmitter inserts into the first bits of a frame.
+  * @param  [in] Bits:   The bit stream from the start of frame.
+  * @param  [in] Number: Bits of the stream to count over.
+  * @return The number of stuff bits.
+  * @note   After 5 equal bits the complement is inserted, and counts towards the next run.
+  */
+static uint32_t vbus_get_stuff_bits(const uint8_t *Bits, uint32_t Number)
+{
+  uint32_t stuff = 0;
+  uint32_t run   = 0;
+  uint8_t  level = 2;
+  
+  for(uint32_t i = 0; i < Number; i++)
+  {
+    if(Bits[i] == level)
+    {
+      run++;
+    }
+    else
+    {
+      level = Bits[i];
+      run   = 1;
+    }
+    
+    if(run == 5)
+    {
+      stuff++;
+      level = !level;
+      run   = 1;
+    }
+  }
+  
+  return stuff;
+}
+
+/**
+  * @brief  Run the node applications due by now.
+  * @param  None.
+  * @return None.
+  */
+static void vbus_poll(void)
+{
+  for(uint32_t i = 0; i < vbusNodeNumber; i++)
+  {
+    VirtualBus_Node *node = &vbusNode[i];
+    
+    while(node->NextPoll <= vbusTime)
+    {
+      node->SetTime(node->NextPoll / 1000);
+      node->Poll(node->NextPoll / 1000);
+      node->NextPoll += VIRTUAL_BUS_POLL_PERIOD * 1000ULL;
+    }
+  }
+}
+
+/**
+  * @brief  Count idle bus time towards bus-off recovery.
+  * @param  [in] Time: The end of the idle time, in picoseconds.
+  * @return None.
+  */
+static void vbus_idle(uint64_t Time)
+{
+  uint64_t span   = 11 * vbusBitTime;
+  uint32_t number = (Time > vbusBusIdle) ? (Time - vbusBusIdle) / span : 0;
+  
+  if(number == 0)
+  {
+    return;
+  }
+  
+  vbusBusIdle += number * span;
+  
+  for(uint32_t i = 0; i < vbusNodeNumber; i++)
+  {
+    vbusNode[i].Recessive(BXCAN_NODE_CAN1, number);
+    vbus_check_bus_off(&vbusNode[i]);
+  }
+}
+
+/**
+  * @brief  Bitwise arbitration among the frames the nodes put up.
+  * @param  None.
+  * @retval true:  At least one node keeps sending after the arbitration field.
+  * @retval false: No node has anything to send.
+  * @note   A dominant bit overwrites a recessive one, a node that sends recessive and
+  *         reads dominant stops. Its controller learns it at once, so a controller
+  *         without automatic retransmission is free to load its next frame while the
+  *         winner is still on the bus.
+  */
+static bool vbus_arbitrate(void)
+{
+  uint32_t number = 0;
+  
+  for(uint32_t i = 0; i < vbusNodeNumber; i++)
+  {
+    VirtualBus_Node *node = &vbusNode[i];
+    
+    node->Request = node->GetRequest(BXCAN_NODE_CAN1, &node->Frame);
+    
+    if(node->Request == true)
+    {
+      vbus_frame_bits(node);
+      number++;
+    }
+  }
+  
+  if(number == 0)
+  {
+    return false;
+  }
+  
+  vbus_idle(vbusTime);
+  
+  for(uint32_t bit = 1; (number > 1) && (bit < VIRTUAL_BUS_FRAME_BITS); bit++)
+  {
+    uint8_t level = 1;
+    
+    for(uint32_t i = 0; i < vbusNodeNumber; i++)
+    {
+      if((vbusNode[i].Request == true) && (bit <= vbusNode[i].Arbitration))
+      {
+        level &= vbusNode[i].Bits[bit];
+      }
+    }
+    
+    for(uint32_t i = 0; i < vbusNodeNumber; i++)
+    {
+      VirtualBus_Node *node = &vbusNode[i];
+      
+      if((node->Request == true) && (bit <= node->Arbitration) && (node->Bits[bit] != level))
+      {
+        node->Request = false;
+        node->Statistics.ArbitrationLost++;
+        number--;
+        
+        node->SetTime(vbusTime / 1000);
+        node->TransmitDone(BXCAN_NODE_CAN1, BxCAN_TransmitArbitrationLost, BXCAN_LEC_NONE);
+      }
+    }
+  }
+  
+  return true;
+}
+
+/**
+  * @brief  Send the frame of the arbitration winners, apply errors and hand the result
+  *         to every node.
+  * @param  None.
+  * @return None.
+  * @note   Winners with the same arbitration field send together. They succeed together
+  *         when their frames are equal, else the first differing bit is a bit error.
+  */
+static void vbus_transfer(void)
+{
+  VirtualBus_Node *first = 0;
+  uint32_t         error = UINT32_MAX;  /* First destroyed bit, unstuffed. */
+  uint32_t         rxLec = BXCAN_LEC_STUFF;
+  uint32_t         bits  = 0;
+  uint32_t         stuff = 0;
+  bool             ack   = false;
+  
+  for(uint32_t i = 0; i < vbusNodeNumber; i++)
+  {
+    VirtualBus_Node *node = &vbusNode[i];
+    
+    node->Lec      = BXCAN_LEC_NONE;
+    node->ErrorBit = UINT32_MAX;
+    
+    if(node->Request != true)
+    {
+      continue;
+    }
+    
+    if(first == 0)
+    {
+      first = node;
+    }
+    
+    for(uint32_t bit = node->Arbitration + 1; bit < node->BitNumber; bit++)
+    {
+      if((bit >= first->BitNumber) || (node->Bits[bit] != first->Bits[bit]))
+      {
+        error = (bit < error) ? bit : error;
+        break;
+      }
+    }
+    
+    if(node->BitErrorNumber > 0)
+    {
+      uint32_t bit = node->BitErrorPosition;
+      
+      bit = (bit <= node->Arbitration) ? node->Arbitration + 1 : bit;
+      bit = (bit >= node->BitNumber) ? node->BitNumber - 1 : bit;
+      
+      error = (bit < error) ? bit : error;
+      node->BitErrorNumber--;
+      node->ErrorBit = bit;
+    }
+  }
+  
+  if(error != UINT32_MAX)
+  {
+    uint8_t level = 1;
+    
+    for(uint32_t i = 0; i < vbusNodeNumber; i++)
+    {
+      if((vbusNode[i].Request == true) && (error < vbusNode[i].BitNumber))
+      {
+        level &= vbusNode[i].Bits[error];
+      }
+    }
+    
+    /* A sender reads back the other level at the destroyed bit, or sees the error flag after it. */
+    for(uint32_t i = 0; i < vbusNodeNumber; i++)
+    {
+      VirtualBus_Node *node = &vbusNode[i];
+      
+      if(node->Request != true)
+      {
+        continue;
+      }
+      
+      if(node->ErrorBit == error)
+      {
+        node->Lec = (node->Bits[error] != 0) ? BXCAN_LEC_BIT_RECESSIVE : BXCAN_LEC_BIT_DOMINANT;
+      }
+      else if((error < node->BitNumber) && (node->Bits[error] != 0) && (level == 0))
+      {
+        node->Lec = BXCAN_LEC_BIT_RECESSIVE;
+      }
+      else
+      {
+        node->Lec = BXCAN_LEC_STUFF;
+      }
+    }
+    
+    bits = error + 1 + vbus_get_stuff_bits(first->Bits, error + 1);
+  }
+  else
+  {
+    for(uint32_t i = 0; i < vbusNodeNumber; i++)
+    {
+      if((vbusNode[i].Request != true) && (vbusNode[i].IsListening(BXCAN_NODE_CAN1) == true))
+      {
+        ack = true;
+      }
+    }
+    
+    if(first->AckErrorNumber > 0)
+    {
+      first->AckErrorNumber--;
+      ack = false;
+    }
+    
+    stuff = vbus_get_stuff_bits(first->Bits, first->BitNumber);
+    bits  = first->BitNumber + stuff;
+    
+    if(ack == true)
+    {
+      bits += VIRTUAL_BUS_FRAME_END;
+    }
+    else
+    {
+      /* The error flag starts at the ACK delimiter, receivers see a form error. */
+      bits  += 2;
+      rxLec  = BXCAN_LEC_FORM;
+      
+      for(uint32_t i = 0; i < vbusNodeNumber; i++)
+      {
+        if(vbusNode[i].Request == true)
+        {
+          vbusNode[i].Lec = BXCAN_LEC_ACK;
+        }
+      }
+    }
+  }
+  
+  if((error != UINT32_MAX) || (ack != true))
+  {
+    bits += VIRTUAL_BUS_ERROR_FLAG_BITS + VIRTUAL_BUS_ERROR_DELIMITER + VIRTUAL_BUS_INTERFRAME_SPACE;
+  }
+  
+  vbusTime    += bits * vbusBitTime;
+  vbusBusIdle  = vbusTime;
+  
+  vbusStatistics.BusyTime += bits * vbusBitTime / 1000;
+  
+  if((error == UINT32_MAX) && (ack == true))
+  {
+    vbusStatistics.Frames++;
+    vbusStatistics.Bits      += bits;
+    vbusStatistics.StuffBits += stuff;
+  }
+  else
+  {
+    vbusStatistics.ErrorFrames++;
+  }
+  
+  /* Every node sees the end of the frame, then the 11 recessive bits that close it. */
+  for(uint32_t i = 0; i < vbusNodeNumber; i++)
+  {
+    VirtualBus_Node *node = &vbusNode[i];
+    
+    node->SetTime(vbusTime / 1000);
+    
+    if(node->Request == true)
+    {
+      if(node->Lec == BXCAN_LEC_NONE)
+      {
+        uint64_t release = node->Frame.DLR | ((uint64_t)(node->Frame.DHR & 0xFFFF) << 32);
+        uint64_t delay   = vbusTime / 1000 - release;
+        
+        node->Statistics.Transmitted++;
+        node->Statistics.DelayTotal += delay;
+        
+        if(delay > node->Statistics.DelayMax)
+        {
+          node->Statistics.DelayMax = delay;
+        }
+        
+        node->TransmitDone(BXCAN_NODE_CAN1, BxCAN_TransmitOk, BXCAN_LEC_NONE);
+      }
+      else
+      {
+        node->Statistics.TransmitError++;
+        node->TransmitDone(BXCAN_NODE_CAN1, BxCAN_TransmitError, node->Lec);
+      }
+    }
+    else if(node->IsListening(BXCAN_NODE_CAN1) == true)
+    {
+      if((error == UINT32_MAX) && (ack == true))
+      {
+        node->Receive(BXCAN_NODE_CAN1, &first->Frame, BXCAN_LEC_NONE);
+      }
+      else
+      {
+        node->Statistics.ReceiveError++;
+        node->Receive(BXCAN_NODE_CAN1, &first->Frame, rxLec);
+      }
+    }
+    
+    node->Recessive(BXCAN_NODE_CAN1, 1);
+    vbus_check_bus_off(node);
+  }
+}
+
+/**
+  * @brief  Count the entries of a node into bus-off.
+  * @param  [in,out] Node: The node.
+  * @return None.
+  */
+static void vbus_check_bus_off(VirtualBus_Node *Node)
+{
+  uint32_t tec = 0;
+  uint32_t rec = 0;
+  
+  Node->GetErrorCounters(BXCAN_NODE_CAN1, &tec, &rec);
+  
+  if((tec > 255) && (Node->BusOff != true))
+  {
+    Node->Statistics.BusOff++;
+  }
+  
+  Node->BusOff = (tec > 255);
+}
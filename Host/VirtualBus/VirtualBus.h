@@ -0,0 +1,100 @@
+/**
+  ******************************************************************************
+  * @file    VirtualBus.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for VirtualBus.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+#ifndef __VIRTUALBUS_H
+#define __VIRTUALBUS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "bxCAN.h"
+#include "Node.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define VIRTUAL_BUS_NODE_NUMBER       (16)
+#define VIRTUAL_BUS_POLL_PERIOD       (10000)  /* Nanoseconds between two polls of a node application. */
+
+#define VIRTUAL_BUS_ERROR_FLAG_BITS   (12)     /* Superposed error flags, at their longest. */
+#define VIRTUAL_BUS_ERROR_DELIMITER   (8)
+#define VIRTUAL_BUS_INTERFRAME_SPACE  (3)
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Frames;                   /*!< Frames completed without error. */
+  uint32_t ErrorFrames;              /*!< Frames destroyed by an error frame. */
+  uint64_t BusyTime;                 /*!< Bus time of both, in nanoseconds. */
+  uint64_t StuffBits;                /*!< Stuff bits of the completed frames. */
+  uint64_t Bits;                     /*!< Bits of the completed frames, stuff bits included. */
+}VirtualBus_Statistics;
+
+typedef struct
+{
+  uint32_t         Transmitted;      /*!< Frames sent without error. */
+  uint32_t         ArbitrationLost;  /*!< Arbitration rounds lost. */
+  uint32_t         TransmitError;    /*!< Own frames destroyed by an error. */
+  uint32_t         ReceiveError;     /*!< Error frames seen while receiving. */
+  uint32_t         BusOff;           /*!< Times the node entered bus-off. */
+  uint32_t         Tec;              /*!< Transmit error counter now. */
+  uint32_t         Rec;              /*!< Receive error counter now. */
+  uint64_t         DelayTotal;       /*!< Release to end of frame of the sent frames, in nanoseconds. */
+  uint64_t         DelayMax;
+  BxCAN_Statistics Controller;       /*!< Statistics of the bxCAN model of the node, CAN1 only. */
+  Node_Statistics  Application;      /*!< Statistics of the node application. */
+}VirtualBus_NodeStatistics;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+int32_t VirtualBus_AddNode(const char *Path, const Node_Config *Config);
+void VirtualBus_Close(void);
+
+void VirtualBus_Run(uint64_t Duration);
+uint64_t VirtualBus_GetTime(void);
+uint32_t VirtualBus_GetBitRate(void);
+
+void VirtualBus_InjectBitError(uint32_t Node, uint32_t Number, uint32_t Bit);
+void VirtualBus_InjectAckError(uint32_t Node, uint32_t Number);
+void VirtualBus_InjectBusOff(uint32_t Node);
+
+void VirtualBus_GetStatistics(VirtualBus_Statistics *Statistics);
+void VirtualBus_GetNodeStatistics(uint32_t Node, VirtualBus_NodeStatistics *Statistics);
+void VirtualBus_ClearStatistics(void);
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __VIRTUALBUS_H */
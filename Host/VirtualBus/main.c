@@ -0,0 +1,143 @@
+/**
+  ******************************************************************************
+  * @file    main.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Load test of the CAN driver on a virtual bus with several nodes.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+/* Header includes -----------------------------------------------------------*/
+#include "VirtualBus.h"
+#include <stdio.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define NODE_PATH      "build/vbus_node.so"
+#define PHASE_TIME     (1000000000ULL)  /* Nanoseconds of bus time per phase. */
+#define BUS_OFF_TIME   (300000000ULL)   /* Into the error phase, when node 3 is put in bus-off. */
+#define ERROR_NUMBER   (10)             /* Frames destroyed by each injected error. */
+
+/* Type definitions ----------------------------------------------------------*/
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+
+/* Identifiers and periods of the nodes, 0x080 and 0x100 are released together every 5 ms. */
+static const Node_Config nodeConfig[] =
+{
+  {CAN_BaudRate500K, 0x080, 8, 5000000,      0},
+  {CAN_BaudRate500K, 0x100, 8, 1000000,      0},
+  {CAN_BaudRate500K, 0x200, 8, 1000000, 500000},
+  {CAN_BaudRate500K, 0x300, 8, 2000000, 250000}
+};
+
+#define NODE_NUMBER    (sizeof(nodeConfig) / sizeof(nodeConfig[0]))
+
+/* Function declarations -----------------------------------------------------*/
+static void print_report(const char *Title, uint64_t Duration);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Main program.
+  * @param  [in] argc: Argument count.
+  * @param  [in] argv: The node shared object may be given as the first argument.
+  * @return 0 when every check passes, 1 otherwise.
+  */
+int main(int argc, char *argv[])
+{
+  const char               *path   = (argc > 1) ? argv[1] : NODE_PATH;
+  bool                      result = true;
+  VirtualBus_NodeStatistics node   = {0};
+  
+  for(uint32_t i = 0; i < NODE_NUMBER; i++)
+  {
+    if(VirtualBus_AddNode(path, &nodeConfig[i]) < 0)
+    {
+      printf("FAIL\n");
+      return 1;
+    }
+  }
+  
+  /* Clean bus: only arbitration. */
+  VirtualBus_Run(PHASE_TIME);
+  print_report("Clean bus", PHASE_TIME);
+  
+  for(uint32_t i = 0; i < NODE_NUMBER; i++)
+  {
+    VirtualBus_GetNodeStatistics(i, &node);
+    result &= (node.Transmitted > 0) && (node.TransmitError == 0) && (node.ReceiveError == 0);
+  }
+  
+  /* Bit errors on node 1, missing acknowledgments on node 2, then bus-off of node 3. */
+  VirtualBus_ClearStatistics();
+  VirtualBus_InjectBitError(1, ERROR_NUMBER, 40);
+  VirtualBus_InjectAckError(2, ERROR_NUMBER);
+  VirtualBus_Run(BUS_OFF_TIME);
+  VirtualBus_InjectBusOff(3);
+  VirtualBus_Run(PHASE_TIME - BUS_OFF_TIME);
+  print_report("Injected errors", PHASE_TIME);
+  
+  VirtualBus_GetNodeStatistics(1, &node);
+  result &= (node.TransmitError == ERROR_NUMBER);
+  VirtualBus_GetNodeStatistics(2, &node);
+  result &= (node.TransmitError == ERROR_NUMBER);
+  VirtualBus_GetNodeStatistics(3, &node);
+  result &= (node.BusOff == 1) && (node.Tec <= 255) && (node.Transmitted > 0);
+  
+  VirtualBus_Close();
+  
+  printf("%s\n", (result == true) ? "PASS" : "FAIL");
+  
+  return (result == true) ? 0 : 1;
+}
+
+/**
+  * @brief  Print the bus and node statistics since the last clear.
+  * @param  [in] Title:    The phase.
+  * @param  [in] Duration: Bus time of the phase, in nanoseconds.
+  * @return None.
+  */
+static void print_report(const char *Title, uint64_t Duration)
+{
+  VirtualBus_Statistics     bus  = {0};
+  VirtualBus_NodeStatistics node = {0};
+  
+  VirtualBus_GetStatistics(&bus);
+  
+  printf("%s, %u nodes at %u kbit/s, %llu ms\n", Title, (uint32_t)NODE_NUMBER,
+         VirtualBus_GetBitRate() / 1000, (unsigned long long)(Duration / 1000000));
+  printf("  %u frames, %.0f frames/s, bus load %.1f %%, %u error frames, %.1f stuff bits per frame\n",
+         bus.Frames, bus.Frames * 1e9 / Duration, 100.0 * bus.BusyTime / Duration, bus.ErrorFrames,
+         (bus.Frames > 0) ? (double)bus.StuffBits / bus.Frames : 0.0);
+  printf("  node   id   queued   sent  arb lost  dropped  tx err  rx err  bus-off  TEC  REC  delay avg/max us\n");
+  
+  for(uint32_t i = 0; i < NODE_NUMBER; i++)
+  {
+    VirtualBus_GetNodeStatistics(i, &node);
+    
+    printf("  %4u  %03X  %7u  %5u  %8u  %7u  %6u  %6u  %7u  %3u  %3u  %7.1f / %.1f\n", i, nodeConfig[i].StdId,
+           node.Application.Queued, node.Transmitted, node.ArbitrationLost, node.Controller.ArbitrationLost[0],
+           node.TransmitError, node.ReceiveError, node.BusOff, node.Tec, node.Rec,
+           (node.Transmitted > 0) ? node.DelayTotal / 1e3 / node.Transmitted : 0.0, node.DelayMax / 1e3);
+  }
+}
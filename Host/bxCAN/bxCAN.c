@@ -0,0 +1,1507 @@
+/**
+  ******************************************************************************
+  * @file    bxCAN.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Behavioral model of the bxCAN controllers and the StdPeriph CAN driver.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+/* Header includes -----------------------------------------------------------*/
+#include "bxCAN.h"
+#include "Core.h"
+#include <stddef.h>
+#include <string.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#ifdef STM32F10X_CL
+#define BXCAN_CONTROLLER_NUMBER   (2)
+#define BXCAN_FILTER_BANK_NUMBER  (28)
+#else
+#define BXCAN_CONTROLLER_NUMBER   (1)
+#define BXCAN_FILTER_BANK_NUMBER  (14)
+#endif /* STM32F10X_CL */
+
+#define BXCAN_DEFAULT_BIT_TIME    (1000000ULL)  /* Picoseconds, 1 Mbit/s when no controller is running. */
+#define BXCAN_BUS_OFF_RECOVERY    (128)         /* Occurrences of 11 recessive bits to leave bus-off. */
+
+#define BXCAN_TSR_RQCP(m)         (CAN_TSR_RQCP0 << (8 * (m)))
+#define BXCAN_TSR_TXOK(m)         (CAN_TSR_TXOK0 << (8 * (m)))
+#define BXCAN_TSR_ALST(m)         (CAN_TSR_ALST0 << (8 * (m)))
+#define BXCAN_TSR_TERR(m)         (CAN_TSR_TERR0 << (8 * (m)))
+#define BXCAN_TSR_TME(m)          (CAN_TSR_TME0 << (m))
+
+/* Type definitions ----------------------------------------------------------*/
+
+/* Controller state that is not visible in the registers. */
+typedef struct
+{
+  BxCAN_Frame Fifo[2][BXCAN_FIFO_DEPTH];
+  uint32_t    FifoNumber[2];
+  uint32_t    TxPending;                /*!< Mailboxes whose request the model has seen. */
+  uint64_t    TxOrder[3];               /*!< Request order, for transmit FIFO priority. */
+  uint32_t    Tec;                      /*!< Transmit error counter, above 255 in bus-off. */
+  uint32_t    Rec;                      /*!< Receive error counter. */
+  uint32_t    Recessive;                /*!< Occurrences of 11 recessive bits seen in bus-off. */
+}BxCAN_Controller;
+
+/* Variable declarations -----------------------------------------------------*/
+CAN_TypeDef hostCAN[2] = {0};
+
+static BxCAN_Controller bxcanController[2] = {0};
+
+static uint64_t bxcanTime     = 0;      /* Picoseconds. */
+static uint64_t bxcanBusIdle  = 0;      /* Picoseconds. */
+static uint64_t bxcanSequence = 0;
+
+static CanTxMsg bxcanRemote[BXCAN_REMOTE_QUEUE_SIZE] = {0};
+static uint32_t bxcanRemoteIn                        = 0;
+static uint32_t bxcanRemoteOut                       = 0;
+
+static void (*bxcanBusCallback)(uint64_t Time, int32_t Node, const CanRxMsg *Message) = 0;
+
+static BxCAN_Statistics bxcanStatistics = {0};
+
+static void (*bxcanClearHook)(CAN_TypeDef *CANx) = 0;
+
+/* The frame on the bus, from the start of arbitration to the end of its interframe space. */
+static bool        bxcanBusy       = false;
+static int32_t     bxcanWinner     = BXCAN_NODE_REMOTE;
+static int32_t     bxcanMailbox[2] = {-1, -1};
+static BxCAN_Frame bxcanFrame      = {0};
+static uint64_t    bxcanStart      = 0;
+static uint64_t    bxcanEnd        = 0;
+
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+static uint32_t bxcan_index(CAN_TypeDef *CANx);
+static bool bxcan_is_active(uint32_t x);
+static void bxcan_sync(uint32_t x);
+static int32_t bxcan_get_mailbox(uint32_t x);
+static void bxcan_transmit_done(uint32_t x, int32_t Mailbox, BxCAN_TransmitResult Result, uint32_t Lec);
+static void bxcan_error_update(uint32_t x, uint32_t Lec);
+static void bxcan_encode(const CanTxMsg *Message, BxCAN_Frame *Frame);
+static void bxcan_decode(const BxCAN_Frame *Frame, CanRxMsg *Message);
+static uint32_t bxcan_get_key(uint32_t IR);
+static uint32_t bxcan_get_bits(const BxCAN_Frame *Frame);
+static uint64_t bxcan_get_bit_time(int32_t Node);
+static int32_t bxcan_filter(uint32_t x, uint32_t IR, uint32_t *Fifo);
+static void bxcan_receive(uint32_t x, const BxCAN_Frame *Frame);
+static void bxcan_fifo_update(uint32_t x, uint32_t Fifo);
+static uint32_t bxcan_run(uint64_t Limit, bool Idle);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Reset the model: registers, FIFOs, time, the remote node and the statistics.
+  * @param  None.
+  * @return None.
+  */
+void BxCAN_Reset(void)
+{
+  memset(bxcanController, 0, sizeof(bxcanController));
+  memset(&bxcanStatistics, 0, sizeof(bxcanStatistics));
+  
+  bxcanTime      = 0;
+  bxcanBusIdle   = 0;
+  bxcanSequence  = 0;
+  bxcanRemoteIn  = 0;
+  bxcanRemoteOut = 0;
+  bxcanBusy      = false;
+  bxcanClearHook = 0;
+  
+  CAN_DeInit(CAN1);
+  CAN_DeInit(CAN2);
+}
+
+/**
+  * @brief  Advance the bus by a fixed time.
+  * @param  [in] Duration: Bus time to simulate, in nanoseconds.
+  * @return The number of frames completed.
+  * @note   Arbitration takes place when the bus is idle and a request is pending, among
+  *         all pending requests. The winning frame stays on the bus across calls until
+  *         its last bit. Handlers run at that time and may queue the next frame, which
+  *         then starts without a gap.
+  */
+uint32_t BxCAN_Run(uint64_t Duration)
+{
+  return bxcan_run(bxcanTime + Duration * 1000, false);
+}
+
+/**
+  * @brief  Run the bus until no controller and no remote frame is pending.
+  * @param  [in] Limit: Maximum bus time to simulate, in nanoseconds.
+  * @return The number of frames completed.
+  * @note   The time stops at the end of the last frame.
+  */
+uint32_t BxCAN_RunIdle(uint64_t Limit)
+{
+  return bxcan_run(bxcanTime + Limit * 1000, true);
+}
+
+/**
+  * @brief  Get the bus time.
+  * @param  None.
+  * @return The simulated time in nanoseconds.
+  */
+uint64_t BxCAN_GetTime(void)
+{
+  return bxcanTime / 1000;
+}
+
+/**
+  * @brief  Queue a frame on the remote node.
+  * @param  [in] Message: The frame.
+  * @retval true:         Queued, it competes for the bus like a controller request.
+  * @retval false:        The remote queue is full.
+  * @note   The remote node stands for the rest of the network: it acknowledges every
+  *         frame, and retransmits its own frames until they win arbitration.
+  */
+bool BxCAN_Inject(const CanTxMsg *Message)
+{
+  if(bxcanRemoteIn - bxcanRemoteOut >= BXCAN_REMOTE_QUEUE_SIZE)
+  {
+    return false;
+  }
+  
+  bxcanRemote[bxcanRemoteIn & (BXCAN_REMOTE_QUEUE_SIZE - 1)] = *Message;
+  bxcanRemoteIn++;
+  
+  return true;
+}
+
+/**
+  * @brief  Get the number of frames queued on the remote node.
+  * @param  None.
+  * @return The number of frames.
+  */
+uint32_t BxCAN_GetInjectNumber(void)
+{
+  return bxcanRemoteIn - bxcanRemoteOut;
+}
+
+/**
+  * @brief  Set the bus monitor.
+  * @param  [in] Callback: Called with every completed frame, its end time in nanoseconds
+  *                        and the sending node, BXCAN_NODE_CAN1, BXCAN_NODE_CAN2 or
+  *                        BXCAN_NODE_REMOTE. It may queue remote frames.
+  * @return None.
+  */
+void BxCAN_SetBusCallback(void (*Callback)(uint64_t Time, int32_t Node, const CanRxMsg *Message))
+{
+  bxcanBusCallback = Callback;
+}
+
+/**
+  * @brief  Get the level of an interrupt line.
+  * @param  [in] IRQn: The interrupt.
+  * @retval true:      The line is high.
+  * @retval false:     The line is low or not driven by the bxCAN.
+  */
+bool BxCAN_GetIRQLevel(IRQn_Type IRQn)
+{
+  CAN_TypeDef *CANx = CAN1;
+  
+  switch(IRQn)
+  {
+#ifdef STM32F10X_CL
+    case CAN2_TX_IRQn:
+      CANx = CAN2;
+#endif /* STM32F10X_CL */
+    case USB_HP_CAN1_TX_IRQn:
+      return ((CANx->IER & CAN_IT_TME) != 0) && ((CANx->TSR & (CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2)) != 0);
+#ifdef STM32F10X_CL
+    case CAN2_RX0_IRQn:
+      CANx = CAN2;
+#endif /* STM32F10X_CL */
+    case USB_LP_CAN1_RX0_IRQn:
+      return (((CANx->IER & CAN_IT_FMP0) != 0) && ((CANx->RF0R & CAN_RF0R_FMP0) != 0)) ||
+             (((CANx->IER & CAN_IT_FF0) != 0) && ((CANx->RF0R & CAN_RF0R_FULL0) != 0)) ||
+             (((CANx->IER & CAN_IT_FOV0) != 0) && ((CANx->RF0R & CAN_RF0R_FOVR0) != 0));
+#ifdef STM32F10X_CL
+    case CAN2_RX1_IRQn:
+      CANx = CAN2;
+#endif /* STM32F10X_CL */
+    case CAN1_RX1_IRQn:
+      return (((CANx->IER & CAN_IT_FMP1) != 0) && ((CANx->RF1R & CAN_RF1R_FMP1) != 0)) ||
+             (((CANx->IER & CAN_IT_FF1) != 0) && ((CANx->RF1R & CAN_RF1R_FULL1) != 0)) ||
+             (((CANx->IER & CAN_IT_FOV1) != 0) && ((CANx->RF1R & CAN_RF1R_FOVR1) != 0));
+#ifdef STM32F10X_CL
+    case CAN2_SCE_IRQn:
+      CANx = CAN2;
+#endif /* STM32F10X_CL */
+    case CAN1_SCE_IRQn:
+      return (((CANx->IER & CAN_IT_ERR) != 0) && ((CANx->MSR & CAN_MSR_ERRI) != 0)) ||
+             (((CANx->IER & CAN_IT_WKU) != 0) && ((CANx->MSR & CAN_MSR_WKUI) != 0)) ||
+             (((CANx->IER & CAN_IT_SLK) != 0) && ((CANx->MSR & CAN_MSR_SLAKI) != 0));
+    default:
+      return false;
+  }
+}
+
+/**
+  * @brief  Set the hook run before a transmit status flag is cleared.
+  * @param  [in] Hook: Called with the controller, after the handler read the status
+  *                    and before the clear takes effect, 0 for none.
+  * @return None.
+  * @note   The hook stands for a mailbox completing in that window, see BxCAN_CompleteTransmit().
+  */
+void BxCAN_SetClearHook(void (*Hook)(CAN_TypeDef *CANx))
+{
+  bxcanClearHook = Hook;
+}
+
+/**
+  * @brief  Complete the oldest pending request of a controller as sent, off the bus.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @retval true:      A mailbox completed.
+  * @retval false:     No request is pending besides the frame on the bus.
+  * @note   The frame takes no bus time and reaches neither the bus monitor nor other nodes.
+  */
+bool BxCAN_CompleteTransmit(CAN_TypeDef *CANx)
+{
+  uint32_t x       = bxcan_index(CANx);
+  int32_t  mailbox = -1;
+  
+  bxcan_sync(x);
+  
+  for(int32_t m = 0; m < 3; m++)
+  {
+    if(((CANx->sTxMailBox[m].TIR & CAN_TI0R_TXRQ) == 0) || ((bxcanBusy == true) && (bxcanWinner == (int32_t)x) && (bxcanMailbox[x] == m)))
+    {
+      continue;
+    }
+    
+    if((mailbox < 0) || (bxcanController[x].TxOrder[m] < bxcanController[x].TxOrder[mailbox]))
+    {
+      mailbox = m;
+    }
+  }
+  
+  if(mailbox < 0)
+  {
+    return false;
+  }
+  
+  bxcan_transmit_done(x, mailbox, BxCAN_TransmitOk, BXCAN_LEC_NONE);
+  
+  return true;
+}
+
+/**
+  * @brief  Get the model statistics.
+  * @param  [out] Statistics: The statistics.
+  * @return None.
+  */
+void BxCAN_GetStatistics(BxCAN_Statistics *Statistics)
+{
+  *Statistics = bxcanStatistics;
+}
+
+/**
+  * @brief  Set the bus time when an external bus drives the controllers.
+  * @param  [in] Time: The bus time in nanoseconds, for the receive time stamps.
+  * @return None.
+  * @note   The port functions below let a bus outside the model, Host/VirtualBus, take
+  *         the place of BxCAN_Run(). The bus statistics are then kept by that bus.
+  */
+void BxCAN_PortSetTime(uint64_t Time)
+{
+  bxcanTime = Time * 1000;
+}
+
+/**
+  * @brief  Get the bit time of a controller.
+  * @param  [in] Node: BXCAN_NODE_CAN1 or BXCAN_NODE_CAN2.
+  * @return The bit time in picoseconds.
+  */
+uint64_t BxCAN_PortGetBitTime(int32_t Node)
+{
+  return bxcan_get_bit_time(Node);
+}
+
+/**
+  * @brief  Get the frame a controller puts up for arbitration.
+  * @param  [in] Node:   BXCAN_NODE_CAN1 or BXCAN_NODE_CAN2.
+  * @param  [out] Frame: The frame, TXRQ set.
+  * @retval true:        A request is pending, BxCAN_PortTransmitDone() must follow.
+  * @retval false:       Nothing to send, or the controller is not on the bus.
+  */
+bool BxCAN_PortGetRequest(int32_t Node, BxCAN_Frame *Frame)
+{
+  int32_t m = bxcan_get_mailbox(Node);
+  
+  bxcanMailbox[Node] = m;
+  
+  if(m < 0)
+  {
+    return false;
+  }
+  
+  Frame->IR  = hostCAN[Node].sTxMailBox[m].TIR;
+  Frame->DTR = hostCAN[Node].sTxMailBox[m].TDTR;
+  Frame->DLR = hostCAN[Node].sTxMailBox[m].TDLR;
+  Frame->DHR = hostCAN[Node].sTxMailBox[m].TDHR;
+  
+  return true;
+}
+
+/**
+  * @brief  End the transmission of the frame got from BxCAN_PortGetRequest().
+  * @param  [in] Node:   BXCAN_NODE_CAN1 or BXCAN_NODE_CAN2.
+  * @param  [in] Result: Sent, lost arbitration, or aborted by an error.
+  * @param  [in] Lec:    The error, BXCAN_LEC_xxx, for BxCAN_TransmitError.
+  * @return None.
+  * @note   Without automatic retransmission a failed request completes with ALST or
+  *         TERR, else it stays pending for the next arbitration.
+  */
+void BxCAN_PortTransmitDone(int32_t Node, BxCAN_TransmitResult Result, uint32_t Lec)
+{
+  bxcan_transmit_done(Node, bxcanMailbox[Node], Result, Lec);
+  bxcanMailbox[Node] = -1;
+  
+  Core_Update();
+}
+
+/**
+  * @brief  Does a controller receive and acknowledge frames from the bus?
+  * @param  [in] Node: BXCAN_NODE_CAN1 or BXCAN_NODE_CAN2.
+  * @retval true:      In normal or silent mode and not in bus-off.
+  * @retval false:     Off the bus.
+  */
+bool BxCAN_PortIsListening(int32_t Node)
+{
+  return (bxcan_is_active(Node) == true) && ((hostCAN[Node].BTR & CAN_BTR_LBKM) == 0) && (bxcanController[Node].Tec <= 255);
+}
+
+/**
+  * @brief  Hand a frame from the bus to a controller.
+  * @param  [in] Node:  BXCAN_NODE_CAN1 or BXCAN_NODE_CAN2.
+  * @param  [in] Frame: The frame.
+  * @param  [in] Lec:   BXCAN_LEC_NONE for a valid frame, else the error that destroyed it.
+  * @return None.
+  */
+void BxCAN_PortReceive(int32_t Node, const BxCAN_Frame *Frame, uint32_t Lec)
+{
+  BxCAN_Controller *controller = &bxcanController[Node];
+  
+  if(BxCAN_PortIsListening(Node) != true)
+  {
+    return;
+  }
+  
+  if(Lec != BXCAN_LEC_NONE)
+  {
+    controller->Rec++;
+  }
+  else
+  {
+    if(controller->Rec > 127)
+    {
+      controller->Rec = 120;
+    }
+    else if(controller->Rec > 0)
+    {
+      controller->Rec--;
+    }
+    
+    bxcan_receive(Node, Frame);
+  }
+  
+  bxcan_error_update(Node, Lec);
+  Core_Update();
+}
+
+/**
+  * @brief  Count recessive bus time towards the bus-off recovery of a controller.
+  * @param  [in] Node:   BXCAN_NODE_CAN1 or BXCAN_NODE_CAN2.
+  * @param  [in] Number: Occurrences of 11 consecutive recessive bits.
+  * @return None.
+  * @note   With automatic bus-off management the controller rejoins the bus after 128
+  *         occurrences, else it stays off until it is initialized again.
+  */
+void BxCAN_PortRecessive(int32_t Node, uint32_t Number)
+{
+  BxCAN_Controller *controller = &bxcanController[Node];
+  
+  if((controller->Tec <= 255) || ((hostCAN[Node].MCR & CAN_MCR_ABOM) == 0) || (bxcan_is_active(Node) != true))
+  {
+    return;
+  }
+  
+  controller->Recessive += Number;
+  
+  if(controller->Recessive >= BXCAN_BUS_OFF_RECOVERY)
+  {
+    controller->Tec       = 0;
+    controller->Rec       = 0;
+    controller->Recessive = 0;
+    
+    bxcan_error_update(Node, BXCAN_LEC_NONE);
+    Core_Update();
+  }
+}
+
+/**
+  * @brief  Set the error counters of a controller.
+  * @param  [in] Node: BXCAN_NODE_CAN1 or BXCAN_NODE_CAN2.
+  * @param  [in] Tec:  Transmit error counter, above 255 puts the controller in bus-off.
+  * @param  [in] Rec:  Receive error counter.
+  * @return None.
+  */
+void BxCAN_PortSetErrorCounters(int32_t Node, uint32_t Tec, uint32_t Rec)
+{
+  bxcanController[Node].Tec       = Tec;
+  bxcanController[Node].Rec       = Rec;
+  bxcanController[Node].Recessive = 0;
+  
+  bxcan_error_update(Node, (hostCAN[Node].ESR & CAN_ESR_LEC) >> 4);
+  Core_Update();
+}
+
+/**
+  * @brief  Get the error counters of a controller.
+  * @param  [in] Node: BXCAN_NODE_CAN1 or BXCAN_NODE_CAN2.
+  * @param  [out] Tec: Transmit error counter, above 255 in bus-off.
+  * @param  [out] Rec: Receive error counter.
+  * @return None.
+  */
+void BxCAN_PortGetErrorCounters(int32_t Node, uint32_t *Tec, uint32_t *Rec)
+{
+  *Tec = bxcanController[Node].Tec;
+  *Rec = bxcanController[Node].Rec;
+}
+
+/**
+  * @brief  Reset a controller to its register reset values.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return None.
+  * @note   CAN1 holds the filter banks, resetting it resets them for both controllers.
+  */
+void CAN_DeInit(CAN_TypeDef *CANx)
+{
+  uint32_t x = bxcan_index(CANx);
+  
+  memset((void *)CANx, 0, offsetof(CAN_TypeDef, FMR));
+  memset(&bxcanController[x], 0, sizeof(bxcanController[x]));
+  
+  CANx->MCR = 0x00010002;
+  CANx->MSR = 0x00000C02;
+  CANx->TSR = 0x1C000000;
+  CANx->BTR = 0x01230000;
+  
+  if(CANx == CAN1)
+  {
+    memset((void *)&CANx->FMR, 0, sizeof(CAN_TypeDef) - offsetof(CAN_TypeDef, FMR));
+    CANx->FMR = 0x2A1C0E01;
+  }
+}
+
+/**
+  * @brief  Initialize a controller and leave initialization mode.
+  * @param  [in] CANx:           Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] CAN_InitStruct: The configuration.
+  * @return CAN_InitStatus_Success.
+  */
+uint8_t CAN_Init(CAN_TypeDef *CANx, CAN_InitTypeDef *CAN_InitStruct)
+{
+  uint32_t mcr = CANx->MCR & ~(CAN_MCR_SLEEP | CAN_MCR_TTCM | CAN_MCR_ABOM | CAN_MCR_AWUM | CAN_MCR_NART | CAN_MCR_RFLM | CAN_MCR_TXFP);
+  
+  mcr |= (CAN_InitStruct->CAN_TTCM == ENABLE) ? CAN_MCR_TTCM : 0;
+  mcr |= (CAN_InitStruct->CAN_ABOM == ENABLE) ? CAN_MCR_ABOM : 0;
+  mcr |= (CAN_InitStruct->CAN_AWUM == ENABLE) ? CAN_MCR_AWUM : 0;
+  mcr |= (CAN_InitStruct->CAN_NART == ENABLE) ? CAN_MCR_NART : 0;
+  mcr |= (CAN_InitStruct->CAN_RFLM == ENABLE) ? CAN_MCR_RFLM : 0;
+  mcr |= (CAN_InitStruct->CAN_TXFP == ENABLE) ? CAN_MCR_TXFP : 0;
+  
+  CANx->MCR = mcr & ~CAN_MCR_INRQ;
+  CANx->MSR = CANx->MSR & ~(CAN_MSR_INAK | CAN_MSR_SLAK);
+  CANx->BTR = ((uint32_t)CAN_InitStruct->CAN_Mode << 30) | ((uint32_t)CAN_InitStruct->CAN_SJW << 24) |
+              ((uint32_t)CAN_InitStruct->CAN_BS1 << 16) | ((uint32_t)CAN_InitStruct->CAN_BS2 << 20) |
+              ((uint32_t)CAN_InitStruct->CAN_Prescaler - 1);
+  
+  return CAN_InitStatus_Success;
+}
+
+/**
+  * @brief  Initialize a filter bank, in the CAN1 registers like the real driver.
+  * @param  [in] CAN_FilterInitStruct: The filter bank.
+  * @return None.
+  */
+void CAN_FilterInit(CAN_FilterInitTypeDef *CAN_FilterInitStruct)
+{
+  uint32_t bank = CAN_FilterInitStruct->CAN_FilterNumber;
+  uint32_t bit  = 1UL << bank;
+  
+  CAN1->FMR  |= CAN_FMR_FINIT;
+  CAN1->FA1R &= ~bit;
+  
+  if(CAN_FilterInitStruct->CAN_FilterScale == CAN_FilterScale_16bit)
+  {
+    CAN1->FS1R &= ~bit;
+    CAN1->sFilterRegister[bank].FR1 = ((uint32_t)CAN_FilterInitStruct->CAN_FilterMaskIdLow << 16) | CAN_FilterInitStruct->CAN_FilterIdLow;
+    CAN1->sFilterRegister[bank].FR2 = ((uint32_t)CAN_FilterInitStruct->CAN_FilterMaskIdHigh << 16) | CAN_FilterInitStruct->CAN_FilterIdHigh;
+  }
+  else
+  {
+    CAN1->FS1R |= bit;
+    CAN1->sFilterRegister[bank].FR1 = ((uint32_t)CAN_FilterInitStruct->CAN_FilterIdHigh << 16) | CAN_FilterInitStruct->CAN_FilterIdLow;
+    CAN1->sFilterRegister[bank].FR2 = ((uint32_t)CAN_FilterInitStruct->CAN_FilterMaskIdHigh << 16) | CAN_FilterInitStruct->CAN_FilterMaskIdLow;
+  }
+  
+  if(CAN_FilterInitStruct->CAN_FilterMode == CAN_FilterMode_IdMask)
+  {
+    CAN1->FM1R &= ~bit;
+  }
+  else
+  {
+    CAN1->FM1R |= bit;
+  }
+  
+  if(CAN_FilterInitStruct->CAN_FilterFIFOAssignment == CAN_Filter_FIFO0)
+  {
+    CAN1->FFA1R &= ~bit;
+  }
+  else
+  {
+    CAN1->FFA1R |= bit;
+  }
+  
+  if(CAN_FilterInitStruct->CAN_FilterActivation == ENABLE)
+  {
+    CAN1->FA1R |= bit;
+  }
+  
+  CAN1->FMR &= ~CAN_FMR_FINIT;
+}
+
+/**
+  * @brief  Set the first filter bank of CAN2.
+  * @param  [in] CAN_BankNumber: The first bank of CAN2, the banks below belong to CAN1.
+  * @return None.
+  */
+void CAN_SlaveStartBank(uint8_t CAN_BankNumber)
+{
+  CAN1->FMR |= CAN_FMR_FINIT;
+  CAN1->FMR  = (CAN1->FMR & ~CAN_FMR_CAN2SB) | ((uint32_t)CAN_BankNumber << 8);
+  CAN1->FMR &= ~CAN_FMR_FINIT;
+}
+
+/**
+  * @brief  Enable or disable interrupts.
+  * @param  [in] CANx:     Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] CAN_IT:   The interrupts.
+  * @param  [in] NewState: ENABLE or DISABLE.
+  * @return None.
+  */
+void CAN_ITConfig(CAN_TypeDef *CANx, uint32_t CAN_IT, FunctionalState NewState)
+{
+  if(NewState == ENABLE)
+  {
+    CANx->IER |= CAN_IT;
+  }
+  else
+  {
+    CANx->IER &= ~CAN_IT;
+  }
+  
+  Core_Update();
+}
+
+/**
+  * @brief  Write a message into the first empty mailbox and request its transmission.
+  * @param  [in] CANx:      Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] TxMessage: The message.
+  * @return The mailbox, or CAN_TxStatus_NoMailBox.
+  */
+uint8_t CAN_Transmit(CAN_TypeDef *CANx, CanTxMsg *TxMessage)
+{
+  BxCAN_Frame frame   = {0};
+  uint8_t     mailbox = 0;
+  
+  if((CANx->TSR & CAN_TSR_TME0) != 0)
+  {
+    mailbox = 0;
+  }
+  else if((CANx->TSR & CAN_TSR_TME1) != 0)
+  {
+    mailbox = 1;
+  }
+  else if((CANx->TSR & CAN_TSR_TME2) != 0)
+  {
+    mailbox = 2;
+  }
+  else
+  {
+    return CAN_TxStatus_NoMailBox;
+  }
+  
+  bxcan_encode(TxMessage, &frame);
+  
+  CANx->sTxMailBox[mailbox].TDTR = (CANx->sTxMailBox[mailbox].TDTR & ~CAN_TDT0R_DLC) | frame.DTR;
+  CANx->sTxMailBox[mailbox].TDLR = frame.DLR;
+  CANx->sTxMailBox[mailbox].TDHR = frame.DHR;
+  CANx->sTxMailBox[mailbox].TIR  = frame.IR | CAN_TI0R_TXRQ;
+  
+  bxcan_sync(bxcan_index(CANx));
+  
+  return mailbox;
+}
+
+/**
+  * @brief  Get the transmission status of a mailbox.
+  * @param  [in] CANx:            Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] TransmitMailbox: The mailbox.
+  * @return CAN_TxStatus_Ok, CAN_TxStatus_Failed or CAN_TxStatus_Pending.
+  */
+uint8_t CAN_TransmitStatus(CAN_TypeDef *CANx, uint8_t TransmitMailbox)
+{
+  uint32_t m     = TransmitMailbox;
+  uint32_t state = CANx->TSR & (BXCAN_TSR_RQCP(m) | BXCAN_TSR_TXOK(m) | BXCAN_TSR_TME(m));
+  
+  if(state == 0)
+  {
+    return CAN_TxStatus_Pending;
+  }
+  else if(state == (BXCAN_TSR_RQCP(m) | BXCAN_TSR_TXOK(m) | BXCAN_TSR_TME(m)))
+  {
+    return CAN_TxStatus_Ok;
+  }
+  else
+  {
+    return CAN_TxStatus_Failed;
+  }
+}
+
+/**
+  * @brief  Abort the request of a mailbox.
+  * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Mailbox: The mailbox.
+  * @return None.
+  * @note   Like the hardware, a mailbox whose frame is on the bus is not aborted.
+  */
+void CAN_CancelTransmit(CAN_TypeDef *CANx, uint8_t Mailbox)
+{
+  uint32_t x = bxcan_index(CANx);
+  
+  if((bxcanBusy == true) && (bxcanWinner == (int32_t)x) && (bxcanMailbox[x] == Mailbox))
+  {
+    return;
+  }
+  
+  if((CANx->sTxMailBox[Mailbox].TIR & CAN_TI0R_TXRQ) != 0)
+  {
+    CANx->sTxMailBox[Mailbox].TIR &= ~CAN_TI0R_TXRQ;
+    CANx->TSR = (CANx->TSR & ~BXCAN_TSR_TXOK(Mailbox)) | BXCAN_TSR_RQCP(Mailbox) | BXCAN_TSR_TME(Mailbox);
+    
+    bxcanController[x].TxPending &= ~(1UL << Mailbox);
+    
+    bxcan_sync(x);
+    Core_Update();
+  }
+}
+
+/**
+  * @brief  Read the oldest message of a FIFO and release it.
+  * @param  [in] CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] FIFONumber: CAN_FIFO0 or CAN_FIFO1.
+  * @param  [out] RxMessage: The message.
+  * @return None.
+  */
+void CAN_Receive(CAN_TypeDef *CANx, uint8_t FIFONumber, CanRxMsg *RxMessage)
+{
+  BxCAN_Frame frame = {0};
+  
+  frame.IR  = CANx->sFIFOMailBox[FIFONumber].RIR;
+  frame.DTR = CANx->sFIFOMailBox[FIFONumber].RDTR;
+  frame.DLR = CANx->sFIFOMailBox[FIFONumber].RDLR;
+  frame.DHR = CANx->sFIFOMailBox[FIFONumber].RDHR;
+  
+  bxcan_decode(&frame, RxMessage);
+  
+  CAN_FIFORelease(CANx, FIFONumber);
+}
+
+/**
+  * @brief  Release the oldest message of a FIFO.
+  * @param  [in] CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] FIFONumber: CAN_FIFO0 or CAN_FIFO1.
+  * @return None.
+  */
+void CAN_FIFORelease(CAN_TypeDef *CANx, uint8_t FIFONumber)
+{
+  uint32_t          x          = bxcan_index(CANx);
+  BxCAN_Controller *controller = &bxcanController[x];
+  
+  if(controller->FifoNumber[FIFONumber] > 0)
+  {
+    controller->FifoNumber[FIFONumber]--;
+    memmove(&controller->Fifo[FIFONumber][0], &controller->Fifo[FIFONumber][1], sizeof(BxCAN_Frame) * controller->FifoNumber[FIFONumber]);
+    
+    bxcan_fifo_update(x, FIFONumber);
+  }
+}
+
+/**
+  * @brief  Get the number of messages in a FIFO.
+  * @param  [in] CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] FIFONumber: CAN_FIFO0 or CAN_FIFO1.
+  * @return The number of messages.
+  */
+uint8_t CAN_MessagePending(CAN_TypeDef *CANx, uint8_t FIFONumber)
+{
+  if(FIFONumber == CAN_FIFO0)
+  {
+    return CANx->RF0R & CAN_RF0R_FMP0;
+  }
+  else
+  {
+    return CANx->RF1R & CAN_RF1R_FMP1;
+  }
+}
+
+/**
+  * @brief  Get the status of an enabled interrupt.
+  * @param  [in] CANx:   Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] CAN_IT: The interrupt.
+  * @return SET or RESET, always RESET for a disabled interrupt.
+  */
+ITStatus CAN_GetITStatus(CAN_TypeDef *CANx, uint32_t CAN_IT)
+{
+  uint32_t status = 0;
+  
+  if((CANx->IER & CAN_IT) == 0)
+  {
+    return RESET;
+  }
+  
+  switch(CAN_IT)
+  {
+    case CAN_IT_TME:  status = CANx->TSR & (CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2); break;
+    case CAN_IT_FMP0: status = CANx->RF0R & CAN_RF0R_FMP0;                                  break;
+    case CAN_IT_FF0:  status = CANx->RF0R & CAN_RF0R_FULL0;                                 break;
+    case CAN_IT_FOV0: status = CANx->RF0R & CAN_RF0R_FOVR0;                                 break;
+    case CAN_IT_FMP1: status = CANx->RF1R & CAN_RF1R_FMP1;                                  break;
+    case CAN_IT_FF1:  status = CANx->RF1R & CAN_RF1R_FULL1;                                 break;
+    case CAN_IT_FOV1: status = CANx->RF1R & CAN_RF1R_FOVR1;                                 break;
+    case CAN_IT_WKU:  status = CANx->MSR & CAN_MSR_WKUI;                                    break;
+    case CAN_IT_SLK:  status = CANx->MSR & CAN_MSR_SLAKI;                                   break;
+    case CAN_IT_EWG:  status = CANx->ESR & CAN_ESR_EWGF;                                    break;
+    case CAN_IT_EPV:  status = CANx->ESR & CAN_ESR_EPVF;                                    break;
+    case CAN_IT_BOF:  status = CANx->ESR & CAN_ESR_BOFF;                                    break;
+    case CAN_IT_LEC:  status = CANx->ESR & CAN_ESR_LEC;                                     break;
+    case CAN_IT_ERR:  status = CANx->MSR & CAN_MSR_ERRI;                                    break;
+    default:          status = 0;                                                           break;
+  }
+  
+  return (status != 0) ? SET : RESET;
+}
+
+/**
+  * @brief  Clear the pending bit of an interrupt.
+  * @param  [in] CANx:   Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] CAN_IT: The interrupt.
+  * @return None.
+  * @note   Clearing CAN_IT_TME clears the request completed bits and with them the
+  *         TXOK, ALST and TERR status of all mailboxes, as on the hardware.
+  */
+void CAN_ClearITPendingBit(CAN_TypeDef *CANx, uint32_t CAN_IT)
+{
+  switch(CAN_IT)
+  {
+    case CAN_IT_TME:
+      if(bxcanClearHook != 0)
+      {
+        bxcanClearHook(CANx);
+      }
+      
+      for(uint32_t m = 0; m < 3; m++)
+      {
+        if((CANx->TSR & BXCAN_TSR_RQCP(m)) != 0)
+        {
+          CANx->TSR &= ~(BXCAN_TSR_RQCP(m) | BXCAN_TSR_TXOK(m) | BXCAN_TSR_ALST(m) | BXCAN_TSR_TERR(m));
+        }
+      }
+      break;
+    case CAN_IT_FF0:  CANx->RF0R &= ~CAN_RF0R_FULL0; break;
+    case CAN_IT_FOV0: CANx->RF0R &= ~CAN_RF0R_FOVR0; break;
+    case CAN_IT_FF1:  CANx->RF1R &= ~CAN_RF1R_FULL1; break;
+    case CAN_IT_FOV1: CANx->RF1R &= ~CAN_RF1R_FOVR1; break;
+    case CAN_IT_WKU:  CANx->MSR  &= ~CAN_MSR_WKUI;   break;
+    case CAN_IT_SLK:  CANx->MSR  &= ~CAN_MSR_SLAKI;  break;
+    case CAN_IT_LEC:  CANx->ESR  &= ~CAN_ESR_LEC;    break;
+    case CAN_IT_ERR:  CANx->MSR  &= ~CAN_MSR_ERRI;   break;
+    default:                                         break;
+  }
+}
+
+/**
+  * @brief  Clear a status flag.
+  * @param  [in] CANx:     Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] CAN_FLAG: CAN_FLAG_RQCP0, CAN_FLAG_RQCP1 or CAN_FLAG_RQCP2.
+  * @return None.
+  * @note   Like the rc_w1 write of the hardware, clearing the request completed bit of
+  *         a mailbox clears its TXOK, ALST and TERR, the other mailboxes are left alone.
+  */
+void CAN_ClearFlag(CAN_TypeDef *CANx, uint32_t CAN_FLAG)
+{
+  if(bxcanClearHook != 0)
+  {
+    bxcanClearHook(CANx);
+  }
+  
+  for(uint32_t m = 0; m < 3; m++)
+  {
+    if((CAN_FLAG & 0x000FFFFF) == BXCAN_TSR_RQCP(m))
+    {
+      CANx->TSR &= ~(BXCAN_TSR_RQCP(m) | BXCAN_TSR_TXOK(m) | BXCAN_TSR_ALST(m) | BXCAN_TSR_TERR(m));
+    }
+  }
+}
+
+/**
+  * @brief  Get the model index of a controller.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return 0 for CAN1, 1 for CAN2.
+  */
+static uint32_t bxcan_index(CAN_TypeDef *CANx)
+{
+  return (CANx == CAN1) ? 0 : 1;
+}
+
+/**
+  * @brief  Is a controller taking part in bus traffic?
+  * @param  [in] x: The controller index.
+  * @retval true:   In normal mode.
+  * @retval false:  In initialization or sleep mode.
+  */
+static bool bxcan_is_active(uint32_t x)
+{
+  return (x < BXCAN_CONTROLLER_NUMBER) && ((hostCAN[x].MCR & (CAN_MCR_INRQ | CAN_MCR_SLEEP)) == 0);
+}
+
+/**
+  * @brief  Pick up transmit requests written to the mailbox registers.
+  * @param  [in] x: The controller index.
+  * @return None.
+  * @note   Setting TXRQ empties the mailbox and clears its completion status, and the
+  *         request order is recorded for transmit FIFO priority, also when firmware
+  *         writes the registers directly.
+  */
+static void bxcan_sync(uint32_t x)
+{
+  CAN_TypeDef      *CANx       = &hostCAN[x];
+  BxCAN_Controller *controller = &bxcanController[x];
+  
+  for(uint32_t m = 0; m < 3; m++)
+  {
+    if(((CANx->sTxMailBox[m].TIR & CAN_TI0R_TXRQ) != 0) && ((controller->TxPending & (1UL << m)) == 0))
+    {
+      controller->TxPending |= 1UL << m;
+      controller->TxOrder[m] = bxcanSequence++;
+      
+      CANx->TSR &= ~(BXCAN_TSR_TME(m) | BXCAN_TSR_RQCP(m) | BXCAN_TSR_TXOK(m) | BXCAN_TSR_ALST(m) | BXCAN_TSR_TERR(m));
+    }
+  }
+  
+  for(uint32_t m = 0; m < 3; m++)
+  {
+    if((CANx->TSR & BXCAN_TSR_TME(m)) != 0)
+    {
+      CANx->TSR = (CANx->TSR & ~CAN_TSR_CODE) | (m << 24);
+      break;
+    }
+  }
+}
+
+/**
+  * @brief  Get the mailbox a controller puts up for arbitration.
+  * @param  [in] x: The controller index.
+  * @return The mailbox, -1 if none is pending.
+  * @note   The oldest request with transmit FIFO priority, else the highest priority
+  *         identifier, the lower mailbox on a tie.
+  */
+static int32_t bxcan_get_mailbox(uint32_t x)
+{
+  CAN_TypeDef      *CANx       = &hostCAN[x];
+  BxCAN_Controller *controller = &bxcanController[x];
+  int32_t           mailbox    = -1;
+  
+  if((bxcan_is_active(x) != true) || ((CANx->BTR & (CAN_BTR_SILM | CAN_BTR_LBKM)) == CAN_BTR_SILM) || (controller->Tec > 255))
+  {
+    return -1;
+  }
+  
+  bxcan_sync(x);
+  
+  for(int32_t m = 0; m < 3; m++)
+  {
+    if((CANx->sTxMailBox[m].TIR & CAN_TI0R_TXRQ) == 0)
+    {
+      continue;
+    }
+    
+    if(mailbox < 0)
+    {
+      mailbox = m;
+    }
+    else if((CANx->MCR & CAN_MCR_TXFP) != 0)
+    {
+      if(controller->TxOrder[m] < controller->TxOrder[mailbox])
+      {
+        mailbox = m;
+      }
+    }
+    else if(bxcan_get_key(CANx->sTxMailBox[m].TIR) < bxcan_get_key(CANx->sTxMailBox[mailbox].TIR))
+    {
+      mailbox = m;
+    }
+  }
+  
+  return mailbox;
+}
+
+/**
+  * @brief  End the transmission of a mailbox.
+  * @param  [in] x:       The controller index.
+  * @param  [in] Mailbox: The mailbox, -1 for none.
+  * @param  [in] Result:  Sent, lost arbitration, or aborted by an error.
+  * @param  [in] Lec:     The error, BXCAN_LEC_xxx, for BxCAN_TransmitError.
+  * @return None.
+  * @note   An error adds 8 to the transmit error counter, except for an acknowledgment
+  *         error of an error passive node, a success takes 1 off.
+  */
+static void bxcan_transmit_done(uint32_t x, int32_t Mailbox, BxCAN_TransmitResult Result, uint32_t Lec)
+{
+  CAN_TypeDef      *CANx       = &hostCAN[x];
+  BxCAN_Controller *controller = &bxcanController[x];
+  uint32_t          m          = Mailbox;
+  
+  if((Mailbox < 0) || ((CANx->sTxMailBox[m].TIR & CAN_TI0R_TXRQ) == 0))
+  {
+    return;
+  }
+  
+  if(Result == BxCAN_TransmitOk)
+  {
+    CANx->sTxMailBox[m].TIR &= ~CAN_TI0R_TXRQ;
+    CANx->TSR = (CANx->TSR & ~(BXCAN_TSR_ALST(m) | BXCAN_TSR_TERR(m))) | BXCAN_TSR_RQCP(m) | BXCAN_TSR_TXOK(m) | BXCAN_TSR_TME(m);
+    controller->TxPending &= ~(1UL << m);
+    
+    if(controller->Tec > 0)
+    {
+      controller->Tec--;
+    }
+    
+    bxcan_error_update(x, BXCAN_LEC_NONE);
+  }
+  else
+  {
+    if(Result == BxCAN_TransmitError)
+    {
+      bxcanStatistics.TransmitError[x]++;
+      
+      if((Lec != BXCAN_LEC_ACK) || (controller->Tec < 128))
+      {
+        controller->Tec += 8;
+      }
+      
+      CANx->TSR |= BXCAN_TSR_TERR(m);
+      bxcan_error_update(x, Lec);
+    }
+    
+    if((CANx->MCR & CAN_MCR_NART) != 0)
+    {
+      CANx->sTxMailBox[m].TIR &= ~CAN_TI0R_TXRQ;
+      CANx->TSR = (CANx->TSR & ~BXCAN_TSR_TXOK(m)) | BXCAN_TSR_RQCP(m) | BXCAN_TSR_TME(m);
+      controller->TxPending &= ~(1UL << m);
+      
+      if(Result == BxCAN_TransmitArbitrationLost)
+      {
+        CANx->TSR |= BXCAN_TSR_ALST(m);
+        bxcanStatistics.ArbitrationLost[x]++;
+      }
+    }
+  }
+  
+  bxcan_sync(x);
+}
+
+/**
+  * @brief  Show the error counters and the last error in CAN_ESR.
+  * @param  [in] x:   The controller index.
+  * @param  [in] Lec: The last error code, BXCAN_LEC_NONE after a successful frame.
+  * @return None.
+  * @note   Sets the error interrupt flag for an enabled warning, passive or bus-off
+  *         state entered, or an error code with CAN_IT_LEC enabled.
+  */
+static void bxcan_error_update(uint32_t x, uint32_t Lec)
+{
+  CAN_TypeDef      *CANx       = &hostCAN[x];
+  BxCAN_Controller *controller = &bxcanController[x];
+  uint32_t          esr        = 0;
+  uint32_t          rising     = 0;
+  
+  esr |= (controller->Tec > 255) ? CAN_ESR_BOFF : 0;
+  esr |= ((controller->Tec > 127) || (controller->Rec > 127)) ? CAN_ESR_EPVF : 0;
+  esr |= ((controller->Tec >= 96) || (controller->Rec >= 96)) ? CAN_ESR_EWGF : 0;
+  esr |= ((Lec << 4) & CAN_ESR_LEC);
+  esr |= (((controller->Tec > 255) ? 255 : controller->Tec) << 16);
+  esr |= (((controller->Rec > 255) ? 255 : controller->Rec) << 24);
+  
+  rising    = esr & ~CANx->ESR;
+  CANx->ESR = esr;
+  
+  if(((CANx->IER & CAN_IT_ERR) != 0) &&
+     ((((rising & CAN_ESR_EWGF) != 0) && ((CANx->IER & CAN_IT_EWG) != 0)) ||
+      (((rising & CAN_ESR_EPVF) != 0) && ((CANx->IER & CAN_IT_EPV) != 0)) ||
+      (((rising & CAN_ESR_BOFF) != 0) && ((CANx->IER & CAN_IT_BOF) != 0)) ||
+      ((Lec != BXCAN_LEC_NONE) && ((CANx->IER & CAN_IT_LEC) != 0))))
+  {
+    CANx->MSR |= CAN_MSR_ERRI;
+  }
+}
+
+/**
+  * @brief  Encode a message into the mailbox register layout.
+  * @param  [in] Message: The message.
+  * @param  [out] Frame:  The register image, TXRQ clear.
+  * @return None.
+  */
+static void bxcan_encode(const CanTxMsg *Message, BxCAN_Frame *Frame)
+{
+  if(Message->IDE == CAN_Id_Standard)
+  {
+    Frame->IR = (Message->StdId << 21) | Message->RTR;
+  }
+  else
+  {
+    Frame->IR = (Message->ExtId << 3) | Message->IDE | Message->RTR;
+  }
+  
+  Frame->DTR = Message->DLC & CAN_TDT0R_DLC;
+  Frame->DLR = ((uint32_t)Message->Data[3] << 24) | ((uint32_t)Message->Data[2] << 16) | ((uint32_t)Message->Data[1] << 8) | Message->Data[0];
+  Frame->DHR = ((uint32_t)Message->Data[7] << 24) | ((uint32_t)Message->Data[6] << 16) | ((uint32_t)Message->Data[5] << 8) | Message->Data[4];
+}
+
+/**
+  * @brief  Decode a FIFO mailbox register image like CAN_Receive() does.
+  * @param  [in] Frame:    The register image.
+  * @param  [out] Message: The message, only the identifier field of its type is written.
+  * @return None.
+  */
+static void bxcan_decode(const BxCAN_Frame *Frame, CanRxMsg *Message)
+{
+  Message->IDE = Frame->IR & CAN_TI0R_IDE;
+  
+  if(Message->IDE == CAN_Id_Standard)
+  {
+    Message->StdId = (Frame->IR >> 21) & 0x7FF;
+  }
+  else
+  {
+    Message->ExtId = (Frame->IR >> 3) & 0x1FFFFFFF;
+  }
+  
+  Message->RTR = Frame->IR & CAN_TI0R_RTR;
+  Message->DLC = Frame->DTR & CAN_TDT0R_DLC;
+  Message->FMI = (Frame->DTR >> 8) & 0xFF;
+  
+  for(uint32_t i = 0; i < 4; i++)
+  {
+    Message->Data[i]     = (Frame->DLR >> (8 * i)) & 0xFF;
+    Message->Data[i + 4] = (Frame->DHR >> (8 * i)) & 0xFF;
+  }
+}
+
+/**
+  * @brief  Get the arbitration field of a frame as a number.
+  * @param  [in] IR: The identifier register.
+  * @return The lower value wins arbitration.
+  * @note   Base identifier, then RTR or SRR, then IDE, then for extended frames the
+  *         identifier extension and RTR, in bus order.
+  */
+static uint32_t bxcan_get_key(uint32_t IR)
+{
+  uint32_t base = IR >> 21;
+  uint32_t rtr  = (IR & CAN_TI0R_RTR) ? 1 : 0;
+  
+  if((IR & CAN_TI0R_IDE) == 0)
+  {
+    return (base << 21) | (rtr << 20);
+  }
+  else
+  {
+    return (base << 21) | (1UL << 20) | (1UL << 19) | (((IR >> 3) & 0x3FFFF) << 1) | rtr;
+  }
+}
+
+/**
+  * @brief  Get the length of a frame on the bus.
+  * @param  [in] Frame: The register image.
+  * @return Bits from start of frame to the end of the interframe space, without stuff bits.
+  */
+static uint32_t bxcan_get_bits(const BxCAN_Frame *Frame)
+{
+  uint32_t dlc  = Frame->DTR & CAN_TDT0R_DLC;
+  uint32_t bits = ((Frame->IR & CAN_TI0R_IDE) != 0) ? 67 : 47;
+  
+  if((Frame->IR & CAN_TI0R_RTR) == 0)
+  {
+    bits += 8 * ((dlc > 8) ? 8 : dlc);
+  }
+  
+  return bits;
+}
+
+/**
+  * @brief  Get the bit time of a node.
+  * @param  [in] Node: The controller index, or BXCAN_NODE_REMOTE for the bus rate.
+  * @return The bit time in picoseconds.
+  * @note   The remote node follows CAN1, or CAN2 when only CAN2 runs.
+  */
+static uint64_t bxcan_get_bit_time(int32_t Node)
+{
+  uint32_t btr = 0;
+  
+  if(Node == BXCAN_NODE_REMOTE)
+  {
+    if(bxcan_is_active(0) == true)
+    {
+      Node = 0;
+    }
+    else if(bxcan_is_active(1) == true)
+    {
+      Node = 1;
+    }
+    else
+    {
+      return BXCAN_DEFAULT_BIT_TIME;
+    }
+  }
+  
+  btr = hostCAN[Node].BTR;
+  
+  uint64_t brp = (btr & CAN_BTR_BRP) + 1;
+  uint64_t tq  = 1 + (((btr & CAN_BTR_TS1) >> 16) + 1) + (((btr & CAN_BTR_TS2) >> 20) + 1);
+  
+  return brp * tq * 1000000ULL / (HOST_PCLK1_FREQUENCY / 1000000);
+}
+
+/**
+  * @brief  Run a frame through the filter banks of a controller.
+  * @param  [in] x:     The controller index.
+  * @param  [in] IR:    The identifier register.
+  * @param  [out] Fifo: The FIFO of the matching filter.
+  * @return The filter match index, -1 if no active filter matches.
+  * @note   Filters are numbered per FIFO over all banks of the controller, active or not.
+  *         On several matches 32-bit beats 16-bit, list beats mask, then the lower number.
+  */
+static int32_t bxcan_filter(uint32_t x, uint32_t IR, uint32_t *Fifo)
+{
+  uint32_t first   = 0;
+  uint32_t last    = BXCAN_FILTER_BANK_NUMBER;
+  uint32_t number[2] = {0, 0};
+  uint32_t id32    = IR & ~CAN_TI0R_TXRQ;
+  uint32_t id16    = ((IR >> 21) << 5) | ((IR & CAN_TI0R_RTR) << 3) | ((IR & CAN_TI0R_IDE) << 1) | ((IR >> 18) & 0x7);
+  int32_t  match   = -1;
+  uint32_t rank    = 0;
+  
+#ifdef STM32F10X_CL
+  uint32_t start = (CAN1->FMR & CAN_FMR_CAN2SB) >> 8;
+  
+  if(x == 0)
+  {
+    last = start;
+  }
+  else
+  {
+    first = start;
+  }
+#endif /* STM32F10X_CL */
+  
+  if((CAN1->FMR & CAN_FMR_FINIT) != 0)
+  {
+    return -1;
+  }
+  
+  for(uint32_t bank = first; bank < last; bank++)
+  {
+    uint32_t bit    = 1UL << bank;
+    bool     scale  = ((CAN1->FS1R & bit) != 0);
+    bool     list   = ((CAN1->FM1R & bit) != 0);
+    uint32_t fifo   = ((CAN1->FFA1R & bit) != 0) ? 1 : 0;
+    uint32_t fr1    = CAN1->sFilterRegister[bank].FR1;
+    uint32_t fr2    = CAN1->sFilterRegister[bank].FR2;
+    uint32_t count  = scale ? (list ? 2 : 1) : (list ? 4 : 2);
+    uint32_t hit    = 0;                /* Bit k set when filter k of the bank matches. */
+    
+    if(scale == true)
+    {
+      if(list == true)
+      {
+        hit = ((id32 == (fr1 & ~1UL)) ? 1 : 0) | ((id32 == (fr2 & ~1UL)) ? 2 : 0);
+      }
+      else
+      {
+        hit = (((id32 ^ fr1) & fr2 & ~1UL) == 0) ? 1 : 0;
+      }
+    }
+    else
+    {
+      if(list == true)
+      {
+        hit = ((id16 == (fr1 & 0xFFFF)) ? 1 : 0) | ((id16 == (fr1 >> 16)) ? 2 : 0) |
+              ((id16 == (fr2 & 0xFFFF)) ? 4 : 0) | ((id16 == (fr2 >> 16)) ? 8 : 0);
+      }
+      else
+      {
+        hit = ((((id16 ^ fr1) & (fr1 >> 16) & 0xFFFF) == 0) ? 1 : 0) |
+              ((((id16 ^ fr2) & (fr2 >> 16) & 0xFFFF) == 0) ? 2 : 0);
+      }
+    }
+    
+    if(((CAN1->FA1R & bit) != 0) && (hit != 0))
+    {
+      uint32_t r = (scale ? 0 : 2) + (list ? 0 : 1);
+      
+      if((match < 0) || (r < rank))
+      {
+        match = number[fifo] + __builtin_ctz(hit);
+        rank  = r;
+        *Fifo = fifo;
+      }
+    }
+    
+    number[fifo] += count;
+  }
+  
+  return match;
+}
+
+/**
+  * @brief  Store a frame from the bus in a FIFO of a controller.
+  * @param  [in] x:     The controller index.
+  * @param  [in] Frame: The register image.
+  * @return None.
+  * @note   A full FIFO sets the overrun flag and, unless receive FIFO locked mode is set,
+  *         the new frame replaces the newest stored one.
+  */
+static void bxcan_receive(uint32_t x, const BxCAN_Frame *Frame)
+{
+  BxCAN_Controller *controller = &bxcanController[x];
+  BxCAN_Frame       frame      = *Frame;
+  uint32_t          fifo       = 0;
+  int32_t           fmi        = bxcan_filter(x, Frame->IR, &fifo);
+  __IO uint32_t    *rfr        = (fifo == 0) ? &hostCAN[x].RF0R : &hostCAN[x].RF1R;
+  
+  if(fmi < 0)
+  {
+    bxcanStatistics.Filtered[x]++;
+    return;
+  }
+  
+  frame.IR  &= ~CAN_TI0R_TXRQ;
+  frame.DTR  = (frame.DTR & CAN_TDT0R_DLC) | ((uint32_t)fmi << 8) | (((bxcanTime / bxcan_get_bit_time(x)) & 0xFFFF) << 16);
+  
+  if(controller->FifoNumber[fifo] >= BXCAN_FIFO_DEPTH)
+  {
+    bxcanStatistics.Overrun[x]++;
+    *rfr |= CAN_RF0R_FOVR0;
+    
+    if((hostCAN[x].MCR & CAN_MCR_RFLM) == 0)
+    {
+      controller->Fifo[fifo][BXCAN_FIFO_DEPTH - 1] = frame;
+    }
+  }
+  else
+  {
+    controller->Fifo[fifo][controller->FifoNumber[fifo]++] = frame;
+    
+    if(controller->FifoNumber[fifo] == BXCAN_FIFO_DEPTH)
+    {
+      *rfr |= CAN_RF0R_FULL0;
+    }
+  }
+  
+  bxcan_fifo_update(x, fifo);
+}
+
+/**
+  * @brief  Show the state of a FIFO in its registers.
+  * @param  [in] x:    The controller index.
+  * @param  [in] Fifo: The FIFO.
+  * @return None.
+  */
+static void bxcan_fifo_update(uint32_t x, uint32_t Fifo)
+{
+  BxCAN_Controller *controller = &bxcanController[x];
+  __IO uint32_t    *rfr        = (Fifo == 0) ? &hostCAN[x].RF0R : &hostCAN[x].RF1R;
+  
+  *rfr = (*rfr & ~CAN_RF0R_FMP0) | controller->FifoNumber[Fifo];
+  
+  if(controller->FifoNumber[Fifo] > 0)
+  {
+    hostCAN[x].sFIFOMailBox[Fifo].RIR  = controller->Fifo[Fifo][0].IR;
+    hostCAN[x].sFIFOMailBox[Fifo].RDTR = controller->Fifo[Fifo][0].DTR;
+    hostCAN[x].sFIFOMailBox[Fifo].RDLR = controller->Fifo[Fifo][0].DLR;
+    hostCAN[x].sFIFOMailBox[Fifo].RDHR = controller->Fifo[Fifo][0].DHR;
+  }
+}
+
+/**
+  * @brief  Simulate the bus.
+  * @param  [in] Limit: The end time in picoseconds.
+  * @param  [in] Idle:  Stop when nothing is pending instead of running to the end time.
+  * @return The number of frames completed.
+  */
+static uint32_t bxcan_run(uint64_t Limit, bool Idle)
+{
+  uint32_t frames = 0;
+  
+  for(;;)
+  {
+    /* Arbitration, among the requests pending when the bus becomes idle. */
+    if(bxcanBusy != true)
+    {
+      uint64_t key = UINT64_MAX;
+      
+      bxcanStart  = (bxcanTime > bxcanBusIdle) ? bxcanTime : bxcanBusIdle;
+      bxcanWinner = BXCAN_NODE_REMOTE;
+      
+      if(bxcanStart > Limit)
+      {
+        break;
+      }
+      
+      for(uint32_t x = 0; x < BXCAN_CONTROLLER_NUMBER; x++)
+      {
+        bxcanMailbox[x] = bxcan_get_mailbox(x);
+        
+        if((bxcanMailbox[x] >= 0) && (bxcan_get_key(hostCAN[x].sTxMailBox[bxcanMailbox[x]].TIR) < key))
+        {
+          key         = bxcan_get_key(hostCAN[x].sTxMailBox[bxcanMailbox[x]].TIR);
+          bxcanWinner = x;
+        }
+      }
+      
+      if(bxcanRemoteIn != bxcanRemoteOut)
+      {
+        BxCAN_Frame remote = {0};
+        
+        bxcan_encode(&bxcanRemote[bxcanRemoteOut & (BXCAN_REMOTE_QUEUE_SIZE - 1)], &remote);
+        
+        if(bxcan_get_key(remote.IR) < key)
+        {
+          key         = bxcan_get_key(remote.IR);
+          bxcanWinner = BXCAN_NODE_REMOTE;
+          bxcanFrame  = remote;
+        }
+      }
+      
+      if(key == UINT64_MAX)
+      {
+        break;
+      }
+      
+      if(bxcanWinner != BXCAN_NODE_REMOTE)
+      {
+        bxcanFrame.IR  = hostCAN[bxcanWinner].sTxMailBox[bxcanMailbox[bxcanWinner]].TIR;
+        bxcanFrame.DTR = hostCAN[bxcanWinner].sTxMailBox[bxcanMailbox[bxcanWinner]].TDTR;
+        bxcanFrame.DLR = hostCAN[bxcanWinner].sTxMailBox[bxcanMailbox[bxcanWinner]].TDLR;
+        bxcanFrame.DHR = hostCAN[bxcanWinner].sTxMailBox[bxcanMailbox[bxcanWinner]].TDHR;
+      }
+      
+      bxcanEnd  = bxcanStart + bxcan_get_bits(&bxcanFrame) * bxcan_get_bit_time(bxcanWinner);
+      bxcanBusy = true;
+    }
+    
+    if(bxcanEnd > Limit)
+    {
+      break;
+    }
+    
+    bxcanTime    = bxcanEnd;
+    bxcanBusIdle = bxcanEnd;
+    bxcanBusy    = false;
+    
+    bxcanStatistics.Frames++;
+    bxcanStatistics.BusyTime += (bxcanEnd - bxcanStart) / 1000;
+    
+    /* The winner completes, losers without automatic retransmission give up. */
+    for(uint32_t x = 0; x < BXCAN_CONTROLLER_NUMBER; x++)
+    {
+      if((int32_t)x == bxcanWinner)
+      {
+        bxcan_transmit_done(x, bxcanMailbox[x], BxCAN_TransmitOk, BXCAN_LEC_NONE);
+      }
+      else
+      {
+        bxcan_transmit_done(x, bxcanMailbox[x], BxCAN_TransmitArbitrationLost, BXCAN_LEC_NONE);
+      }
+    }
+    
+    if(bxcanWinner == BXCAN_NODE_REMOTE)
+    {
+      bxcanRemoteOut++;
+    }
+    
+    /* Loop back mode receives its own frames only, silent loop back keeps them off the bus. */
+    for(uint32_t x = 0; x < BXCAN_CONTROLLER_NUMBER; x++)
+    {
+      if((int32_t)x == bxcanWinner)
+      {
+        if((hostCAN[x].BTR & CAN_BTR_LBKM) != 0)
+        {
+          bxcan_receive(x, &bxcanFrame);
+        }
+      }
+      else if((bxcan_is_active(x) == true) && ((hostCAN[x].BTR & CAN_BTR_LBKM) == 0))
+      {
+        if((bxcanWinner == BXCAN_NODE_REMOTE) || ((hostCAN[bxcanWinner].BTR & CAN_BTR_SILM) == 0))
+        {
+          bxcan_receive(x, &bxcanFrame);
+        }
+      }
+    }
+    
+    if(bxcanBusCallback != 0)
+    {
+      CanRxMsg message = {0};
+      
+      bxcan_decode(&bxcanFrame, &message);
+      message.FMI = 0;
+      bxcanBusCallback(BxCAN_GetTime(), bxcanWinner, &message);
+    }
+    
+    frames++;
+    
+    Core_Update();
+  }
+  
+  if((Idle != true) && (bxcanTime < Limit))
+  {
+    bxcanTime = Limit;
+  }
+  
+  return frames;
+}
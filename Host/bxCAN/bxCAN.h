@@ -0,0 +1,121 @@
+/**
+  ******************************************************************************
+  * @file    bxCAN.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for bxCAN.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __BXCAN_H
+#define __BXCAN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "stm32f10x.h"
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define BXCAN_FIFO_DEPTH        (3)
+#define BXCAN_REMOTE_QUEUE_SIZE (256)   /* Frames of the remote node, a power of 2. */
+
+#define BXCAN_NODE_CAN1         (0)
+#define BXCAN_NODE_CAN2         (1)
+#define BXCAN_NODE_REMOTE       (-1)
+
+/* Last error codes, as in the LEC field of CAN_ESR. */
+#define BXCAN_LEC_NONE          (0)
+#define BXCAN_LEC_STUFF         (1)
+#define BXCAN_LEC_FORM          (2)
+#define BXCAN_LEC_ACK           (3)
+#define BXCAN_LEC_BIT_RECESSIVE (4)
+#define BXCAN_LEC_BIT_DOMINANT  (5)
+#define BXCAN_LEC_CRC           (6)
+
+/* Type definitions ----------------------------------------------------------*/
+
+/* A frame as the mailbox registers hold it. */
+typedef struct
+{
+  uint32_t IR;
+  uint32_t DTR;
+  uint32_t DLR;
+  uint32_t DHR;
+}BxCAN_Frame;
+
+typedef enum
+{
+  BxCAN_TransmitOk = 0,
+  BxCAN_TransmitArbitrationLost,
+  BxCAN_TransmitError
+}BxCAN_TransmitResult;
+
+typedef struct
+{
+  uint32_t Frames;                      /*!< Frames completed on the bus. */
+  uint64_t BusyTime;                    /*!< Bus time taken by those frames, in nanoseconds. */
+  uint32_t ArbitrationLost[2];          /*!< Requests of CAN1/CAN2 dropped after losing arbitration, NART only. */
+  uint32_t TransmitError[2];            /*!< Transmissions of CAN1/CAN2 aborted by a bus error. */
+  uint32_t Overrun[2];                  /*!< Frames lost by CAN1/CAN2 to a full FIFO. */
+  uint32_t Filtered[2];                 /*!< Frames no filter of CAN1/CAN2 accepted. */
+}BxCAN_Statistics;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+void BxCAN_Reset(void);
+
+uint32_t BxCAN_Run(uint64_t Duration);
+uint32_t BxCAN_RunIdle(uint64_t Limit);
+uint64_t BxCAN_GetTime(void);
+
+bool BxCAN_Inject(const CanTxMsg *Message);
+uint32_t BxCAN_GetInjectNumber(void);
+void BxCAN_SetBusCallback(void (*Callback)(uint64_t Time, int32_t Node, const CanRxMsg *Message));
+
+bool BxCAN_GetIRQLevel(IRQn_Type IRQn);
+
+void BxCAN_SetClearHook(void (*Hook)(CAN_TypeDef *CANx));
+bool BxCAN_CompleteTransmit(CAN_TypeDef *CANx);
+
+void BxCAN_GetStatistics(BxCAN_Statistics *Statistics);
+
+void BxCAN_PortSetTime(uint64_t Time);
+uint64_t BxCAN_PortGetBitTime(int32_t Node);
+bool BxCAN_PortGetRequest(int32_t Node, BxCAN_Frame *Frame);
+void BxCAN_PortTransmitDone(int32_t Node, BxCAN_TransmitResult Result, uint32_t Lec);
+bool BxCAN_PortIsListening(int32_t Node);
+void BxCAN_PortReceive(int32_t Node, const BxCAN_Frame *Frame, uint32_t Lec);
+void BxCAN_PortRecessive(int32_t Node, uint32_t Number);
+void BxCAN_PortSetErrorCounters(int32_t Node, uint32_t Tec, uint32_t Rec);
+void BxCAN_PortGetErrorCounters(int32_t Node, uint32_t *Tec, uint32_t *Rec);
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BXCAN_H */
@@ -0,0 +1,2039 @@
+/**
+  ******************************************************************************
+  * @file    main.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Runs the CAN driver on the host bxCAN model: correctness, throughput and latency.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+/* Header includes -----------------------------------------------------------*/
+#include "CAN.h"
+#include "Core.h"
+#include "bxCAN.h"
+#include "CANProfile.h"
+#include "CANTrace.h"
+#include "CANScheduler.h"
+#include "CANTimeout.h"
+#include "J1939.h"
+#include "FramePool.h"
+#include "ISOTP.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define FRAME_NUMBER         (20000)
+#define POLL_PERIOD          (10000)    /* Nanoseconds of bus time between two application polls. */
+#define RECEIVE_POLL_PERIOD  (5000000)  /* Longer than the receive buffer lasts at full load. */
+#define TRACE_FILE           "build/cantrace.bin"
+#define SCHEDULER_NUMBER     (44)       /* Cyclic messages, a quarter each at 10, 20, 100 and 1000 ms. */
+#define SCHEDULER_TIME       (2000)     /* Ticks the scheduler runs. */
+#define TIMEOUT_NUMBER       (200)      /* Supervised identifiers, each received every TIMEOUT_PERIOD. */
+#define TIMEOUT_PERIOD       (50)
+#define TIMEOUT_STOPPED      (10)       /* Identifiers no longer sent after TIMEOUT_STOP. */
+#define TIMEOUT_STOP         (500)
+#define TIMEOUT_TIME         (1000)     /* Ticks the supervision runs. */
+#define PRODUCER_ID          (0x301)    /* Filled when a mailbox frees up. */
+#define PRODUCER_QUEUE_ID    (0x300)    /* The same signal queued. */
+#define PRODUCER_FLOOD_ID    (0x700)    /* Keeps the transmit buffer full. */
+#define PRODUCER_TIME        (1000)     /* Ticks the producer runs, one signal update each. */
+#define WATCHDOG_NUMBER      (200)      /* Frames sent in the watchdog run. */
+#define WATCHDOG_FLOOD       (50)       /* Ticks a higher priority node holds the bus. */
+#define WATCHDOG_TIMEOUT     (2)        /* Ticks a request may stay pending. */
+#define URGENT_ID            (0x010)    /* Above the flooding node. */
+#define URGENT_TIME          (100)      /* Ticks of the urgent run, one urgent frame each. */
+#define URGENT_QUEUED        (16)       /* Low priority frames queued behind the flood. */
+#define URGENT_BOUND         (300000)   /* Nanoseconds, the frame on the bus and the urgent frame with margin. */
+#define RATE_FLOOD_ID        (0x700)    /* A node flooding its class, limited. */
+#define RATE_OTHER_ID        (0x100)    /* Not limited. */
+#define RATE_LIMIT           (100)      /* Frames per 1000 ticks of the flooding class. */
+#define RATE_BURST           (5)
+#define RATE_TIME            (1000)     /* Ticks the flood lasts. */
+#define GATEWAY_ID           (0x100)    /* Received in frame mode, forwarded as GATEWAY_ID | GATEWAY_FORWARD. */
+#define GATEWAY_FORWARD      (0x400)
+#define GATEWAY_NUMBER       (2000)     /* Frames forwarded as they arrive. */
+#define GATEWAY_PERIOD       (250000)   /* Nanoseconds between two of them, half the bus. */
+#define GATEWAY_BURST        (48)       /* Frames sent back to back while the gateway stalls or holds frames. */
+#define ISOTP_TX_ID          (0x7E0)    /* Tester to ECU, both sessions on CAN1 in loop back. */
+#define ISOTP_RX_ID          (0x7E8)
+#define ISOTP_LENGTH         (4095)     /* The largest message with a 12-bit first frame. */
+#define J1939_NAME           ((1ULL << 63) | 0x1234)  /* Arbitrary address capable. */
+#define J1939_NODE           (0x80)     /* Our address in the transport runs. */
+#define J1939_PEER           (0x20)     /* The remote sender, and our preferred address when the claim is contested. */
+#define J1939_PGN            (0x0EF00)  /* Proprietary A, carried by the transport protocol. */
+#define J1939_FRAME_BITS     (131)      /* An extended frame of 8 bytes and the interframe space, unstuffed. */
+#define RX_POLL_BURST        (2)        /* Messages by interrupt in one poll period that switch to polling. */
+#define RX_POLL_IDLE         (2)        /* Empty polls that switch back. */
+
+#ifdef STM32F10X_CL
+#define TX_IRQn              CAN1_TX_IRQn
+#define RX0_IRQn             CAN1_RX0_IRQn
+#else
+#define TX_IRQn              USB_HP_CAN1_TX_IRQn
+#define RX0_IRQn             USB_LP_CAN1_RX0_IRQn
+#endif /* STM32F10X_CL */
+
+/* Type definitions ----------------------------------------------------------*/
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+static uint64_t queueTime[FRAME_NUMBER] = {0};
+static uint64_t latencyTotal            = 0;
+static uint64_t latencyMax              = 0;
+static uint32_t latencyNumber           = 0;
+
+static CAN_SchedulerMessage schedulerMessage[SCHEDULER_NUMBER];
+static CAN_TimeoutEntry     timeoutEntry[TIMEOUT_NUMBER];
+static uint32_t             timeoutExpire[TIMEOUT_NUMBER];
+static bool                 timeoutEvent[4];           /* Callbacks of the ordering run, in order. */
+static uint32_t             timeoutEventNumber = 0;
+
+static uint32_t completeNumber[6] = {0};  /* Per CAN_TxStatus. */
+static uint32_t completeHandle    = 0;    /* Handle expected next. */
+static uint32_t completeDisorder  = 0;
+
+static uint64_t urgentLatencyMax   = 0;
+static uint64_t urgentLatencyTotal = 0;
+static uint32_t urgentNumber       = 0;
+
+static CAN_Producer producer          = {0};
+static uint64_t     producerAge[2]    = {0};  /* Index 0 the producer, 1 the queued signal. */
+static uint64_t     producerAgeMax[2] = {0};
+static uint32_t     producerNumber[2] = {0};
+
+static bool     raceArmed    = false;  /* The next status clear completes another mailbox. */
+static uint32_t raceComplete = 0;
+
+static uint32_t rateFrames[2] = {0};  /* Index 0 the flooding class, 1 the other identifier. */
+
+static CanRxMsg *gatewayHeld[FRAME_POOL_SIZE] = {0};  /* Taken from the receive queue, not yet forwarded. */
+static uint32_t  gatewayHeldNumber             = 0;
+static uint32_t  gatewayReceived               = 0;
+static uint32_t  gatewayForwarded              = 0;  /* Seen on the bus. */
+static uint32_t  gatewayNext                   = 0;  /* Sequence number forwarded next, at least. */
+static uint32_t  gatewayDisorder               = 0;
+
+static uint8_t  isotpData[ISOTP_LENGTH];
+static uint8_t  isotpBuffer[ISOTP_LENGTH];
+static uint32_t isotpLength = 0;  /* Of the message received, 0 until then. */
+static uint64_t isotpEnd    = 0;
+
+static bool     j1939Contest  = false;                  /* The remote claims every address we claim. */
+static uint32_t j1939Claims   = 0;
+static uint8_t  j1939Reported = J1939_ADDRESS_GLOBAL;   /* Passed to the address callback, global until then. */
+static uint32_t j1939Length   = 0;                      /* Of the reassembled message, 0 until then. */
+static bool     j1939Intact   = false;
+static uint64_t j1939End      = 0;
+static bool     j1939EoMA     = false;
+
+static uint32_t pollFlood = 0;  /* Messages seen by the slow receive callback. */
+
+/* Function declarations -----------------------------------------------------*/
+static void setup(CAN_WorkMode WorkMode);
+static void make_message(CanTxMsg *Message, uint32_t StdId, uint32_t Sequence);
+static uint32_t get_sequence(const CanRxMsg *Message);
+static void bus_latency(uint64_t Time, int32_t Node, const CanRxMsg *Message);
+static void print_irq(const char *Name, uint64_t HostTime, uint32_t Frames);
+static void print_profile(const char *Name, CAN_ProfilePoint Point);
+static bool dump_trace(const char *Path);
+static bool run_loopback(void);
+static bool run_receive(void);
+static bool transmit_complete(CAN_TypeDef *CANx, const CAN_TxCompletion *Completion);
+static bool run_arbitration(CAN_Retransmit Mode, const char *Name);
+static uint32_t get_time_us(void);
+static void stamp_message(CAN_TypeDef *CANx, CanTxMsg *Message);
+static void bus_scheduler(uint64_t Time, int32_t Node, const CanRxMsg *Message);
+static bool drop_message(CAN_TypeDef *CANx, const CanRxMsg *Message);
+static bool run_scheduler(uint32_t Offset, const char *Name);
+static void timeout_event(CAN_TimeoutEntry *Entry, bool Timeout);
+static bool timeout_input(CAN_TypeDef *CANx, const CanRxMsg *Message);
+static bool run_timeout(void);
+static void timeout_order_event(CAN_TimeoutEntry *Entry, bool Timeout);
+static bool run_timeout_order(void);
+static bool producer_fill(CAN_TypeDef *CANx, CanTxMsg *Message);
+static void bus_producer(uint64_t Time, int32_t Node, const CanRxMsg *Message);
+static bool run_producer(void);
+static bool run_watchdog(void);
+static void bus_urgent(uint64_t Time, int32_t Node, const CanRxMsg *Message);
+static bool run_urgent(void);
+static void clear_race(CAN_TypeDef *CANx);
+static bool run_race(void);
+static bool run_urgent_timeout(void);
+static void bus_rate(uint64_t Time, int32_t Node, const CanRxMsg *Message);
+static bool run_rate(CAN_RateAction Action, const char *Name);
+static bool run_rate_clear(void);
+static void bus_gateway(uint64_t Time, int32_t Node, const CanRxMsg *Message);
+static void gateway_poll(CAN_TypeDef *CANx, bool Forward);
+static bool run_gateway(void);
+static void isotp_receive(uint32_t Session, const uint8_t *Data, uint32_t Length, ISOTP_Result Result);
+static bool run_isotp(uint8_t BlockSize, uint8_t STmin, const char *Name);
+static bool run_isotp_hold(void);
+static void j1939_setup(uint8_t Address);
+static void j1939_peer_send(uint32_t PGN, uint8_t DA, const uint8_t *Data);
+static void j1939_peer_packet(uint8_t DA, uint8_t Sequence);
+static void j1939_address(uint8_t Address);
+static void j1939_receive(uint32_t PGN, uint8_t SA, uint8_t DA, const uint8_t *Data, uint32_t Length);
+static void bus_j1939(uint64_t Time, int32_t Node, const CanRxMsg *Message);
+static bool run_j1939_claim(void);
+static bool run_j1939(bool Broadcast);
+static bool run_poll(uint32_t Burst, uint32_t Period, const char *Name);
+static bool poll_flood(CAN_TypeDef *CANx, const CanRxMsg *Message);
+static bool run_poll_budget(void);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Main program.
+  * @param  None.
+  * @return 0 when every check passes, 1 otherwise.
+  */
+int main(void)
+{
+  bool result = true;
+  
+  result &= run_loopback();
+  result &= run_receive();
+  result &= run_arbitration(CAN_RetransmitNone, "not retransmitted (NART)");
+  result &= run_arbitration(CAN_RetransmitSoftware, "software retry 3");
+  result &= run_arbitration(CAN_RetransmitHardware, "hardware retransmit");
+  result &= dump_trace(TRACE_FILE);
+  run_scheduler(0, "offsets 0");
+  result &= run_scheduler(CAN_SCHEDULER_OFFSET_AUTO, "automatic offsets");
+  result &= run_timeout();
+  result &= run_timeout_order();
+  result &= run_producer();
+  result &= run_watchdog();
+  result &= run_urgent();
+  result &= run_race();
+  result &= run_urgent_timeout();
+  result &= run_rate(CAN_RateReject, "rejected");
+  result &= run_rate(CAN_RateDefer, "deferred");
+  result &= run_rate_clear();
+  result &= run_gateway();
+  result &= run_isotp(0, 0, "no block limit");
+  result &= run_isotp(8, 0, "blocks of 8");
+  result &= run_isotp(0, 1, "STmin 1 ms");
+  result &= run_isotp_hold();
+  result &= run_j1939_claim();
+  result &= run_j1939(true);
+  result &= run_j1939(false);
+  result &= run_poll(0, 200000, "interrupt only");
+  result &= run_poll(RX_POLL_BURST, 200000, "hybrid");
+  result &= run_poll(RX_POLL_BURST, 500000, "hybrid, polls later than the FIFO fills");
+  result &= run_poll_budget();
+  
+  printf("%s\n", (result == true) ? "PASS" : "FAIL");
+  
+  return (result == true) ? 0 : 1;
+}
+
+/**
+  * @brief  Reset the model and configure CAN1 at 1 Mbit/s, receiving every identifier.
+  * @param  [in] WorkMode: Work mode.
+  * @return None.
+  */
+static void setup(CAN_WorkMode WorkMode)
+{
+  const CAN_FilterId filter[] =
+  {
+    {CAN_Id_Standard, 0, 0},
+    {CAN_Id_Extended, 0, 0}
+  };
+  
+  CAN_Unconfigure(CAN1);
+  BxCAN_Reset();
+  BxCAN_SetBusCallback(0);
+  Core_ClearIRQStatistics();
+  CAN_Profile_Init();
+  CAN_Trace_Init();
+  CAN_Trace_Start();
+  
+  CAN_Configure(CAN1, WorkMode, CAN_BaudRate1000K, 0, 0);
+  CAN_SetReceiveFilter(CAN1, filter, sizeof(filter) / sizeof(filter[0]));
+}
+
+/**
+  * @brief  Build a message carrying a sequence number.
+  * @param  [out] Message:  The message.
+  * @param  [in] StdId:     Standard identifier.
+  * @param  [in] Sequence:  Sequence number, in the first 4 data bytes.
+  * @return None.
+  */
+static void make_message(CanTxMsg *Message, uint32_t StdId, uint32_t Sequence)
+{
+  memset(Message, 0, sizeof(*Message));
+  
+  Message->StdId = StdId;
+  Message->IDE   = CAN_Id_Standard;
+  Message->RTR   = CAN_RTR_Data;
+  Message->DLC   = 8;
+  
+  memcpy(Message->Data, &Sequence, sizeof(Sequence));
+}
+
+/**
+  * @brief  Get the sequence number of a message.
+  * @param  [in] Message: The message.
+  * @return The sequence number.
+  */
+static uint32_t get_sequence(const CanRxMsg *Message)
+{
+  uint32_t sequence = 0;
+  
+  memcpy(&sequence, Message->Data, sizeof(sequence));
+  
+  return sequence;
+}
+
+/**
+  * @brief  Bus monitor measuring the time from queueing a message to the end of its frame.
+  */
+static void bus_latency(uint64_t Time, int32_t Node, const CanRxMsg *Message)
+{
+  uint32_t sequence = get_sequence(Message);
+  
+  if((Node == BXCAN_NODE_CAN1) && (sequence < FRAME_NUMBER))
+  {
+    uint64_t latency = Time - queueTime[sequence];
+    
+    latencyTotal += latency;
+    latencyNumber++;
+    
+    if(latency > latencyMax)
+    {
+      latencyMax = latency;
+    }
+  }
+}
+
+/**
+  * @brief  Print the host cost of an interrupt handler.
+  */
+static void print_irq(const char *Name, uint64_t HostTime, uint32_t Frames)
+{
+  printf("  %-24s %8.1f ns/frame host\n", Name, (Frames > 0) ? (double)HostTime / Frames : 0.0);
+}
+
+/**
+  * @brief  Print a CAN1 histogram of the driver instrumentation.
+  */
+static void print_profile(const char *Name, CAN_ProfilePoint Point)
+{
+  CAN_ProfileHistogram histogram = {0};
+  double               scale     = 1e9 / CAN_Profile_GetFrequency();
+  
+  CAN_Profile_GetHistogram(CAN1, Point, &histogram);
+  
+  printf("  %-24s %8u times, min %.0f, avg %.0f, p99 <= %.0f, max %.0f ns host\n", Name, histogram.Count,
+         histogram.Min * scale, (histogram.Count > 0) ? histogram.Total * scale / histogram.Count : 0.0,
+         CAN_Profile_GetPercentile(&histogram, 99) * scale, histogram.Max * scale);
+}
+
+/**
+  * @brief  Write the driver trace of the last run, for Tools/CANTrace/cantrace.py.
+  * @param  [in] Path: The dump file.
+  * @retval true:  Written.
+  * @retval false: Failed.
+  */
+static bool dump_trace(const char *Path)
+{
+  const CAN_TraceBuffer *trace = CAN_Trace_GetBuffer();
+  FILE                  *file  = fopen(Path, "wb");
+  
+  CAN_Trace_Stop();
+  
+  if(file == 0)
+  {
+    printf("Trace, cannot write %s\n", Path);
+    return false;
+  }
+  
+  bool result = (fwrite(trace, sizeof(*trace), 1, file) == 1);
+  
+  fclose(file);
+  printf("Trace, %u events, the last %u in %s\n", trace->Index, (trace->Index < trace->Size) ? trace->Index : trace->Size, Path);
+  
+  return result;
+}
+
+/**
+  * @brief  Loop back: every queued message must come back once and in order.
+  * @param  None.
+  * @retval true:  Passed.
+  * @retval false: Failed.
+  */
+static bool run_loopback(void)
+{
+  CanTxMsg           canTxMsg = {0};
+  CanRxMsg           canRxMsg = {0};
+  uint32_t           sent     = 0;
+  uint32_t           received = 0;
+  uint32_t           errors   = 0;
+  Core_IRQStatistics tx       = {0};
+  Core_IRQStatistics rx       = {0};
+  BxCAN_Statistics   bus      = {0};
+  
+  setup(CAN_WorkModeLoopBack);
+  BxCAN_SetBusCallback(bus_latency);
+  
+  latencyTotal  = 0;
+  latencyMax    = 0;
+  latencyNumber = 0;
+  
+  while(received < FRAME_NUMBER)
+  {
+    while((sent < FRAME_NUMBER) && (CAN_IsTransmitBufferFull(CAN1) != true))
+    {
+      make_message(&canTxMsg, 0x100 + (sent & 0xFF), sent);
+      queueTime[sent] = BxCAN_GetTime();
+      
+      if(CAN_SetTransmitMessage(CAN1, &canTxMsg, 1) == 1)
+      {
+        sent++;
+      }
+    }
+    
+    BxCAN_Run(POLL_PERIOD);
+    
+    while(CAN_GetReceiveMessage(CAN1, &canRxMsg, 1) == 1)
+    {
+      if(get_sequence(&canRxMsg) != received)
+      {
+        errors++;
+      }
+      
+      received++;
+    }
+    
+    if((sent == FRAME_NUMBER) && (CAN_IsTransmitMessage(CAN1) != true) && (CAN_IsReceiveBufferEmpty(CAN1) == true))
+    {
+      break;
+    }
+  }
+  
+  Core_GetIRQStatistics(TX_IRQn, &tx);
+  Core_GetIRQStatistics(RX0_IRQn, &rx);
+  BxCAN_GetStatistics(&bus);
+  
+  printf("Loop back, %u frames of 8 bytes at 1 Mbit/s\n", FRAME_NUMBER);
+  printf("  received %u, out of order %u\n", received, errors);
+  printf("  %.0f frames/s, bus load %.1f %%\n", bus.Frames * 1e9 / BxCAN_GetTime(), 100.0 * bus.BusyTime / BxCAN_GetTime());
+  printf("  queue to end of frame %.1f us average, %.1f us max\n", latencyTotal / 1e3 / (latencyNumber ? latencyNumber : 1), latencyMax / 1e3);
+  print_irq("TX interrupt", tx.HostTime, tx.Count);
+  print_irq("RX interrupt", rx.HostTime, rx.Count);
+  print_profile("TX interrupt", CAN_ProfileTxIsr);
+  print_profile("RX interrupt", CAN_ProfileRxIsr);
+  print_profile("RX entry to callback", CAN_ProfileRxCallback);
+  print_profile("enqueue to TX complete", CAN_ProfileTxComplete);
+  
+  return (received == FRAME_NUMBER) && (errors == 0);
+}
+
+/**
+  * @brief  Receive at full bus load while the application polls late.
+  * @param  None.
+  * @retval true:  Every frame was received or counted as lost.
+  * @retval false: Failed.
+  */
+static bool run_receive(void)
+{
+  CanTxMsg         canTxMsg = {0};
+  CanRxMsg         canRxMsg = {0};
+  uint32_t         injected = 0;
+  uint32_t         received = 0;
+  uint32_t         expected = 0;
+  uint32_t         gaps     = 0;
+  BxCAN_Statistics bus      = {0};
+  
+  setup(CAN_WorkModeNormal);
+  
+  while(received + gaps < FRAME_NUMBER)
+  {
+    while((injected < FRAME_NUMBER) && (BxCAN_GetInjectNumber() < BXCAN_REMOTE_QUEUE_SIZE))
+    {
+      make_message(&canTxMsg, 0x200, injected++);
+      BxCAN_Inject(&canTxMsg);
+    }
+    
+    BxCAN_Run(RECEIVE_POLL_PERIOD);
+    
+    while(CAN_GetReceiveMessage(CAN1, &canRxMsg, 1) == 1)
+    {
+      uint32_t sequence = get_sequence(&canRxMsg);
+      
+      gaps     += sequence - expected;
+      expected  = sequence + 1;
+      received++;
+    }
+    
+    if((injected == FRAME_NUMBER) && (BxCAN_GetInjectNumber() == 0) && (BxCAN_RunIdle(0) == 0) && (CAN_IsReceiveBufferEmpty(CAN1) == true))
+    {
+      gaps += FRAME_NUMBER - expected;
+      break;
+    }
+  }
+  
+  BxCAN_GetStatistics(&bus);
+  
+  printf("Receive at full load, polled every %u us\n", RECEIVE_POLL_PERIOD / 1000);
+  printf("  received %u, lost %u (FIFO overrun %u, receive buffer full %u)\n", received, gaps, bus.Overrun[0], gaps - bus.Overrun[0]);
+  
+  return (received + gaps == FRAME_NUMBER);
+}
+
+/**
+  * @brief  Transmit complete callback counting the status, lost frames left to the completion buffer.
+  */
+static bool transmit_complete(CAN_TypeDef *CANx, const CAN_TxCompletion *Completion)
+{
+  if(Completion->Handle != completeHandle++)
+  {
+    completeDisorder++;
+  }
+  
+  completeNumber[Completion->Status]++;
+  
+  return (Completion->Status == CAN_TxStatusOk);
+}
+
+/**
+  * @brief  Transmit against a remote node sending higher priority frames.
+  * @param  [in] Mode: Retransmit mode, software retries 3 times.
+  * @param  [in] Name: Printed name of the run.
+  * @retval true:  Every frame was sent or reported lost in arbitration, with its handle,
+  *                the retries and losses match the bus.
+  * @retval false: Failed.
+  */
+static bool run_arbitration(CAN_Retransmit Mode, const char *Name)
+{
+  CanTxMsg                 canTxMsg   = {0};
+  CAN_TxCompletion         completion = {0};
+  CAN_RetransmitStatistics retransmit = {0};
+  uint32_t                 sent       = 0;
+  uint32_t                 queued     = 0;
+  uint32_t                 handle     = 0;
+  BxCAN_Statistics         bus        = {0};
+  bool                     result     = false;
+  
+  setup(CAN_WorkModeNormal);
+  CAN_SetTransmitCompleteCallback(CAN1, transmit_complete);
+  CAN_SetRetransmit(CAN1, Mode, 3, 0);
+  
+  memset(completeNumber, 0, sizeof(completeNumber));
+  completeHandle   = 0;
+  completeDisorder = 0;
+  
+  while((sent < 1000) || (CAN_IsTransmitMessage(CAN1) == true))
+  {
+    while((sent < 1000) && (CAN_IsTransmitBufferFull(CAN1) != true))
+    {
+      make_message(&canTxMsg, 0x300, sent);
+      CAN_SendMessage(CAN1, &canTxMsg, &handle);
+      completeDisorder += (handle != sent++) ? 1 : 0;
+    }
+    
+    while(CAN_GetTransmitCompletion(CAN1, &completion, 1) > 0)
+    {
+      queued += (completion.Status == CAN_TxStatusArbitrationLost) ? 1 : 0;
+    }
+    
+    if(BxCAN_GetInjectNumber() == 0)
+    {
+      make_message(&canTxMsg, 0x080, 0);
+      BxCAN_Inject(&canTxMsg);
+    }
+    
+    BxCAN_Run(POLL_PERIOD);
+  }
+  
+  BxCAN_GetStatistics(&bus);
+  
+  while(CAN_GetTransmitCompletion(CAN1, &completion, 1) > 0)
+  {
+    queued += (completion.Status == CAN_TxStatusArbitrationLost) ? 1 : 0;
+  }
+  
+  CAN_GetRetransmitStatistics(CAN1, &retransmit);
+  CAN_SetTransmitCompleteCallback(CAN1, 0);
+  
+  printf("Arbitration against a higher priority node, 1000 frames, %s\n", Name);
+  printf("  lost in arbitration %u, retried %u, sent after a retry %u, given up %u\n", bus.ArbitrationLost[0], retransmit.Retry, retransmit.Recovered, retransmit.GiveUp);
+  printf("  completions: sent %u, arbitration lost %u (%u from the buffer), error %u, handles out of order %u\n",
+         completeNumber[CAN_TxStatusOk], completeNumber[CAN_TxStatusArbitrationLost], queued, completeNumber[CAN_TxStatusError], completeDisorder);
+  
+  result = (completeNumber[CAN_TxStatusOk] + completeNumber[CAN_TxStatusArbitrationLost] == 1000) &&
+           (queued == completeNumber[CAN_TxStatusArbitrationLost]) && (completeDisorder == 0);
+  
+  switch(Mode)
+  {
+    case CAN_RetransmitNone:
+      return result && (completeNumber[CAN_TxStatusArbitrationLost] == bus.ArbitrationLost[0]);
+    
+    case CAN_RetransmitSoftware:
+      return result && (retransmit.ArbitrationLost == bus.ArbitrationLost[0]) && (retransmit.Retry + retransmit.GiveUp == retransmit.ArbitrationLost) &&
+             (completeNumber[CAN_TxStatusArbitrationLost] == retransmit.GiveUp);
+    
+    default:
+      return result && (completeNumber[CAN_TxStatusOk] == 1000);
+  }
+}
+
+/**
+  * @brief  Bus time in microseconds, the time of the scheduler.
+  */
+static uint32_t get_time_us(void)
+{
+  return (uint32_t)(BxCAN_GetTime() / 1000);
+}
+
+/**
+  * @brief  Payload update of the cyclic messages, the release time in data bytes 4 to 7.
+  */
+static void stamp_message(CAN_TypeDef *CANx, CanTxMsg *Message)
+{
+  uint32_t time = get_time_us();
+  
+  memcpy(&Message->Data[4], &time, sizeof(time));
+}
+
+/**
+  * @brief  Bus monitor measuring the time from the release of a cyclic message to the end of its frame.
+  */
+static void bus_scheduler(uint64_t Time, int32_t Node, const CanRxMsg *Message)
+{
+  uint32_t release = 0;
+  
+  memcpy(&release, &Message->Data[4], sizeof(release));
+  
+  if((Node == BXCAN_NODE_CAN1) && (Time / 1000 - release > latencyMax))
+  {
+    latencyMax = Time / 1000 - release;
+  }
+}
+
+/**
+  * @brief  Receive callback taking the looped back frames.
+  */
+static bool drop_message(CAN_TypeDef *CANx, const CanRxMsg *Message)
+{
+  return true;
+}
+
+/**
+  * @brief  Transmit cyclic messages from the scheduler for SCHEDULER_TIME ticks.
+  * @param  [in] Offset: The offset of every message, CAN_SCHEDULER_OFFSET_AUTO to spread them.
+  * @param  [in] Name:   Printed name of the run.
+  * @retval true:  Every message released on time, none lost, at most 2 releases per tick.
+  * @retval false: Failed.
+  */
+static bool run_scheduler(uint32_t Offset, const char *Name)
+{
+  static const uint32_t period[] = {10, 20, 100, 1000};
+  
+  CanTxMsg                canTxMsg   = {0};
+  CAN_SchedulerStatistics statistics = {0};
+  uint32_t                release    = 0;
+  uint32_t                overflow   = 0;
+  uint32_t                missing    = 0;
+  int32_t                 jitterMin  = 0;
+  int32_t                 jitterMax  = 0;
+  
+  setup(CAN_WorkModeLoopBack);
+  CAN_SetReceiveMessageCallback(CAN1, drop_message);
+  BxCAN_SetBusCallback(bus_scheduler);
+  TimerWheel_Init();
+  CAN_Scheduler_Init(get_time_us);
+  
+  latencyMax = 0;
+  
+  for(uint32_t i = 0; i < SCHEDULER_NUMBER; i++)
+  {
+    make_message(&canTxMsg, 0x100 + i, i);
+    CAN_Scheduler_Add(&schedulerMessage[i], CAN1, &canTxMsg, period[i * 4 / SCHEDULER_NUMBER], Offset, stamp_message);
+  }
+  
+  uint32_t peak = CAN_Scheduler_GetPeakLoad();
+  
+  for(uint32_t i = 0; i < SCHEDULER_TIME; i++)
+  {
+    BxCAN_Run(TIMER_WHEEL_TICK * 1000ULL);
+    TimerWheel_Tick();
+  }
+  
+  BxCAN_RunIdle(1000000000);
+  
+  for(uint32_t i = 0; i < SCHEDULER_NUMBER; i++)
+  {
+    CAN_Scheduler_GetStatistics(&schedulerMessage[i], &statistics);
+    CAN_Scheduler_Remove(&schedulerMessage[i]);
+    
+    release  += statistics.Release;
+    overflow += statistics.Overflow;
+    missing  += (statistics.Release + statistics.Overflow + 1 < SCHEDULER_TIME / period[i * 4 / SCHEDULER_NUMBER]) ? 1 : 0;
+    
+    jitterMin = (statistics.JitterMin < jitterMin) ? statistics.JitterMin : jitterMin;
+    jitterMax = (statistics.JitterMax > jitterMax) ? statistics.JitterMax : jitterMax;
+  }
+  
+  CAN_SetReceiveMessageCallback(CAN1, 0);
+  
+  printf("Scheduler, %u cyclic messages at 10/20/100/1000 ms for %u ms, %s\n", SCHEDULER_NUMBER, SCHEDULER_TIME, Name);
+  printf("  peak %u releases per tick, released %u, lost %u, late messages %u\n", peak, release, overflow, missing);
+  printf("  release jitter %d to %d us, release to end of frame %llu us max\n", jitterMin, jitterMax, (unsigned long long)latencyMax);
+  
+  return (missing == 0) && (overflow == 0) && (peak <= 2);
+}
+
+/**
+  * @brief  Supervision callback keeping the tick of the timeout.
+  */
+static void timeout_event(CAN_TimeoutEntry *Entry, bool Timeout)
+{
+  if(Timeout == true)
+  {
+    timeoutExpire[Entry - timeoutEntry] = TimerWheel_GetTime();
+  }
+}
+
+/**
+  * @brief  Receive callback of the supervision run, taking the frames.
+  */
+static bool timeout_input(CAN_TypeDef *CANx, const CanRxMsg *Message)
+{
+  CAN_Timeout_Input(CANx, Message);
+  
+  return true;
+}
+
+/**
+  * @brief  Supervise cyclic identifiers sent by a remote node, some of which stop.
+  * @param  None.
+  * @retval true:  Exactly the stopped identifiers timed out, on their deadline.
+  * @retval false: Failed.
+  */
+static bool run_timeout(void)
+{
+  CanTxMsg           canTxMsg = {0};
+  Core_IRQStatistics rx       = {0};
+  uint32_t           expired  = 0;
+  uint32_t           wrong    = 0;
+  uint32_t           gapMax   = 0;
+  
+  setup(CAN_WorkModeNormal);
+  CAN_SetReceiveMessageCallback(CAN1, timeout_input);
+  TimerWheel_Init();
+  CAN_Timeout_Init();
+  
+  for(uint32_t i = 0; i < TIMEOUT_NUMBER; i++)
+  {
+    timeoutExpire[i] = 0;
+    CAN_Timeout_Add(&timeoutEntry[i], CAN1, CAN_Id_Standard, 0x200 + i, TIMEOUT_PERIOD * 3, timeout_event);
+  }
+  
+  for(uint32_t tick = 1; tick <= TIMEOUT_TIME; tick++)
+  {
+    for(uint32_t i = tick % TIMEOUT_PERIOD; i < TIMEOUT_NUMBER; i += TIMEOUT_PERIOD)
+    {
+      if((i >= TIMEOUT_STOPPED) || (tick < TIMEOUT_STOP))
+      {
+        make_message(&canTxMsg, 0x200 + i, tick);
+        BxCAN_Inject(&canTxMsg);
+      }
+    }
+    
+    BxCAN_Run(TIMER_WHEEL_TICK * 1000ULL);
+    TimerWheel_Tick();
+  }
+  
+  for(uint32_t i = 0; i < TIMEOUT_NUMBER; i++)
+  {
+    CAN_TimeoutEntry *entry = &timeoutEntry[i];
+    
+    if(CAN_Timeout_IsExpired(entry) == true)
+    {
+      expired++;
+      
+      /* Stopped ones time out once, a deadline and the tick of their last frame after it. */
+      if((i >= TIMEOUT_STOPPED) || (entry->Expiry != 1) || (timeoutExpire[i] - entry->Last != entry->Timeout + 1))
+      {
+        wrong++;
+      }
+    }
+    else if((i < TIMEOUT_STOPPED) || (entry->Expiry != 0))
+    {
+      wrong++;
+    }
+    
+    gapMax = (entry->GapMax > gapMax) ? entry->GapMax : gapMax;
+    
+    CAN_Timeout_Remove(entry);
+  }
+  
+  Core_GetIRQStatistics(RX0_IRQn, &rx);
+  CAN_SetReceiveMessageCallback(CAN1, 0);
+  
+  printf("Reception timeout, %u identifiers every %u ms, %u stop after %u ms\n", TIMEOUT_NUMBER, TIMEOUT_PERIOD, TIMEOUT_STOPPED, TIMEOUT_STOP);
+  printf("  timed out %u, wrong %u, longest gap %u ms\n", expired, wrong, gapMax);
+  print_irq("RX interrupt", rx.HostTime, rx.Count);
+  
+  return (expired == TIMEOUT_STOPPED) && (wrong == 0);
+}
+
+/**
+  * @brief  Callback of the ordering run, a frame arrives while the timeout is reported.
+  */
+static void timeout_order_event(CAN_TimeoutEntry *Entry, bool Timeout)
+{
+  CanRxMsg canRxMsg = {0};
+  
+  if(timeoutEventNumber < sizeof(timeoutEvent) / sizeof(timeoutEvent[0]))
+  {
+    timeoutEvent[timeoutEventNumber] = Timeout;
+  }
+  
+  timeoutEventNumber++;
+  
+  if(Timeout == true)
+  {
+    canRxMsg.StdId = Entry->Id;
+    canRxMsg.IDE   = CAN_Id_Standard;
+    canRxMsg.DLC   = 8;
+    CAN_Timeout_Input(CAN1, &canRxMsg);
+  }
+}
+
+/**
+  * @brief  Receive a supervised identifier while its timeout callback runs.
+  * @param  None.
+  * @retval true:  The reception is reported after the timeout, and the identifier is no
+  *                longer timed out.
+  * @retval false: Failed.
+  */
+static bool run_timeout_order(void)
+{
+  CAN_TimeoutEntry *entry  = &timeoutEntry[0];
+  bool              result = false;
+  
+  TimerWheel_Init();
+  CAN_Timeout_Init();
+  timeoutEventNumber = 0;
+  
+  CAN_Timeout_Add(entry, CAN1, CAN_Id_Standard, 0x200, 5, timeout_order_event);
+  
+  for(uint32_t tick = 1; tick <= 10; tick++)
+  {
+    TimerWheel_Tick();
+  }
+  
+  result = (timeoutEventNumber == 2) && (timeoutEvent[0] == true) && (timeoutEvent[1] == false) &&
+           (CAN_Timeout_IsExpired(entry) != true) && (entry->Expiry == 1);
+  
+  CAN_Timeout_Remove(entry);
+  
+  printf("Reception during the timeout callback: %u callbacks, timeout %s then %s, expired %s\n", timeoutEventNumber,
+         (timeoutEvent[0] == true) ? "true" : "false", (timeoutEvent[1] == true) ? "true" : "false",
+         (CAN_Timeout_IsExpired(entry) == true) ? "yes" : "no");
+  
+  return result;
+}
+
+/**
+  * @brief  Producer fill callback, the signal sampled in data bytes 4 to 7 as the mailbox is loaded.
+  */
+static bool producer_fill(CAN_TypeDef *CANx, CanTxMsg *Message)
+{
+  stamp_message(CANx, Message);
+  
+  return true;
+}
+
+/**
+  * @brief  Bus monitor measuring the age of the signal at the end of its frame.
+  */
+static void bus_producer(uint64_t Time, int32_t Node, const CanRxMsg *Message)
+{
+  uint32_t sample = 0;
+  uint32_t which  = (Message->StdId == PRODUCER_ID) ? 0 : 1;
+  
+  memcpy(&sample, &Message->Data[4], sizeof(sample));
+  
+  if((Node == BXCAN_NODE_CAN1) && (Message->StdId != PRODUCER_FLOOD_ID))
+  {
+    uint64_t age = Time / 1000 - sample;
+    
+    producerAge[which] += age;
+    producerNumber[which]++;
+    
+    if(age > producerAgeMax[which])
+    {
+      producerAgeMax[which] = age;
+    }
+  }
+}
+
+/**
+  * @brief  Send a signal every tick both from a producer and through the full transmit buffer.
+  * @param  None.
+  * @retval true:  Every update sent, the producer data younger than the queued data.
+  * @retval false: Failed.
+  */
+static bool run_producer(void)
+{
+  CanTxMsg canTxMsg = {0};
+  
+  setup(CAN_WorkModeLoopBack);
+  CAN_SetReceiveMessageCallback(CAN1, drop_message);
+  BxCAN_SetBusCallback(bus_producer);
+  
+  memset(producerAge, 0, sizeof(producerAge));
+  memset(producerAgeMax, 0, sizeof(producerAgeMax));
+  memset(producerNumber, 0, sizeof(producerNumber));
+  
+  memset(&producer, 0, sizeof(producer));
+  make_message(&producer.Message, PRODUCER_ID, 0);
+  producer.Fill = producer_fill;
+  CAN_AddProducer(CAN1, &producer);
+  
+  for(uint32_t tick = 0; tick < PRODUCER_TIME; tick++)
+  {
+    make_message(&canTxMsg, PRODUCER_QUEUE_ID, tick);
+    stamp_message(CAN1, &canTxMsg);
+    CAN_SetTransmitMessage(CAN1, &canTxMsg, 1);
+    CAN_TriggerProducer(CAN1, &producer);
+    
+    make_message(&canTxMsg, PRODUCER_FLOOD_ID, tick);
+    
+    while(CAN_IsTransmitBufferFull(CAN1) != true)
+    {
+      CAN_SetTransmitMessage(CAN1, &canTxMsg, 1);
+    }
+    
+    BxCAN_Run(1000000);
+  }
+  
+  BxCAN_RunIdle(1000000000);
+  
+  CAN_RemoveProducer(CAN1, &producer);
+  CAN_SetReceiveMessageCallback(CAN1, 0);
+  
+  printf("Producer, a signal updated every ms behind a full transmit buffer for %u ms\n", PRODUCER_TIME);
+  printf("  producer: sent %u, coalesced %u, age at end of frame %llu us mean, %llu us max\n", producer.Loaded, producer.Coalesced,
+         (unsigned long long)(producerAge[0] / ((producerNumber[0] > 0) ? producerNumber[0] : 1)), (unsigned long long)producerAgeMax[0]);
+  printf("  queued:   sent %u, age at end of frame %llu us mean, %llu us max\n", producerNumber[1],
+         (unsigned long long)(producerAge[1] / ((producerNumber[1] > 0) ? producerNumber[1] : 1)), (unsigned long long)producerAgeMax[1]);
+  
+  return (producer.Loaded == PRODUCER_TIME) && (producerNumber[0] == PRODUCER_TIME) && (producerAgeMax[0] < producerAgeMax[1]);
+}
+
+/**
+  * @brief  Transmit with hardware retransmission while a higher priority node holds the bus.
+  * @param  None.
+  * @retval true:  The stuck requests timed out, the queue went on and every frame completed.
+  * @retval false: Failed.
+  */
+static bool run_watchdog(void)
+{
+  CanTxMsg                 canTxMsg   = {0};
+  CAN_TxCompletion         completion = {0};
+  CAN_RetransmitStatistics retransmit = {0};
+  uint32_t                 sent       = 0;
+  uint32_t                 tick       = 0;
+  
+  setup(CAN_WorkModeNormal);
+  CAN_SetTransmitCompleteCallback(CAN1, transmit_complete);
+  CAN_SetRetransmit(CAN1, CAN_RetransmitHardware, 0, 0);
+  CAN_SetTransmitTimeout(CAN1, WATCHDOG_TIMEOUT);
+  
+  memset(completeNumber, 0, sizeof(completeNumber));
+  completeHandle   = 0;
+  completeDisorder = 0;
+  
+  for(tick = 0; (tick < 10000) && ((sent < WATCHDOG_NUMBER) || (CAN_IsTransmitMessage(CAN1) == true)); tick++)
+  {
+    while((sent < WATCHDOG_NUMBER) && (CAN_IsTransmitBufferFull(CAN1) != true))
+    {
+      make_message(&canTxMsg, 0x300, sent++);
+      CAN_SendMessage(CAN1, &canTxMsg, 0);
+    }
+    
+    make_message(&canTxMsg, 0x080, tick);
+    
+    while((tick < WATCHDOG_FLOOD) && (BxCAN_Inject(&canTxMsg) == true))
+    {
+    }
+    
+    BxCAN_Run(TIMER_WHEEL_TICK * 1000ULL);
+    CAN_Tick();
+    
+    while(CAN_GetTransmitCompletion(CAN1, &completion, 1) > 0)
+    {
+    }
+  }
+  
+  CAN_GetRetransmitStatistics(CAN1, &retransmit);
+  CAN_SetTransmitCompleteCallback(CAN1, 0);
+  
+  printf("Transmit timeout of %u ms, hardware retransmit, a higher priority node flooding the bus for %u ms\n", WATCHDOG_TIMEOUT, WATCHDOG_FLOOD);
+  printf("  %u frames done after %u ms: sent %u, timed out %u, handles out of order %u\n", WATCHDOG_NUMBER, tick,
+         completeNumber[CAN_TxStatusOk], completeNumber[CAN_TxStatusTimeout], completeDisorder);
+  
+  return (completeNumber[CAN_TxStatusOk] + completeNumber[CAN_TxStatusTimeout] == WATCHDOG_NUMBER) && (completeNumber[CAN_TxStatusTimeout] > 0) &&
+         (completeNumber[CAN_TxStatusTimeout] == retransmit.Timeout) && (completeDisorder == 0) && (CAN_IsTransmitMessage(CAN1) != true);
+}
+
+/**
+  * @brief  Bus monitor measuring the time from CAN_SendUrgent() to the end of the urgent frame.
+  */
+static void bus_urgent(uint64_t Time, int32_t Node, const CanRxMsg *Message)
+{
+  uint64_t call = 0;
+  
+  if((Node == BXCAN_NODE_CAN1) && (Message->StdId == URGENT_ID))
+  {
+    memcpy(&call, Message->Data, sizeof(call));
+    
+    urgentLatencyTotal += Time - call;
+    urgentNumber++;
+    
+    if(Time - call > urgentLatencyMax)
+    {
+      urgentLatencyMax = Time - call;
+    }
+  }
+}
+
+/**
+  * @brief  Send urgent frames while queued ones are stuck behind a higher priority node.
+  * @param  None.
+  * @retval true:  Every urgent frame went out within URGENT_BOUND, the preempted frames were sent later.
+  * @retval false: Failed.
+  */
+static bool run_urgent(void)
+{
+  CanTxMsg             canTxMsg   = {0};
+  CAN_TxCompletion     completion = {0};
+  CAN_UrgentStatistics statistics = {0};
+  uint32_t             queued     = 0;
+  uint32_t             sent       = 0;
+  uint32_t             lost       = 0;
+  uint32_t             tick       = 0;
+  
+  setup(CAN_WorkModeNormal);
+  CAN_SetRetransmit(CAN1, CAN_RetransmitHardware, 0, 0);
+  BxCAN_SetBusCallback(bus_urgent);
+  
+  urgentLatencyMax   = 0;
+  urgentLatencyTotal = 0;
+  urgentNumber       = 0;
+  
+  for(uint32_t i = 0; i < URGENT_QUEUED; i++)
+  {
+    make_message(&canTxMsg, 0x300, i);
+    queued += CAN_SetTransmitMessage(CAN1, &canTxMsg, 1);
+  }
+  
+  for(tick = 0; (tick < 10000) && ((tick < URGENT_TIME) || (CAN_IsTransmitMessage(CAN1) == true)); tick++)
+  {
+    make_message(&canTxMsg, 0x200, tick);
+    
+    while((tick < URGENT_TIME) && (BxCAN_Inject(&canTxMsg) == true))
+    {
+    }
+    
+    BxCAN_Run(TIMER_WHEEL_TICK * 1000ULL / 2);
+    
+    if(tick < URGENT_TIME)
+    {
+      uint64_t call = BxCAN_GetTime();
+      
+      make_message(&canTxMsg, URGENT_ID, 0);
+      memcpy(canTxMsg.Data, &call, sizeof(call));
+      CAN_SendUrgent(CAN1, &canTxMsg);
+    }
+    
+    BxCAN_Run(TIMER_WHEEL_TICK * 1000ULL / 2);
+    
+    while(CAN_GetTransmitCompletion(CAN1, &completion, 1) > 0)
+    {
+      if(completion.Source == CAN_TxSourceMessage)
+      {
+        sent += (completion.Status == CAN_TxStatusOk) ? 1 : 0;
+        lost += (completion.Status != CAN_TxStatusOk) ? 1 : 0;
+      }
+    }
+  }
+  
+  CAN_GetUrgentStatistics(CAN1, &statistics);
+  
+  printf("Urgent frames, one per ms for %u ms, %u queued frames stuck behind a higher priority node\n", URGENT_TIME, queued);
+  printf("  urgent sent %u, refused %u, queued frames preempted %u, queued sent %u, lost %u after %u ms\n",
+         urgentNumber, statistics.Busy, statistics.Preempted, sent, lost, tick);
+  printf("  call to end of frame %.1f us average, %.1f us max\n", urgentLatencyTotal / 1e3 / ((urgentNumber > 0) ? urgentNumber : 1), urgentLatencyMax / 1e3);
+  
+  return (urgentNumber == URGENT_TIME) && (urgentLatencyMax < URGENT_BOUND) && (statistics.Preempted > 0) && (sent == queued) && (lost == 0);
+}
+
+/**
+  * @brief  Clear hook completing another pending mailbox between the status read and the clear.
+  */
+static void clear_race(CAN_TypeDef *CANx)
+{
+  if(raceArmed == true)
+  {
+    raceArmed     = false;
+    raceComplete += (BxCAN_CompleteTransmit(CANx) == true) ? 1 : 0;
+  }
+}
+
+/**
+  * @brief  Complete the second mailbox in flight while the transmit interrupt clears the first.
+  * @param  None.
+  * @retval true:  The urgent frame completing as the queued one is cleared, and the preempted
+  *                frame completing as the urgent one is cleared, were both reported.
+  * @retval false: Failed.
+  */
+static bool run_race(void)
+{
+  CanTxMsg             canTxMsg   = {0};
+  CAN_TxCompletion     completion = {0};
+  CAN_UrgentStatistics statistics = {0};
+  uint32_t             urgent     = 0;
+  uint32_t             queued     = 0;
+  bool                 resend     = false;
+  
+  setup(CAN_WorkModeNormal);
+  CAN_SetRetransmit(CAN1, CAN_RetransmitHardware, 0, 0);
+  BxCAN_SetClearHook(clear_race);
+  
+  raceComplete = 0;
+  
+  for(uint32_t i = 0; i < 2; i++)
+  {
+    make_message(&canTxMsg, 0x300, i);
+    CAN_SetTransmitMessage(CAN1, &canTxMsg, 1);
+    
+    /* First the queued frame is on the bus, then it waits behind a remote frame and is preempted. */
+    make_message(&canTxMsg, 0x200, i);
+    
+    for(uint32_t j = 0; (i == 1) && (j < 3); j++)
+    {
+      BxCAN_Inject(&canTxMsg);
+    }
+    
+    BxCAN_Run(50000);
+    
+    make_message(&canTxMsg, URGENT_ID, i);
+    CAN_SendUrgent(CAN1, &canTxMsg);
+    raceArmed = true;
+    
+    BxCAN_RunIdle(10000000);
+    
+    while(CAN_GetTransmitCompletion(CAN1, &completion, 1) > 0)
+    {
+      urgent += ((completion.Source == CAN_TxSourceUrgent) && (completion.Status == CAN_TxStatusOk)) ? 1 : 0;
+      queued += ((completion.Source == CAN_TxSourceMessage) && (completion.Status == CAN_TxStatusOk)) ? 1 : 0;
+    }
+  }
+  
+  BxCAN_SetClearHook(0);
+  
+  /* Neither mailbox is left stuck. */
+  make_message(&canTxMsg, URGENT_ID, 2);
+  resend = CAN_SendUrgent(CAN1, &canTxMsg);
+  BxCAN_RunIdle(10000000);
+  
+  CAN_GetUrgentStatistics(CAN1, &statistics);
+  
+  printf("Second mailbox completing while the transmit interrupt clears the first, 2 rounds\n");
+  printf("  completed in the window %u, urgent sent %u, queued sent %u, preempted %u, urgent accepted after %s\n",
+         raceComplete, urgent, queued, statistics.Preempted, (resend == true) ? "yes" : "no");
+  
+  return (raceComplete == 2) && (urgent == 2) && (queued == 2) && (statistics.Preempted == 1) && (resend == true) && (CAN_IsTransmitMessage(CAN1) != true);
+}
+
+/**
+  * @brief  Send an urgent frame while a node with a higher priority identifier holds the bus, and one after.
+  * @param  None.
+  * @retval true:  The stuck urgent frame timed out and the next one was accepted and sent.
+  * @retval false: Failed.
+  */
+static bool run_urgent_timeout(void)
+{
+  CanTxMsg             canTxMsg   = {0};
+  CAN_TxCompletion     completion = {0};
+  CAN_UrgentStatistics statistics = {0};
+  uint32_t             accepted   = 0;
+  uint32_t             sent       = 0;
+  uint32_t             timeout    = 0;
+  
+  setup(CAN_WorkModeNormal);
+  CAN_SetRetransmit(CAN1, CAN_RetransmitHardware, 0, 0);
+  CAN_SetTransmitTimeout(CAN1, WATCHDOG_TIMEOUT);
+  
+  for(uint32_t tick = 0; tick < 2 * WATCHDOG_FLOOD; tick++)
+  {
+    make_message(&canTxMsg, URGENT_ID - 1, tick);
+    
+    while((tick < WATCHDOG_FLOOD) && (BxCAN_Inject(&canTxMsg) == true))
+    {
+    }
+    
+    if((tick == WATCHDOG_FLOOD / 2) || (tick == WATCHDOG_FLOOD + WATCHDOG_FLOOD / 2))
+    {
+      make_message(&canTxMsg, URGENT_ID, tick);
+      accepted += (CAN_SendUrgent(CAN1, &canTxMsg) == true) ? 1 : 0;
+    }
+    
+    BxCAN_Run(TIMER_WHEEL_TICK * 1000ULL);
+    CAN_Tick();
+    
+    while(CAN_GetTransmitCompletion(CAN1, &completion, 1) > 0)
+    {
+      sent    += (completion.Status == CAN_TxStatusOk) ? 1 : 0;
+      timeout += (completion.Status == CAN_TxStatusTimeout) ? 1 : 0;
+    }
+  }
+  
+  CAN_GetUrgentStatistics(CAN1, &statistics);
+  
+  printf("Urgent frame behind a higher priority node for %u ms, transmit timeout of %u ms\n", WATCHDOG_FLOOD, WATCHDOG_TIMEOUT);
+  printf("  urgent accepted %u, timed out %u, sent %u, refused %u\n", accepted, timeout, sent, statistics.Busy);
+  
+  return (accepted == 2) && (timeout == 1) && (statistics.Timeout == 1) && (sent == 1);
+}
+
+/**
+  * @brief  Bus monitor counting the frames of the flooding class and of the other identifier.
+  */
+static void bus_rate(uint64_t Time, int32_t Node, const CanRxMsg *Message)
+{
+  if(Node == BXCAN_NODE_CAN1)
+  {
+    rateFrames[(Message->StdId == RATE_FLOOD_ID) ? 0 : 1]++;
+  }
+}
+
+/**
+  * @brief  Flood the transmit buffer with a rate limited class beside one other frame every tick.
+  * @param  [in] Action: For a flooding frame without a token.
+  * @param  [in] Name:   Printed name of the run.
+  * @retval true:  The class kept its rate, every frame completed, rejected ones
+  *                throttled, and the other identifier went out every tick. Deferred
+  *                frames complete after later frames of the other identifier.
+  * @retval false: Failed.
+  */
+static bool run_rate(CAN_RateAction Action, const char *Name)
+{
+  CanTxMsg           canTxMsg   = {0};
+  CAN_RateLimit      limit      = {CAN_Id_Standard, RATE_FLOOD_ID, RATE_FLOOD_ID | 0xFF, RATE_LIMIT, RATE_BURST, Action};
+  CAN_RateStatistics statistics = {0};
+  uint32_t           flood      = 0;
+  uint32_t           other      = 0;
+  uint32_t           tick       = 0;
+  
+  setup(CAN_WorkModeLoopBack);
+  CAN_SetReceiveMessageCallback(CAN1, drop_message);
+  CAN_SetTransmitCompleteCallback(CAN1, transmit_complete);
+  CAN_SetRateLimit(CAN1, 0, &limit);
+  BxCAN_SetBusCallback(bus_rate);
+  
+  memset(completeNumber, 0, sizeof(completeNumber));
+  memset(rateFrames, 0, sizeof(rateFrames));
+  completeHandle   = 0;
+  completeDisorder = 0;
+  
+  for(tick = 0; (tick < 10000) && ((tick < RATE_TIME) || (CAN_IsTransmitMessage(CAN1) == true)); tick++)
+  {
+    if(tick < RATE_TIME)
+    {
+      make_message(&canTxMsg, RATE_OTHER_ID, tick);
+      other += CAN_SetTransmitMessage(CAN1, &canTxMsg, 1);
+      
+      make_message(&canTxMsg, RATE_FLOOD_ID, tick);
+      
+      while(CAN_IsTransmitBufferFull(CAN1) != true)
+      {
+        flood += CAN_SetTransmitMessage(CAN1, &canTxMsg, 1);
+      }
+    }
+    
+    BxCAN_Run(TIMER_WHEEL_TICK * 1000ULL);
+    CAN_Tick();
+  }
+  
+  CAN_GetRateStatistics(CAN1, 0, &statistics);
+  limit.Rate = 0;
+  CAN_SetRateLimit(CAN1, 0, &limit);
+  CAN_SetTransmitCompleteCallback(CAN1, 0);
+  CAN_SetReceiveMessageCallback(CAN1, 0);
+  
+  printf("Rate limit of %u frames per s, burst %u, a class flooding the transmit buffer for %u ms, %s\n", RATE_LIMIT, RATE_BURST, RATE_TIME, Name);
+  printf("  flooding class: queued %u, sent %u (%.1f per s), deferred %u, rejected %u, throttled completions %u\n", flood, rateFrames[0],
+         rateFrames[0] * 1000.0 / tick, statistics.Deferred, statistics.Rejected, completeNumber[CAN_TxStatusThrottled]);
+  printf("  other identifier: queued %u, sent %u, done after %u ms, handles out of order %u\n", other, rateFrames[1], tick, completeDisorder);
+  
+  bool result = (rateFrames[0] == statistics.Passed) && (rateFrames[0] <= RATE_BURST + RATE_LIMIT * tick / 1000 + 1) &&
+                (statistics.Passed + statistics.Rejected == flood) && (completeNumber[CAN_TxStatusThrottled] == statistics.Rejected) &&
+                (completeNumber[CAN_TxStatusOk] == rateFrames[0] + rateFrames[1]) && (rateFrames[1] == other) && (other == RATE_TIME) &&
+                (rateFrames[0] >= RATE_LIMIT * RATE_TIME / 1000);
+  
+  if(Action == CAN_RateReject)
+  {
+    return result && (completeDisorder == 0);
+  }
+  
+  return result && (statistics.Deferred > 0);
+}
+
+/**
+  * @brief  Clear the transmit buffer while frames of a rate limited class are deferred.
+  * @param  None.
+  * @retval true:  The channel went idle, and a message of each identifier sent afterwards went out.
+  * @retval false: Failed.
+  */
+static bool run_rate_clear(void)
+{
+  CanTxMsg           canTxMsg   = {0};
+  CAN_RateLimit      limit      = {CAN_Id_Standard, RATE_FLOOD_ID, RATE_FLOOD_ID | 0xFF, RATE_LIMIT, 1, CAN_RateDefer};
+  CAN_RateStatistics statistics = {0};
+  bool               idle       = false;
+  uint32_t           tick       = 0;
+  
+  setup(CAN_WorkModeLoopBack);
+  CAN_SetReceiveMessageCallback(CAN1, drop_message);
+  CAN_SetRateLimit(CAN1, 0, &limit);
+  BxCAN_SetBusCallback(bus_rate);
+  
+  memset(rateFrames, 0, sizeof(rateFrames));
+  
+  /* The first one takes the token, the others are deferred. */
+  for(uint32_t i = 0; i < 3; i++)
+  {
+    make_message(&canTxMsg, RATE_FLOOD_ID, i);
+    CAN_SetTransmitMessage(CAN1, &canTxMsg, 1);
+  }
+  
+  BxCAN_RunIdle(1000000);
+  CAN_GetRateStatistics(CAN1, 0, &statistics);
+  CAN_ClearTransmitBuffer(CAN1);
+  idle = (CAN_IsTransmitMessage(CAN1) != true);
+  
+  make_message(&canTxMsg, RATE_OTHER_ID, 0);
+  CAN_SetTransmitMessage(CAN1, &canTxMsg, 1);
+  make_message(&canTxMsg, RATE_FLOOD_ID, 3);
+  CAN_SetTransmitMessage(CAN1, &canTxMsg, 1);
+  
+  for(tick = 0; (tick < 1000) && (CAN_IsTransmitMessage(CAN1) == true); tick++)
+  {
+    BxCAN_Run(TIMER_WHEEL_TICK * 1000ULL);
+    CAN_Tick();
+  }
+  
+  limit.Rate = 0;
+  CAN_SetRateLimit(CAN1, 0, &limit);
+  CAN_SetReceiveMessageCallback(CAN1, 0);
+  
+  printf("Transmit buffer cleared with %u frames deferred by the rate limit\n", statistics.Deferred);
+  printf("  idle after the clear %s, then sent %u of the class and %u other after %u ms\n", (idle == true) ? "yes" : "no", rateFrames[0] - 1, rateFrames[1], tick);
+  
+  return (statistics.Deferred == 2) && (idle == true) && (rateFrames[0] == 2) && (rateFrames[1] == 1) && (CAN_IsTransmitMessage(CAN1) != true);
+}
+
+/**
+  * @brief  Bus monitor counting the forwarded frames and checking their order.
+  */
+static void bus_gateway(uint64_t Time, int32_t Node, const CanRxMsg *Message)
+{
+  if((Node != BXCAN_NODE_REMOTE) && (Message->StdId == (GATEWAY_ID | GATEWAY_FORWARD)))
+  {
+    uint32_t sequence = get_sequence(Message);
+    
+    if(sequence < gatewayNext)
+    {
+      gatewayDisorder++;
+    }
+    
+    gatewayNext = sequence + 1;
+    gatewayForwarded++;
+  }
+}
+
+/**
+  * @brief  The application side of the gateway: take the received frames and forward them without a copy.
+  * @param  [in] CANx:    The channel forwarded to.
+  * @param  [in] Forward: false to hold every frame taken, as a stalled consumer does.
+  * @return None.
+  */
+static void gateway_poll(CAN_TypeDef *CANx, bool Forward)
+{
+  CanRxMsg *frame = 0;
+  uint32_t  sent  = 0;
+  
+  while((frame = CAN_GetReceiveFrame(CAN1)) != 0)
+  {
+    frame->StdId |= GATEWAY_FORWARD;
+    gatewayHeld[gatewayHeldNumber++] = frame;
+    gatewayReceived++;
+  }
+  
+  /* In order, a frame the transmit queue has no room for is kept and tried again. */
+  while((Forward == true) && (sent < gatewayHeldNumber) && (CAN_SetTransmitFrame(CANx, gatewayHeld[sent]) == true))
+  {
+    sent++;
+  }
+  
+  memmove(gatewayHeld, &gatewayHeld[sent], sizeof(gatewayHeld[0]) * (gatewayHeldNumber - sent));
+  gatewayHeldNumber -= sent;
+}
+
+/**
+  * @brief  Forward frames received in frame mode, CAN1 to CAN2 on the connectivity line and back
+  *         to CAN1 otherwise, then let the receive queue and the frame pool overflow.
+  * @param  None.
+  * @retval true:  Every frame was forwarded in order while the gateway kept up, a stall lost only
+  *                what the receive queue could not hold, holding frames lost only what the pool
+  *                could not hold, and every frame went back to the pool.
+  * @retval false: Failed.
+  */
+static bool run_gateway(void)
+{
+#ifdef STM32F10X_CL
+  CAN_TypeDef       *canx      = CAN2;
+#else
+  CAN_TypeDef       *canx      = CAN1;
+#endif /* STM32F10X_CL */
+  const CAN_FilterId filter    = {CAN_Id_Standard, GATEWAY_ID, 0x7FF};
+  CanTxMsg           canTxMsg  = {0};
+  uint32_t           sequence  = 0;
+  uint32_t           received  = 0;
+  uint32_t           fail      = 0;
+  uint32_t           stall[2]  = {0};  /* Frames received, allocations failed. */
+  uint32_t           hold[2]   = {0};
+  bool               forward   = false;
+  
+  setup(CAN_WorkModeNormal);
+  CAN_SetReceiveFilter(CAN1, &filter, 1);
+  FramePool_Init();
+  CAN_SetReceiveFrameMode(CAN1, true);
+  BxCAN_SetBusCallback(bus_gateway);
+  
+#ifdef STM32F10X_CL
+  CAN_Configure(CAN2, CAN_WorkModeNormal, CAN_BaudRate1000K, 0, 0);
+#endif /* STM32F10X_CL */
+  
+  /* The forwarded frames lose arbitration to the bursts. */
+  CAN_SetRetransmit(canx, CAN_RetransmitHardware, 0, 0);
+  
+  gatewayHeldNumber = 0;
+  gatewayReceived   = 0;
+  gatewayForwarded  = 0;
+  gatewayNext       = 0;
+  gatewayDisorder   = 0;
+  
+  /* Forwarded as they arrive. */
+  for(uint32_t i = 0; i < GATEWAY_NUMBER; i++)
+  {
+    make_message(&canTxMsg, GATEWAY_ID, sequence++);
+    BxCAN_Inject(&canTxMsg);
+    
+    for(uint32_t t = 0; t < GATEWAY_PERIOD; t += POLL_PERIOD)
+    {
+      BxCAN_Run(POLL_PERIOD);
+      gateway_poll(canx, true);
+    }
+  }
+  
+  BxCAN_RunIdle(1000000);
+  forward = (gatewayReceived == GATEWAY_NUMBER) && (gatewayForwarded == GATEWAY_NUMBER);
+  
+  /* The gateway stalls: the receive queue fills up, the pool does not. */
+  received = gatewayReceived;
+  fail     = FramePool_GetAllocFailNumber();
+  
+  for(uint32_t i = 0; i < GATEWAY_BURST; i++)
+  {
+    make_message(&canTxMsg, GATEWAY_ID, sequence++);
+    BxCAN_Inject(&canTxMsg);
+  }
+  
+  BxCAN_RunIdle(1000000000);
+  gateway_poll(canx, true);
+  BxCAN_RunIdle(1000000000);
+  stall[0] = gatewayReceived - received;
+  stall[1] = FramePool_GetAllocFailNumber() - fail;
+  
+  /* The gateway takes the frames but holds them: the pool runs dry. */
+  received = gatewayReceived;
+  fail     = FramePool_GetAllocFailNumber();
+  
+  for(uint32_t i = 0; i < GATEWAY_BURST; i++)
+  {
+    make_message(&canTxMsg, GATEWAY_ID, sequence++);
+    BxCAN_Inject(&canTxMsg);
+  }
+  
+  while(BxCAN_GetInjectNumber() > 0)
+  {
+    BxCAN_Run(POLL_PERIOD);
+    gateway_poll(canx, false);
+  }
+  
+  hold[0] = gatewayReceived - received;
+  hold[1] = FramePool_GetAllocFailNumber() - fail;
+  
+  /* Released, everything held goes out and the gateway forwards again. */
+  make_message(&canTxMsg, GATEWAY_ID, sequence++);
+  BxCAN_Inject(&canTxMsg);
+  
+  for(uint32_t t = 0; (t < 100000000) && ((gatewayHeldNumber > 0) || (BxCAN_GetInjectNumber() > 0) || (CAN_IsTransmitMessage(canx) == true)); t += POLL_PERIOD)
+  {
+    gateway_poll(canx, true);
+    BxCAN_Run(POLL_PERIOD);
+  }
+  
+  gateway_poll(canx, true);
+  BxCAN_RunIdle(1000000);
+  CAN_SetReceiveFrameMode(CAN1, false);
+  
+#ifdef STM32F10X_CL
+  CAN_Unconfigure(CAN2);
+#endif /* STM32F10X_CL */
+  
+  printf("Gateway in frame mode, %u frames forwarded one every %u us, then bursts of %u\n", GATEWAY_NUMBER, GATEWAY_PERIOD / 1000, GATEWAY_BURST);
+  printf("  forwarded %u of %u, out of order %u\n", gatewayForwarded, gatewayReceived, gatewayDisorder);
+  printf("  stalled: received %u, pool empty %u; holding frames: received %u, pool empty %u; pool free %u of %u\n",
+         stall[0], stall[1], hold[0], hold[1], FramePool_GetFreeNumber(), FRAME_POOL_SIZE);
+  
+  return (forward == true) && (gatewayDisorder == 0) && (gatewayForwarded == gatewayReceived) && (gatewayHeldNumber == 0) &&
+         (stall[0] == CAN1_RX_BUFFER_SIZE) && (stall[1] == 0) && (hold[0] == FRAME_POOL_SIZE) && (hold[1] == GATEWAY_BURST - FRAME_POOL_SIZE) &&
+         (FramePool_GetFreeNumber() == FRAME_POOL_SIZE);
+}
+
+/**
+  * @brief  Receive finish callback of the ISO-TP receiving session.
+  */
+static void isotp_receive(uint32_t Session, const uint8_t *Data, uint32_t Length, ISOTP_Result Result)
+{
+  if(Result == ISOTP_ResultOk)
+  {
+    isotpLength = Length;
+    isotpEnd    = BxCAN_GetTime();
+  }
+}
+
+/**
+  * @brief  Send the largest segmented message between two sessions at 500 kbit/s and compare the
+  *         throughput with the bus limit of ISOTP_GetThroughputLimit().
+  * @param  [in] BlockSize: Announced by the receiver.
+  * @param  [in] STmin:     Announced by the receiver, in milliseconds.
+  * @param  [in] Name:      Printed name of the run.
+  * @retval true:  The message arrived intact without error, within 10% of the limit less
+  *                the flow control frames and the separation time.
+  * @retval false: Failed.
+  */
+static bool run_isotp(uint8_t BlockSize, uint8_t STmin, const char *Name)
+{
+  ISOTP_Config     tester     = {CAN1, CAN_Id_Standard, ISOTP_TX_ID, ISOTP_RX_ID, 0, 0, 0, 0, 0, 0};
+  ISOTP_Config     ecu        = {CAN1, CAN_Id_Standard, ISOTP_RX_ID, ISOTP_TX_ID, BlockSize, STmin, isotpBuffer, sizeof(isotpBuffer), 0, isotp_receive};
+  ISOTP_Statistics statistics = {0};
+  CAN_FilterId     filter     = {CAN_Id_Standard, ISOTP_TX_ID, 0x7F7};  /* Both identifiers. */
+  uint32_t         limit      = ISOTP_GetThroughputLimit(CAN_BaudRate500K, CAN_Id_Standard);
+  uint64_t         start      = 0;
+  uint32_t         tick       = 0;
+  
+  setup(CAN_WorkModeLoopBack);
+  CAN_Unconfigure(CAN1);
+  CAN_Configure(CAN1, CAN_WorkModeLoopBack, CAN_BaudRate500K, 0, 0);
+  CAN_SetReceiveFilter(CAN1, &filter, 1);
+  CAN_SetReceiveMessageCallback(CAN1, ISOTP_Input);
+  CAN_SetTransmitFinishCallback(CAN1, ISOTP_Process);
+  ISOTP_Open(0, &tester);
+  ISOTP_Open(1, &ecu);
+  
+  for(uint32_t i = 0; i < ISOTP_LENGTH; i++)
+  {
+    isotpData[i] = i * 7 + BlockSize + STmin;
+  }
+  
+  memset(isotpBuffer, 0, sizeof(isotpBuffer));
+  isotpLength = 0;
+  isotpEnd    = 0;
+  start       = BxCAN_GetTime();
+  
+  bool result = ISOTP_Transmit(0, isotpData, ISOTP_LENGTH);
+  
+  for(tick = 0; (tick < 10000) && ((isotpLength == 0) || (ISOTP_IsTransmitBusy(0) == true)); tick++)
+  {
+    BxCAN_Run(ISOTP_TICK_PERIOD * 1000000ULL);
+    ISOTP_Tick();
+  }
+  
+  ISOTP_GetStatistics(1, &statistics);
+  ISOTP_Close(0);
+  ISOTP_Close(1);
+  CAN_SetTransmitFinishCallback(CAN1, 0);
+  CAN_SetReceiveMessageCallback(CAN1, 0);
+  
+  uint32_t measured = (isotpEnd > start) ? (uint32_t)(ISOTP_LENGTH * 1000000000ULL / (isotpEnd - start)) : 0;
+  uint32_t expected = limit;
+  
+  /* A flow control frame after every block, one consecutive frame per separation time and tick. */
+  if(BlockSize > 0)
+  {
+    expected = expected * BlockSize / (BlockSize + 1);
+  }
+  
+  if((STmin > 0) && (expected > 7000 / (STmin + ISOTP_TICK_PERIOD)))
+  {
+    expected = 7000 / (STmin + ISOTP_TICK_PERIOD);
+  }
+  
+  printf("ISO-TP transfer of %u bytes at %u bit/s, %s\n", ISOTP_LENGTH, CAN_GetBitRate(CAN_BaudRate500K), Name);
+  printf("  %.2f ms on the bus, %u bytes per s, bus limit %u (%.1f%%), expected %u, receiver reports %u bytes in %u ms (%u bytes per s)\n",
+         (isotpEnd - start) / 1e6, measured, limit, measured * 100.0 / limit, expected, statistics.ReceiveLength, statistics.ReceiveTime,
+         ISOTP_GetThroughput(statistics.ReceiveLength, statistics.ReceiveTime));
+  
+  return result && (isotpLength == ISOTP_LENGTH) && (memcmp(isotpBuffer, isotpData, ISOTP_LENGTH) == 0) &&
+         (statistics.Error == 0) && (measured >= expected * 9 / 10);
+}
+
+/**
+  * @brief  Send a single frame to a session without a receive buffer, as the bootloader leaves it
+  *         while both page buffers are busy.
+  * @param  None.
+  * @retval true:  The frame was held and delivered once a buffer was set, and reported as an
+  *                overflow when sent again to a buffer too small.
+  * @retval false: Failed.
+  */
+static bool run_isotp_hold(void)
+{
+  ISOTP_Config tester   = {CAN1, CAN_Id_Standard, ISOTP_TX_ID, ISOTP_RX_ID, 0, 0, 0, 0, 0, 0};
+  ISOTP_Config ecu      = {CAN1, CAN_Id_Standard, ISOTP_RX_ID, ISOTP_TX_ID, 0, 0, 0, 0, 0, isotp_receive};
+  CAN_FilterId filter   = {CAN_Id_Standard, ISOTP_TX_ID, 0x7F7};
+  uint8_t      end[5]   = {0x03, 0x12, 0x34, 0x56, 0x78};
+  bool         held     = false;
+  uint32_t     length   = 0;
+  
+  ISOTP_Statistics statistics = {0};
+  
+  setup(CAN_WorkModeLoopBack);
+  CAN_SetReceiveFilter(CAN1, &filter, 1);
+  CAN_SetReceiveMessageCallback(CAN1, ISOTP_Input);
+  ISOTP_Open(0, &tester);
+  ISOTP_Open(1, &ecu);
+  
+  memset(isotpBuffer, 0, sizeof(isotpBuffer));
+  isotpLength = 0;
+  
+  ISOTP_Transmit(0, end, sizeof(end));
+  BxCAN_RunIdle(1000000);
+  held = (isotpLength == 0) && (ISOTP_IsReceiveBusy(1) == true);
+  
+  ISOTP_SetReceiveBuffer(1, isotpBuffer, sizeof(isotpBuffer));
+  length = isotpLength;
+  
+  /* Too long for the buffer, dropped with an error and no delivery. */
+  isotpLength = 0;
+  ISOTP_SetReceiveBuffer(1, isotpBuffer, 2);
+  ISOTP_Transmit(0, end, sizeof(end));
+  BxCAN_RunIdle(1000000);
+  ISOTP_GetStatistics(1, &statistics);
+  
+  ISOTP_Close(0);
+  ISOTP_Close(1);
+  CAN_SetReceiveMessageCallback(CAN1, 0);
+  
+  printf("ISO-TP single frame without a receive buffer: held %s, delivered %u bytes once a buffer was set\n", (held == true) ? "yes" : "no", length);
+  printf("  into a buffer of 2 bytes: delivered %u bytes, %u errors\n", isotpLength, statistics.Error);
+  
+  return (held == true) && (length == sizeof(end)) && (memcmp(isotpBuffer, end, sizeof(end)) == 0) &&
+         (isotpLength == 0) && (statistics.Error == 1);
+}
+
+/**
+  * @brief  Start the J1939 layer on CAN1 at 250 kbit/s, the remote node scripted by bus_j1939().
+  * @param  [in] Address: Preferred address.
+  * @return None.
+  */
+static void j1939_setup(uint8_t Address)
+{
+  J1939_Config config = {CAN1, J1939_NAME, Address, j1939_receive, 0, j1939_address};
+  
+  setup(CAN_WorkModeNormal);
+  CAN_Unconfigure(CAN1);
+  CAN_Configure(CAN1, CAN_WorkModeNormal, CAN_BaudRate250K, 0, 0);
+  CAN_SetReceiveMessageCallback(CAN1, J1939_Input);
+  CAN_SetTransmitFinishCallback(CAN1, J1939_Process);
+  BxCAN_SetBusCallback(bus_j1939);
+  
+  j1939Contest  = false;
+  j1939Claims   = 0;
+  j1939Reported = J1939_ADDRESS_GLOBAL;
+  j1939Length   = 0;
+  j1939Intact   = false;
+  j1939End      = 0;
+  j1939EoMA     = false;
+  
+  J1939_Init(&config);
+}
+
+/**
+  * @brief  Queue a frame of the remote J1939 node.
+  * @param  [in] PGN:  Parameter group number.
+  * @param  [in] DA:   Destination address.
+  * @param  [in] Data: 8 data bytes.
+  * @return None.
+  */
+static void j1939_peer_send(uint32_t PGN, uint8_t DA, const uint8_t *Data)
+{
+  CanTxMsg canTxMsg = {0};
+  
+  canTxMsg.ExtId = J1939_MakeId(7, PGN, DA, J1939_PEER);
+  canTxMsg.IDE   = CAN_Id_Extended;
+  canTxMsg.RTR   = CAN_RTR_Data;
+  canTxMsg.DLC   = 8;
+  
+  memcpy(canTxMsg.Data, Data, 8);
+  BxCAN_Inject(&canTxMsg);
+}
+
+/**
+  * @brief  Queue a data packet of the remote node, byte n of the message holding n modulo 251.
+  * @param  [in] DA:       Destination address.
+  * @param  [in] Sequence: Sequence number of the packet, from 1.
+  * @return None.
+  */
+static void j1939_peer_packet(uint8_t DA, uint8_t Sequence)
+{
+  uint8_t data[8] = {Sequence};
+  
+  for(uint32_t i = 0; i < 7; i++)
+  {
+    uint32_t offset = (Sequence - 1) * 7 + i;
+    
+    data[1 + i] = (offset < J1939_MESSAGE_SIZE_MAX) ? (offset % 251) : 0xFF;
+  }
+  
+  j1939_peer_send(J1939_PGN_TP_DT, DA, data);
+}
+
+/**
+  * @brief  Address callback of the J1939 layer.
+  */
+static void j1939_address(uint8_t Address)
+{
+  j1939Reported = Address;
+}
+
+/**
+  * @brief  Receive callback of the J1939 layer, checking the reassembled message.
+  */
+static void j1939_receive(uint32_t PGN, uint8_t SA, uint8_t DA, const uint8_t *Data, uint32_t Length)
+{
+  j1939Length = Length;
+  j1939Intact = (PGN == J1939_PGN) && (SA == J1939_PEER);
+  j1939End    = BxCAN_GetTime();
+  
+  for(uint32_t i = 0; i < Length; i++)
+  {
+    j1939Intact &= (Data[i] == i % 251);
+  }
+}
+
+/**
+  * @brief  The remote J1939 node: contests address claims, and answers a CTS with its window of packets.
+  */
+static void bus_j1939(uint64_t Time, int32_t Node, const CanRxMsg *Message)
+{
+  if(Node != BXCAN_NODE_CAN1)
+  {
+    return;
+  }
+  
+  uint32_t pgn = J1939_GetPGN(Message->ExtId);
+  uint8_t  sa  = J1939_GetSA(Message->ExtId);
+  
+  if(pgn == J1939_PGN_ADDRESS_CLAIM)
+  {
+    const uint8_t name[8] = {0};
+    
+    j1939Claims++;
+    
+    /* The lower NAME wins every address. */
+    if((j1939Contest == true) && (sa != J1939_ADDRESS_NULL))
+    {
+      CanTxMsg canTxMsg = {0};
+      
+      canTxMsg.ExtId = J1939_MakeId(6, J1939_PGN_ADDRESS_CLAIM, J1939_ADDRESS_GLOBAL, sa);
+      canTxMsg.IDE   = CAN_Id_Extended;
+      canTxMsg.RTR   = CAN_RTR_Data;
+      canTxMsg.DLC   = 8;
+      
+      memcpy(canTxMsg.Data, name, 8);
+      BxCAN_Inject(&canTxMsg);
+    }
+  }
+  else if((pgn == J1939_PGN_TP_CM) && (J1939_GetDA(Message->ExtId) == J1939_PEER))
+  {
+    /* CTS: number of packets and next sequence number. EoMA ends the transfer. */
+    if(Message->Data[0] == 17)
+    {
+      for(uint32_t i = 0; i < Message->Data[1]; i++)
+      {
+        j1939_peer_packet(sa, Message->Data[2] + i);
+      }
+    }
+    else if(Message->Data[0] == 19)
+    {
+      j1939EoMA = true;
+    }
+  }
+}
+
+/**
+  * @brief  Claim an address below 128 against a node contesting every claim.
+  * @param  None.
+  * @retval true:  The layer gave up after the preferred address and one lap of 128 to 247.
+  * @retval false: Failed.
+  */
+static bool run_j1939_claim(void)
+{
+  uint32_t tick = 0;
+  
+  j1939_setup(J1939_PEER);
+  j1939Contest = true;
+  
+  for(tick = 0; (tick < 10000) && (j1939Reported == J1939_ADDRESS_GLOBAL); tick++)
+  {
+    BxCAN_Run(TIMER_WHEEL_TICK * 1000ULL);
+    J1939_Tick();
+  }
+  
+  BxCAN_RunIdle(1000000);
+  CAN_SetTransmitFinishCallback(CAN1, 0);
+  CAN_SetReceiveMessageCallback(CAN1, 0);
+  
+  printf("J1939 address claim contested at every address, preferred 0x%02X\n", J1939_PEER);
+  printf("  reported 0x%02X after %u claims in %u ms\n", j1939Reported, j1939Claims, tick);
+  
+  /* The preferred address, 120 self-configurable ones and the cannot claim message. */
+  return (j1939Reported == J1939_ADDRESS_NULL) && (J1939_GetAddress() == J1939_ADDRESS_NULL) && (j1939Claims == 1 + 120 + 1);
+}
+
+/**
+  * @brief  Receive the largest multipacket message at 250 kbit/s and compare its rate with the bus.
+  * @param  [in] Broadcast: BAM, packets every J1939_BAM_INTERVAL ms, instead of RTS/CTS, the
+  *                         remote sending each window back to back.
+  * @retval true:  The message arrived intact, nothing aborted or timed out.
+  * @retval false: Failed.
+  */
+static bool run_j1939(bool Broadcast)
+{
+  uint32_t         length     = J1939_MESSAGE_SIZE_MAX;
+  uint32_t         packets    = (length + 6) / 7;
+  uint32_t         bitRate    = CAN_GetBitRate(CAN_BaudRate250K);
+  uint8_t          da         = (Broadcast == true) ? J1939_ADDRESS_GLOBAL : J1939_NODE;
+  uint8_t          cm[8]      = {(Broadcast == true) ? 32 : 16, length, length >> 8, packets, 0xFF, J1939_PGN & 0xFF, J1939_PGN >> 8, J1939_PGN >> 16};
+  J1939_Statistics statistics = {0};
+  uint64_t         start      = 0;
+  uint32_t         sent       = 0;
+  uint32_t         tick       = 0;
+  double           theory     = 0;
+  
+  j1939_setup(J1939_NODE);
+  
+  for(tick = 0; (tick < 1000) && (J1939_GetAddress() != J1939_NODE); tick++)
+  {
+    BxCAN_Run(TIMER_WHEEL_TICK * 1000ULL);
+    J1939_Tick();
+  }
+  
+  start = BxCAN_GetTime();
+  j1939_peer_send(J1939_PGN_TP_CM, da, cm);
+  
+  for(tick = 0; (tick < 20000) && (j1939Length == 0); tick++)
+  {
+    if((Broadcast == true) && (sent < packets) && (tick % J1939_BAM_INTERVAL == J1939_BAM_INTERVAL - 1))
+    {
+      j1939_peer_packet(da, ++sent);
+    }
+    
+    BxCAN_Run(TIMER_WHEEL_TICK * 1000ULL);
+    J1939_Tick();
+  }
+  
+  BxCAN_RunIdle(1000000);
+  J1939_GetStatistics(&statistics);
+  CAN_SetTransmitFinishCallback(CAN1, 0);
+  CAN_SetReceiveMessageCallback(CAN1, 0);
+  
+  /* Bytes per second with the bus fully used: the announcement, the packets and, for RTS/CTS, one CTS a window. */
+  if(Broadcast == true)
+  {
+    theory = length * 1000.0 / (packets * J1939_BAM_INTERVAL);
+  }
+  else
+  {
+    theory = length * (double)bitRate / ((1 + packets + (packets + J1939_CTS_PACKETS - 1) / J1939_CTS_PACKETS) * J1939_FRAME_BITS);
+  }
+  
+  double measured = (j1939End > start) ? length * 1e9 / (j1939End - start) : 0;
+  
+  printf("J1939 %s of %u bytes in %u packets at %u bit/s\n", (Broadcast == true) ? "BAM" : "RTS/CTS", length, packets, bitRate);
+  printf("  %.2f ms on the bus, %.0f bytes per s, %.0f in theory (%.0f%%), layer reassembly %u bytes in %u ms\n",
+         (j1939End - start) / 1e6, measured, theory, measured * 100 / theory, statistics.Bytes, statistics.Time);
+  
+  return (j1939Length == length) && (j1939Intact == true) && (statistics.Messages == 1) && (statistics.Abort == 0) &&
+         (statistics.Timeout == 0) && ((Broadcast == true) || (j1939EoMA == true));
+}
+
+/**
+  * @brief  Receive at full load, FIFO 0 polled periodically in the hybrid receive mode.
+  * @param  [in] Burst:  Messages by interrupt in one poll period that switch to polling, 0 for interrupt only.
+  * @param  [in] Period: Nanoseconds of bus time between two polls.
+  * @param  [in] Name:   Printed name of the run.
+  * @retval true:  Nothing lost, the hybrid mode took few interrupts and went back to the interrupt when idle.
+  * @retval false: Failed.
+  */
+static bool run_poll(uint32_t Burst, uint32_t Period, const char *Name)
+{
+  CanTxMsg             canTxMsg   = {0};
+  CanRxMsg             canRxMsg   = {0};
+  CAN_RxPollStatistics statistics = {0};
+  Core_IRQStatistics   rx         = {0};
+  uint64_t             pollTime   = 0;
+  uint32_t             injected   = 0;
+  uint32_t             received   = 0;
+  uint32_t             expected   = 0;
+  uint32_t             gaps       = 0;
+  
+  setup(CAN_WorkModeNormal);
+  CAN_SetReceivePolling(CAN1, Burst, RX_POLL_IDLE);
+  
+  /* Run on after the last frame, the idle polls switch back to the interrupt. */
+  for(uint32_t idle = 0; idle <= RX_POLL_IDLE; )
+  {
+    while((injected < FRAME_NUMBER) && (BxCAN_GetInjectNumber() < BXCAN_REMOTE_QUEUE_SIZE))
+    {
+      make_message(&canTxMsg, 0x200, injected++);
+      BxCAN_Inject(&canTxMsg);
+    }
+    
+    BxCAN_Run(Period);
+    
+    uint64_t start = Core_GetHostTime();
+    
+    CAN_PollReceive(CAN1);
+    pollTime += Core_GetHostTime() - start;
+    
+    while(CAN_GetReceiveMessage(CAN1, &canRxMsg, 1) == 1)
+    {
+      uint32_t sequence = get_sequence(&canRxMsg);
+      
+      gaps     += sequence - expected;
+      expected  = sequence + 1;
+      received++;
+    }
+    
+    if((injected == FRAME_NUMBER) && (BxCAN_GetInjectNumber() == 0))
+    {
+      idle++;
+    }
+  }
+  
+  gaps += FRAME_NUMBER - expected;
+  
+  CAN_GetReceivePollStatistics(CAN1, &statistics);
+  Core_GetIRQStatistics(RX0_IRQn, &rx);
+  
+  printf("Receive at full load, FIFO 0 polled every %u us, %s\n", Period / 1000, Name);
+  printf("  received %u, lost %u, RX interrupts %u (%.3f per frame), polled %u, FIFO full interrupts %u, switches %u/%u\n", received, gaps,
+         rx.Count, (double)rx.Count / FRAME_NUMBER, statistics.Polled, statistics.Full, statistics.Enter, statistics.Leave);
+  printf("  host time per frame: RX interrupt %.1f ns, polls %.1f ns\n", (double)rx.HostTime / FRAME_NUMBER, (double)pollTime / FRAME_NUMBER);
+  
+  CAN_SetReceivePolling(CAN1, 0, RX_POLL_IDLE);
+  
+  if(Burst == 0)
+  {
+    return (received == FRAME_NUMBER) && (rx.Count == FRAME_NUMBER);
+  }
+  
+  return (received == FRAME_NUMBER) && (statistics.Interrupt + statistics.Polled + 3 * statistics.Full >= FRAME_NUMBER) &&
+         (rx.Count < FRAME_NUMBER / 2) && (statistics.Enter > 0) && (statistics.Leave == statistics.Enter);
+}
+
+/**
+  * @brief  Receive callback slower than the bus, the next frame is in FIFO 0 before it returns.
+  */
+static bool poll_flood(CAN_TypeDef *CANx, const CanRxMsg *Message)
+{
+  pollFlood++;
+  
+  /* One frame short of full, the FIFO full interrupt stays out of it. */
+  while((CAN_MessagePending(CANx, CAN_FIFO0) < 2) && (BxCAN_GetInjectNumber() > 0))
+  {
+    BxCAN_Run(1000);
+  }
+  
+  return true;
+}
+
+/**
+  * @brief  Poll FIFO 0 while the receive callback is slower than the frames arrive.
+  * @param  None.
+  * @retval true:  CAN_PollReceive() returned at the budget and stayed in polling mode.
+  * @retval false: Failed.
+  */
+static bool run_poll_budget(void)
+{
+  CanTxMsg             canTxMsg   = {0};
+  CAN_RxPollStatistics statistics = {0};
+  uint32_t             number     = 0;
+  
+  setup(CAN_WorkModeNormal);
+  CAN_SetReceivePolling(CAN1, RX_POLL_BURST, RX_POLL_IDLE);
+  
+  for(uint32_t i = 0; i < BXCAN_REMOTE_QUEUE_SIZE; i++)
+  {
+    make_message(&canTxMsg, 0x200, i);
+    BxCAN_Inject(&canTxMsg);
+  }
+  
+  /* A burst by interrupt switches to polling. */
+  CAN_PollReceive(CAN1);
+  BxCAN_Run(500000);
+  
+  pollFlood = 0;
+  CAN_SetReceiveMessageCallback(CAN1, poll_flood);
+  number = CAN_PollReceive(CAN1);
+  CAN_SetReceiveMessageCallback(CAN1, 0);
+  
+  CAN_GetReceivePollStatistics(CAN1, &statistics);
+  CAN_SetReceivePolling(CAN1, 0, RX_POLL_IDLE);
+  
+  printf("Receive callback slower than the bus, FIFO 0 polled\n");
+  printf("  one poll took %u messages (budget %u), stopped at the budget %u times, switches %u/%u\n", number, CAN_POLL_RECEIVE_BUDGET,
+         statistics.Budget, statistics.Enter, statistics.Leave);
+  
+  return (number == CAN_POLL_RECEIVE_BUDGET) && (pollFlood == number) && (statistics.Budget == 1) && (statistics.Enter == 1) &&
+         (statistics.Leave == 0);
+}
+
@@ -0,0 +1,447 @@
+/**
+  ******************************************************************************
+  * @file    stm32f10x.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Host replacement for the device header and the StdPeriph declarations.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __STM32F10x_H
+#define __STM32F10x_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include <stdint.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define __I   volatile const
+#define __O   volatile
+#define __IO  volatile
+
+#define HOST_MODEL                      /* Firmware built against the host model. */
+
+#define HOST_PCLK1_FREQUENCY  (36000000)
+#define HOST_PCLK2_FREQUENCY  (72000000)
+
+/* Type definitions ----------------------------------------------------------*/
+typedef enum {RESET = 0, SET = !RESET} FlagStatus, ITStatus;
+typedef enum {DISABLE = 0, ENABLE = !DISABLE} FunctionalState;
+typedef enum {ERROR = 0, SUCCESS = !ERROR} ErrorStatus;
+
+typedef enum
+{
+  USB_HP_CAN1_TX_IRQn  = 19,
+  USB_LP_CAN1_RX0_IRQn = 20,
+  CAN1_RX1_IRQn        = 21,
+  CAN1_SCE_IRQn        = 22,
+  CAN2_TX_IRQn         = 63,
+  CAN2_RX0_IRQn        = 64,
+  CAN2_RX1_IRQn        = 65,
+  CAN2_SCE_IRQn        = 66,
+  HOST_IRQn_NUMBER     = 68
+}IRQn_Type;
+
+#ifdef STM32F10X_CL
+#define CAN1_TX_IRQn   USB_HP_CAN1_TX_IRQn
+#define CAN1_RX0_IRQn  USB_LP_CAN1_RX0_IRQn
+#endif /* STM32F10X_CL */
+
+/******************************** CAN registers *******************************/
+typedef struct
+{
+  __IO uint32_t TIR;
+  __IO uint32_t TDTR;
+  __IO uint32_t TDLR;
+  __IO uint32_t TDHR;
+}CAN_TxMailBox_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t RIR;
+  __IO uint32_t RDTR;
+  __IO uint32_t RDLR;
+  __IO uint32_t RDHR;
+}CAN_FIFOMailBox_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t FR1;
+  __IO uint32_t FR2;
+}CAN_FilterRegister_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t              MCR;
+  __IO uint32_t              MSR;
+  __IO uint32_t              TSR;
+  __IO uint32_t              RF0R;
+  __IO uint32_t              RF1R;
+  __IO uint32_t              IER;
+  __IO uint32_t              ESR;
+  __IO uint32_t              BTR;
+  uint32_t                   RESERVED0[88];
+  CAN_TxMailBox_TypeDef      sTxMailBox[3];
+  CAN_FIFOMailBox_TypeDef    sFIFOMailBox[2];
+  uint32_t                   RESERVED1[12];
+  __IO uint32_t              FMR;
+  __IO uint32_t              FM1R;
+  uint32_t                   RESERVED2;
+  __IO uint32_t              FS1R;
+  uint32_t                   RESERVED3;
+  __IO uint32_t              FFA1R;
+  uint32_t                   RESERVED4;
+  __IO uint32_t              FA1R;
+  uint32_t                   RESERVED5[8];
+  CAN_FilterRegister_TypeDef sFilterRegister[28];
+}CAN_TypeDef;
+
+#define CAN_MCR_INRQ     (0x00000001)
+#define CAN_MCR_SLEEP    (0x00000002)
+#define CAN_MCR_TXFP     (0x00000004)
+#define CAN_MCR_RFLM     (0x00000008)
+#define CAN_MCR_NART     (0x00000010)
+#define CAN_MCR_AWUM     (0x00000020)
+#define CAN_MCR_ABOM     (0x00000040)
+#define CAN_MCR_TTCM     (0x00000080)
+#define CAN_MCR_RESET    (0x00008000)
+
+#define CAN_MSR_INAK     (0x00000001)
+#define CAN_MSR_SLAK     (0x00000002)
+#define CAN_MSR_ERRI     (0x00000004)
+#define CAN_MSR_WKUI     (0x00000008)
+#define CAN_MSR_SLAKI    (0x00000010)
+
+#define CAN_TSR_RQCP0    (0x00000001)
+#define CAN_TSR_TXOK0    (0x00000002)
+#define CAN_TSR_ALST0    (0x00000004)
+#define CAN_TSR_TERR0    (0x00000008)
+#define CAN_TSR_ABRQ0    (0x00000080)
+#define CAN_TSR_RQCP1    (0x00000100)
+#define CAN_TSR_TXOK1    (0x00000200)
+#define CAN_TSR_ALST1    (0x00000400)
+#define CAN_TSR_TERR1    (0x00000800)
+#define CAN_TSR_ABRQ1    (0x00008000)
+#define CAN_TSR_RQCP2    (0x00010000)
+#define CAN_TSR_TXOK2    (0x00020000)
+#define CAN_TSR_ALST2    (0x00040000)
+#define CAN_TSR_TERR2    (0x00080000)
+#define CAN_TSR_ABRQ2    (0x00800000)
+#define CAN_TSR_CODE     (0x03000000)
+#define CAN_TSR_TME      (0x1C000000)
+#define CAN_TSR_TME0     (0x04000000)
+#define CAN_TSR_TME1     (0x08000000)
+#define CAN_TSR_TME2     (0x10000000)
+
+#define CAN_RF0R_FMP0    (0x00000003)
+#define CAN_RF0R_FULL0   (0x00000008)
+#define CAN_RF0R_FOVR0   (0x00000010)
+#define CAN_RF0R_RFOM0   (0x00000020)
+#define CAN_RF1R_FMP1    (0x00000003)
+#define CAN_RF1R_FULL1   (0x00000008)
+#define CAN_RF1R_FOVR1   (0x00000010)
+#define CAN_RF1R_RFOM1   (0x00000020)
+
+#define CAN_ESR_EWGF     (0x00000001)
+#define CAN_ESR_EPVF     (0x00000002)
+#define CAN_ESR_BOFF     (0x00000004)
+#define CAN_ESR_LEC      (0x00000070)
+#define CAN_ESR_TEC      (0x00FF0000)
+#define CAN_ESR_REC      (0xFF000000)
+
+#define CAN_BTR_BRP      (0x000003FF)
+#define CAN_BTR_TS1      (0x000F0000)
+#define CAN_BTR_TS2      (0x00700000)
+#define CAN_BTR_SJW      (0x03000000)
+#define CAN_BTR_LBKM     (0x40000000)
+#define CAN_BTR_SILM     (0x80000000)
+
+#define CAN_TI0R_TXRQ    (0x00000001)
+#define CAN_TI0R_RTR     (0x00000002)
+#define CAN_TI0R_IDE     (0x00000004)
+#define CAN_TDT0R_DLC    (0x0000000F)
+#define CAN_TDT0R_TGT    (0x00000100)
+
+#define CAN_FMR_FINIT    (0x00000001)
+#define CAN_FMR_CAN2SB   (0x00003F00)
+
+/**************************** StdPeriph CAN driver ****************************/
+typedef struct
+{
+  uint16_t        CAN_Prescaler;
+  uint8_t         CAN_Mode;
+  uint8_t         CAN_SJW;
+  uint8_t         CAN_BS1;
+  uint8_t         CAN_BS2;
+  FunctionalState CAN_TTCM;
+  FunctionalState CAN_ABOM;
+  FunctionalState CAN_AWUM;
+  FunctionalState CAN_NART;
+  FunctionalState CAN_RFLM;
+  FunctionalState CAN_TXFP;
+}CAN_InitTypeDef;
+
+typedef struct
+{
+  uint16_t        CAN_FilterIdHigh;
+  uint16_t        CAN_FilterIdLow;
+  uint16_t        CAN_FilterMaskIdHigh;
+  uint16_t        CAN_FilterMaskIdLow;
+  uint16_t        CAN_FilterFIFOAssignment;
+  uint8_t         CAN_FilterNumber;
+  uint8_t         CAN_FilterMode;
+  uint8_t         CAN_FilterScale;
+  FunctionalState CAN_FilterActivation;
+}CAN_FilterInitTypeDef;
+
+typedef struct
+{
+  uint32_t StdId;
+  uint32_t ExtId;
+  uint8_t  IDE;
+  uint8_t  RTR;
+  uint8_t  DLC;
+  uint8_t  Data[8];
+}CanTxMsg;
+
+typedef struct
+{
+  uint32_t StdId;
+  uint32_t ExtId;
+  uint8_t  IDE;
+  uint8_t  RTR;
+  uint8_t  DLC;
+  uint8_t  Data[8];
+  uint8_t  FMI;
+}CanRxMsg;
+
+#define CAN_InitStatus_Failed    ((uint8_t)0x00)
+#define CAN_InitStatus_Success   ((uint8_t)0x01)
+
+#define CAN_Mode_Normal          ((uint8_t)0x00)
+#define CAN_Mode_LoopBack        ((uint8_t)0x01)
+#define CAN_Mode_Silent          ((uint8_t)0x02)
+#define CAN_Mode_Silent_LoopBack ((uint8_t)0x03)
+
+#define CAN_SJW_1tq              ((uint8_t)0x00)
+#define CAN_SJW_2tq              ((uint8_t)0x01)
+#define CAN_SJW_3tq              ((uint8_t)0x02)
+#define CAN_SJW_4tq              ((uint8_t)0x03)
+
+#define CAN_BS1_1tq              ((uint8_t)0x00)
+#define CAN_BS1_2tq              ((uint8_t)0x01)
+#define CAN_BS1_3tq              ((uint8_t)0x02)
+#define CAN_BS1_4tq              ((uint8_t)0x03)
+#define CAN_BS1_5tq              ((uint8_t)0x04)
+#define CAN_BS1_6tq              ((uint8_t)0x05)
+#define CAN_BS1_7tq              ((uint8_t)0x06)
+#define CAN_BS1_8tq              ((uint8_t)0x07)
+
+#define CAN_BS2_1tq              ((uint8_t)0x00)
+#define CAN_BS2_2tq              ((uint8_t)0x01)
+#define CAN_BS2_3tq              ((uint8_t)0x02)
+#define CAN_BS2_4tq              ((uint8_t)0x03)
+
+#define CAN_FilterMode_IdMask    ((uint8_t)0x00)
+#define CAN_FilterMode_IdList    ((uint8_t)0x01)
+#define CAN_FilterScale_16bit    ((uint8_t)0x00)
+#define CAN_FilterScale_32bit    ((uint8_t)0x01)
+#define CAN_Filter_FIFO0         ((uint8_t)0x00)
+#define CAN_Filter_FIFO1         ((uint8_t)0x01)
+
+#define CAN_Id_Standard          ((uint32_t)0x00000000)
+#define CAN_Id_Extended          ((uint32_t)0x00000004)
+#define CAN_ID_STD               CAN_Id_Standard
+#define CAN_ID_EXT               CAN_Id_Extended
+
+#define CAN_RTR_Data             ((uint32_t)0x00000000)
+#define CAN_RTR_Remote           ((uint32_t)0x00000002)
+#define CAN_RTR_DATA             CAN_RTR_Data
+#define CAN_RTR_REMOTE           CAN_RTR_Remote
+
+#define CAN_TxStatus_Failed      ((uint8_t)0x00)
+#define CAN_TxStatus_Ok          ((uint8_t)0x01)
+#define CAN_TxStatus_Pending     ((uint8_t)0x02)
+#define CAN_TxStatus_NoMailBox   ((uint8_t)0x04)
+
+#define CAN_FIFO0                ((uint8_t)0x00)
+#define CAN_FIFO1                ((uint8_t)0x01)
+
+#define CAN_IT_TME               ((uint32_t)0x00000001)
+#define CAN_IT_FMP0              ((uint32_t)0x00000002)
+#define CAN_IT_FF0               ((uint32_t)0x00000004)
+#define CAN_IT_FOV0              ((uint32_t)0x00000008)
+#define CAN_IT_FMP1              ((uint32_t)0x00000010)
+#define CAN_IT_FF1               ((uint32_t)0x00000020)
+#define CAN_IT_FOV1              ((uint32_t)0x00000040)
+#define CAN_IT_EWG               ((uint32_t)0x00000100)
+#define CAN_IT_EPV               ((uint32_t)0x00000200)
+#define CAN_IT_BOF               ((uint32_t)0x00000400)
+#define CAN_IT_LEC               ((uint32_t)0x00000800)
+#define CAN_IT_ERR               ((uint32_t)0x00008000)
+#define CAN_IT_WKU               ((uint32_t)0x00010000)
+#define CAN_IT_SLK               ((uint32_t)0x00020000)
+
+#define CAN_FLAG_RQCP0           ((uint32_t)0x38000001)
+#define CAN_FLAG_RQCP1           ((uint32_t)0x38000100)
+#define CAN_FLAG_RQCP2           ((uint32_t)0x38010000)
+
+/********************************* GPIO, RCC **********************************/
+typedef struct
+{
+  __IO uint32_t CRL;
+  __IO uint32_t CRH;
+  __IO uint32_t IDR;
+  __IO uint32_t ODR;
+  __IO uint32_t BSRR;
+  __IO uint32_t BRR;
+  __IO uint32_t LCKR;
+}GPIO_TypeDef;
+
+typedef enum
+{
+  GPIO_Speed_10MHz = 1,
+  GPIO_Speed_2MHz,
+  GPIO_Speed_50MHz
+}GPIOSpeed_TypeDef;
+
+typedef enum
+{
+  GPIO_Mode_AIN         = 0x0,
+  GPIO_Mode_IN_FLOATING = 0x04,
+  GPIO_Mode_IPD         = 0x28,
+  GPIO_Mode_IPU         = 0x48,
+  GPIO_Mode_Out_OD      = 0x14,
+  GPIO_Mode_Out_PP      = 0x10,
+  GPIO_Mode_AF_OD       = 0x1C,
+  GPIO_Mode_AF_PP       = 0x18
+}GPIOMode_TypeDef;
+
+typedef struct
+{
+  uint16_t          GPIO_Pin;
+  GPIOSpeed_TypeDef GPIO_Speed;
+  GPIOMode_TypeDef  GPIO_Mode;
+}GPIO_InitTypeDef;
+
+typedef struct
+{
+  uint32_t SYSCLK_Frequency;
+  uint32_t HCLK_Frequency;
+  uint32_t PCLK1_Frequency;
+  uint32_t PCLK2_Frequency;
+  uint32_t ADCCLK_Frequency;
+}RCC_ClocksTypeDef;
+
+#define GPIO_Pin_8               ((uint16_t)0x0100)
+#define GPIO_Pin_9               ((uint16_t)0x0200)
+#define GPIO_Pin_11              ((uint16_t)0x0800)
+#define GPIO_Pin_12              ((uint16_t)0x1000)
+#define GPIO_Pin_13              ((uint16_t)0x2000)
+
+#define GPIO_Remap1_CAN1         ((uint32_t)0x001D4000)
+#define GPIO_Remap2_CAN1         ((uint32_t)0x001D6000)
+#define GPIO_Remap_CAN2          ((uint32_t)0x00200040)
+
+#define RCC_APB2Periph_AFIO      ((uint32_t)0x00000001)
+#define RCC_APB2Periph_GPIOA     ((uint32_t)0x00000004)
+#define RCC_APB2Periph_GPIOB     ((uint32_t)0x00000008)
+#define RCC_APB2Periph_GPIOD     ((uint32_t)0x00000020)
+#define RCC_APB1Periph_CAN1      ((uint32_t)0x02000000)
+#define RCC_APB1Periph_CAN2      ((uint32_t)0x04000000)
+
+/************************************ NVIC ************************************/
+typedef struct
+{
+  uint8_t         NVIC_IRQChannel;
+  uint8_t         NVIC_IRQChannelPreemptionPriority;
+  uint8_t         NVIC_IRQChannelSubPriority;
+  FunctionalState NVIC_IRQChannelCmd;
+}NVIC_InitTypeDef;
+
+#define NVIC_PriorityGroup_0     ((uint32_t)0x700)
+#define NVIC_PriorityGroup_1     ((uint32_t)0x600)
+#define NVIC_PriorityGroup_2     ((uint32_t)0x500)
+#define NVIC_PriorityGroup_3     ((uint32_t)0x400)
+#define NVIC_PriorityGroup_4     ((uint32_t)0x300)
+
+/* Variable declarations -----------------------------------------------------*/
+extern CAN_TypeDef  hostCAN[2];
+extern GPIO_TypeDef hostGPIO[4];
+
+#define CAN1   (&hostCAN[0])
+#define CAN2   (&hostCAN[1])
+#define GPIOA  (&hostGPIO[0])
+#define GPIOB  (&hostGPIO[1])
+#define GPIOD  (&hostGPIO[3])
+
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+
+/* bxCAN model, Host/bxCAN/bxCAN.c. */
+void CAN_DeInit(CAN_TypeDef *CANx);
+uint8_t CAN_Init(CAN_TypeDef *CANx, CAN_InitTypeDef *CAN_InitStruct);
+void CAN_FilterInit(CAN_FilterInitTypeDef *CAN_FilterInitStruct);
+void CAN_SlaveStartBank(uint8_t CAN_BankNumber);
+void CAN_ITConfig(CAN_TypeDef *CANx, uint32_t CAN_IT, FunctionalState NewState);
+uint8_t CAN_Transmit(CAN_TypeDef *CANx, CanTxMsg *TxMessage);
+uint8_t CAN_TransmitStatus(CAN_TypeDef *CANx, uint8_t TransmitMailbox);
+void CAN_CancelTransmit(CAN_TypeDef *CANx, uint8_t Mailbox);
+void CAN_Receive(CAN_TypeDef *CANx, uint8_t FIFONumber, CanRxMsg *RxMessage);
+void CAN_FIFORelease(CAN_TypeDef *CANx, uint8_t FIFONumber);
+uint8_t CAN_MessagePending(CAN_TypeDef *CANx, uint8_t FIFONumber);
+ITStatus CAN_GetITStatus(CAN_TypeDef *CANx, uint32_t CAN_IT);
+void CAN_ClearITPendingBit(CAN_TypeDef *CANx, uint32_t CAN_IT);
+void CAN_ClearFlag(CAN_TypeDef *CANx, uint32_t CAN_FLAG);
+
+/* Core model, Host/Core/Core.c. */
+void GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_InitStruct);
+void GPIO_PinRemapConfig(uint32_t GPIO_Remap, FunctionalState NewState);
+void RCC_APB1PeriphClockCmd(uint32_t RCC_APB1Periph, FunctionalState NewState);
+void RCC_APB2PeriphClockCmd(uint32_t RCC_APB2Periph, FunctionalState NewState);
+void RCC_GetClocksFreq(RCC_ClocksTypeDef *RCC_Clocks);
+void NVIC_PriorityGroupConfig(uint32_t NVIC_PriorityGroup);
+void NVIC_Init(NVIC_InitTypeDef *NVIC_InitStruct);
+
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __LDREXW(volatile uint32_t *addr);
+uint32_t __STREXW(uint32_t value, volatile uint32_t *addr);
+void __CLREX(void);
+
+/* Function definitions ------------------------------------------------------*/
+#define __DMB()   __sync_synchronize()
+#define __DSB()   __sync_synchronize()
+#define __ISB()   __sync_synchronize()
+#define __NOP()   ((void)0)
+#define __CLZ(x)  (((x) == 0) ? 32 : __builtin_clz(x))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32F10x_H */
@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# @file    cantrace.py
+# @author  XinLi
+# @version v1.0
+# @date    19-October-2026
+# @brief   Decode a CANTrace dump into a timeline.
+#
+# Copyright (C) 2018 XinLi
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+"""Decode a CANTrace dump into a timeline.
+
+The dump is the raw CAN_TraceBuffer image, read from the target RAM with the
+debugger (the address of canTraceBuffer, sizeof(CAN_TraceBuffer) bytes) or
+written by the host build to Host/build/cantrace.bin. The records are put in
+order oldest first, the 32-bit time stamps are unwrapped and scaled with the
+frequency stored in the dump, and every interrupt exit shows the time since
+its entry.
+
+Usage:
+    cantrace.py dump.bin
+    cantrace.py dump.bin --csv timeline.csv
+    cantrace.py dump.bin --summary
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+MAGIC = 0x43525443
+VERSION = 1
+
+HEADER = struct.Struct('<IHHII')
+RECORD = struct.Struct('<IBBH')
+
+EVENTS = {
+    1: 'TxIsrEnter',
+    2: 'TxIsrExit',
+    3: 'RxIsrEnter',
+    4: 'RxIsrExit',
+    5: 'Enqueue',
+    6: 'Dequeue',
+    7: 'Drop',
+    8: 'MailboxLoad',
+    9: 'Receive',
+    10: 'ErrorState',
+    11: 'User',
+}
+
+# Exit event: entry event.
+ISR = {2: 1, 4: 3}
+
+DROPS = {1: 'receive buffer full', 2: 'frame pool empty', 3: 'transmit buffer full', 4: 'transmit rate limit'}
+
+LECS = ['none', 'stuff', 'form', 'ack', 'bit recessive', 'bit dominant', 'crc', 'software']
+
+
+class Record(object):
+    def __init__(self, time, event, channel, data):
+        self.time = time
+        self.event = event
+        self.channel = channel
+        self.data = data
+        self.duration = None
+
+
+def load(path):
+    """Read a dump, return the frequency, the number of events and the records oldest first."""
+    with open(path, 'rb') as f:
+        image = f.read()
+
+    if len(image) < HEADER.size:
+        raise ValueError('%s: too short for a trace' % path)
+
+    magic, version, size, frequency, index = HEADER.unpack_from(image, 0)
+
+    if magic != MAGIC:
+        raise ValueError('%s: bad magic 0x%08X' % (path, magic))
+    if version != VERSION:
+        raise ValueError('%s: version %d, expected %d' % (path, version, VERSION))
+    if len(image) < HEADER.size + size * RECORD.size:
+        raise ValueError('%s: %d records expected' % (path, size))
+
+    if index <= size:
+        order = range(index)
+    else:
+        order = [(index + i) % size for i in range(size)]
+
+    records = []
+    for slot in order:
+        time, event, channel, data = RECORD.unpack_from(image, HEADER.size + slot * RECORD.size)
+        # A slot reserved but not yet written when the dump was taken.
+        if event == 0:
+            continue
+        records.append(Record(time, event, channel, data))
+
+    return frequency, index, records
+
+
+def unwrap(records):
+    """Turn the 32-bit time stamps into ticks since the first record."""
+    total = 0
+    last = records[0].time if records else 0
+
+    for record in records:
+        delta = (record.time - last) & 0xFFFFFFFF
+        # A record reserved before, but stamped after, a nested one.
+        if delta & 0x80000000:
+            delta -= 1 << 32
+        total += delta
+        last = record.time
+        record.time = total
+
+
+def match(records):
+    """Set the duration of every interrupt exit from its entry."""
+    entry = {}
+
+    for record in records:
+        if record.event in ISR.values():
+            entry[(record.channel, record.event)] = record.time
+        elif record.event in ISR:
+            start = entry.pop((record.channel, ISR[record.event]), None)
+            if start is not None:
+                record.duration = record.time - start
+
+
+def describe(record):
+    event = record.event
+    data = record.data
+
+    if event == 1:
+        boxes = []
+        for box in range(3):
+            bits = (data >> (box * 4)) & 0xF
+            if bits:
+                flags = [name for bit, name in enumerate(('RQCP', 'TXOK', 'ALST', 'TERR')) if bits & (1 << bit)]
+                boxes.append('mailbox %d %s' % (box, '|'.join(flags)))
+        return ', '.join(boxes)
+    if event == 3:
+        return '%d pending' % data
+    if event in (5, 6):
+        return '%d frames' % data
+    if event == 7:
+        return DROPS.get(data, 'reason %d' % data)
+    if event in (8, 9):
+        return 'id 0x%X' % data
+    if event == 10:
+        state = 'bus-off' if data & 4 else 'error passive' if data & 2 else 'error warning' if data & 1 else 'error active'
+        return '%s, tec %d, last error %s' % (state, data >> 8, LECS[(data >> 4) & 7])
+    if event in ISR:
+        return ''
+    return '0x%04X' % data
+
+
+def print_timeline(records, scale):
+    print('%12s %10s  %-4s  %-12s %s' % ('time us', 'delta us', 'ch', 'event', 'data'))
+
+    last = records[0].time if records else 0
+    for record in records:
+        text = describe(record)
+        if record.duration is not None:
+            text = '%.3f us' % (record.duration * scale)
+        print('%12.3f %10.3f  CAN%d  %-12s %s' % (record.time * scale, (record.time - last) * scale,
+                                                  record.channel + 1, EVENTS.get(record.event, '?%d' % record.event),
+                                                  text))
+        last = record.time
+
+
+def print_summary(records, scale, index):
+    print('%d events recorded, %d decoded' % (index, len(records)))
+    if records:
+        print('span %.3f us' % ((records[-1].time - records[0].time) * scale))
+
+    for channel in sorted(set(r.channel for r in records)):
+        print('CAN%d' % (channel + 1))
+        for event, name in sorted(EVENTS.items()):
+            same = [r for r in records if r.channel == channel and r.event == event]
+            if not same:
+                continue
+            line = '  %-12s %8d' % (name, len(same))
+            durations = [r.duration for r in same if r.duration is not None]
+            if durations:
+                line += '   min %.3f, avg %.3f, max %.3f us' % (min(durations) * scale,
+                                                               sum(durations) * scale / len(durations),
+                                                               max(durations) * scale)
+            print(line)
+
+
+def write_csv(records, scale, path):
+    with open(path, 'w', newline='') as f:
+        writer = csv.writer(f)
+        writer.writerow(['time_us', 'channel', 'event', 'data', 'duration_us', 'description'])
+        for record in records:
+            writer.writerow(['%.3f' % (record.time * scale), record.channel + 1,
+                             EVENTS.get(record.event, record.event), record.data,
+                             '' if record.duration is None else '%.3f' % (record.duration * scale),
+                             describe(record)])
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode a CANTrace dump into a timeline.')
+    parser.add_argument('dump', help='CAN_TraceBuffer image')
+    parser.add_argument('--csv', metavar='FILE', help='also write the timeline as CSV')
+    parser.add_argument('--summary', action='store_true', help='print the event counts only')
+    args = parser.parse_args()
+
+    try:
+        frequency, index, records = load(args.dump)
+    except (IOError, ValueError) as error:
+        sys.stderr.write('%s\n' % error)
+        return 1
+
+    scale = 1e6 / frequency if frequency else 1.0
+
+    unwrap(records)
+    match(records)
+
+    if not args.summary:
+        print_timeline(records, scale)
+        print('')
+    print_summary(records, scale, index)
+
+    if args.csv:
+        write_csv(records, scale, args.csv)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,478 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# @file    dbc2c.py
+# @author  XinLi
+# @version v1.0
+# @date    19-October-2026
+# @brief   Generate C signal encode/decode functions from a DBC file.
+#
+# Copyright (C) 2018 XinLi
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+"""Generate a C header of static inline encode/decode functions from a DBC.
+
+Every message gets a struct of raw signal values and a pair of functions.
+The 8 data bytes are loaded once as a little endian 64-bit word for Intel
+signals and as a big endian one for Motorola signals, so every signal is a
+single shift and mask with constants computed here. Multiplexed signals are
+only decoded and encoded for the multiplexor value they belong to.
+
+Usage:
+    dbc2c.py input.dbc output.h [--prefix DBC]
+    dbc2c.py input.dbc output.h --benchmark benchmark.c
+"""
+
+import argparse
+import os
+import re
+import sys
+
+RE_MESSAGE = re.compile(r'^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+(\w+)')
+RE_SIGNAL = re.compile(r'^SG_\s+(\w+)\s*(M|m\d+)?\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*'
+                       r'\(\s*([^,]+)\s*,\s*([^)]+)\)\s*\[\s*([^|]+)\|([^\]]+)\]')
+RE_VALTYPE = re.compile(r'^SIG_VALTYPE_\s+(\d+)\s+(\w+)\s*:?\s*([12])\s*;')
+
+
+class Signal(object):
+    def __init__(self, name, mux, start, length, intel, signed, factor, offset, minimum, maximum):
+        self.name = name
+        self.mux = mux
+        self.start = start
+        self.length = length
+        self.intel = intel
+        self.signed = signed
+        self.factor = factor
+        self.offset = offset
+        self.minimum = minimum
+        self.maximum = maximum
+        self.float = 0
+
+    @property
+    def shift(self):
+        """Position of the least significant bit in the loaded word."""
+        if self.intel:
+            return self.start
+        # Byte 0 is the most significant byte of the big endian word.
+        msb = (7 - self.start // 8) * 8 + self.start % 8
+        return msb - self.length + 1
+
+    @property
+    def mask(self):
+        return (1 << self.length) - 1
+
+    @property
+    def ctype(self):
+        if self.float == 1:
+            return 'float'
+        if self.float == 2:
+            return 'double'
+        for size in (8, 16, 32, 64):
+            if self.length <= size:
+                return ('int%d_t' if self.signed else 'uint%d_t') % size
+        raise ValueError(self.name)
+
+
+class Message(object):
+    def __init__(self, frame_id, name, dlc):
+        self.extended = (frame_id & 0x80000000) != 0
+        self.id = frame_id & 0x1FFFFFFF
+        self.name = name
+        self.dlc = dlc
+        self.signals = []
+
+    @property
+    def multiplexor(self):
+        for signal in self.signals:
+            if signal.mux == 'M':
+                return signal
+        return None
+
+
+def parse(path):
+    messages = []
+    by_id = {}
+    message = None
+
+    with open(path, encoding='latin-1') as f:
+        for line in f:
+            line = line.strip()
+            m = RE_MESSAGE.match(line)
+            if m:
+                message = Message(int(m.group(1)), m.group(2), int(m.group(3)))
+                if message.dlc > 8:
+                    sys.stderr.write('skipping %s: more than 8 bytes\n' % message.name)
+                    message = None
+                    continue
+                messages.append(message)
+                by_id[int(m.group(1))] = message
+                continue
+            m = RE_SIGNAL.match(line)
+            if m:
+                if message is None:
+                    continue
+                signal = Signal(m.group(1), m.group(2), int(m.group(3)), int(m.group(4)),
+                                m.group(5) == '1', m.group(6) == '-',
+                                float(m.group(7)), float(m.group(8)),
+                                float(m.group(9)), float(m.group(10)))
+                if signal.length == 0 or signal.length > 64 or signal.shift < 0 or signal.shift + signal.length > 64:
+                    sys.stderr.write('skipping %s.%s: outside 8 bytes\n' % (message.name, signal.name))
+                    continue
+                message.signals.append(signal)
+                continue
+            message = None
+            m = RE_VALTYPE.match(line)
+            if m and int(m.group(1)) in by_id:
+                for signal in by_id[int(m.group(1))].signals:
+                    if signal.name == m.group(2):
+                        signal.float = int(m.group(3))
+
+    return messages
+
+
+def number(value):
+    text = repr(float(value))
+    return text if ('e' in text or '.' in text) else text + '.0'
+
+
+def emit_extract(signal, indent):
+    word = 'le' if signal.intel else 'be'
+    raw = '(%s >> %d) & 0x%XULL' % (word, signal.shift, signal.mask) if signal.length < 64 else word
+    lines = []
+    if signal.float == 1:
+        lines.append('{ uint32_t raw = (uint32_t)(%s); memcpy(&Message->%s, &raw, 4); }' % (raw, signal.name))
+    elif signal.float == 2:
+        lines.append('{ uint64_t raw = %s; memcpy(&Message->%s, &raw, 8); }' % (raw, signal.name))
+    elif signal.signed and signal.length < 64:
+        sign = 1 << (signal.length - 1)
+        lines.append('Message->%s = (%s)(int64_t)((((%s) ^ 0x%XULL)) - 0x%XULL);' % (signal.name, signal.ctype, raw, sign, sign))
+    else:
+        lines.append('Message->%s = (%s)(%s);' % (signal.name, signal.ctype, raw))
+    return [indent + l for l in lines]
+
+
+def emit_insert(signal, indent):
+    word = 'le' if signal.intel else 'be'
+    if signal.float == 1:
+        value = 'raw'
+        pre = '{ uint32_t raw; memcpy(&raw, &Message->%s, 4); ' % signal.name
+        post = ' }'
+    elif signal.float == 2:
+        value = 'raw'
+        pre = '{ uint64_t raw; memcpy(&raw, &Message->%s, 8); ' % signal.name
+        post = ' }'
+    else:
+        value = '(uint64_t)Message->%s' % signal.name
+        pre = post = ''
+    if signal.length < 64:
+        body = '%s |= (%s & 0x%XULL) << %d;' % (word, value, signal.mask, signal.shift)
+    else:
+        body = '%s |= %s;' % (word, value)
+    return [indent + pre + body + post]
+
+
+def emit_signals(message, emit, indent):
+    lines = []
+    mux = message.multiplexor
+    plain = [s for s in message.signals if s.mux is None or s.mux == 'M']
+    groups = {}
+    for s in message.signals:
+        if s.mux is not None and s.mux != 'M':
+            groups.setdefault(int(s.mux[1:]), []).append(s)
+
+    for s in plain:
+        lines += emit(s, indent)
+
+    if mux is not None and groups:
+        lines.append('%s' % indent)
+        lines.append('%sswitch(Message->%s)' % (indent, mux.name))
+        lines.append('%s{' % indent)
+        for value in sorted(groups):
+            lines.append('%s  case %d:' % (indent, value))
+            for s in groups[value]:
+                lines += emit(s, indent + '    ')
+            lines.append('%s    break;' % indent)
+        lines.append('%s  default:' % indent)
+        lines.append('%s    break;' % indent)
+        lines.append('%s}' % indent)
+    return lines
+
+
+def generate(messages, output, prefix):
+    guard = '__' + re.sub(r'\W', '_', os.path.basename(output)).upper()
+    uses = lambda m, intel: any(s.intel == intel for s in m.signals)
+    out = []
+    out.append('/**')
+    out.append('  ******************************************************************************')
+    out.append('  * @file    %s' % os.path.basename(output))
+    out.append('  * @brief   Signal encode/decode functions, generated by dbc2c.py. Do not edit.')
+    out.append('  ******************************************************************************')
+    out.append('  */')
+    out.append('')
+    out.append('#ifndef %s' % guard)
+    out.append('#define %s' % guard)
+    out.append('')
+    out.append('#ifdef __cplusplus')
+    out.append('extern "C" {')
+    out.append('#endif')
+    out.append('')
+    out.append('/* Header includes -----------------------------------------------------------*/')
+    out.append('#include <stdint.h>')
+    out.append('#include <string.h>')
+    out.append('')
+    out.append('/* Macro definitions ---------------------------------------------------------*/')
+    for m in messages:
+        upper = '%s_%s' % (prefix, m.name.upper())
+        out.append('#define %s_ID        (0x%X)' % (upper, m.id))
+        out.append('#define %s_EXTENDED  (%d)' % (upper, 1 if m.extended else 0))
+        out.append('#define %s_DLC       (%d)' % (upper, m.dlc))
+        for s in m.signals:
+            su = '%s_%s' % (upper, s.name.upper())
+            out.append('#define %s_FACTOR  (%s)' % (su, number(s.factor)))
+            out.append('#define %s_OFFSET  (%s)' % (su, number(s.offset)))
+            out.append('#define %s_MIN     (%s)' % (su, number(s.minimum)))
+            out.append('#define %s_MAX     (%s)' % (su, number(s.maximum)))
+        out.append('')
+    out.append('/* Type definitions ----------------------------------------------------------*/')
+    for m in messages:
+        out.append('typedef struct')
+        out.append('{')
+        width = max([len(s.ctype) for s in m.signals] + [1])
+        for s in m.signals:
+            note = ''
+            if s.mux == 'M':
+                note = '  /*!< Multiplexor. */'
+            elif s.mux is not None:
+                note = '  /*!< Multiplexed, %s == %s. */' % (m.multiplexor.name if m.multiplexor else '?', s.mux[1:])
+            out.append('  %s %s;%s' % (s.ctype.ljust(width), s.name, note))
+        if not m.signals:
+            out.append('  uint8_t Reserved;')
+        out.append('}%s_%s;' % (prefix, m.name))
+        out.append('')
+    out.append('/* Variable declarations -----------------------------------------------------*/')
+    out.append('/* Variable definitions ------------------------------------------------------*/')
+    out.append('/* Function declarations -----------------------------------------------------*/')
+    out.append('/* Function definitions ------------------------------------------------------*/')
+    out.append('')
+    out.append('/* The data is 8 bytes, as in CanRxMsg and CanTxMsg, and the target little endian. */')
+    out.append('static inline uint64_t %s_LoadLE(const uint8_t *Data)' % prefix)
+    out.append('{')
+    out.append('  uint64_t word;')
+    out.append('  ')
+    out.append('  memcpy(&word, Data, 8);')
+    out.append('  ')
+    out.append('  return word;')
+    out.append('}')
+    out.append('')
+    out.append('static inline uint64_t %s_Swap(uint64_t Word)' % prefix)
+    out.append('{')
+    out.append('#if defined(__GNUC__) || defined(__clang__)')
+    out.append('  return __builtin_bswap64(Word);')
+    out.append('#elif defined(__CC_ARM)')
+    out.append('  return ((uint64_t)__rev((uint32_t)Word) << 32) | __rev((uint32_t)(Word >> 32));')
+    out.append('#else')
+    out.append('  Word = ((Word & 0x00FF00FF00FF00FFULL) << 8)  | ((Word >> 8)  & 0x00FF00FF00FF00FFULL);')
+    out.append('  Word = ((Word & 0x0000FFFF0000FFFFULL) << 16) | ((Word >> 16) & 0x0000FFFF0000FFFFULL);')
+    out.append('  return (Word << 32) | (Word >> 32);')
+    out.append('#endif')
+    out.append('}')
+    out.append('')
+    out.append('static inline void %s_Store(uint8_t *Data, uint64_t LE, uint64_t BE)' % prefix)
+    out.append('{')
+    out.append('  uint64_t word = LE | %s_Swap(BE);' % prefix)
+    out.append('  ')
+    out.append('  memcpy(Data, &word, 8);')
+    out.append('}')
+    for m in messages:
+        name = '%s_%s' % (prefix, m.name)
+        intel, motorola = uses(m, True), uses(m, False)
+        out.append('')
+        out.append('/**')
+        out.append('  * @brief  Decode the %s message.' % m.name)
+        out.append('  * @param  [in]  Data:    The 8 data bytes.')
+        out.append('  * @param  [out] Message: The raw signal values.')
+        out.append('  * @return None.')
+        out.append('  */')
+        out.append('static inline void %s_Decode(const uint8_t *Data, %s *Message)' % (name, name))
+        out.append('{')
+        if intel:
+            out.append('  uint64_t le = %s_LoadLE(Data);' % prefix)
+        if motorola:
+            out.append('  uint64_t be = %s_Swap(%s_LoadLE(Data));' % (prefix, prefix))
+        if not m.signals:
+            out.append('  (void)Data;')
+            out.append('  (void)Message;')
+        else:
+            out.append('  ')
+        out += emit_signals(m, emit_extract, '  ')
+        out.append('}')
+        out.append('')
+        out.append('/**')
+        out.append('  * @brief  Encode the %s message.' % m.name)
+        out.append('  * @param  [in]  Message: The raw signal values.')
+        out.append('  * @param  [out] Data:    The 8 data bytes, unused bits cleared.')
+        out.append('  * @return None.')
+        out.append('  */')
+        out.append('static inline void %s_Encode(const %s *Message, uint8_t *Data)' % (name, name))
+        out.append('{')
+        out.append('  uint64_t le = 0;')
+        out.append('  uint64_t be = 0;')
+        out.append('  ')
+        if not m.signals:
+            out.append('  (void)Message;')
+        out += emit_signals(m, emit_insert, '  ')
+        if m.signals:
+            out.append('  ')
+        out.append('  %s_Store(Data, le, be);' % prefix)
+        out.append('}')
+    out.append('')
+    out.append('#ifdef __cplusplus')
+    out.append('}')
+    out.append('#endif')
+    out.append('')
+    out.append('#endif /* %s */' % guard)
+    out.append('')
+    return '\n'.join(out)
+
+
+def generate_benchmark(messages, header, prefix):
+    """A host program timing the generated decoders against a bit-by-bit one."""
+    out = []
+    out.append('/* Benchmark of %s, generated by dbc2c.py. */' % os.path.basename(header))
+    out.append('#include <stdio.h>')
+    out.append('#include <stdlib.h>')
+    out.append('#include <time.h>')
+    out.append('#include "%s"' % os.path.basename(header))
+    out.append('')
+    out.append('#define FRAMES      (1024)')
+    out.append('#define ITERATIONS  (2000)')
+    out.append('')
+    out.append('typedef struct { uint8_t Start; uint8_t Length; uint8_t Intel; uint8_t Signed; } Layout;')
+    out.append('')
+    out.append('/* Generic decoder: one bit at a time, as the hand-written code did. */')
+    out.append('static uint64_t generic_decode(const uint8_t *data, const Layout *layout)')
+    out.append('{')
+    out.append('  uint64_t value = 0;')
+    out.append('  int      bit   = layout->Start;')
+    out.append('  ')
+    out.append('  for(int i = 0; i < layout->Length; i++)')
+    out.append('  {')
+    out.append('    if(layout->Intel)')
+    out.append('    {')
+    out.append('      value |= (uint64_t)((data[(bit + i) / 8] >> ((bit + i) % 8)) & 1) << i;')
+    out.append('    }')
+    out.append('    else')
+    out.append('    {')
+    out.append('      value = (value << 1) | ((data[bit / 8] >> (bit % 8)) & 1);')
+    out.append('      bit = ((bit % 8) == 0) ? (bit + 15) : (bit - 1);')
+    out.append('    }')
+    out.append('  }')
+    out.append('  ')
+    out.append('  if(layout->Signed && (layout->Length < 64) && (value >> (layout->Length - 1)))')
+    out.append('  {')
+    out.append('    value |= ~0ULL << layout->Length;')
+    out.append('  }')
+    out.append('  ')
+    out.append('  return value;')
+    out.append('}')
+    out.append('')
+    out.append('static double now(void)')
+    out.append('{')
+    out.append('  struct timespec ts;')
+    out.append('  ')
+    out.append('  clock_gettime(CLOCK_MONOTONIC, &ts);')
+    out.append('  return ts.tv_sec + ts.tv_nsec * 1e-9;')
+    out.append('}')
+    out.append('')
+    out.append('int main(void)')
+    out.append('{')
+    out.append('  static uint8_t data[FRAMES][8];')
+    out.append('  volatile uint64_t sink = 0;')
+    out.append('  int errors = 0;')
+    out.append('  ')
+    out.append('  srand(1);')
+    out.append('  for(int i = 0; i < FRAMES; i++) for(int j = 0; j < 8; j++) data[i][j] = rand();')
+    out.append('  ')
+    out.append('  printf("%-32s %12s %12s %8s\\n", "message", "generic ns", "generated ns", "speedup");')
+    for m in messages:
+        signals = [s for s in m.signals if s.float == 0]
+        if not signals:
+            continue
+        name = '%s_%s' % (prefix, m.name)
+        mux = m.multiplexor
+        out.append('  {')
+        out.append('    static const Layout layout[] = {%s};' % ', '.join(
+            '{%d, %d, %d, %d}' % (s.start, s.length, 1 if s.intel else 0, 1 if s.signed else 0) for s in signals))
+        out.append('    static const int mux[] = {%s};' % ', '.join(
+            str(-1 if (s.mux is None or s.mux == 'M') else int(s.mux[1:])) for s in signals))
+        out.append('    %s message = {0};' % name)
+        out.append('    double t0 = now();')
+        out.append('    for(int n = 0; n < ITERATIONS; n++) for(int i = 0; i < FRAMES; i++)')
+        out.append('    {')
+        out.append('      for(unsigned k = 0; k < sizeof(layout) / sizeof(layout[0]); k++) sink += generic_decode(data[i], &layout[k]);')
+        out.append('    }')
+        out.append('    double t1 = now();')
+        out.append('    for(int n = 0; n < ITERATIONS; n++) for(int i = 0; i < FRAMES; i++)')
+        out.append('    {')
+        out.append('      %s_Decode(data[i], &message);' % name)
+        out.append('      sink += %s;' % ' + '.join('(uint64_t)message.%s' % s.name for s in signals))
+        out.append('    }')
+        out.append('    double t2 = now();')
+        out.append('    for(int i = 0; i < FRAMES; i++)')
+        out.append('    {')
+        out.append('      uint8_t round[8];')
+        out.append('      %s_Decode(data[i], &message);' % name)
+        for k, s in enumerate(signals):
+            cond = '' if mux is None or s.mux is None or s.mux == 'M' else '(uint64_t)message.%s == %d && ' % (mux.name, int(s.mux[1:]))
+            out.append('      if(%s(uint64_t)(int64_t)message.%s != generic_decode(data[i], &layout[%d])) errors++;' % (cond, s.name, k))
+        out.append('      %s_Encode(&message, round);' % name)
+        out.append('      %s check = message;' % name)
+        out.append('      %s_Decode(round, &check);' % name)
+        out.append('      if(memcmp(&check, &message, sizeof(message)) != 0) errors++;')
+        out.append('    }')
+        out.append('    (void)mux;')
+        out.append('    double frames = (double)ITERATIONS * FRAMES;')
+        out.append('    printf("%%-32s %%12.2f %%12.2f %%7.1fx\\n", "%s", (t1 - t0) * 1e9 / frames, (t2 - t1) * 1e9 / frames, (t1 - t0) / (t2 - t1));' % m.name)
+        out.append('  }')
+    out.append('  ')
+    out.append('  printf("mismatches: %d\\n", errors);')
+    out.append('  return (errors == 0) ? 0 : 1;')
+    out.append('}')
+    out.append('')
+    return '\n'.join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate C signal encode/decode functions from a DBC file.')
+    parser.add_argument('dbc', help='input DBC file')
+    parser.add_argument('output', help='output C header')
+    parser.add_argument('--prefix', default='DBC', help='prefix of the generated names (default DBC)')
+    parser.add_argument('--benchmark', metavar='FILE', help='also write a host benchmark program')
+    args = parser.parse_args()
+
+    messages = parse(args.dbc)
+
+    with open(args.output, 'w') as f:
+        f.write(generate(messages, args.output, args.prefix))
+
+    if args.benchmark:
+        with open(args.benchmark, 'w') as f:
+            f.write(generate_benchmark(messages, args.output, args.prefix))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,708 @@
+/**
+  ******************************************************************************
+  * @file    Benchmark.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Throughput, latency and CPU load benchmark of the CAN driver.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+/* Header includes -----------------------------------------------------------*/
+#include "Benchmark.h"
+#include "CANProfile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HOST_MODEL
+#include "Core.h"
+#endif /* HOST_MODEL */
+
+/* Macro definitions ---------------------------------------------------------*/
+/* Type definitions ----------------------------------------------------------*/
+typedef struct
+{
+  uint64_t Start;                       /*!< Ticks at the start of the run. */
+  uint64_t Last;                        /*!< Ticks of the last progress. */
+  uint64_t Now;
+  uint32_t Idle;                        /*!< Idle loop iterations. */
+}Benchmark_Clock;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+static const Benchmark_Config *benchmarkConfig = 0;
+
+static uint32_t benchmarkTimeLast = 0;
+static uint64_t benchmarkTimeHigh = 0;
+static uint32_t benchmarkIdleRate = 0;  /* Idle loop iterations per second without load. */
+
+static uint32_t benchmarkSample[BENCHMARK_SAMPLE_SIZE];
+static uint32_t benchmarkSampleNumber = 0;
+
+static const char *const benchmarkName[BenchmarkNumber] =
+{
+  "burst_tx",
+  "saturate_rx",
+  "round_trip",
+  "mixed_priority"
+};
+
+/* Function declarations -----------------------------------------------------*/
+static void benchmark_start(const Benchmark_Config *Config, Benchmark_Clock *Clock);
+static uint32_t benchmark_get_ticks(void);
+static uint64_t benchmark_get_time(void);
+static uint32_t benchmark_get_frequency(void);
+static uint64_t benchmark_to_ns(uint64_t Ticks);
+static bool benchmark_poll(Benchmark_Clock *Clock, bool Work);
+static bool benchmark_send(uint32_t StdId, uint32_t Sequence, uint32_t Time);
+static bool benchmark_receive(CanRxMsg *Message, uint32_t *Sequence, uint32_t *Latency);
+static void benchmark_sample(uint32_t Latency);
+static void benchmark_finish(const Benchmark_Clock *Clock, Benchmark_Result *Result);
+static int benchmark_compare(const void *A, const void *B);
+static bool benchmark_echo(CAN_TypeDef *CANx, const CanRxMsg *Message);
+
+static void benchmark_burst_tx(Benchmark_Clock *Clock, Benchmark_Result *Result);
+static void benchmark_saturate_rx(Benchmark_Clock *Clock, Benchmark_Result *Result);
+static void benchmark_round_trip(Benchmark_Clock *Clock, Benchmark_Result *Result);
+static void benchmark_mixed_priority(Benchmark_Clock *Clock, Benchmark_Result *Result);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Count the idle loop iterations per second without load.
+  * @param  [in] Config: The benchmark configuration, only the clock and idle hook are used.
+  * @return Idle loop iterations per second.
+  * @note   Run with the bus quiet. Benchmark_Run() calibrates on its first call.
+  */
+uint32_t Benchmark_Calibrate(const Benchmark_Config *Config)
+{
+  Benchmark_Clock clock = {0};
+  
+  benchmark_start(Config, &clock);
+  
+  uint64_t end = clock.Start + (uint64_t)benchmark_get_frequency() * BENCHMARK_CALIBRATE_TIME / 1000;
+  
+  while(clock.Now < end)
+  {
+    CanRxMsg canRxMsg = {0};
+    
+    benchmark_poll(&clock, CAN_GetReceiveMessage(Config->CANx, &canRxMsg, 1) > 0);
+  }
+  
+  uint64_t time = benchmark_to_ns(clock.Now - clock.Start);
+  
+  benchmarkIdleRate = (time > 0) ? (uint32_t)((uint64_t)clock.Idle * 1000000000 / time) : 0;
+  
+  return benchmarkIdleRate;
+}
+
+/**
+  * @brief  Run a benchmark scenario.
+  * @param  [in] Config:  The benchmark configuration, the CAN peripheral already configured.
+  * @param  [out] Result: The result.
+  * @retval true:         Finished.
+  * @retval false:        Gave up after BENCHMARK_TIMEOUT without progress, the result is partial.
+  * @note   Takes over the receive buffer of the channel, the receive message callback must be unset.
+  */
+bool Benchmark_Run(const Benchmark_Config *Config, Benchmark_Result *Result)
+{
+  Benchmark_Clock clock = {0};
+  
+  memset(Result, 0, sizeof(*Result));
+  
+  if(benchmarkIdleRate == 0)
+  {
+    Benchmark_Calibrate(Config);
+  }
+  
+  benchmark_start(Config, &clock);
+  benchmarkSampleNumber = 0;
+  
+  CAN_ClearReceiveBuffer(Config->CANx);
+  
+#if CAN_PROFILE_ENABLE
+  CAN_Profile_Clear();
+#endif /* CAN_PROFILE_ENABLE */
+  
+  switch(Config->Scenario)
+  {
+    case BenchmarkBurstTx:
+      benchmark_burst_tx(&clock, Result);
+      break;
+    case BenchmarkSaturateRx:
+      benchmark_saturate_rx(&clock, Result);
+      break;
+    case BenchmarkRoundTrip:
+      benchmark_round_trip(&clock, Result);
+      break;
+    case BenchmarkMixedPriority:
+      benchmark_mixed_priority(&clock, Result);
+      break;
+    default:
+      return false;
+  }
+  
+  benchmark_finish(&clock, Result);
+  
+  /* Let the frames still queued go before the next run. */
+  Benchmark_Clock drain = clock;
+  
+  drain.Last = drain.Now;
+  
+  while((CAN_IsTransmitMessage(Config->CANx) == true) && (benchmark_poll(&drain, false) == true));
+  
+  return (clock.Now - clock.Last < (uint64_t)benchmark_get_frequency() * BENCHMARK_TIMEOUT / 1000);
+}
+
+/**
+  * @brief  Format a result as one line of JSON.
+  * @param  [in] Config: The benchmark configuration.
+  * @param  [in] Result: The result.
+  * @param  [out] Text:  The line with its newline, terminated.
+  * @param  [in] Size:   The size of @Text, BENCHMARK_TEXT_SIZE is enough.
+  * @return The length of the line, 0 if it does not fit.
+  */
+uint32_t Benchmark_Format(const Benchmark_Config *Config, const Benchmark_Result *Result, char *Text, uint32_t Size)
+{
+  int length = snprintf(Text, Size,
+                        "{\"scenario\":\"%s\",\"loopback\":%s,\"bit_rate\":%u,\"sent\":%u,\"received\":%u,\"lost\":%u,"
+                        "\"time_us\":%u,\"frames_per_s\":%u,\"cpu_permille\":%u,\"latency_ns\":{\"count\":%u,"
+                        "\"min\":%u,\"p50\":%u,\"p90\":%u,\"p99\":%u,\"max\":%u},\"ram_execute\":%s,"
+                        "\"isr_cycles\":{\"tx_mean\":%u,\"tx_max\":%u,\"rx_mean\":%u,\"rx_max\":%u}}\n",
+                        (Config->Scenario < BenchmarkNumber) ? benchmarkName[Config->Scenario] : "unknown",
+                        (Config->LoopBack == true) ? "true" : "false", (unsigned int)CAN_GetBitRate(Config->BaudRate),
+                        (unsigned int)Result->Sent, (unsigned int)Result->Received, (unsigned int)Result->Lost,
+                        (unsigned int)(Result->Time / 1000), (unsigned int)Result->FramesPerSecond,
+                        (unsigned int)Result->CpuPermille, (unsigned int)Result->LatencyNumber,
+                        (unsigned int)Result->LatencyMin, (unsigned int)Result->LatencyP50, (unsigned int)Result->LatencyP90,
+                        (unsigned int)Result->LatencyP99, (unsigned int)Result->LatencyMax, (CAN_RAM_EXECUTE) ? "true" : "false",
+                        (unsigned int)Result->TxIsrMean, (unsigned int)Result->TxIsrMax,
+                        (unsigned int)Result->RxIsrMean, (unsigned int)Result->RxIsrMax);
+  
+  if((length < 0) || ((uint32_t)length >= Size))
+  {
+    return 0;
+  }
+  
+  return (uint32_t)length;
+}
+
+/**
+  * @brief  Answer every frame received with the identifier plus BENCHMARK_ID_ECHO, same data.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return None.
+  * @note   The second board of a two board benchmark, answered in the receive interrupt.
+  *         The background frames of BenchmarkMixedPriority are not answered.
+  */
+void Benchmark_Echo(CAN_TypeDef *CANx)
+{
+  CAN_SetReceiveMessageCallback(CANx, benchmark_echo);
+}
+
+/**
+  * @brief  Start the clock of a run.
+  * @param  [in] Config: The benchmark configuration.
+  * @param  [out] Clock: The clock.
+  * @return None.
+  */
+static void benchmark_start(const Benchmark_Config *Config, Benchmark_Clock *Clock)
+{
+  benchmarkConfig = Config;
+  
+#ifndef HOST_MODEL
+  if(Config->GetTime == 0)
+  {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+  }
+#endif /* HOST_MODEL */
+  
+  benchmarkTimeLast = benchmark_get_ticks();
+  benchmarkTimeHigh = 0;
+  
+  memset(Clock, 0, sizeof(*Clock));
+}
+
+/**
+  * @brief  Get the free running time.
+  * @param  None.
+  * @return Ticks.
+  */
+static uint32_t benchmark_get_ticks(void)
+{
+  if(benchmarkConfig->GetTime != 0)
+  {
+    return benchmarkConfig->GetTime();
+  }
+  
+#ifdef HOST_MODEL
+  return (uint32_t)Core_GetHostTime();
+#else
+  return DWT->CYCCNT;
+#endif /* HOST_MODEL */
+}
+
+/**
+  * @brief  Get the time since benchmark_start().
+  * @param  None.
+  * @return Ticks, extended to 64 bits.
+  * @note   Must be called at least once per wrap of the 32-bit time.
+  */
+static uint64_t benchmark_get_time(void)
+{
+  uint32_t time = benchmark_get_ticks();
+  
+  benchmarkTimeHigh += time - benchmarkTimeLast;
+  benchmarkTimeLast  = time;
+  
+  return benchmarkTimeHigh;
+}
+
+/**
+  * @brief  Get the rate of the time.
+  * @param  None.
+  * @return Ticks per second.
+  */
+static uint32_t benchmark_get_frequency(void)
+{
+  if(benchmarkConfig->Frequency != 0)
+  {
+    return benchmarkConfig->Frequency;
+  }
+  
+#ifdef HOST_MODEL
+  return 1000000000;
+#else
+  return SystemCoreClock;
+#endif /* HOST_MODEL */
+}
+
+/**
+  * @brief  Convert ticks to nanoseconds.
+  * @param  [in] Ticks: The time.
+  * @return Nanoseconds.
+  */
+static uint64_t benchmark_to_ns(uint64_t Ticks)
+{
+  uint32_t frequency = benchmark_get_frequency();
+  
+  return (Ticks / frequency) * 1000000000 + (Ticks % frequency) * 1000000000 / frequency;
+}
+
+/**
+  * @brief  End an iteration of a benchmark loop.
+  * @param  [in] Clock: The clock.
+  * @param  [in] Work:  The iteration sent or received a frame.
+  * @retval true:       Go on.
+  * @retval false:      No progress for BENCHMARK_TIMEOUT.
+  */
+static bool benchmark_poll(Benchmark_Clock *Clock, bool Work)
+{
+  Clock->Now = benchmark_get_time();
+  
+  if(Work == true)
+  {
+    Clock->Last = Clock->Now;
+  }
+  else
+  {
+    Clock->Idle++;
+    
+    if(benchmarkConfig->Idle != 0)
+    {
+      benchmarkConfig->Idle();
+    }
+  }
+  
+  return (Clock->Now - Clock->Last < (uint64_t)benchmark_get_frequency() * BENCHMARK_TIMEOUT / 1000);
+}
+
+/**
+  * @brief  Queue a frame carrying its send time and a sequence number.
+  * @param  [in] StdId:    Standard identifier.
+  * @param  [in] Sequence: Sequence number, data bytes 4 to 7.
+  * @param  [in] Time:     Send time, data bytes 0 to 3.
+  * @retval true:          Queued.
+  * @retval false:         The transmit buffer is full.
+  */
+static bool benchmark_send(uint32_t StdId, uint32_t Sequence, uint32_t Time)
+{
+  CanTxMsg canTxMsg = {0};
+  
+  canTxMsg.StdId = StdId;
+  canTxMsg.IDE   = CAN_Id_Standard;
+  canTxMsg.RTR   = CAN_RTR_Data;
+  canTxMsg.DLC   = 8;
+  
+  memcpy(&canTxMsg.Data[0], &Time, sizeof(Time));
+  memcpy(&canTxMsg.Data[4], &Sequence, sizeof(Sequence));
+  
+  return (CAN_SetTransmitMessage(benchmarkConfig->CANx, &canTxMsg, 1) == 1);
+}
+
+/**
+  * @brief  Take a received frame.
+  * @param  [out] Message:  The frame.
+  * @param  [out] Sequence: Its sequence number.
+  * @param  [out] Latency:  Nanoseconds since it was sent, meaningful on the same clock only.
+  * @retval true:           A frame was taken.
+  * @retval false:          The receive buffer is empty.
+  */
+static bool benchmark_receive(CanRxMsg *Message, uint32_t *Sequence, uint32_t *Latency)
+{
+  uint32_t time = 0;
+  
+  if(CAN_GetReceiveMessage(benchmarkConfig->CANx, Message, 1) == 0)
+  {
+    return false;
+  }
+  
+  memcpy(&time, &Message->Data[0], sizeof(time));
+  memcpy(Sequence, &Message->Data[4], sizeof(*Sequence));
+  
+  uint64_t latency = benchmark_to_ns((uint32_t)benchmark_get_time() - time);
+  
+  *Latency = (latency < UINT32_MAX) ? (uint32_t)latency : UINT32_MAX;
+  
+  return true;
+}
+
+/**
+  * @brief  Keep a latency for the percentiles.
+  * @param  [in] Latency: Nanoseconds.
+  * @return None.
+  */
+static void benchmark_sample(uint32_t Latency)
+{
+  benchmarkSample[benchmarkSampleNumber % BENCHMARK_SAMPLE_SIZE] = Latency;
+  benchmarkSampleNumber++;
+}
+
+/**
+  * @brief  Work out the rates, the CPU load, the latency percentiles and the interrupt times.
+  * @param  [in] Clock:   The clock at the end of the run.
+  * @param  [out] Result: The result.
+  * @return None.
+  */
+static void benchmark_finish(const Benchmark_Clock *Clock, Benchmark_Result *Result)
+{
+  uint64_t time   = benchmark_to_ns(Clock->Last - Clock->Start);
+  uint64_t frames = ((benchmarkConfig->Scenario == BenchmarkBurstTx) && (benchmarkConfig->LoopBack != true)) ? Result->Sent : Result->Received;
+  uint64_t idle   = benchmark_to_ns(Clock->Now - Clock->Start) * benchmarkIdleRate / 1000000000;
+  
+  Result->Time            = time;
+  Result->FramesPerSecond = (time > 0) ? (uint32_t)(frames * 1000000000 / time) : 0;
+  Result->CpuPermille     = ((idle > 0) && (Clock->Idle < idle)) ? (uint32_t)(1000 - (uint64_t)Clock->Idle * 1000 / idle) : 0;
+  
+  uint32_t number = (benchmarkSampleNumber < BENCHMARK_SAMPLE_SIZE) ? benchmarkSampleNumber : BENCHMARK_SAMPLE_SIZE;
+  
+  Result->LatencyNumber = benchmarkSampleNumber;
+  
+  if(number > 0)
+  {
+    qsort(benchmarkSample, number, sizeof(benchmarkSample[0]), benchmark_compare);
+    
+    Result->LatencyMin = benchmarkSample[0];
+    Result->LatencyP50 = benchmarkSample[(number - 1) * 50 / 100];
+    Result->LatencyP90 = benchmarkSample[(number - 1) * 90 / 100];
+    Result->LatencyP99 = benchmarkSample[(number - 1) * 99 / 100];
+    Result->LatencyMax = benchmarkSample[number - 1];
+  }
+  
+#if CAN_PROFILE_ENABLE
+  CAN_ProfileHistogram histogram = {0};
+  
+  CAN_Profile_GetHistogram(benchmarkConfig->CANx, CAN_ProfileTxIsr, &histogram);
+  
+  Result->TxIsrMean = (histogram.Count > 0) ? (uint32_t)(histogram.Total / histogram.Count) : 0;
+  Result->TxIsrMax  = histogram.Max;
+  
+  CAN_Profile_GetHistogram(benchmarkConfig->CANx, CAN_ProfileRxIsr, &histogram);
+  
+  Result->RxIsrMean = (histogram.Count > 0) ? (uint32_t)(histogram.Total / histogram.Count) : 0;
+  Result->RxIsrMax  = histogram.Max;
+#endif /* CAN_PROFILE_ENABLE */
+}
+
+/**
+  * @brief  Order of two latencies.
+  */
+static int benchmark_compare(const void *A, const void *B)
+{
+  uint32_t a = *(const uint32_t *)A;
+  uint32_t b = *(const uint32_t *)B;
+  
+  return (a > b) - (a < b);
+}
+
+/**
+  * @brief  Receive message callback of Benchmark_Echo().
+  * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Message: The received frame.
+  * @return true, the frame is consumed.
+  */
+static bool benchmark_echo(CAN_TypeDef *CANx, const CanRxMsg *Message)
+{
+  CanTxMsg canTxMsg = {0};
+  
+  if((Message->IDE == CAN_Id_Standard) && (Message->StdId == BENCHMARK_ID_LOW))
+  {
+    return true;
+  }
+  
+  canTxMsg.StdId = (Message->StdId + BENCHMARK_ID_ECHO) & 0x7FF;
+  canTxMsg.ExtId = (Message->ExtId + BENCHMARK_ID_ECHO) & 0x1FFFFFFF;
+  canTxMsg.IDE   = Message->IDE;
+  canTxMsg.RTR   = Message->RTR;
+  canTxMsg.DLC   = Message->DLC;
+  memcpy(canTxMsg.Data, Message->Data, sizeof(canTxMsg.Data));
+  
+  CAN_SetTransmitMessage(CANx, &canTxMsg, 1);
+  
+  return true;
+}
+
+/**
+  * @brief  Queue Frames back to back, until they all came back, or were sent without loop back.
+  * @param  [in] Clock:   The clock.
+  * @param  [out] Result: The result.
+  * @return None.
+  * @note   Without loop back the rate is that of the frames sent, answers of an echo
+  *         board are counted but not waited for.
+  */
+static void benchmark_burst_tx(Benchmark_Clock *Clock, Benchmark_Result *Result)
+{
+  uint32_t frames   = benchmarkConfig->Frames;
+  uint32_t expected = 0;
+  bool     go       = true;
+  
+  while(go == true)
+  {
+    CanRxMsg canRxMsg = {0};
+    uint32_t sequence = 0;
+    uint32_t latency  = 0;
+    bool     work     = false;
+    
+    if((Result->Sent < frames) && (benchmark_send(BENCHMARK_ID_STREAM, Result->Sent, (uint32_t)Clock->Now) == true))
+    {
+      Result->Sent++;
+      work = true;
+    }
+    
+    if(benchmark_receive(&canRxMsg, &sequence, &latency) == true)
+    {
+      Result->Lost += (sequence > expected) ? (sequence - expected) : 0;
+      expected      = sequence + 1;
+      Result->Received++;
+      work = true;
+      
+      benchmark_sample(latency);
+    }
+    
+    go = benchmark_poll(Clock, work);
+    
+    if(benchmarkConfig->LoopBack == true)
+    {
+      go &= (Result->Received + Result->Lost < frames);
+    }
+    else
+    {
+      go &= (Result->Sent < frames) || (CAN_IsTransmitMessage(benchmarkConfig->CANx) == true);
+    }
+  }
+  
+  if(benchmarkConfig->LoopBack == true)
+  {
+    Result->Lost = frames - Result->Received;
+  }
+  else
+  {
+    Result->Lost = 0;
+  }
+}
+
+/**
+  * @brief  Receive for Duration at full bus load.
+  * @param  [in] Clock:   The clock.
+  * @param  [out] Result: The result.
+  * @return None.
+  * @note   In loop back the benchmark loads the bus itself and the latency is measured,
+  *         otherwise another node sends the frames and only gaps in their sequence count.
+  */
+static void benchmark_saturate_rx(Benchmark_Clock *Clock, Benchmark_Result *Result)
+{
+  uint64_t end      = Clock->Start + (uint64_t)benchmark_get_frequency() * benchmarkConfig->Duration / 1000;
+  uint32_t expected = 0;
+  
+  while(Clock->Now < end)
+  {
+    CanRxMsg canRxMsg = {0};
+    uint32_t sequence = 0;
+    uint32_t latency  = 0;
+    bool     work     = false;
+    
+    if((benchmarkConfig->LoopBack == true) && (benchmark_send(BENCHMARK_ID_STREAM, Result->Sent, (uint32_t)Clock->Now) == true))
+    {
+      Result->Sent++;
+      work = true;
+    }
+    
+    if(benchmark_receive(&canRxMsg, &sequence, &latency) == true)
+    {
+      if(Result->Received > 0)
+      {
+        Result->Lost += (sequence > expected) ? (sequence - expected) : 0;
+      }
+      
+      expected = sequence + 1;
+      Result->Received++;
+      work = true;
+      
+      if(benchmarkConfig->LoopBack == true)
+      {
+        benchmark_sample(latency);
+      }
+    }
+    
+    benchmark_poll(Clock, work);
+  }
+  
+  Clock->Last = Clock->Now;
+}
+
+/**
+  * @brief  Send Frames one at a time, each waiting for its answer.
+  * @param  [in] Clock:   The clock.
+  * @param  [out] Result: The result.
+  * @return None.
+  * @note   A frame not answered within BENCHMARK_TIMEOUT is lost.
+  */
+static void benchmark_round_trip(Benchmark_Clock *Clock, Benchmark_Result *Result)
+{
+  while(Result->Sent < benchmarkConfig->Frames)
+  {
+    if(benchmark_send(BENCHMARK_ID_STREAM, Result->Sent, (uint32_t)Clock->Now) != true)
+    {
+      if(benchmark_poll(Clock, false) != true)
+      {
+        return;
+      }
+      
+      continue;
+    }
+    
+    uint32_t sent = Result->Sent++;
+    bool     go   = benchmark_poll(Clock, true);
+    
+    while(go == true)
+    {
+      CanRxMsg canRxMsg = {0};
+      uint32_t sequence = 0;
+      uint32_t latency  = 0;
+      
+      if((benchmark_receive(&canRxMsg, &sequence, &latency) == true) && (sequence == sent))
+      {
+        Result->Received++;
+        benchmark_sample(latency);
+        benchmark_poll(Clock, true);
+        break;
+      }
+      
+      go = benchmark_poll(Clock, false);
+    }
+    
+    if(go != true)
+    {
+      Result->Lost++;
+      Clock->Last = Clock->Now;
+    }
+  }
+}
+
+/**
+  * @brief  Send Frames high priority frames every Interval while low priority frames fill
+  *         the rest of the transmit buffer.
+  * @param  [in] Clock:   The clock.
+  * @param  [out] Result: The result.
+  * @return None.
+  * @note   The latency is that of the high priority frames. The transmit buffer is first in
+  *         first out, so they wait behind the low priority frames queued before them.
+  */
+static void benchmark_mixed_priority(Benchmark_Clock *Clock, Benchmark_Result *Result)
+{
+  uint32_t frames   = benchmarkConfig->Frames;
+  uint64_t interval = (uint64_t)benchmark_get_frequency() * benchmarkConfig->Interval / 1000000;
+  uint64_t next     = Clock->Now;
+  uint32_t high     = 0;
+  uint32_t low      = 0;
+  uint32_t received = 0;
+  uint32_t expected = 0;
+  bool     go       = true;
+  
+  while((go == true) && (received + Result->Lost < frames))
+  {
+    CanRxMsg canRxMsg = {0};
+    uint32_t sequence = 0;
+    uint32_t latency  = 0;
+    bool     work     = false;
+    
+    if((high < frames) && (Clock->Now >= next))
+    {
+      if(benchmark_send(BENCHMARK_ID_HIGH, high, (uint32_t)Clock->Now) == true)
+      {
+        high++;
+        next += interval;
+        work  = true;
+      }
+    }
+    else if((high < frames) && (benchmark_send(BENCHMARK_ID_LOW, low, (uint32_t)Clock->Now) == true))
+    {
+      low++;
+      work = true;
+    }
+    
+    if(benchmark_receive(&canRxMsg, &sequence, &latency) == true)
+    {
+      if((canRxMsg.StdId & ~BENCHMARK_ID_ECHO) == BENCHMARK_ID_HIGH)
+      {
+        Result->Lost += (sequence > expected) ? (sequence - expected) : 0;
+        expected      = sequence + 1;
+        received++;
+        
+        benchmark_sample(latency);
+      }
+      
+      Result->Received++;
+      work = true;
+    }
+    
+    go = benchmark_poll(Clock, work);
+  }
+  
+  Result->Sent = high + low;
+  
+  if(go != true)
+  {
+    Result->Lost = frames - received;
+  }
+}
@@ -0,0 +1,114 @@
+/**
+  ******************************************************************************
+  * @file    Benchmark.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for Benchmark.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+#ifndef __BENCHMARK_H
+#define __BENCHMARK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "CAN.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define BENCHMARK_SAMPLE_SIZE     (1024)  /* Latencies kept for the percentiles, the last ones win. */
+#define BENCHMARK_TIMEOUT         (100)   /* Milliseconds without progress before a run gives up. */
+#define BENCHMARK_CALIBRATE_TIME  (100)   /* Milliseconds of the idle loop calibration. */
+#define BENCHMARK_TEXT_SIZE       (512)   /* Enough for Benchmark_Format(), with the terminator. */
+
+#define BENCHMARK_ID_STREAM       (0x100) /* Frames of every scenario but the high priority ones. */
+#define BENCHMARK_ID_HIGH         (0x080) /* High priority frames of BenchmarkMixedPriority. */
+#define BENCHMARK_ID_LOW          (0x700) /* Background frames of BenchmarkMixedPriority. */
+#define BENCHMARK_ID_ECHO         (0x001) /* Benchmark_Echo() answers with the identifier plus this. */
+
+/* Type definitions ----------------------------------------------------------*/
+typedef enum
+{
+  BenchmarkBurstTx = 0,                 /*!< Frames queued back to back as fast as the transmit buffer takes them. */
+  BenchmarkSaturateRx,                  /*!< Receive for Duration at full bus load. */
+  BenchmarkRoundTrip,                   /*!< One frame at a time, each waits for its answer. */
+  BenchmarkMixedPriority,               /*!< High priority frames every Interval over a low priority flood. */
+  BenchmarkNumber
+}Benchmark_Scenario;
+
+typedef struct
+{
+  CAN_TypeDef        *CANx;             /*!< Configured CAN peripheral. */
+  CAN_BaudRate        BaudRate;         /*!< Its baud rate, for the report. */
+  bool                LoopBack;         /*!< The frames sent come back, loop back work mode. Otherwise a
+                                             second board runs Benchmark_Echo(), or floods for BenchmarkSaturateRx. */
+  Benchmark_Scenario  Scenario;
+  uint32_t            Frames;           /*!< Frames to send, high priority ones for BenchmarkMixedPriority. */
+  uint32_t            Duration;         /*!< Milliseconds of BenchmarkSaturateRx. */
+  uint32_t            Interval;         /*!< Microseconds between high priority frames of BenchmarkMixedPriority. */
+  
+  uint32_t          (*GetTime)(void);   /*!< Free running time, 0 for the DWT cycle counter. */
+  uint32_t            Frequency;        /*!< Ticks per second of GetTime, 0 for SystemCoreClock. */
+  void              (*Idle)(void);      /*!< Called in every idle loop iteration, 0 for none. */
+}Benchmark_Config;
+
+typedef struct
+{
+  uint32_t Sent;                        /*!< Frames sent, background frames included. */
+  uint32_t Received;                    /*!< Frames received, background frames included. */
+  uint32_t Lost;                        /*!< Frames missing from the received sequence or never answered. */
+  uint64_t Time;                        /*!< Nanoseconds of the run. */
+  uint32_t FramesPerSecond;             /*!< Frames received per second, sent per second for BenchmarkBurstTx without loop back. */
+  uint32_t CpuPermille;                 /*!< CPU load from the idle loop count, in 1/1000. */
+  uint32_t LatencyNumber;               /*!< Latencies measured, send to receive in nanoseconds. */
+  uint32_t LatencyMin;
+  uint32_t LatencyP50;
+  uint32_t LatencyP90;
+  uint32_t LatencyP99;
+  uint32_t LatencyMax;
+  uint32_t TxIsrMean;                   /*!< Transmit interrupt time in CAN_Profile_GetTime() ticks, */
+  uint32_t TxIsrMax;                    /*!< cycles on the target. 0 without CAN_PROFILE_ENABLE. */
+  uint32_t RxIsrMean;                   /*!< Receive interrupt time, the same. */
+  uint32_t RxIsrMax;
+}Benchmark_Result;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+uint32_t Benchmark_Calibrate(const Benchmark_Config *Config);
+bool Benchmark_Run(const Benchmark_Config *Config, Benchmark_Result *Result);
+uint32_t Benchmark_Format(const Benchmark_Config *Config, const Benchmark_Result *Result, char *Text, uint32_t Size);
+
+void Benchmark_Echo(CAN_TypeDef *CANx);
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BENCHMARK_H */
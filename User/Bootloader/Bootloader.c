@@ -0,0 +1,477 @@
+/**
+  ******************************************************************************
+  * @file    Bootloader.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   CAN bootloader module source file.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+/* Header includes -----------------------------------------------------------*/
+#include "Bootloader.h"
+#include <string.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define BOOTLOADER_BUFFER_SIZE  (BOOTLOADER_DATA_HEADER + BOOTLOADER_PAGE_SIZE)
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct
+{
+  uint32_t      Word[BOOTLOADER_BUFFER_SIZE / 4];  /*!< Word aligned for programming. */
+  uint32_t      Length;
+  volatile bool Full;                              /*!< Received, waiting for Bootloader_Process(). */
+}Bootloader_Buffer;
+
+/* Variable declarations -----------------------------------------------------*/
+static uint32_t              bootloaderSession     = 0;
+static CAN_TypeDef          *bootloaderCANx        = 0;
+
+static Bootloader_Buffer     bootloaderBuffer[2]   = {0};
+static volatile uint32_t     bootloaderReceive     = 0;      /* Buffer the ISO-TP session receives into. */
+static volatile bool         bootloaderHold        = false;  /* Both buffers full, no buffer given to the session. */
+static uint32_t              bootloaderNext        = 0;      /* Buffer processed next. */
+
+static bool                  bootloaderStarted     = false;
+static uint32_t              bootloaderAddress     = 0;
+static uint32_t              bootloaderSize        = 0;
+static uint32_t              bootloaderOffset      = 0;
+static uint8_t               bootloaderSequence    = 0;
+static bool                  bootloaderJump        = false;
+static uint8_t               bootloaderResponse[3] = {0};
+static bool                  bootloaderRespond     = false;  /* The response found the transmit buffer full. */
+
+static Bootloader_Statistics bootloaderStatistics  = {0};
+static volatile uint32_t     bootloaderTick        = 0;
+static uint32_t              bootloaderStart       = 0;
+
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+static void bootloader_receive_finish(uint32_t session, const uint8_t *data, uint32_t length, ISOTP_Result result);
+static Bootloader_Status bootloader_command(const uint8_t *data, uint32_t length);
+static Bootloader_Status bootloader_start(uint32_t address, uint32_t size);
+static Bootloader_Status bootloader_data(uint8_t sequence, const uint32_t *word, uint32_t length);
+static Bootloader_Status bootloader_end(uint32_t crc);
+static uint32_t bootloader_get_word(const uint8_t *data);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Initialize the bootloader and open its ISO-TP session.
+  * @param  [in] Session: ISO-TP session number.
+  * @param  [in] Config:  ISO-TP configuration. The receive buffer and the
+  *                       receive finish callback are set by the bootloader.
+  * @retval true:         The session is open.
+  * @retval false:        The session could not be opened.
+  * @note   Two page buffers are used in turn: one is programmed by
+  *         Bootloader_Process() in the main loop while the next page streams
+  *         into the other. When both are full the first frame of the next
+  *         message is held back with flow control wait frames, and a single
+  *         frame command such as END is held by the session until a buffer
+  *         is free.
+  */
+bool Bootloader_Init(uint32_t Session, const ISOTP_Config *Config)
+{
+  ISOTP_Config config = *Config;
+  
+  memset(bootloaderBuffer, 0, sizeof(bootloaderBuffer));
+  memset(&bootloaderStatistics, 0, sizeof(bootloaderStatistics));
+  
+  bootloaderSession  = Session;
+  bootloaderCANx     = Config->CANx;
+  bootloaderReceive  = 0;
+  bootloaderHold     = false;
+  bootloaderNext     = 0;
+  bootloaderStarted  = false;
+  bootloaderJump     = false;
+  bootloaderRespond  = false;
+  
+  config.RxBuffer              = (uint8_t *)bootloaderBuffer[0].Word;
+  config.RxBufferSize          = BOOTLOADER_BUFFER_SIZE;
+  config.ReceiveFinishCallback = bootloader_receive_finish;
+  
+  RCC_AHBPeriphClockCmd(RCC_AHBPeriph_CRC, ENABLE);
+  
+  return ISOTP_Open(Session, &config);
+}
+
+/**
+  * @brief  Execute the received commands, call it from the main loop.
+  * @param  None.
+  * @return None.
+  */
+void Bootloader_Process(void)
+{
+  if(ISOTP_IsTransmitBusy(bootloaderSession) == true)
+  {
+    return;
+  }
+  
+  /* No command is executed before the host has the response of the previous one. */
+  if(bootloaderRespond == true)
+  {
+    bootloaderRespond = (ISOTP_Transmit(bootloaderSession, bootloaderResponse, sizeof(bootloaderResponse)) != true);
+    return;
+  }
+  
+  if(bootloaderJump == true)
+  {
+    bootloaderJump = false;
+    Bootloader_JumpToApplication();
+  }
+  
+  Bootloader_Buffer *buffer = &bootloaderBuffer[bootloaderNext];
+  
+  if(buffer->Full != true)
+  {
+    return;
+  }
+  
+  const uint8_t *data = (const uint8_t *)buffer->Word;
+  
+  bootloaderResponse[0] = data[0] | 0x40;
+  bootloaderResponse[1] = bootloader_command(data, buffer->Length);
+  bootloaderResponse[2] = (data[0] == BOOTLOADER_CMD_DATA) ? data[1] : 0;
+  
+  /* Give the buffer back, to the session directly if it has none. */
+  __disable_irq();
+  
+  buffer->Full = false;
+  
+  if(bootloaderHold == true)
+  {
+    bootloaderHold = false;
+    ISOTP_SetReceiveBuffer(bootloaderSession, (uint8_t *)buffer->Word, BOOTLOADER_BUFFER_SIZE);
+  }
+  
+  __enable_irq();
+  
+  bootloaderNext ^= 1;
+  
+  bootloaderRespond = (ISOTP_Transmit(bootloaderSession, bootloaderResponse, sizeof(bootloaderResponse)) != true);
+}
+
+/**
+  * @brief  Time base of the bootloader statistics.
+  * @param  None.
+  * @return None.
+  * @note   Call it every BOOTLOADER_TICK_PERIOD milliseconds.
+  */
+void Bootloader_Tick(void)
+{
+  bootloaderTick++;
+}
+
+/**
+  * @brief  Start the application at BOOTLOADER_APPLICATION_ADDRESS.
+  * @param  None.
+  * @retval false: No valid application, otherwise the function does not return.
+  * @note   The CAN peripheral is unconfigured once the transmit buffer is
+  *         empty, or after BOOTLOADER_TIMEOUT_JUMP, so that the response to
+  *         JUMP reaches the host. All interrupts are then disabled and
+  *         cleared, the vector table is moved to the application.
+  */
+bool Bootloader_JumpToApplication(void)
+{
+  uint32_t stack = *(volatile uint32_t *)BOOTLOADER_APPLICATION_ADDRESS;
+  uint32_t entry = *(volatile uint32_t *)(BOOTLOADER_APPLICATION_ADDRESS + 4);
+  
+  if(((stack & 0x2FFE0000) != 0x20000000) || (entry < BOOTLOADER_APPLICATION_ADDRESS) || (entry >= BOOTLOADER_FLASH_END))
+  {
+    return false;
+  }
+  
+  uint32_t start = bootloaderTick;
+  
+  while((CAN_IsTransmitMessage(bootloaderCANx) == true) &&
+        ((bootloaderTick - start) * BOOTLOADER_TICK_PERIOD < BOOTLOADER_TIMEOUT_JUMP))
+  {
+  }
+  
+  CAN_Unconfigure(bootloaderCANx);
+  
+  __disable_irq();
+  
+  SysTick->CTRL = 0;
+  
+  for(uint32_t i = 0; i < 8; i++)
+  {
+    NVIC->ICER[i] = 0xFFFFFFFF;
+    NVIC->ICPR[i] = 0xFFFFFFFF;
+  }
+  
+  SCB->VTOR = BOOTLOADER_APPLICATION_ADDRESS;
+  __set_MSP(stack);
+  
+  __enable_irq();
+  
+  ((void (*)(void))entry)();
+  
+  return true;
+}
+
+/**
+  * @brief  Calculate the CRC of a flash area with the CRC calculation unit.
+  * @param  [in] Address: Start address, word aligned.
+  * @param  [in] Size:    Size, a multiple of 4.
+  * @return The CRC-32 (polynomial 0x04C11DB7, initial value 0xFFFFFFFF, no
+  *         reflection, no final XOR) of the area read as little endian words,
+  *         each word fed most significant byte first.
+  */
+uint32_t Bootloader_GetCRC(uint32_t Address, uint32_t Size)
+{
+  CRC->CR = CRC_CR_RESET;
+  
+  for(uint32_t i = 0; i < Size; i += 4)
+  {
+    CRC->DR = *(const volatile uint32_t *)(Address + i);
+  }
+  
+  return CRC->DR;
+}
+
+/**
+  * @brief  Get the bootloader statistics.
+  * @param  [out] Statistics: The statistics.
+  * @return None.
+  */
+void Bootloader_GetStatistics(Bootloader_Statistics *Statistics)
+{
+  *Statistics = bootloaderStatistics;
+}
+
+/**
+  * @brief  Receive finish callback of the ISO-TP session.
+  * @param  [in] session: Session number.
+  * @param  [in] data:    The message.
+  * @param  [in] length:  The length of the message.
+  * @param  [in] result:  The result of the reception.
+  * @return None.
+  * @note   Called from the CAN receive interrupt. The session is given the
+  *         other buffer, or no buffer while it is still being processed.
+  */
+static void bootloader_receive_finish(uint32_t session, const uint8_t *data, uint32_t length, ISOTP_Result result)
+{
+  if(result != ISOTP_ResultOk)
+  {
+    return;
+  }
+  
+  bootloaderBuffer[bootloaderReceive].Length = length;
+  bootloaderBuffer[bootloaderReceive].Full   = true;
+  
+  bootloaderReceive ^= 1;
+  
+  if(bootloaderBuffer[bootloaderReceive].Full != true)
+  {
+    ISOTP_SetReceiveBuffer(session, (uint8_t *)bootloaderBuffer[bootloaderReceive].Word, BOOTLOADER_BUFFER_SIZE);
+  }
+  else
+  {
+    bootloaderHold = true;
+    bootloaderStatistics.BufferFull++;
+    ISOTP_SetReceiveBuffer(session, 0, 0);
+  }
+}
+
+/**
+  * @brief  Execute a command.
+  * @param  [in] data:   The command, word aligned.
+  * @param  [in] length: The length of the command.
+  * @return The status returned to the host.
+  */
+static Bootloader_Status bootloader_command(const uint8_t *data, uint32_t length)
+{
+  switch(data[0])
+  {
+    case BOOTLOADER_CMD_START:
+      if(length != 9)
+      {
+        break;
+      }
+      return bootloader_start(bootloader_get_word(&data[1]), bootloader_get_word(&data[5]));
+    case BOOTLOADER_CMD_DATA:
+      if(length < BOOTLOADER_DATA_HEADER)
+      {
+        break;
+      }
+      return bootloader_data(data[1], (const uint32_t *)&data[BOOTLOADER_DATA_HEADER], length - BOOTLOADER_DATA_HEADER);
+    case BOOTLOADER_CMD_END:
+      if(length != 5)
+      {
+        break;
+      }
+      return bootloader_end(bootloader_get_word(&data[1]));
+    case BOOTLOADER_CMD_JUMP:
+    {
+      uint32_t stack = *(volatile uint32_t *)BOOTLOADER_APPLICATION_ADDRESS;
+      
+      if((bootloaderStarted == true) || ((stack & 0x2FFE0000) != 0x20000000))
+      {
+        return Bootloader_StatusApplication;
+      }
+      
+      bootloaderJump = true;
+      return Bootloader_StatusOk;
+    }
+    default:
+      break;
+  }
+  
+  return Bootloader_StatusCommand;
+}
+
+/**
+  * @brief  Erase the area of a new image.
+  * @param  [in] address: Start address, page aligned.
+  * @param  [in] size:    Size of the image, a multiple of 4.
+  * @return The status returned to the host.
+  * @note   The whole area is erased here, so that the page erase, which
+  *         stalls the CPU and the CAN interrupts, never runs while the image
+  *         is streaming in.
+  */
+static Bootloader_Status bootloader_start(uint32_t address, uint32_t size)
+{
+  bootloaderStarted = false;
+  
+  if((address < BOOTLOADER_APPLICATION_ADDRESS) || ((address % BOOTLOADER_PAGE_SIZE) != 0) ||
+     (size == 0) || ((size % 4) != 0) || (size > BOOTLOADER_FLASH_END - address))
+  {
+    return Bootloader_StatusAddress;
+  }
+  
+  memset(&bootloaderStatistics, 0, sizeof(bootloaderStatistics));
+  
+  uint32_t start = bootloaderTick;
+  
+  FLASH_Unlock();
+  FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR);
+  
+  for(uint32_t page = address; page < address + size; page += BOOTLOADER_PAGE_SIZE)
+  {
+    if(FLASH_ErasePage(page) != FLASH_COMPLETE)
+    {
+      FLASH_Lock();
+      return Bootloader_StatusErase;
+    }
+  }
+  
+  bootloaderStatistics.EraseTime = (bootloaderTick - start) * BOOTLOADER_TICK_PERIOD;
+  
+  bootloaderStarted  = true;
+  bootloaderAddress  = address;
+  bootloaderSize     = size;
+  bootloaderOffset   = 0;
+  bootloaderSequence = 0;
+  
+  return Bootloader_StatusOk;
+}
+
+/**
+  * @brief  Program the next bytes of the image.
+  * @param  [in] sequence: Sequence number of the data message.
+  * @param  [in] word:     The data.
+  * @param  [in] length:   The length of the data, a multiple of 4.
+  * @return The status returned to the host.
+  * @note   Erased words are skipped, every programmed word is read back.
+  */
+static Bootloader_Status bootloader_data(uint8_t sequence, const uint32_t *word, uint32_t length)
+{
+  if((bootloaderStarted != true) || (sequence != bootloaderSequence) ||
+     ((length % 4) != 0) || (length > bootloaderSize - bootloaderOffset))
+  {
+    return Bootloader_StatusSequence;
+  }
+  
+  uint32_t start   = bootloaderTick;
+  uint32_t address = bootloaderAddress + bootloaderOffset;
+  
+  if(bootloaderOffset == 0)
+  {
+    bootloaderStart = start;
+  }
+  
+  for(uint32_t i = 0; i < length / 4; i++, address += 4)
+  {
+    if(word[i] == 0xFFFFFFFF)
+    {
+      continue;
+    }
+    
+    if(FLASH_ProgramWord(address, word[i]) != FLASH_COMPLETE)
+    {
+      bootloaderStarted = false;
+      FLASH_Lock();
+      return Bootloader_StatusProgram;
+    }
+    
+    if(*(const volatile uint32_t *)address != word[i])
+    {
+      bootloaderStarted = false;
+      FLASH_Lock();
+      return Bootloader_StatusVerify;
+    }
+  }
+  
+  bootloaderOffset += length;
+  bootloaderSequence++;
+  
+  bootloaderStatistics.Pages++;
+  bootloaderStatistics.Bytes       += length;
+  bootloaderStatistics.ProgramTime += (bootloaderTick - start) * BOOTLOADER_TICK_PERIOD;
+  
+  return Bootloader_StatusOk;
+}
+
+/**
+  * @brief  Verify the image.
+  * @param  [in] crc: CRC of the image computed by the host, see Bootloader_GetCRC().
+  * @return The status returned to the host.
+  */
+static Bootloader_Status bootloader_end(uint32_t crc)
+{
+  if((bootloaderStarted != true) || (bootloaderOffset != bootloaderSize))
+  {
+    return Bootloader_StatusSequence;
+  }
+  
+  bootloaderStarted = false;
+  FLASH_Lock();
+  
+  bootloaderStatistics.TransferTime = (bootloaderTick - bootloaderStart) * BOOTLOADER_TICK_PERIOD;
+  
+  if(Bootloader_GetCRC(bootloaderAddress, bootloaderSize) != crc)
+  {
+    return Bootloader_StatusVerify;
+  }
+  
+  return Bootloader_StatusOk;
+}
+
+/**
+  * @brief  Get a little endian word of a command.
+  * @param  [in] data: The bytes.
+  * @return The word.
+  */
+static uint32_t bootloader_get_word(const uint8_t *data)
+{
+  return data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
@@ -0,0 +1,104 @@
+/**
+  ******************************************************************************
+  * @file    Bootloader.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for Bootloader.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __BOOTLOADER_H
+#define __BOOTLOADER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "ISOTP.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#if defined(STM32F10X_HD) || defined(STM32F10X_HD_VL) || defined(STM32F10X_CL) || defined(STM32F10X_XL)
+#define BOOTLOADER_PAGE_SIZE            (2048)
+#else
+#define BOOTLOADER_PAGE_SIZE            (1024)
+#endif
+
+#define BOOTLOADER_APPLICATION_ADDRESS  (0x08008000)
+#define BOOTLOADER_FLASH_END            (0x08080000)  /* 512 KB of the STM32F103ZE. */
+
+#define BOOTLOADER_TICK_PERIOD          (1)           /* Milliseconds between Bootloader_Tick() calls. */
+#define BOOTLOADER_TIMEOUT_JUMP         (100)         /* Milliseconds the jump waits for the transmit buffer to empty. */
+
+/* Commands, the response to a command is the command | 0x40 and a status byte. */
+#define BOOTLOADER_CMD_START            (0x01)        /* Address (4), size (4): erase the area. */
+#define BOOTLOADER_CMD_DATA             (0x02)        /* Sequence (1), reserved (2), data: program the next bytes. */
+#define BOOTLOADER_CMD_END              (0x03)        /* CRC (4): verify the area. */
+#define BOOTLOADER_CMD_JUMP             (0x04)        /* Start the application. */
+
+#define BOOTLOADER_DATA_HEADER          (4)           /* Keeps the data of a page word aligned. */
+
+/* Type definitions ----------------------------------------------------------*/
+typedef enum
+{
+  Bootloader_StatusOk = 0,
+  Bootloader_StatusCommand,                           /*!< Unknown or malformed command. */
+  Bootloader_StatusAddress,                           /*!< Area outside the application flash. */
+  Bootloader_StatusSequence,                          /*!< Data out of sequence or past the area. */
+  Bootloader_StatusErase,
+  Bootloader_StatusProgram,
+  Bootloader_StatusVerify,                            /*!< Read back or CRC mismatch. */
+  Bootloader_StatusApplication                        /*!< No valid application to start. */
+}Bootloader_Status;
+
+typedef struct
+{
+  uint32_t Pages;                                     /*!< Data messages programmed. */
+  uint32_t Bytes;                                     /*!< Bytes programmed. */
+  uint32_t TransferTime;                              /*!< From the first data message to the end, in milliseconds. */
+  uint32_t ProgramTime;                               /*!< Spent programming, in milliseconds. */
+  uint32_t EraseTime;                                 /*!< Spent erasing, in milliseconds. */
+  uint32_t BufferFull;                                /*!< Messages held back by flow control wait, both buffers busy. */
+}Bootloader_Statistics;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+bool Bootloader_Init(uint32_t Session, const ISOTP_Config *Config);
+
+void Bootloader_Process(void);
+void Bootloader_Tick(void);
+
+bool Bootloader_JumpToApplication(void);
+uint32_t Bootloader_GetCRC(uint32_t Address, uint32_t Size);
+
+void Bootloader_GetStatistics(Bootloader_Statistics *Statistics);
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BOOTLOADER_H */
@@ -29,32 +29,242 @@
 /* Header includes -----------------------------------------------------------*/
 #include "CAN.h"
 #include "RingBuffer.h"
+#include "FramePool.h"
+#include "CANProfile.h"
+#include "CANTrace.h"
+#include <string.h>
+
+#ifdef HOST_MODEL
+#include "Core.h"
+#endif /* HOST_MODEL */
 
 /* Macro definitions ---------------------------------------------------------*/
+#ifdef RTE_CMSIS_RTOS2
+#define CAN_EVENT_RECEIVE   (0x01)
+#define CAN_EVENT_TRANSMIT  (0x02)
+#endif /* RTE_CMSIS_RTOS2 */
+
+#ifdef HOST_MODEL
+#define CAN_TIME()          ((uint32_t)Core_GetHostTime())
+#else
+#define CAN_TIME()          (DWT->CYCCNT)
+#endif /* HOST_MODEL */
+
+/* RingBuffer.c does not see CAN.h, so the ring buffer has its own switch. */
+#if CAN_RAM_EXECUTE != RING_BUFFER_RAM_EXECUTE
+#error "CAN_RAM_EXECUTE and RING_BUFFER_RAM_EXECUTE must be set alike."
+#endif
+
+#if CAN_RAM_EXECUTE
+#ifdef STM32F10X_CL
+#define CAN_VECTOR_NUMBER   (16 + 68)   /* Up to OTG_FS_IRQn. */
+#else
+#define CAN_VECTOR_NUMBER   (16 + 60)   /* Up to DMA2_Channel4_5_IRQn. */
+#endif /* STM32F10X_CL */
+#endif /* CAN_RAM_EXECUTE */
+
 /* Type definitions ----------------------------------------------------------*/
+typedef struct
+{
+  CAN_RateLimit      Limit;
+  uint32_t           Token;             /*!< In thousandths of a frame. */
+  uint32_t           Tick;              /*!< Of the last refill. */
+  CAN_RateStatistics Statistics;
+  CanTxMsg           Parked[CAN_RATE_DEFER_NUMBER];  /*!< Deferred messages, oldest first. */
+  uint32_t           ParkedHandle[CAN_RATE_DEFER_NUMBER];
+  uint32_t           ParkedOut;         /*!< Index of the oldest. */
+  uint32_t           ParkedNumber;
+}CAN_RateClass;
+
+typedef struct
+{
+  uint8_t                  Mailbox;          /*!< Of the frame in flight, CAN_TxStatus_NoMailBox if none. */
+  uint8_t                  Attempt;          /*!< Retries of the frame in flight. */
+  CAN_TxCompletion         InFlight;         /*!< Filled when the mailbox is loaded. */
+  CanTxMsg                 Message;          /*!< The frame in flight, for a retry or after a preemption. */
+  uint32_t                 HandleIn;         /*!< Handle of the next message put into the transmit buffer. */
+  uint32_t                 HandleOut;        /*!< Handle of the next message taken out of it. */
+  RingBuffer              *Buffer;           /*!< Completions not taken by the callback. */
+  bool (*volatile          Callback)(CAN_TypeDef *CANx, const CAN_TxCompletion *Completion);
+  CAN_Retransmit           Mode;
+  uint8_t                  RetryLimit;
+  uint8_t                  Backoff;
+  bool                     RetryPending;     /*!< A failed frame waits for its retry. */
+  uint8_t                  RetryAttempt;
+  uint32_t                 RetryWait;        /*!< Frames let through before the retry. */
+  CanTxMsg                 RetryMessage;
+  CAN_TxCompletion         RetryCompletion;
+  CAN_RetransmitStatistics Statistics;
+  uint32_t                 Timeout;          /*!< Ticks a request may stay pending, 0 for no limit. */
+  uint32_t                 LoadTick;         /*!< Tick of the mailbox load. */
+  bool                     Cancel;           /*!< The timeout cancelled the request in flight. */
+  bool                     Preempt;          /*!< An urgent frame cancelled the request in flight. */
+  uint8_t                  UrgentMailbox;    /*!< Of the urgent frame, CAN_TxStatus_NoMailBox if none. */
+  uint32_t                 UrgentStart;      /*!< Time of the CAN_SendUrgent() call. */
+  uint32_t                 UrgentTick;       /*!< Tick of the urgent mailbox load. */
+  bool                     UrgentCancel;     /*!< The timeout cancelled the urgent frame. */
+  CAN_TxCompletion         UrgentCompletion;
+  CAN_UrgentStatistics     UrgentStatistics;
+  CAN_RateClass            Rate[CAN_RATE_CLASS_NUMBER];
+  uint32_t                 Parked;           /*!< Deferred messages of all classes waiting for a token. */
+}CAN_TxState;
+
+typedef struct
+{
+  uint32_t             Burst;      /*!< Messages by interrupt between two polls that switch to polling, 0 for never. */
+  uint32_t             Idle;       /*!< Empty polls in a row that switch back to the interrupt. */
+  volatile bool        Polling;    /*!< FIFO 0 message pending is off, the FIFO is polled. */
+  uint32_t             Count;      /*!< Messages by interrupt since the last poll. */
+  uint32_t             Empty;      /*!< Empty polls in a row. */
+  CAN_RxPollStatistics Statistics;
+}CAN_RxState;
+
+#if CAN_POLL_MODE
+typedef struct
+{
+  bool               BusOff;     /*!< Bus-off at the last poll. */
+  CAN_PollStatistics Statistics;
+}CAN_PollState;
+#endif /* CAN_POLL_MODE */
+
+#ifdef RTE_CMSIS_RTOS2
+typedef struct
+{
+  osEventFlagsId_t   EventFlags;
+  osMutexId_t        TxMutex;     /*!< Serializes the threads waiting for transmit buffer space. */
+  osMutexId_t        RxMutex;     /*!< Serializes the threads waiting for received messages. */
+  osThreadId_t       RxThread;
+  void             (*RxCallback)(CAN_TypeDef *CANx, const CanRxMsg *Message);
+  volatile bool      TxWaiting;
+  volatile uint32_t  RxStamp;     /*!< Cycle counter when the receive event was set. */
+  CAN_RtosStatistics Statistics;
+}CAN_Rtos;
+#endif /* RTE_CMSIS_RTOS2 */
+
 /* Variable declarations -----------------------------------------------------*/
 static volatile bool can1InitFlag     = false;
 static volatile bool can1TransmitFlag = false;
 
 static volatile void (*can1TransmitFinishCallback)(void) = 0;
 static volatile void (*can1ReceiveFinishCallback)(void)  = 0;
+static bool (*volatile can1ReceiveMessageCallback)(CAN_TypeDef *CANx, const CanRxMsg *Message) = 0;
 
 static RingBuffer *can1TxBuffer = 0;
 static RingBuffer *can1RxBuffer = 0;
 
+static volatile bool can1FrameMode     = false;
+static RingBuffer   *can1TxFrameBuffer = 0;
+static RingBuffer   *can1RxFrameBuffer = 0;
+
+static CAN_FilterInitTypeDef can1FilterBank[CAN_FILTER_BANK_NUMBER] = {0};
+static uint32_t              can1FilterBankNumber                   = 0;
+
+static CAN_Producer *can1Producer = 0;
+static CAN_TxState   can1TxState  = {0};
+static CAN_RxState   can1RxState  = {0};
+
+#if CAN_POLL_MODE
+static CAN_PollState can1Poll = {0};
+#endif /* CAN_POLL_MODE */
+
+#ifdef RTE_CMSIS_RTOS2
+static CAN_Rtos can1Rtos = {0};
+#endif /* RTE_CMSIS_RTOS2 */
+
 #ifdef STM32F10X_CL
 static volatile bool can2InitFlag     = false;
 static volatile bool can2TransmitFlag = false;
 
 static volatile void (*can2TransmitFinishCallback)(void) = 0;
 static volatile void (*can2ReceiveFinishCallback)(void)  = 0;
+static bool (*volatile can2ReceiveMessageCallback)(CAN_TypeDef *CANx, const CanRxMsg *Message) = 0;
 
 static RingBuffer *can2TxBuffer = 0;
 static RingBuffer *can2RxBuffer = 0;
+
+static volatile bool can2FrameMode     = false;
+static RingBuffer   *can2TxFrameBuffer = 0;
+static RingBuffer   *can2RxFrameBuffer = 0;
+
+static CAN_FilterInitTypeDef can2FilterBank[CAN_FILTER_BANK_NUMBER] = {0};
+static uint32_t              can2FilterBankNumber                   = 0;
+
+static CAN_Producer *can2Producer = 0;
+static CAN_TxState   can2TxState  = {0};
+static CAN_RxState   can2RxState  = {0};
+
+#if CAN_POLL_MODE
+static CAN_PollState can2Poll = {0};
+#endif /* CAN_POLL_MODE */
+
+#ifdef RTE_CMSIS_RTOS2
+static CAN_Rtos can2Rtos = {0};
+#endif /* RTE_CMSIS_RTOS2 */
 #endif /* STM32F10X_CL */
 
+static volatile uint32_t canTick = 0;
+
+/* Request completed flag of each mailbox, clearing it clears TXOK, ALST and TERR of that mailbox only. */
+static const uint32_t canFlagRqcp[3] = {CAN_FLAG_RQCP0, CAN_FLAG_RQCP1, CAN_FLAG_RQCP2};
+
+#if CAN_RAM_EXECUTE
+/* VTOR needs the table aligned to its size rounded up to a power of 2. */
+static uint32_t canVectorTable[CAN_VECTOR_NUMBER] __attribute__((aligned(512)));
+#endif /* CAN_RAM_EXECUTE */
+
 /* Variable definitions ------------------------------------------------------*/
 /* Function declarations -----------------------------------------------------*/
+static uint32_t can_filter_compile(const CAN_FilterId *Filter, uint32_t Number, CAN_FilterInitTypeDef *Bank, uint32_t Size);
+static void can_filter_update(void);
+static CAN_Producer **can_producer_get(CAN_TypeDef *CANx);
+static bool can_producer_load(CAN_TypeDef *CANx, CAN_TxState *State, CAN_Producer *Producer);
+static void can_transmit(CAN_TypeDef *CANx, CAN_TxState *State, const CanTxMsg *Message, CAN_TxSource Source, uint32_t Handle);
+static bool can_transmit_status(CAN_TypeDef *CANx, CAN_TxState *State, CAN_TxCompletion *Completion);
+static void can_transmit_complete(CAN_TypeDef *CANx, CAN_TxState *State, const CAN_TxCompletion *Completion);
+static bool can_transmit_retry(CAN_TypeDef *CANx, CAN_TxState *State, bool Force);
+static void can_transmit_watchdog(CAN_TypeDef *CANx);
+static CAN_TxStatus can_transmit_result(uint32_t TSR);
+static bool can_transmit_urgent(CAN_TypeDef *CANx, CAN_TxState *State, CAN_TxCompletion *Completion);
+static bool can_transmit_queue(CAN_TypeDef *CANx, CAN_TxState *State, RingBuffer *Buffer, const CAN_TxCompletion *Completion, bool *Complete);
+static void can_transmit_start(CAN_TypeDef *CANx, CAN_TxState *State, RingBuffer *Buffer, volatile bool *Flag);
+static bool can_transmit_parked(CAN_TypeDef *CANx, CAN_TxState *State);
+static CAN_RateClass *can_rate_class(CAN_TxState *State, const CanTxMsg *Message);
+static bool can_rate_take(CAN_RateClass *Class);
+static void can_rate_resume(CAN_TypeDef *CANx);
+static void can_rate_clear(CAN_TxState *State);
+static void can_receive(CAN_TypeDef *CANx);
+static void can_receive_burst(CAN_TypeDef *CANx, CAN_RxState *State);
+static CAN_RxState *can_receive_get(CAN_TypeDef *CANx);
+
+#if CAN_POLL_MODE
+static void can_poll_error(CAN_TypeDef *CANx, CAN_PollState *Poll);
+
+/* The handlers, called as functions by CAN_Poll(). */
+#ifdef STM32F10X_CL
+void CAN1_TX_IRQHandler(void);
+void CAN1_RX0_IRQHandler(void);
+void CAN2_TX_IRQHandler(void);
+void CAN2_RX0_IRQHandler(void);
+#else
+void USB_HP_CAN1_TX_IRQHandler(void);
+void USB_LP_CAN1_RX0_IRQHandler(void);
+#endif /* STM32F10X_CL */
+#endif /* CAN_POLL_MODE */
+static CAN_TxState *can_transmit_get(CAN_TypeDef *CANx);
+
+#if CAN_RAM_EXECUTE
+static void can_vector_relocate(void);
+#endif /* CAN_RAM_EXECUTE */
+
+#ifdef RTE_CMSIS_RTOS2
+static void can_rtos_create(CAN_Rtos *rtos);
+static void can_rtos_delete(CAN_Rtos *rtos);
+static void can_rtos_receive(CAN_Rtos *rtos);
+static void can_rtos_transmit(CAN_Rtos *rtos);
+static CAN_Rtos *can_rtos_get(CAN_TypeDef *CANx);
+static void can_rtos_thread(void *argument);
+#endif /* RTE_CMSIS_RTOS2 */
+
 /* Function definitions ------------------------------------------------------*/
 
 /**
@@ -65,14 +275,25 @@ static RingBuffer *can2RxBuffer = 0;
   * @param  [in] StdId:    Filter standard frame ID.
   * @param  [in] ExtId:    Filter extended frame ID.
   * @return None.
+  * @note   With CMSIS-RTOS2 it must be called after osKernelInitialize(), the
+  *         event flags and mutexes of the channel are created here.
   */
 void CAN_Configure(CAN_TypeDef *CANx, CAN_WorkMode WorkMode, CAN_BaudRate BaudRate, uint32_t StdId, uint32_t ExtId)
 {
   GPIO_InitTypeDef      GPIO_InitStructure      = {0};
   CAN_InitTypeDef       CAN_InitStructure       = {0};
-  CAN_FilterInitTypeDef CAN_FilterInitStructure = {0};
   NVIC_InitTypeDef      NVIC_InitStructure      = {0};
   
+#if CAN_RAM_EXECUTE
+  can_vector_relocate();
+#endif /* CAN_RAM_EXECUTE */
+  
+#ifndef HOST_MODEL
+  /* The cycle counter timestamps the transmit completions. */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+#endif /* HOST_MODEL */
+  
   if(CANx == CAN1)
   {
     if(can1InitFlag == false)
@@ -83,10 +304,49 @@ void CAN_Configure(CAN_TypeDef *CANx, CAN_WorkMode WorkMode, CAN_BaudRate BaudRa
       
       can1TransmitFinishCallback = 0;
       can1ReceiveFinishCallback  = 0;
+      can1ReceiveMessageCallback = 0;
+      
+      can1Producer = 0;
       
       can1TxBuffer = RingBuffer_Malloc(sizeof(CanTxMsg) * CAN1_TX_BUFFER_SIZE);
       can1RxBuffer = RingBuffer_Malloc(sizeof(CanRxMsg) * CAN1_RX_BUFFER_SIZE);
       
+      can1FrameMode     = false;
+      can1TxFrameBuffer = RingBuffer_Malloc(sizeof(uint8_t) * CAN1_TX_BUFFER_SIZE);
+      can1RxFrameBuffer = RingBuffer_Malloc(sizeof(uint8_t) * CAN1_RX_BUFFER_SIZE);
+      
+      can1TxState.Mailbox   = CAN_TxStatus_NoMailBox;
+      can1TxState.HandleIn  = 0;
+      can1TxState.HandleOut = 0;
+      can1TxState.Buffer    = RingBuffer_Malloc(sizeof(CAN_TxCompletion) * CAN1_TX_COMPLETE_SIZE);
+      can1TxState.Callback  = 0;
+      
+      can1TxState.Mode         = CAN_RetransmitNone;
+      can1TxState.RetryLimit   = 0;
+      can1TxState.Backoff      = 0;
+      can1TxState.RetryPending = false;
+      can1TxState.Timeout      = 0;
+      memset(&can1TxState.Statistics, 0, sizeof(can1TxState.Statistics));
+      
+      can1TxState.UrgentMailbox = CAN_TxStatus_NoMailBox;
+      memset(&can1TxState.UrgentStatistics, 0, sizeof(can1TxState.UrgentStatistics));
+      
+      can1TxState.Parked = 0;
+      memset(can1TxState.Rate, 0, sizeof(can1TxState.Rate));
+      
+      memset(&can1RxState, 0, sizeof(can1RxState));
+      
+#if CAN_POLL_MODE
+      memset(&can1Poll, 0, sizeof(can1Poll));
+#endif /* CAN_POLL_MODE */
+      
+      CAN_PROFILE_TX_CLEAR(CAN1, CAN_PROFILE_QUEUE_MESSAGE);
+      CAN_PROFILE_TX_CLEAR(CAN1, CAN_PROFILE_QUEUE_FRAME);
+      
+#ifdef RTE_CMSIS_RTOS2
+      can_rtos_create(&can1Rtos);
+#endif /* RTE_CMSIS_RTOS2 */
+      
 #ifdef STM32F10X_CL
       if(can2InitFlag == false)
 #endif /* STM32F10X_CL */
@@ -122,16 +382,17 @@ void CAN_Configure(CAN_TypeDef *CANx, CAN_WorkMode WorkMode, CAN_BaudRate BaudRa
       CAN_DeInit(CAN1);
       CAN_Init(CAN1, &CAN_InitStructure);
       
-      CAN_FilterInitStructure.CAN_FilterIdHigh         = (uint16_t)((((StdId<<18)|ExtId)<<3)>>16);
-      CAN_FilterInitStructure.CAN_FilterIdLow          = (uint16_t)(((StdId<<18)|ExtId)<<3);
-      CAN_FilterInitStructure.CAN_FilterMaskIdHigh     = (~((uint16_t)((((StdId<<18)|ExtId)<<3)>>16)))&0xFFFF;
-      CAN_FilterInitStructure.CAN_FilterMaskIdLow      = (~((uint16_t)(((StdId<<18)|ExtId)<<3)))&0xFFF8;
-      CAN_FilterInitStructure.CAN_FilterFIFOAssignment = CAN_Filter_FIFO0;
-      CAN_FilterInitStructure.CAN_FilterNumber         = 0;
-      CAN_FilterInitStructure.CAN_FilterMode           = CAN_FilterMode_IdMask;
-      CAN_FilterInitStructure.CAN_FilterScale          = CAN_FilterScale_32bit;
-      CAN_FilterInitStructure.CAN_FilterActivation     = ENABLE;
-      CAN_FilterInit(&CAN_FilterInitStructure);
+      can1FilterBank[0].CAN_FilterIdHigh         = (uint16_t)((((StdId<<18)|ExtId)<<3)>>16);
+      can1FilterBank[0].CAN_FilterIdLow          = (uint16_t)(((StdId<<18)|ExtId)<<3);
+      can1FilterBank[0].CAN_FilterMaskIdHigh     = (~((uint16_t)((((StdId<<18)|ExtId)<<3)>>16)))&0xFFFF;
+      can1FilterBank[0].CAN_FilterMaskIdLow      = (~((uint16_t)(((StdId<<18)|ExtId)<<3)))&0xFFF8;
+      can1FilterBank[0].CAN_FilterFIFOAssignment = CAN_Filter_FIFO0;
+      can1FilterBank[0].CAN_FilterMode           = CAN_FilterMode_IdMask;
+      can1FilterBank[0].CAN_FilterScale          = CAN_FilterScale_32bit;
+      can1FilterBank[0].CAN_FilterActivation     = ENABLE;
+      can1FilterBankNumber = 1;
+      
+      can_filter_update();
       
       CAN_ITConfig(CAN1, CAN_IT_TME | CAN_IT_FMP0 |CAN_IT_FF0 | CAN_IT_FOV0 | CAN_IT_FMP1 | CAN_IT_FF1 | CAN_IT_FOV1 |
                          CAN_IT_WKU | CAN_IT_SLK  |CAN_IT_EWG | CAN_IT_EPV  | CAN_IT_BOF  | CAN_IT_LEC | CAN_IT_ERR, DISABLE);
@@ -145,7 +406,7 @@ void CAN_Configure(CAN_TypeDef *CANx, CAN_WorkMode WorkMode, CAN_BaudRate BaudRa
       
       NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = CAN1_IRQ_PREEMPT_PRIORITY;
       NVIC_InitStructure.NVIC_IRQChannelSubPriority        = CAN1_IRQ_SUB_PRIORITY;
-      NVIC_InitStructure.NVIC_IRQChannelCmd                = ENABLE;
+      NVIC_InitStructure.NVIC_IRQChannelCmd                = (CAN_POLL_MODE) ? DISABLE : ENABLE;  /* CAN_Poll() calls the handlers. */
       NVIC_Init(&NVIC_InitStructure);
       
 #ifdef STM32F10X_CL
@@ -169,10 +430,49 @@ void CAN_Configure(CAN_TypeDef *CANx, CAN_WorkMode WorkMode, CAN_BaudRate BaudRa
       
       can2TransmitFinishCallback = 0;
       can2ReceiveFinishCallback  = 0;
+      can2ReceiveMessageCallback = 0;
+      
+      can2Producer = 0;
       
       can2TxBuffer = RingBuffer_Malloc(sizeof(CanTxMsg) * CAN2_TX_BUFFER_SIZE);
       can2RxBuffer = RingBuffer_Malloc(sizeof(CanRxMsg) * CAN2_RX_BUFFER_SIZE);
       
+      can2FrameMode     = false;
+      can2TxFrameBuffer = RingBuffer_Malloc(sizeof(uint8_t) * CAN2_TX_BUFFER_SIZE);
+      can2RxFrameBuffer = RingBuffer_Malloc(sizeof(uint8_t) * CAN2_RX_BUFFER_SIZE);
+      
+      can2TxState.Mailbox   = CAN_TxStatus_NoMailBox;
+      can2TxState.HandleIn  = 0;
+      can2TxState.HandleOut = 0;
+      can2TxState.Buffer    = RingBuffer_Malloc(sizeof(CAN_TxCompletion) * CAN2_TX_COMPLETE_SIZE);
+      can2TxState.Callback  = 0;
+      
+      can2TxState.Mode         = CAN_RetransmitNone;
+      can2TxState.RetryLimit   = 0;
+      can2TxState.Backoff      = 0;
+      can2TxState.RetryPending = false;
+      can2TxState.Timeout      = 0;
+      memset(&can2TxState.Statistics, 0, sizeof(can2TxState.Statistics));
+      
+      can2TxState.UrgentMailbox = CAN_TxStatus_NoMailBox;
+      memset(&can2TxState.UrgentStatistics, 0, sizeof(can2TxState.UrgentStatistics));
+      
+      can2TxState.Parked = 0;
+      memset(can2TxState.Rate, 0, sizeof(can2TxState.Rate));
+      
+      memset(&can2RxState, 0, sizeof(can2RxState));
+      
+#if CAN_POLL_MODE
+      memset(&can2Poll, 0, sizeof(can2Poll));
+#endif /* CAN_POLL_MODE */
+      
+      CAN_PROFILE_TX_CLEAR(CAN2, CAN_PROFILE_QUEUE_MESSAGE);
+      CAN_PROFILE_TX_CLEAR(CAN2, CAN_PROFILE_QUEUE_FRAME);
+      
+#ifdef RTE_CMSIS_RTOS2
+      can_rtos_create(&can2Rtos);
+#endif /* RTE_CMSIS_RTOS2 */
+      
       if(can1InitFlag == false)
       {
         RCC_APB1PeriphClockCmd(RCC_APB1Periph_CAN1, ENABLE);
@@ -207,16 +507,17 @@ void CAN_Configure(CAN_TypeDef *CANx, CAN_WorkMode WorkMode, CAN_BaudRate BaudRa
       CAN_DeInit(CAN2);
       CAN_Init(CAN2, &CAN_InitStructure);
       
-      CAN_FilterInitStructure.CAN_FilterIdHigh         = (uint16_t)((((StdId<<18)|ExtId)<<3)>>16);
-      CAN_FilterInitStructure.CAN_FilterIdLow          = (uint16_t)(((StdId<<18)|ExtId)<<3);
-      CAN_FilterInitStructure.CAN_FilterMaskIdHigh     = (~((uint16_t)((((StdId<<18)|ExtId)<<3)>>16)))&0xFFFF;
-      CAN_FilterInitStructure.CAN_FilterMaskIdLow      = (~((uint16_t)(((StdId<<18)|ExtId)<<3)))&0xFFF8;
-      CAN_FilterInitStructure.CAN_FilterFIFOAssignment = CAN_Filter_FIFO0;
-      CAN_FilterInitStructure.CAN_FilterNumber         = 14;
-      CAN_FilterInitStructure.CAN_FilterMode           = CAN_FilterMode_IdMask;
-      CAN_FilterInitStructure.CAN_FilterScale          = CAN_FilterScale_32bit;
-      CAN_FilterInitStructure.CAN_FilterActivation     = ENABLE;
-      CAN_FilterInit(&CAN_FilterInitStructure);
+      can2FilterBank[0].CAN_FilterIdHigh         = (uint16_t)((((StdId<<18)|ExtId)<<3)>>16);
+      can2FilterBank[0].CAN_FilterIdLow          = (uint16_t)(((StdId<<18)|ExtId)<<3);
+      can2FilterBank[0].CAN_FilterMaskIdHigh     = (~((uint16_t)((((StdId<<18)|ExtId)<<3)>>16)))&0xFFFF;
+      can2FilterBank[0].CAN_FilterMaskIdLow      = (~((uint16_t)(((StdId<<18)|ExtId)<<3)))&0xFFF8;
+      can2FilterBank[0].CAN_FilterFIFOAssignment = CAN_Filter_FIFO0;
+      can2FilterBank[0].CAN_FilterMode           = CAN_FilterMode_IdMask;
+      can2FilterBank[0].CAN_FilterScale          = CAN_FilterScale_32bit;
+      can2FilterBank[0].CAN_FilterActivation     = ENABLE;
+      can2FilterBankNumber = 1;
+      
+      can_filter_update();
       
       CAN_ITConfig(CAN2, CAN_IT_TME | CAN_IT_FMP0 |CAN_IT_FF0 | CAN_IT_FOV0 | CAN_IT_FMP1 | CAN_IT_FF1 | CAN_IT_FOV1 |
                          CAN_IT_WKU | CAN_IT_SLK  |CAN_IT_EWG | CAN_IT_EPV  | CAN_IT_BOF  | CAN_IT_LEC | CAN_IT_ERR, DISABLE);
@@ -225,7 +526,7 @@ void CAN_Configure(CAN_TypeDef *CANx, CAN_WorkMode WorkMode, CAN_BaudRate BaudRa
       NVIC_InitStructure.NVIC_IRQChannel                   = CAN2_TX_IRQn;
       NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = CAN2_IRQ_PREEMPT_PRIORITY;
       NVIC_InitStructure.NVIC_IRQChannelSubPriority        = CAN2_IRQ_SUB_PRIORITY;
-      NVIC_InitStructure.NVIC_IRQChannelCmd                = ENABLE;
+      NVIC_InitStructure.NVIC_IRQChannelCmd                = (CAN_POLL_MODE) ? DISABLE : ENABLE;  /* CAN_Poll() calls the handlers. */
       NVIC_Init(&NVIC_InitStructure);
       
       NVIC_InitStructure.NVIC_IRQChannel                   = CAN2_RX0_IRQn;
@@ -278,13 +579,53 @@ void CAN_Unconfigure(CAN_TypeDef *CANx)
         RCC_APB1PeriphClockCmd(RCC_APB1Periph_CAN1, DISABLE);
       }
       
+      can1FilterBankNumber = 0;
+      
+#ifdef STM32F10X_CL
+      if(can2InitFlag == true)
+#endif /* STM32F10X_CL */
+      {
+        can_filter_update();
+      }
+      
       can1TransmitFlag = false;
       
       can1TransmitFinishCallback = 0;
       can1ReceiveFinishCallback  = 0;
+      can1ReceiveMessageCallback = 0;
+      
+      can1Producer = 0;
+      
+#ifdef RTE_CMSIS_RTOS2
+      can_rtos_delete(&can1Rtos);
+#endif /* RTE_CMSIS_RTOS2 */
       
       RingBuffer_Free(can1TxBuffer);
       RingBuffer_Free(can1RxBuffer);
+      RingBuffer_Free(can1TxState.Buffer);
+      
+      can1TxState.Mailbox       = CAN_TxStatus_NoMailBox;
+      can1TxState.UrgentMailbox = CAN_TxStatus_NoMailBox;
+      can1TxState.Callback      = 0;
+      can1TxState.RetryPending  = false;
+      can1TxState.Parked        = 0;
+      
+      can1FrameMode = false;
+      
+      uint8_t index = 0;
+      
+      while(RingBuffer_Out(can1TxFrameBuffer, &index, sizeof(index)) > 0)
+      {
+        FramePool_Free(FramePool_GetFrame(index));
+      }
+      
+      while(RingBuffer_Out(can1RxFrameBuffer, &index, sizeof(index)) > 0)
+      {
+        FramePool_Free(FramePool_GetFrame(index));
+      }
+      
+      RingBuffer_Free(can1TxFrameBuffer);
+      RingBuffer_Free(can1RxFrameBuffer);
     }
   }
   
@@ -313,16 +654,156 @@ void CAN_Unconfigure(CAN_TypeDef *CANx)
       
       RCC_APB1PeriphClockCmd(RCC_APB1Periph_CAN2, DISABLE);
       
+      can2FilterBankNumber = 0;
+      
+      if(can1InitFlag == true)
+      {
+        can_filter_update();
+      }
+      
       can2TransmitFlag = false;
       
       can2TransmitFinishCallback = 0;
       can2ReceiveFinishCallback  = 0;
+      can2ReceiveMessageCallback = 0;
+      
+      can2Producer = 0;
+      
+#ifdef RTE_CMSIS_RTOS2
+      can_rtos_delete(&can2Rtos);
+#endif /* RTE_CMSIS_RTOS2 */
       
       RingBuffer_Free(can2TxBuffer);
       RingBuffer_Free(can2RxBuffer);
+      RingBuffer_Free(can2TxState.Buffer);
+      
+      can2TxState.Mailbox       = CAN_TxStatus_NoMailBox;
+      can2TxState.UrgentMailbox = CAN_TxStatus_NoMailBox;
+      can2TxState.Callback      = 0;
+      can2TxState.RetryPending  = false;
+      can2TxState.Parked        = 0;
+      
+      can2FrameMode = false;
+      
+      uint8_t index = 0;
+      
+      while(RingBuffer_Out(can2TxFrameBuffer, &index, sizeof(index)) > 0)
+      {
+        FramePool_Free(FramePool_GetFrame(index));
+      }
+      
+      while(RingBuffer_Out(can2RxFrameBuffer, &index, sizeof(index)) > 0)
+      {
+        FramePool_Free(FramePool_GetFrame(index));
+      }
+      
+      RingBuffer_Free(can2TxFrameBuffer);
+      RingBuffer_Free(can2RxFrameBuffer);
+    }
+  }
+#endif /* STM32F10X_CL */
+}
+
+/**
+  * @brief  CAN set receive filter.
+  * @param  [in] CANx:   Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Filter: The address of the identifier set to be received.
+  * @param  [in] Number: The number of the identifier set entries.
+  * @retval true:        The filter banks have been reallocated.
+  * @retval false:       Not enough filter banks, the filter is unchanged.
+  * @note   Replaces the filter given to CAN_Configure(). Entries are packed
+  *         as densely as possible: single standard IDs four per bank,
+  *         masked standard IDs and single extended IDs two per bank, masked
+  *         extended IDs one per bank. Single IDs match data frames only,
+  *         use a mask entry to receive remote frames as well.
+  *         On connectivity line devices the 28 banks are shared by CAN1 and
+  *         CAN2, and the split between them follows each channel's needs.
+  */
+bool CAN_SetReceiveFilter(CAN_TypeDef *CANx, const CAN_FilterId *Filter, uint32_t Number)
+{
+  CAN_FilterInitTypeDef bank[CAN_FILTER_BANK_NUMBER] = {0};
+  
+  if(CANx == CAN1)
+  {
+    if(can1InitFlag == true)
+    {
+#ifdef STM32F10X_CL
+      uint32_t size = CAN_FILTER_BANK_NUMBER - ((can2FilterBankNumber > 0) ? can2FilterBankNumber : 1);
+#else
+      uint32_t size = CAN_FILTER_BANK_NUMBER;
+#endif /* STM32F10X_CL */
+      uint32_t number = can_filter_compile(Filter, Number, bank, size);
+      
+      if(number <= size)
+      {
+        for(uint32_t i = 0; i < number; i++)
+        {
+          can1FilterBank[i] = bank[i];
+        }
+        
+        can1FilterBankNumber = number;
+        
+        can_filter_update();
+        
+        return true;
+      }
+    }
+  }
+  
+#ifdef STM32F10X_CL
+  if(CANx == CAN2)
+  {
+    if(can2InitFlag == true)
+    {
+      uint32_t size = CAN_FILTER_BANK_NUMBER - ((can1FilterBankNumber > 0) ? can1FilterBankNumber : 1);
+      uint32_t number = can_filter_compile(Filter, Number, bank, size);
+      
+      if(number <= size)
+      {
+        for(uint32_t i = 0; i < number; i++)
+        {
+          can2FilterBank[i] = bank[i];
+        }
+        
+        can2FilterBankNumber = number;
+        
+        can_filter_update();
+        
+        return true;
+      }
+    }
+  }
+#endif /* STM32F10X_CL */
+  
+  return false;
+}
+
+/**
+  * @brief  Get the number of filter banks used by the CAN.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return The number of filter banks.
+  */
+uint32_t CAN_GetFilterBankNumber(CAN_TypeDef *CANx)
+{
+  if(CANx == CAN1)
+  {
+    if(can1InitFlag == true)
+    {
+      return can1FilterBankNumber;
+    }
+  }
+  
+#ifdef STM32F10X_CL
+  if(CANx == CAN2)
+  {
+    if(can2InitFlag == true)
+    {
+      return can2FilterBankNumber;
     }
   }
 #endif /* STM32F10X_CL */
+  
+  return 0;
 }
 
 /**
@@ -379,12 +860,46 @@ void CAN_SetReceiveFinishCallback(CAN_TypeDef *CANx, void (*Callback)(void))
 #endif /* STM32F10X_CL */
 }
 
+/**
+  * @brief  CAN set receive message callback.
+  * @param  [in] CANx:     Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Callback: Callback, called in interrupt context for every
+  *                        received message before it is buffered.
+  * @return None.
+  * @note   When the callback returns true the message is consumed, it is not
+  *         put into the receive buffer and the receive finish callback is not
+  *         called.
+  */
+void CAN_SetReceiveMessageCallback(CAN_TypeDef *CANx, bool (*Callback)(CAN_TypeDef *CANx, const CanRxMsg *Message))
+{
+  if(CANx == CAN1)
+  {
+    if(can1InitFlag == true)
+    {
+      can1ReceiveMessageCallback = Callback;
+    }
+  }
+  
+#ifdef STM32F10X_CL
+  if(CANx == CAN2)
+  {
+    if(can2InitFlag == true)
+    {
+      can2ReceiveMessageCallback = Callback;
+    }
+  }
+#endif /* STM32F10X_CL */
+}
+
 /**
   * @brief  CAN set transmit message.
   * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
   * @param  [in] Message: The address of the message to be transmit.
   * @param  [in] Number:  The number of the message to be transmit.
   * @return The number of message transmit.
+  * @note   The buffer is written with interrupts masked, threads and interrupts
+  *         (the protocol stacks answer from the receive and transmit interrupts)
+  *         may send at the same time.
   */
 uint32_t CAN_SetTransmitMessage(CAN_TypeDef *CANx, const CanTxMsg *Message, uint32_t Number)
 {
@@ -392,6 +907,11 @@ uint32_t CAN_SetTransmitMessage(CAN_TypeDef *CANx, const CanTxMsg *Message, uint
   {
     if(can1InitFlag == true)
     {
+      uint32_t primask = __get_PRIMASK();
+      __disable_irq();
+      
+      CAN_PROFILE_START(enqueue);
+      
       uint32_t available = RingBuffer_Avail(can1TxBuffer) / sizeof(CanTxMsg);
       
       if(available > Number)
@@ -400,21 +920,26 @@ uint32_t CAN_SetTransmitMessage(CAN_TypeDef *CANx, const CanTxMsg *Message, uint
       }
       else
       {
+        if(available < Number)
+        {
+          CAN_TRACE(CAN1, CAN_TraceDrop, CAN_TRACE_DROP_TX_BUFFER);
+        }
+        
         Number = RingBuffer_In(can1TxBuffer, Message, sizeof(CanTxMsg) * available) / sizeof(CanTxMsg);
       }
       
+      CAN_PROFILE_TX_QUEUE(CAN1, CAN_PROFILE_QUEUE_MESSAGE, enqueue, Number);
+      CAN_TRACE(CAN1, CAN_TraceEnqueue, Number);
+      
+      can1TxState.HandleIn += Number;
+      
       if(Number > 0)
       {
-        if(can1TransmitFlag == false)
-        {
-          can1TransmitFlag = true;
-          
-          CanTxMsg canTxMsg = {0};
-          RingBuffer_Out(can1TxBuffer, &canTxMsg, sizeof(canTxMsg));
-          CAN_Transmit(CAN1, &canTxMsg);
-        }
+        can_transmit_start(CAN1, &can1TxState, can1TxBuffer, &can1TransmitFlag);
       }
       
+      __set_PRIMASK(primask);
+      
       return Number;
     }
   }
@@ -424,6 +949,11 @@ uint32_t CAN_SetTransmitMessage(CAN_TypeDef *CANx, const CanTxMsg *Message, uint
   {
     if(can2InitFlag == true)
     {
+      uint32_t primask = __get_PRIMASK();
+      __disable_irq();
+      
+      CAN_PROFILE_START(enqueue);
+      
       uint32_t available = RingBuffer_Avail(can2TxBuffer) / sizeof(CanTxMsg);
       
       if(available > Number)
@@ -432,21 +962,26 @@ uint32_t CAN_SetTransmitMessage(CAN_TypeDef *CANx, const CanTxMsg *Message, uint
       }
       else
       {
+        if(available < Number)
+        {
+          CAN_TRACE(CAN2, CAN_TraceDrop, CAN_TRACE_DROP_TX_BUFFER);
+        }
+        
         Number = RingBuffer_In(can2TxBuffer, Message, sizeof(CanTxMsg) * available) / sizeof(CanTxMsg);
       }
       
+      CAN_PROFILE_TX_QUEUE(CAN2, CAN_PROFILE_QUEUE_MESSAGE, enqueue, Number);
+      CAN_TRACE(CAN2, CAN_TraceEnqueue, Number);
+      
+      can2TxState.HandleIn += Number;
+      
       if(Number > 0)
       {
-        if(can2TransmitFlag == false)
-        {
-          can2TransmitFlag = true;
-          
-          CanTxMsg canTxMsg = {0};
-          RingBuffer_Out(can2TxBuffer, &canTxMsg, sizeof(canTxMsg));
-          CAN_Transmit(CAN2, &canTxMsg);
-        }
+        can_transmit_start(CAN2, &can2TxState, can2TxBuffer, &can2TransmitFlag);
       }
       
+      __set_PRIMASK(primask);
+      
       return Number;
     }
   }
@@ -468,7 +1003,10 @@ uint32_t CAN_GetReceiveMessage(CAN_TypeDef *CANx, CanRxMsg *Message, uint32_t Nu
   {
     if(can1InitFlag == true)
     {
-      return RingBuffer_Out(can1RxBuffer, Message, sizeof(CanRxMsg) * Number) / sizeof(CanRxMsg);
+      Number = RingBuffer_Out(can1RxBuffer, Message, sizeof(CanRxMsg) * Number) / sizeof(CanRxMsg);
+      CAN_TRACE(CAN1, CAN_TraceDequeue, Number);
+      
+      return Number;
     }
   }
   
@@ -477,7 +1015,10 @@ uint32_t CAN_GetReceiveMessage(CAN_TypeDef *CANx, CanRxMsg *Message, uint32_t Nu
   {
     if(can2InitFlag == true)
     {
-      return RingBuffer_Out(can2RxBuffer, Message, sizeof(CanRxMsg) * Number) / sizeof(CanRxMsg);
+      Number = RingBuffer_Out(can2RxBuffer, Message, sizeof(CanRxMsg) * Number) / sizeof(CanRxMsg);
+      CAN_TRACE(CAN2, CAN_TraceDequeue, Number);
+      
+      return Number;
     }
   }
 #endif /* STM32F10X_CL */
@@ -486,17 +1027,23 @@ uint32_t CAN_GetReceiveMessage(CAN_TypeDef *CANx, CanRxMsg *Message, uint32_t Nu
 }
 
 /**
-  * @brief  Get the size of the CAN transmit buffer used.
-  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
-  * @return Used the size of the transmit buffer.
+  * @brief  CAN set receive frame mode.
+  * @param  [in] CANx:   Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Enable: true to receive into frame pool frames, false to copy into the receive buffer.
+  * @return None.
+  * @note   In frame mode the interrupt receives straight into a frame allocated from the
+  *         frame pool, the receive message callback sees that frame, and frames it does
+  *         not consume are queued by index for CAN_GetReceiveFrame(). The payload is
+  *         never copied. A message is dropped when the pool is empty.
+  *         FramePool_Init() must have been called.
   */
-uint32_t CAN_GetUsedTransmitBufferSize(CAN_TypeDef *CANx)
+void CAN_SetReceiveFrameMode(CAN_TypeDef *CANx, bool Enable)
 {
   if(CANx == CAN1)
   {
     if(can1InitFlag == true)
     {
-      return RingBuffer_Len(can1TxBuffer) / sizeof(CanTxMsg);
+      can1FrameMode = Enable;
     }
   }
   
@@ -505,26 +1052,32 @@ uint32_t CAN_GetUsedTransmitBufferSize(CAN_TypeDef *CANx)
   {
     if(can2InitFlag == true)
     {
-      return RingBuffer_Len(can2TxBuffer) / sizeof(CanTxMsg);
+      can2FrameMode = Enable;
     }
   }
 #endif /* STM32F10X_CL */
-  
-  return 0;
 }
 
 /**
-  * @brief  Get the size of the CAN receive buffer used.
+  * @brief  CAN get receive frame.
   * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
-  * @return Used the size of the receive buffer.
+  * @return The oldest received frame, NULL if there is none.
+  * @note   The caller owns the frame, and must hand it to CAN_SetTransmitFrame() or
+  *         return it with FramePool_Free().
   */
-uint32_t CAN_GetUsedReceiveBufferSize(CAN_TypeDef *CANx)
+CanRxMsg *CAN_GetReceiveFrame(CAN_TypeDef *CANx)
 {
   if(CANx == CAN1)
   {
     if(can1InitFlag == true)
     {
-      return RingBuffer_Len(can1RxBuffer) / sizeof(CanRxMsg);
+      uint8_t index = 0;
+      
+      if(RingBuffer_Out(can1RxFrameBuffer, &index, sizeof(index)) > 0)
+      {
+        CAN_TRACE(CAN1, CAN_TraceDequeue, 1);
+        return FramePool_GetFrame(index);
+      }
     }
   }
   
@@ -533,7 +1086,13 @@ uint32_t CAN_GetUsedReceiveBufferSize(CAN_TypeDef *CANx)
   {
     if(can2InitFlag == true)
     {
-      return RingBuffer_Len(can2RxBuffer) / sizeof(CanRxMsg);
+      uint8_t index = 0;
+      
+      if(RingBuffer_Out(can2RxFrameBuffer, &index, sizeof(index)) > 0)
+      {
+        CAN_TRACE(CAN2, CAN_TraceDequeue, 1);
+        return FramePool_GetFrame(index);
+      }
     }
   }
 #endif /* STM32F10X_CL */
@@ -542,17 +1101,50 @@ uint32_t CAN_GetUsedReceiveBufferSize(CAN_TypeDef *CANx)
 }
 
 /**
-  * @brief  Get the size of the CAN transmit buffer unused.
-  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
-  * @return Unused the size of the transmit buffer.
+  * @brief  CAN set transmit frame.
+  * @param  [in] CANx:  Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Frame: A frame pool frame to be transmit.
+  * @retval true:       The driver owns the frame, and frees it once it is in a mailbox.
+  * @retval false:      The frame queue is full, the caller still owns the frame.
+  * @note   Queued frames are sent after the messages of CAN_SetTransmitMessage().
+  *         Forwarding a frame of CAN_GetReceiveFrame() to another channel needs no copy.
   */
-uint32_t CAN_GetUnusedTransmitBufferSize(CAN_TypeDef *CANx)
+bool CAN_SetTransmitFrame(CAN_TypeDef *CANx, CanRxMsg *Frame)
 {
   if(CANx == CAN1)
   {
     if(can1InitFlag == true)
     {
-      return RingBuffer_Avail(can1TxBuffer) / sizeof(CanTxMsg);
+      /* The transmit interrupt clears the flag, checking and setting it must not be split. */
+      uint32_t primask = __get_PRIMASK();
+      __disable_irq();
+      
+      uint8_t index  = FramePool_GetIndex(Frame);
+      bool    result = true;
+      
+      CAN_PROFILE_START(enqueue);
+      
+      if(can1TransmitFlag == false)
+      {
+        can1TransmitFlag = true;
+        
+        CAN_PROFILE_TX_QUEUE(CAN1, CAN_PROFILE_QUEUE_FRAME, enqueue, 1);
+        CAN_PROFILE_TX_START(CAN1, CAN_PROFILE_QUEUE_FRAME);
+        CAN_TRACE(CAN1, CAN_TraceEnqueue, 1);
+        CAN_TRACE(CAN1, CAN_TraceMailboxLoad, CAN_TRACE_ID(Frame));
+        can_transmit(CAN1, &can1TxState, (CanTxMsg *)Frame, CAN_TxSourceFrame, 0);
+        FramePool_Free(Frame);
+      }
+      else
+      {
+        result = (RingBuffer_In(can1TxFrameBuffer, &index, sizeof(index)) > 0);
+        CAN_PROFILE_TX_QUEUE(CAN1, CAN_PROFILE_QUEUE_FRAME, enqueue, (result == true) ? 1 : 0);
+        CAN_TRACE(CAN1, (result == true) ? CAN_TraceEnqueue : CAN_TraceDrop, (result == true) ? 1 : CAN_TRACE_DROP_TX_BUFFER);
+      }
+      
+      __set_PRIMASK(primask);
+      
+      return result;
     }
   }
   
@@ -561,26 +1153,139 @@ uint32_t CAN_GetUnusedTransmitBufferSize(CAN_TypeDef *CANx)
   {
     if(can2InitFlag == true)
     {
-      return RingBuffer_Avail(can2TxBuffer) / sizeof(CanTxMsg);
+      /* The transmit interrupt clears the flag, checking and setting it must not be split. */
+      uint32_t primask = __get_PRIMASK();
+      __disable_irq();
+      
+      uint8_t index  = FramePool_GetIndex(Frame);
+      bool    result = true;
+      
+      CAN_PROFILE_START(enqueue);
+      
+      if(can2TransmitFlag == false)
+      {
+        can2TransmitFlag = true;
+        
+        CAN_PROFILE_TX_QUEUE(CAN2, CAN_PROFILE_QUEUE_FRAME, enqueue, 1);
+        CAN_PROFILE_TX_START(CAN2, CAN_PROFILE_QUEUE_FRAME);
+        CAN_TRACE(CAN2, CAN_TraceEnqueue, 1);
+        CAN_TRACE(CAN2, CAN_TraceMailboxLoad, CAN_TRACE_ID(Frame));
+        can_transmit(CAN2, &can2TxState, (CanTxMsg *)Frame, CAN_TxSourceFrame, 0);
+        FramePool_Free(Frame);
+      }
+      else
+      {
+        result = (RingBuffer_In(can2TxFrameBuffer, &index, sizeof(index)) > 0);
+        CAN_PROFILE_TX_QUEUE(CAN2, CAN_PROFILE_QUEUE_FRAME, enqueue, (result == true) ? 1 : 0);
+        CAN_TRACE(CAN2, (result == true) ? CAN_TraceEnqueue : CAN_TraceDrop, (result == true) ? 1 : CAN_TRACE_DROP_TX_BUFFER);
+      }
+      
+      __set_PRIMASK(primask);
+      
+      return result;
     }
   }
 #endif /* STM32F10X_CL */
   
-  return 0;
+  return false;
 }
 
 /**
-  * @brief  Get the size of the CAN receive buffer unused.
+  * @brief  Get the size of the CAN transmit buffer used.
   * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
-  * @return Unused the size of the receive buffer.
+  * @return Used the size of the transmit buffer.
   */
-uint32_t CAN_GetUnusedReceiveBufferSize(CAN_TypeDef *CANx)
+uint32_t CAN_GetUsedTransmitBufferSize(CAN_TypeDef *CANx)
 {
   if(CANx == CAN1)
   {
     if(can1InitFlag == true)
     {
-      return RingBuffer_Avail(can1RxBuffer) / sizeof(CanRxMsg);
+      return RingBuffer_Len(can1TxBuffer) / sizeof(CanTxMsg);
+    }
+  }
+  
+#ifdef STM32F10X_CL
+  if(CANx == CAN2)
+  {
+    if(can2InitFlag == true)
+    {
+      return RingBuffer_Len(can2TxBuffer) / sizeof(CanTxMsg);
+    }
+  }
+#endif /* STM32F10X_CL */
+  
+  return 0;
+}
+
+/**
+  * @brief  Get the size of the CAN receive buffer used.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return Used the size of the receive buffer.
+  */
+uint32_t CAN_GetUsedReceiveBufferSize(CAN_TypeDef *CANx)
+{
+  if(CANx == CAN1)
+  {
+    if(can1InitFlag == true)
+    {
+      return RingBuffer_Len(can1RxBuffer) / sizeof(CanRxMsg);
+    }
+  }
+  
+#ifdef STM32F10X_CL
+  if(CANx == CAN2)
+  {
+    if(can2InitFlag == true)
+    {
+      return RingBuffer_Len(can2RxBuffer) / sizeof(CanRxMsg);
+    }
+  }
+#endif /* STM32F10X_CL */
+  
+  return 0;
+}
+
+/**
+  * @brief  Get the size of the CAN transmit buffer unused.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return Unused the size of the transmit buffer.
+  */
+uint32_t CAN_GetUnusedTransmitBufferSize(CAN_TypeDef *CANx)
+{
+  if(CANx == CAN1)
+  {
+    if(can1InitFlag == true)
+    {
+      return RingBuffer_Avail(can1TxBuffer) / sizeof(CanTxMsg);
+    }
+  }
+  
+#ifdef STM32F10X_CL
+  if(CANx == CAN2)
+  {
+    if(can2InitFlag == true)
+    {
+      return RingBuffer_Avail(can2TxBuffer) / sizeof(CanTxMsg);
+    }
+  }
+#endif /* STM32F10X_CL */
+  
+  return 0;
+}
+
+/**
+  * @brief  Get the size of the CAN receive buffer unused.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return Unused the size of the receive buffer.
+  */
+uint32_t CAN_GetUnusedReceiveBufferSize(CAN_TypeDef *CANx)
+{
+  if(CANx == CAN1)
+  {
+    if(can1InitFlag == true)
+    {
+      return RingBuffer_Avail(can1RxBuffer) / sizeof(CanRxMsg);
     }
   }
   
@@ -717,6 +1422,9 @@ bool CAN_IsReceiveBufferFull(CAN_TypeDef *CANx)
   * @brief  Clear the CAN transmit buffer.
   * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
   * @return None.
+  * @note   Messages deferred by their rate limit are dropped too, without a
+  *         completion. They hold no mailbox, the frame in flight completes
+  *         and the channel goes idle, or on with the other queues.
   */
 void CAN_ClearTransmitBuffer(CAN_TypeDef *CANx)
 {
@@ -724,7 +1432,17 @@ void CAN_ClearTransmitBuffer(CAN_TypeDef *CANx)
   {
     if(can1InitFlag == true)
     {
+      uint32_t primask = __get_PRIMASK();
+      __disable_irq();
+      
+      can1TxState.HandleOut += RingBuffer_Len(can1TxBuffer) / sizeof(CanTxMsg);
+      
+      can_rate_clear(&can1TxState);
+      
       RingBuffer_Reset(can1TxBuffer);
+      CAN_PROFILE_TX_CLEAR(CAN1, CAN_PROFILE_QUEUE_MESSAGE);
+      
+      __set_PRIMASK(primask);
     }
   }
   
@@ -733,7 +1451,17 @@ void CAN_ClearTransmitBuffer(CAN_TypeDef *CANx)
   {
     if(can2InitFlag == true)
     {
+      uint32_t primask = __get_PRIMASK();
+      __disable_irq();
+      
+      can2TxState.HandleOut += RingBuffer_Len(can2TxBuffer) / sizeof(CanTxMsg);
+      
+      can_rate_clear(&can2TxState);
+      
       RingBuffer_Reset(can2TxBuffer);
+      CAN_PROFILE_TX_CLEAR(CAN2, CAN_PROFILE_QUEUE_MESSAGE);
+      
+      __set_PRIMASK(primask);
     }
   }
 #endif /* STM32F10X_CL */
@@ -770,6 +1498,7 @@ void CAN_ClearReceiveBuffer(CAN_TypeDef *CANx)
   * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
   * @retval true:      Is transmit a message.
   * @retval false:     Not transmit a message.
+  * @note   Messages deferred by their rate limit count as transmitting.
   */
 bool CAN_IsTransmitMessage(CAN_TypeDef *CANx)
 {
@@ -777,7 +1506,7 @@ bool CAN_IsTransmitMessage(CAN_TypeDef *CANx)
   {
     if(can1InitFlag == true)
     {
-      return can1TransmitFlag;
+      return (can1TransmitFlag == true) || (can1TxState.Parked > 0);
     }
   }
   
@@ -786,7 +1515,7 @@ bool CAN_IsTransmitMessage(CAN_TypeDef *CANx)
   {
     if(can2InitFlag == true)
     {
-      return can2TransmitFlag;
+      return (can2TransmitFlag == true) || (can2TxState.Parked > 0);
     }
   }
 #endif /* STM32F10X_CL */
@@ -795,123 +1524,2214 @@ bool CAN_IsTransmitMessage(CAN_TypeDef *CANx)
 }
 
 /**
-  * @brief  This function handles CAN1 TX handler.
-  * @param  None.
+  * @brief  CAN send a message and get its handle.
+  * @param  [in]  CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in]  Message: The message.
+  * @param  [out] Handle:  The handle of the message, reported with its completion.
+  * @retval true:          The message is in the transmit buffer.
+  * @retval false:         The transmit buffer is full or the CAN is not configured.
+  * @note   Handles count the messages of the transmit buffer, those of
+  *         CAN_SetTransmitMessage() included, and wrap around at 2^32.
+  */
+bool CAN_SendMessage(CAN_TypeDef *CANx, const CanTxMsg *Message, uint32_t *Handle)
+{
+  CAN_TxState *state = can_transmit_get(CANx);
+  
+  if(state == 0)
+  {
+    return false;
+  }
+  
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  uint32_t handle = state->HandleIn;
+  bool     result = (CAN_SetTransmitMessage(CANx, Message, 1) == 1);
+  
+  __set_PRIMASK(primask);
+  
+  if((result == true) && (Handle != 0))
+  {
+    *Handle = handle;
+  }
+  
+  return result;
+}
+
+/**
+  * @brief  CAN set transmit complete callback.
+  * @param  [in] CANx:     Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Callback: Callback, called in interrupt context for every
+  *                        completed transmit request.
   * @return None.
+  * @note   When the callback returns true the completion is consumed, it is
+  *         not put into the completion buffer of CAN_GetTransmitCompletion().
   */
-#ifdef STM32F10X_CL
-void CAN1_TX_IRQHandler(void)
-#else
-void USB_HP_CAN1_TX_IRQHandler(void)
-#endif /* STM32F10X_CL */
+void CAN_SetTransmitCompleteCallback(CAN_TypeDef *CANx, bool (*Callback)(CAN_TypeDef *CANx, const CAN_TxCompletion *Completion))
 {
-  if(CAN_GetITStatus(CAN1, CAN_IT_TME) != RESET)
+  CAN_TxState *state = can_transmit_get(CANx);
+  
+  if(state != 0)
   {
-    CAN_ClearITPendingBit(CAN1, CAN_IT_TME);
-    
-    CanTxMsg canTxMsg = {0};
-    uint8_t  number   = RingBuffer_Out(can1TxBuffer, &canTxMsg, sizeof(canTxMsg)) / sizeof(canTxMsg);
-    
-    if(number > 0)
-    {
-      CAN_Transmit(CAN1, &canTxMsg);
-    }
-    else
-    {
-      can1TransmitFlag = false;
-      
-      if(can1TransmitFinishCallback != 0)
-      {
-        can1TransmitFinishCallback();
-      }
-    }
+    state->Callback = Callback;
   }
 }
 
 /**
-  * @brief  This function handles CAN1 RX0 handler.
+  * @brief  CAN get transmit completion.
+  * @param  [in]  CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [out] Completion: To store the completions.
+  * @param  [in]  Number:     To read the number of completions.
+  * @return The number of completions obtained.
+  * @note   The buffer keeps CANx_TX_COMPLETE_SIZE completions, later ones are
+  *         lost until it is read.
+  */
+uint32_t CAN_GetTransmitCompletion(CAN_TypeDef *CANx, CAN_TxCompletion *Completion, uint32_t Number)
+{
+  CAN_TxState *state = can_transmit_get(CANx);
+  
+  if(state == 0)
+  {
+    return 0;
+  }
+  
+  return RingBuffer_Out(state->Buffer, Completion, sizeof(CAN_TxCompletion) * Number) / sizeof(CAN_TxCompletion);
+}
+
+/**
+  * @brief  CAN set the retransmission of failed requests.
+  * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Mode:    Retransmit mode, CAN_RetransmitNone after CAN_Configure().
+  * @param  [in] Retry:   Software mode, retries of a frame before it is reported failed.
+  * @param  [in] Backoff: Software mode, frames of the other queues sent before the first
+  *                       retry, doubled for every further retry. 0 retries at once and
+  *                       keeps the order of the frames.
+  * @retval true:         The mode is set.
+  * @retval false:        The CAN is not configured.
+  * @note   In hardware mode the controller retransmits until the frame is sent,
+  *         a mailbox can stay busy indefinitely. In software mode one frame
+  *         waits for a retry at a time, another failing meanwhile is reported.
+  */
+bool CAN_SetRetransmit(CAN_TypeDef *CANx, CAN_Retransmit Mode, uint8_t Retry, uint8_t Backoff)
+{
+  CAN_TxState *state = can_transmit_get(CANx);
+  
+  if(state == 0)
+  {
+    return false;
+  }
+  
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  state->Mode       = Mode;
+  state->RetryLimit = Retry;
+  state->Backoff    = Backoff;
+  
+  /* NART is read at every transmission attempt, a pending request follows it. */
+  if(Mode == CAN_RetransmitHardware)
+  {
+    CANx->MCR &= ~CAN_MCR_NART;
+  }
+  else
+  {
+    CANx->MCR |= CAN_MCR_NART;
+  }
+  
+  __set_PRIMASK(primask);
+  
+  return true;
+}
+
+/**
+  * @brief  Get the retransmission statistics of the CAN.
+  * @param  [in]  CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [out] Statistics: The statistics.
+  * @return None.
+  * @note   In hardware mode failed attempts do not complete and are not counted.
+  */
+void CAN_GetRetransmitStatistics(CAN_TypeDef *CANx, CAN_RetransmitStatistics *Statistics)
+{
+  CAN_TxState *state = can_transmit_get(CANx);
+  
+  if(state != 0)
+  {
+    *Statistics = state->Statistics;
+  }
+}
+
+/**
+  * @brief  CAN set the transmit timeout.
+  * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Timeout: Ticks of CAN_Tick() a request may stay in its mailbox,
+  *                       0 for no limit, the default.
+  * @retval true:         The timeout is set.
+  * @retval false:        The CAN is not configured.
+  * @note   A request pending longer, in hardware retransmit mode on a bus
+  *         without acknowledgment for example, is cancelled between Timeout
+  *         and Timeout + 1 ticks after its load, reported with
+  *         CAN_TxStatusTimeout, and the transmit buffers go on. The same
+  *         applies to an urgent frame, CAN_SendUrgent() then accepts the next.
+  */
+bool CAN_SetTransmitTimeout(CAN_TypeDef *CANx, uint32_t Timeout)
+{
+  CAN_TxState *state = can_transmit_get(CANx);
+  
+  if(state == 0)
+  {
+    return false;
+  }
+  
+  state->Timeout = Timeout;
+  
+  return true;
+}
+
+/**
+  * @brief  Advance the tick of the transmit timeout.
   * @param  None.
   * @return None.
+  * @note   Called from the tick handler, or with RTX5 from a 1 ms timer, it
+  *         checks the queued and the urgent request in flight of every channel,
+  *         and loads a message that waits for a token.
   */
+void CAN_Tick(void)
+{
+  canTick++;
+  
+  can_transmit_watchdog(CAN1);
+  can_rate_resume(CAN1);
+  
 #ifdef STM32F10X_CL
-void CAN1_RX0_IRQHandler(void)
-#else
-void USB_LP_CAN1_RX0_IRQHandler(void)
+  can_transmit_watchdog(CAN2);
+  can_rate_resume(CAN2);
 #endif /* STM32F10X_CL */
+}
+
+/**
+  * @brief  CAN send an urgent message ahead of everything queued.
+  * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Message: The message.
+  * @retval true:         The message is in a mailbox.
+  * @retval false:        An urgent message is still pending, or the CAN is not configured.
+  * @note   The queued frame in flight is cancelled, unless it is already on
+  *         the bus, and sent again right after the urgent one with its handle.
+  *         The urgent frame then only waits for the frame on the bus and for
+  *         arbitration against higher priority identifiers of other nodes.
+  */
+bool CAN_SendUrgent(CAN_TypeDef *CANx, const CanTxMsg *Message)
 {
-  if(CAN_GetITStatus(CAN1, CAN_IT_FMP0) != RESET)
+  CAN_TxState *state = can_transmit_get(CANx);
+  
+  if(state == 0)
   {
-    CAN_ClearITPendingBit(CAN1, CAN_IT_FMP0);
+    return false;
+  }
+  
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  if(state->UrgentMailbox != CAN_TxStatus_NoMailBox)
+  {
+    state->UrgentStatistics.Busy++;
+    __set_PRIMASK(primask);
     
-    CanRxMsg canRxMsg = {0};
-    CAN_Receive(CAN1, CAN_FIFO0, &canRxMsg);
+    return false;
+  }
+  
+  state->UrgentStart  = CAN_TIME();
+  state->UrgentTick   = canTick;
+  state->UrgentCancel = false;
+  
+  /* Mailboxes go out in request order (TXFP), the queued frame must step back. */
+  bool preempt = (state->Mailbox != CAN_TxStatus_NoMailBox) && (state->Cancel != true) && (state->RetryPending != true);
+  
+  if(preempt == true)
+  {
+    CAN_TxCompletion completion = {0};
     
-    if(RingBuffer_Avail(can1RxBuffer) / sizeof(CanRxMsg) > 0)
-    {
-      RingBuffer_In(can1RxBuffer, &canRxMsg, sizeof(canRxMsg));
-    }
+    state->Preempt = true;
+    CAN_CancelTransmit(CANx, state->Mailbox);
     
-    if(can1ReceiveFinishCallback != 0)
+    /* An aborted mailbox is empty at once and taken by the urgent frame, its status is read first. */
+    if(can_transmit_status(CANx, state, &completion) == true)
     {
-      can1ReceiveFinishCallback();
+      can_transmit_complete(CANx, state, &completion);
     }
   }
+  
+  state->UrgentCompletion.Source = CAN_TxSourceUrgent;
+  state->UrgentCompletion.Handle = 0;
+  state->UrgentCompletion.IDE    = Message->IDE;
+  state->UrgentCompletion.Id     = (Message->IDE == CAN_Id_Standard) ? Message->StdId : Message->ExtId;
+  
+  CAN_TRACE(CANx, CAN_TraceMailboxLoad, CAN_TRACE_ID(Message));
+  state->UrgentMailbox = CAN_Transmit(CANx, (CanTxMsg *)Message);
+  
+  /* The preempted frame follows right behind. */
+  if((preempt == true) && (state->Mailbox == CAN_TxStatus_NoMailBox))
+  {
+    can_transmit_retry(CANx, state, false);
+  }
+  
+  bool result = (state->UrgentMailbox != CAN_TxStatus_NoMailBox);
+  
+  state->UrgentStatistics.Number += (result == true) ? 1 : 0;
+  
+  __set_PRIMASK(primask);
+  
+  return result;
 }
 
-#ifdef STM32F10X_CL
 /**
-  * @brief  This function handles CAN2 TX handler.
-  * @param  None.
+  * @brief  Get the urgent message statistics of the CAN.
+  * @param  [in]  CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [out] Statistics: The statistics.
   * @return None.
   */
-void CAN2_TX_IRQHandler(void)
+void CAN_GetUrgentStatistics(CAN_TypeDef *CANx, CAN_UrgentStatistics *Statistics)
 {
-  if(CAN_GetITStatus(CAN2, CAN_IT_TME) != RESET)
+  CAN_TxState *state = can_transmit_get(CANx);
+  
+  if(state != 0)
   {
-    CAN_ClearITPendingBit(CAN2, CAN_IT_TME);
-    
-    CanTxMsg canTxMsg = {0};
-    uint8_t  number   = RingBuffer_Out(can2TxBuffer, &canTxMsg, sizeof(canTxMsg)) / sizeof(canTxMsg);
-    
-    if(number > 0)
-    {
-      CAN_Transmit(CAN2, &canTxMsg);
-    }
-    else
-    {
-      can2TransmitFlag = false;
-      
-      if(can2TransmitFinishCallback != 0)
-      {
-        can2TransmitFinishCallback();
-      }
-    }
+    *Statistics = state->UrgentStatistics;
   }
 }
 
 /**
-  * @brief  This function handles CAN2 RX0 handler.
-  * @param  None.
+  * @brief  CAN set the rate limit of an identifier class.
+  * @param  [in] CANx:  Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Class: The class, 0 to CAN_RATE_CLASS_NUMBER - 1.
+  * @param  [in] Limit: Identifier range, rate, burst and action of the class.
+  * @retval true:       The class is set, with a full bucket and its statistics cleared.
+  * @retval false:      A parameter is out of range, or the CAN is not configured.
+  * @note   The limit is checked as a message is taken out of the transmit
+  *         buffer, CAN_SetTransmitMessage() is unchanged. The first class
+  *         matching the identifier applies, other messages are not limited.
+  *         Deferred messages wait with their class, the transmit buffer goes
+  *         on with the other classes, so their completions may come first.
+  */
+bool CAN_SetRateLimit(CAN_TypeDef *CANx, uint32_t Class, const CAN_RateLimit *Limit)
+{
+  CAN_TxState *state = can_transmit_get(CANx);
+  
+  if((state == 0) || (Class >= CAN_RATE_CLASS_NUMBER) || (Limit->Rate > 1000000) ||
+     ((Limit->Rate > 0) && ((Limit->Burst == 0) || (Limit->Burst > 0xFFFF))))
+  {
+    return false;
+  }
+  
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  state->Rate[Class].Limit = *Limit;
+  state->Rate[Class].Token = Limit->Burst * 1000;
+  state->Rate[Class].Tick  = canTick;
+  memset(&state->Rate[Class].Statistics, 0, sizeof(state->Rate[Class].Statistics));
+  
+  __set_PRIMASK(primask);
+  
+  return true;
+}
+
+/**
+  * @brief  Get the rate limit statistics of an identifier class.
+  * @param  [in]  CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in]  Class:      The class, 0 to CAN_RATE_CLASS_NUMBER - 1.
+  * @param  [out] Statistics: The statistics.
   * @return None.
   */
-void CAN2_RX0_IRQHandler(void)
+void CAN_GetRateStatistics(CAN_TypeDef *CANx, uint32_t Class, CAN_RateStatistics *Statistics)
 {
-  if(CAN_GetITStatus(CAN2, CAN_IT_FMP0) != RESET)
+  CAN_TxState *state = can_transmit_get(CANx);
+  
+  if((state != 0) && (Class < CAN_RATE_CLASS_NUMBER))
   {
-    CAN_ClearITPendingBit(CAN2, CAN_IT_FMP0);
-    
-    CanRxMsg canRxMsg = {0};
-    CAN_Receive(CAN2, CAN_FIFO0, &canRxMsg);
-    
-    if(RingBuffer_Avail(can2RxBuffer) / sizeof(CanRxMsg) > 0)
-    {
-      RingBuffer_In(can2RxBuffer, &canRxMsg, sizeof(canRxMsg));
-    }
-    
-    if(can2ReceiveFinishCallback != 0)
-    {
-      can2ReceiveFinishCallback();
-    }
+    *Statistics = state->Rate[Class].Statistics;
   }
 }
-#endif /* STM32F10X_CL */
+
+/**
+  * @brief  CAN set the hybrid interrupt and polling receive mode.
+  * @param  [in] CANx:  Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Burst: Messages received by interrupt between two calls of
+  *                     CAN_PollReceive() that switch to polling, 0 to stay
+  *                     with the interrupt, the default.
+  * @param  [in] Idle:  Calls of CAN_PollReceive() in a row finding FIFO 0
+  *                     empty that switch back to the interrupt, at least 1.
+  * @retval true:       The mode is set, in interrupt mode.
+  * @retval false:      Idle is 0, or the CAN is not configured.
+  * @note   While polling, the message callbacks run in CAN_PollReceive().
+  */
+bool CAN_SetReceivePolling(CAN_TypeDef *CANx, uint32_t Burst, uint32_t Idle)
+{
+  CAN_RxState *state = can_receive_get(CANx);
+  
+  if((state == 0) || (Idle == 0))
+  {
+    return false;
+  }
+  
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  state->Burst   = Burst;
+  state->Idle    = Idle;
+  state->Polling = false;
+  state->Count   = 0;
+  
+  CAN_ITConfig(CANx, CAN_IT_FF0, DISABLE);
+  CAN_ITConfig(CANx, CAN_IT_FMP0, ENABLE);
+  
+  __set_PRIMASK(primask);
+  
+  return true;
+}
+
+/**
+  * @brief  CAN poll FIFO 0 in the hybrid receive mode.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return The number of messages received.
+  * @note   Called periodically from a timer or the main loop, more often than
+  *         FIFO 0 fills up (3 frames, about 330 us at 1 Mbit/s) or the FIFO
+  *         full interrupt takes the messages. In interrupt mode it only opens
+  *         the window in which a burst is counted. It takes CAN_POLL_RECEIVE_BUDGET
+  *         messages at most, so callbacks slower than the bus cannot keep it from
+  *         returning, and stays in polling mode for the rest.
+  */
+uint32_t CAN_PollReceive(CAN_TypeDef *CANx)
+{
+  CAN_RxState *state  = can_receive_get(CANx);
+  uint32_t     number = 0;
+  
+  if(state == 0)
+  {
+    return 0;
+  }
+  
+  if(state->Polling != true)
+  {
+    state->Count = 0;
+    
+    return 0;
+  }
+  
+  bool pending = true;
+  
+  /* Masked one message at a time, the FIFO full interrupt may take the others. */
+  while((pending == true) && (number < CAN_POLL_RECEIVE_BUDGET))
+  {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    
+    pending = (CAN_MessagePending(CANx, CAN_FIFO0) > 0);
+    
+    if(pending == true)
+    {
+      can_receive(CANx);
+      number++;
+    }
+    
+    __set_PRIMASK(primask);
+  }
+  
+  if(number == CAN_POLL_RECEIVE_BUDGET)
+  {
+    state->Statistics.Budget++;
+  }
+  
+  state->Statistics.Polled += number;
+  state->Empty              = (number > 0) ? 0 : state->Empty + 1;
+  
+  if(state->Empty >= state->Idle)
+  {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    
+    state->Polling = false;
+    state->Count   = 0;
+    state->Statistics.Leave++;
+    
+    /* Message pending is a level, a message arrived since the last poll interrupts at once. */
+    CAN_ITConfig(CANx, CAN_IT_FF0, DISABLE);
+    CAN_ITConfig(CANx, CAN_IT_FMP0, ENABLE);
+    
+    __set_PRIMASK(primask);
+  }
+  
+  return number;
+}
+
+/**
+  * @brief  Get the hybrid receive statistics of the CAN.
+  * @param  [in]  CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [out] Statistics: The statistics.
+  * @return None.
+  */
+void CAN_GetReceivePollStatistics(CAN_TypeDef *CANx, CAN_RxPollStatistics *Statistics)
+{
+  CAN_RxState *state = can_receive_get(CANx);
+  
+  if(state != 0)
+  {
+    *Statistics = state->Statistics;
+  }
+}
+
+/**
+  * @brief  Add a transmit producer to the CAN.
+  * @param  [in] CANx:     Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Producer: The producer, Message and Fill set by the caller.
+  * @retval true:          The producer is added.
+  * @retval false:         The CAN is not configured or the producer is invalid.
+  * @note   Producers are served before the transmit buffers, in the order added,
+  *         each time a mailbox frees up. The payload is written by Fill() at that
+  *         moment, so nothing is queued and the data is never older than one frame.
+  */
+bool CAN_AddProducer(CAN_TypeDef *CANx, CAN_Producer *Producer)
+{
+  CAN_Producer **list = can_producer_get(CANx);
+  
+  if((list == 0) || (Producer == 0) || (Producer->Fill == 0))
+  {
+    return false;
+  }
+  
+  Producer->Pending = false;
+  
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  while(*list != 0)
+  {
+    list = &(*list)->Next;
+  }
+  
+  Producer->Next = 0;
+  *list          = Producer;
+  
+  __set_PRIMASK(primask);
+  
+  return true;
+}
+
+/**
+  * @brief  Remove a transmit producer from the CAN.
+  * @param  [in] CANx:     Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Producer: The producer.
+  * @return None.
+  * @note   A frame already in a mailbox is still sent.
+  */
+void CAN_RemoveProducer(CAN_TypeDef *CANx, CAN_Producer *Producer)
+{
+  CAN_Producer **list = can_producer_get(CANx);
+  
+  if(list == 0)
+  {
+    return;
+  }
+  
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  while((*list != 0) && (*list != Producer))
+  {
+    list = &(*list)->Next;
+  }
+  
+  if(*list != 0)
+  {
+    *list             = Producer->Next;
+    Producer->Next    = 0;
+    Producer->Pending = false;
+  }
+  
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Ask a transmit producer for a frame.
+  * @param  [in] CANx:     Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Producer: An added producer.
+  * @retval true:          The producer is pending or its frame is loaded.
+  * @retval false:         The CAN is not configured.
+  * @note   Triggering a pending producer sends one frame, not two. When the CAN
+  *         is idle Fill() is called here, otherwise by the transmit interrupt.
+  */
+bool CAN_TriggerProducer(CAN_TypeDef *CANx, CAN_Producer *Producer)
+{
+  if(CANx == CAN1)
+  {
+    if(can1InitFlag == true)
+    {
+      uint32_t primask = __get_PRIMASK();
+      __disable_irq();
+      
+      if(Producer->Pending == true)
+      {
+        Producer->Coalesced++;
+      }
+      
+      Producer->Pending = true;
+      
+      if(can1TransmitFlag == false)
+      {
+        can1TransmitFlag = can_producer_load(CAN1, &can1TxState, can1Producer);
+      }
+      
+      __set_PRIMASK(primask);
+      
+      return true;
+    }
+  }
+  
+#ifdef STM32F10X_CL
+  if(CANx == CAN2)
+  {
+    if(can2InitFlag == true)
+    {
+      uint32_t primask = __get_PRIMASK();
+      __disable_irq();
+      
+      if(Producer->Pending == true)
+      {
+        Producer->Coalesced++;
+      }
+      
+      Producer->Pending = true;
+      
+      if(can2TransmitFlag == false)
+      {
+        can2TransmitFlag = can_producer_load(CAN2, &can2TxState, can2Producer);
+      }
+      
+      __set_PRIMASK(primask);
+      
+      return true;
+    }
+  }
+#endif /* STM32F10X_CL */
+  
+  return false;
+}
+
+/**
+  * @brief  Get the CAN bit rate.
+  * @param  [in] BaudRate: Communication baud rate.
+  * @return The bit rate in bit/s.
+  * @note   CAN_Configure() uses 6 time quanta per bit: 1 sync, 3 BS1 and 2 BS2.
+  */
+uint32_t CAN_GetBitRate(CAN_BaudRate BaudRate)
+{
+  RCC_ClocksTypeDef RCC_Clocks = {0};
+  
+  RCC_GetClocksFreq(&RCC_Clocks);
+  
+  return RCC_Clocks.PCLK1_Frequency / ((uint32_t)BaudRate * 6);
+}
+
+#if CAN_POLL_MODE
+/**
+  * @brief  CAN do the work of the interrupts, in polled mode.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return None.
+  * @note   Called at a fixed rate from the superloop. One call loads the next
+  *         frame after a completed mailbox, reads up to CAN_POLL_RECEIVE_NUMBER
+  *         messages of FIFO 0 and checks overrun and bus-off, so its time is
+  *         bounded, the callbacks it calls aside. CAN_GetPollStatistics() gives
+  *         the longest call measured with the cycle counter.
+  */
+void CAN_Poll(CAN_TypeDef *CANx)
+{
+  uint32_t       start = CAN_TIME();
+  CAN_PollState *poll  = 0;
+  
+  if((CANx == CAN1) && (can1InitFlag == true))
+  {
+    poll = &can1Poll;
+    
+#ifdef STM32F10X_CL
+    CAN1_TX_IRQHandler();
+    
+    for(uint32_t i = 0; (i < CAN_POLL_RECEIVE_NUMBER) && (CAN_MessagePending(CAN1, CAN_FIFO0) > 0); i++)
+    {
+      CAN1_RX0_IRQHandler();
+    }
+#else
+    USB_HP_CAN1_TX_IRQHandler();
+    
+    for(uint32_t i = 0; (i < CAN_POLL_RECEIVE_NUMBER) && (CAN_MessagePending(CAN1, CAN_FIFO0) > 0); i++)
+    {
+      USB_LP_CAN1_RX0_IRQHandler();
+    }
+#endif /* STM32F10X_CL */
+  }
+  
+#ifdef STM32F10X_CL
+  if((CANx == CAN2) && (can2InitFlag == true))
+  {
+    poll = &can2Poll;
+    
+    CAN2_TX_IRQHandler();
+    
+    for(uint32_t i = 0; (i < CAN_POLL_RECEIVE_NUMBER) && (CAN_MessagePending(CAN2, CAN_FIFO0) > 0); i++)
+    {
+      CAN2_RX0_IRQHandler();
+    }
+  }
+#endif /* STM32F10X_CL */
+  
+  if(poll == 0)
+  {
+    return;
+  }
+  
+  can_poll_error(CANx, poll);
+  
+  poll->Statistics.Number++;
+  poll->Statistics.CyclesLast = CAN_TIME() - start;
+  
+  if(poll->Statistics.CyclesLast > poll->Statistics.CyclesMax)
+  {
+    poll->Statistics.CyclesMax = poll->Statistics.CyclesLast;
+  }
+}
+
+/**
+  * @brief  Get the polled mode statistics of the CAN.
+  * @param  [in]  CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [out] Statistics: The statistics.
+  * @return None.
+  */
+void CAN_GetPollStatistics(CAN_TypeDef *CANx, CAN_PollStatistics *Statistics)
+{
+  if((CANx == CAN1) && (can1InitFlag == true))
+  {
+    *Statistics = can1Poll.Statistics;
+  }
+  
+#ifdef STM32F10X_CL
+  if((CANx == CAN2) && (can2InitFlag == true))
+  {
+    *Statistics = can2Poll.Statistics;
+  }
+#endif /* STM32F10X_CL */
+}
+#endif /* CAN_POLL_MODE */
+
+#ifdef RTE_CMSIS_RTOS2
+/**
+  * @brief  CAN transmit messages, waiting for transmit buffer space.
+  * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Message: The address of the messages to be transmit.
+  * @param  [in] Number:  The number of the messages to be transmit.
+  * @param  [in] Timeout: Timeout of each wait, in kernel ticks, or osWaitForever.
+  * @return The number of messages transmit, less than @Number on timeout.
+  * @note   Thread context only. The messages of one call are queued in order
+  *         even when other threads transmit at the same time.
+  */
+uint32_t CAN_WaitTransmitMessage(CAN_TypeDef *CANx, const CanTxMsg *Message, uint32_t Number, uint32_t Timeout)
+{
+  CAN_Rtos *rtos  = can_rtos_get(CANx);
+  uint32_t  count = 0;
+  
+  if((rtos == 0) || (osMutexAcquire(rtos->TxMutex, Timeout) != osOK))
+  {
+    return 0;
+  }
+  
+  rtos->TxWaiting = true;
+  
+  while(count < Number)
+  {
+    osEventFlagsClear(rtos->EventFlags, CAN_EVENT_TRANSMIT);
+    
+    count += CAN_SetTransmitMessage(CANx, &Message[count], Number - count);
+    
+    if((count >= Number) || ((osEventFlagsWait(rtos->EventFlags, CAN_EVENT_TRANSMIT, osFlagsWaitAny, Timeout) & osFlagsError) != 0))
+    {
+      break;
+    }
+  }
+  
+  rtos->TxWaiting = false;
+  
+  osMutexRelease(rtos->TxMutex);
+  
+  return count;
+}
+
+/**
+  * @brief  CAN get received messages, waiting for them if the receive buffer
+  *         is empty.
+  * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Message: To store the address of the receive messages.
+  * @param  [in] Number:  To read the number of the received messages.
+  * @param  [in] Timeout: Timeout, in kernel ticks, or osWaitForever.
+  * @return The number of messages obtained, 0 on timeout.
+  * @note   Thread context only. The thread sleeps on an event flag set by the
+  *         receive interrupt, every wakeup is counted in the statistics.
+  */
+uint32_t CAN_WaitReceiveMessage(CAN_TypeDef *CANx, CanRxMsg *Message, uint32_t Number, uint32_t Timeout)
+{
+  CAN_Rtos *rtos   = can_rtos_get(CANx);
+  uint32_t  number = 0;
+  
+  if((rtos == 0) || (osMutexAcquire(rtos->RxMutex, Timeout) != osOK))
+  {
+    return 0;
+  }
+  
+  while(1)
+  {
+    number = CAN_GetReceiveMessage(CANx, Message, Number);
+    
+    if(number > 0)
+    {
+      break;
+    }
+    
+    /* Clear a stale event, then check again so no message is missed. */
+    osEventFlagsClear(rtos->EventFlags, CAN_EVENT_RECEIVE);
+    
+    number = CAN_GetReceiveMessage(CANx, Message, Number);
+    
+    if(number > 0)
+    {
+      break;
+    }
+    
+    if((osEventFlagsWait(rtos->EventFlags, CAN_EVENT_RECEIVE, osFlagsWaitAny, Timeout) & osFlagsError) != 0)
+    {
+      break;
+    }
+    
+    uint32_t latency = DWT->CYCCNT - rtos->RxStamp;
+    
+    rtos->Statistics.Wakeups++;
+    rtos->Statistics.LatencyLast   = latency;
+    rtos->Statistics.LatencyTotal += latency;
+    
+    if(latency > rtos->Statistics.LatencyMax)
+    {
+      rtos->Statistics.LatencyMax = latency;
+    }
+  }
+  
+  rtos->Statistics.Frames += number;
+  
+  osMutexRelease(rtos->RxMutex);
+  
+  return number;
+}
+
+/**
+  * @brief  Start a thread dispatching the received messages.
+  * @param  [in] CANx:     Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Callback: Called in the thread for every received message.
+  * @retval true:          The thread is started.
+  * @retval false:         The thread is already running or could not be created.
+  * @note   The thread runs at CAN_RX_THREAD_PRIORITY and is terminated by
+  *         CAN_Unconfigure(). Messages consumed by the receive message
+  *         callback do not reach it.
+  */
+bool CAN_StartReceiveThread(CAN_TypeDef *CANx, void (*Callback)(CAN_TypeDef *CANx, const CanRxMsg *Message))
+{
+  CAN_Rtos       *rtos = can_rtos_get(CANx);
+  osThreadAttr_t  attr = {0};
+  
+  if((rtos == 0) || (rtos->RxThread != 0) || (Callback == 0))
+  {
+    return false;
+  }
+  
+  attr.name       = "CAN RX";
+  attr.stack_size = CAN_RX_THREAD_STACK_SIZE;
+  attr.priority   = CAN_RX_THREAD_PRIORITY;
+  
+  rtos->RxCallback = Callback;
+  rtos->RxThread   = osThreadNew(can_rtos_thread, CANx, &attr);
+  
+  return rtos->RxThread != 0;
+}
+
+/**
+  * @brief  Get the CMSIS-RTOS2 statistics of the CAN.
+  * @param  [in]  CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [out] Statistics: The statistics.
+  * @return None.
+  * @note   Frames divided by Wakeups gives the messages handled per context
+  *         switch, the latency is measured with the DWT cycle counter.
+  */
+void CAN_GetRtosStatistics(CAN_TypeDef *CANx, CAN_RtosStatistics *Statistics)
+{
+  CAN_Rtos *rtos = can_rtos_get(CANx);
+  
+  if(rtos != 0)
+  {
+    *Statistics = rtos->Statistics;
+  }
+}
+#endif /* RTE_CMSIS_RTOS2 */
+
+/**
+  * @brief  This function handles CAN1 TX handler.
+  * @param  None.
+  * @return None.
+  */
+#ifdef STM32F10X_CL
+CAN_RAMFUNC void CAN1_TX_IRQHandler(void)
+#else
+CAN_RAMFUNC void USB_HP_CAN1_TX_IRQHandler(void)
+#endif /* STM32F10X_CL */
+{
+  CAN_PROFILE_START(start);
+  CAN_TRACE(CAN1, CAN_TraceTxIsrEnter, CAN_TRACE_TSR(CAN1->TSR));
+  CAN_TRACE_ERROR(CAN1);
+  
+  if(CAN_GetITStatus(CAN1, CAN_IT_TME) != RESET)
+  {
+    CAN_TxCompletion completion = {0};
+    CAN_TxCompletion urgent     = {0};
+    bool             complete   = can_transmit_status(CAN1, &can1TxState, &completion);
+    bool             preempt    = can_transmit_urgent(CAN1, &can1TxState, &urgent);
+    
+    CAN_PROFILE_TX_DONE(CAN1);
+    
+    uint8_t index = 0;
+    
+    if(can1TransmitFlag != true)
+    {
+      /* Only an urgent frame was in flight, the idle start loads the transmit buffers. */
+    }
+    else if(can1TxState.Mailbox != CAN_TxStatus_NoMailBox)
+    {
+      /* The urgent frame completed, the queued one is still pending. */
+    }
+    else if((can_transmit_retry(CAN1, &can1TxState, false) == true) || (can_producer_load(CAN1, &can1TxState, can1Producer) == true))
+    {
+      /* A retry, or a producer filled in place, the transmit buffers wait for the next mailbox. */
+    }
+    else if(can_transmit_queue(CAN1, &can1TxState, can1TxBuffer, &completion, &complete) == true)
+    {
+#ifdef RTE_CMSIS_RTOS2
+      can_rtos_transmit(&can1Rtos);
+#endif /* RTE_CMSIS_RTOS2 */
+    }
+    else if(RingBuffer_Out(can1TxFrameBuffer, &index, sizeof(index)) > 0)
+    {
+      CanRxMsg *frame = FramePool_GetFrame(index);
+      
+      CAN_PROFILE_TX_START(CAN1, CAN_PROFILE_QUEUE_FRAME);
+      CAN_TRACE(CAN1, CAN_TraceMailboxLoad, CAN_TRACE_ID(frame));
+      can_transmit(CAN1, &can1TxState, (CanTxMsg *)frame, CAN_TxSourceFrame, 0);
+      FramePool_Free(frame);
+    }
+    else if(can_transmit_retry(CAN1, &can1TxState, true) != true)
+    {
+      can1TransmitFlag = false;
+    }
+    
+    /* Reported once the next frame is in the mailbox, the bus does not wait for the callback. */
+    if(preempt == true)
+    {
+      can_transmit_complete(CAN1, &can1TxState, &urgent);
+    }
+    
+    if(complete == true)
+    {
+      can_transmit_complete(CAN1, &can1TxState, &completion);
+    }
+    
+    if((can1TransmitFlag == false) && (can1TransmitFinishCallback != 0))
+    {
+      can1TransmitFinishCallback();
+    }
+  }
+  
+  CAN_TRACE(CAN1, CAN_TraceTxIsrExit, 0);
+  CAN_PROFILE_STOP(CAN1, CAN_ProfileTxIsr, start);
+}
+
+/**
+  * @brief  This function handles CAN1 RX0 handler.
+  * @param  None.
+  * @return None.
+  */
+#ifdef STM32F10X_CL
+CAN_RAMFUNC void CAN1_RX0_IRQHandler(void)
+#else
+CAN_RAMFUNC void USB_LP_CAN1_RX0_IRQHandler(void)
+#endif /* STM32F10X_CL */
+{
+  CAN_PROFILE_START(start);
+  CAN_TRACE(CAN1, CAN_TraceRxIsrEnter, CAN1->RF0R & CAN_RF0R_FMP0);
+  CAN_TRACE_ERROR(CAN1);
+  
+  if(CAN_GetITStatus(CAN1, CAN_IT_FMP0) != RESET)
+  {
+    CAN_ClearITPendingBit(CAN1, CAN_IT_FMP0);
+    can_receive(CAN1);
+    can_receive_burst(CAN1, &can1RxState);
+  }
+  else if(CAN_GetITStatus(CAN1, CAN_IT_FF0) != RESET)
+  {
+    /* The polls fell behind, the full FIFO is emptied here. */
+    while(CAN_MessagePending(CAN1, CAN_FIFO0) > 0)
+    {
+      can_receive(CAN1);
+    }
+    
+    CAN_ClearITPendingBit(CAN1, CAN_IT_FF0);
+    can1RxState.Statistics.Full++;
+  }
+  
+  CAN_TRACE(CAN1, CAN_TraceRxIsrExit, 0);
+  CAN_PROFILE_STOP(CAN1, CAN_ProfileRxIsr, start);
+}
+
+#ifdef STM32F10X_CL
+/**
+  * @brief  This function handles CAN2 TX handler.
+  * @param  None.
+  * @return None.
+  */
+CAN_RAMFUNC void CAN2_TX_IRQHandler(void)
+{
+  CAN_PROFILE_START(start);
+  CAN_TRACE(CAN2, CAN_TraceTxIsrEnter, CAN_TRACE_TSR(CAN2->TSR));
+  CAN_TRACE_ERROR(CAN2);
+  
+  if(CAN_GetITStatus(CAN2, CAN_IT_TME) != RESET)
+  {
+    CAN_TxCompletion completion = {0};
+    CAN_TxCompletion urgent     = {0};
+    bool             complete   = can_transmit_status(CAN2, &can2TxState, &completion);
+    bool             preempt    = can_transmit_urgent(CAN2, &can2TxState, &urgent);
+    
+    CAN_PROFILE_TX_DONE(CAN2);
+    
+    uint8_t index = 0;
+    
+    if(can2TransmitFlag != true)
+    {
+      /* Only an urgent frame was in flight, the idle start loads the transmit buffers. */
+    }
+    else if(can2TxState.Mailbox != CAN_TxStatus_NoMailBox)
+    {
+      /* The urgent frame completed, the queued one is still pending. */
+    }
+    else if((can_transmit_retry(CAN2, &can2TxState, false) == true) || (can_producer_load(CAN2, &can2TxState, can2Producer) == true))
+    {
+      /* A retry, or a producer filled in place, the transmit buffers wait for the next mailbox. */
+    }
+    else if(can_transmit_queue(CAN2, &can2TxState, can2TxBuffer, &completion, &complete) == true)
+    {
+#ifdef RTE_CMSIS_RTOS2
+      can_rtos_transmit(&can2Rtos);
+#endif /* RTE_CMSIS_RTOS2 */
+    }
+    else if(RingBuffer_Out(can2TxFrameBuffer, &index, sizeof(index)) > 0)
+    {
+      CanRxMsg *frame = FramePool_GetFrame(index);
+      
+      CAN_PROFILE_TX_START(CAN2, CAN_PROFILE_QUEUE_FRAME);
+      CAN_TRACE(CAN2, CAN_TraceMailboxLoad, CAN_TRACE_ID(frame));
+      can_transmit(CAN2, &can2TxState, (CanTxMsg *)frame, CAN_TxSourceFrame, 0);
+      FramePool_Free(frame);
+    }
+    else if(can_transmit_retry(CAN2, &can2TxState, true) != true)
+    {
+      can2TransmitFlag = false;
+    }
+    
+    /* Reported once the next frame is in the mailbox, the bus does not wait for the callback. */
+    if(preempt == true)
+    {
+      can_transmit_complete(CAN2, &can2TxState, &urgent);
+    }
+    
+    if(complete == true)
+    {
+      can_transmit_complete(CAN2, &can2TxState, &completion);
+    }
+    
+    if((can2TransmitFlag == false) && (can2TransmitFinishCallback != 0))
+    {
+      can2TransmitFinishCallback();
+    }
+  }
+  
+  CAN_TRACE(CAN2, CAN_TraceTxIsrExit, 0);
+  CAN_PROFILE_STOP(CAN2, CAN_ProfileTxIsr, start);
+}
+
+/**
+  * @brief  This function handles CAN2 RX0 handler.
+  * @param  None.
+  * @return None.
+  */
+CAN_RAMFUNC void CAN2_RX0_IRQHandler(void)
+{
+  CAN_PROFILE_START(start);
+  CAN_TRACE(CAN2, CAN_TraceRxIsrEnter, CAN2->RF0R & CAN_RF0R_FMP0);
+  CAN_TRACE_ERROR(CAN2);
+  
+  if(CAN_GetITStatus(CAN2, CAN_IT_FMP0) != RESET)
+  {
+    CAN_ClearITPendingBit(CAN2, CAN_IT_FMP0);
+    can_receive(CAN2);
+    can_receive_burst(CAN2, &can2RxState);
+  }
+  else if(CAN_GetITStatus(CAN2, CAN_IT_FF0) != RESET)
+  {
+    /* The polls fell behind, the full FIFO is emptied here. */
+    while(CAN_MessagePending(CAN2, CAN_FIFO0) > 0)
+    {
+      can_receive(CAN2);
+    }
+    
+    CAN_ClearITPendingBit(CAN2, CAN_IT_FF0);
+    can2RxState.Statistics.Full++;
+  }
+  
+  CAN_TRACE(CAN2, CAN_TraceRxIsrExit, 0);
+  CAN_PROFILE_STOP(CAN2, CAN_ProfileRxIsr, start);
+}
+#endif /* STM32F10X_CL */
+
+/**
+  * @brief  Compile an identifier set into filter banks.
+  * @param  [in] Filter: The identifier set.
+  * @param  [in] Number: The number of the identifier set entries.
+  * @param  [in] Bank:   To store the filter banks.
+  * @param  [in] Size:   The number of banks available.
+  * @return The number of banks required, nothing is stored if it exceeds @Size.
+  */
+static uint32_t can_filter_compile(const CAN_FilterId *Filter, uint32_t Number, CAN_FilterInitTypeDef *Bank, uint32_t Size)
+{
+  /* Entry classes: single standard, masked standard, single extended, masked extended. */
+  static const uint8_t slotNumber[4] = {4, 2, 2, 1};
+  static const uint8_t mode[4]       = {CAN_FilterMode_IdList, CAN_FilterMode_IdMask, CAN_FilterMode_IdList, CAN_FilterMode_IdMask};
+  static const uint8_t scale[4]      = {CAN_FilterScale_16bit, CAN_FilterScale_16bit, CAN_FilterScale_32bit, CAN_FilterScale_32bit};
+  
+  uint32_t count[4] = {0};
+  uint32_t number   = 0;
+  
+  for(uint32_t i = 0; i < Number; i++)
+  {
+    if(Filter[i].IDE == CAN_Id_Standard)
+    {
+      count[((Filter[i].Mask & 0x7FF) == 0x7FF) ? 0 : 1]++;
+    }
+    else
+    {
+      count[((Filter[i].Mask & 0x1FFFFFFF) == 0x1FFFFFFF) ? 2 : 3]++;
+    }
+  }
+  
+  for(uint32_t k = 0; k < 4; k++)
+  {
+    number += (count[k] + slotNumber[k] - 1) / slotNumber[k];
+  }
+  
+  if(number > Size)
+  {
+    return number;
+  }
+  
+  uint32_t bank = 0;
+  
+  for(uint32_t k = 0; k < 4; k++)
+  {
+    uint32_t slot  = 0;
+    uint32_t fr[2] = {0};
+    
+    for(uint32_t i = 0; i < Number; i++)
+    {
+      uint32_t id   = 0;
+      uint32_t mask = 0;
+      uint32_t type = 0;
+      
+      if(Filter[i].IDE == CAN_Id_Standard)
+      {
+        type = ((Filter[i].Mask & 0x7FF) == 0x7FF) ? 0 : 1;
+        id   = (Filter[i].Id & 0x7FF) << 5;
+        mask = ((Filter[i].Mask & 0x7FF) << 5) | 0x08;  /* IDE must match. */
+      }
+      else
+      {
+        type = ((Filter[i].Mask & 0x1FFFFFFF) == 0x1FFFFFFF) ? 2 : 3;
+        id   = ((Filter[i].Id & 0x1FFFFFFF) << 3) | CAN_Id_Extended;
+        mask = ((Filter[i].Mask & 0x1FFFFFFF) << 3) | CAN_Id_Extended;
+      }
+      
+      if(type != k)
+      {
+        continue;
+      }
+      
+      /* The first entry of a bank also fills the unused slots, so a partly used bank matches nothing else. */
+      switch(k)
+      {
+        case 0:
+          if(slot == 0)
+          {
+            fr[0] = fr[1] = (id << 16) | id;
+          }
+          else
+          {
+            fr[slot / 2] = (slot % 2) ? ((fr[slot / 2] & 0x0000FFFF) | (id << 16)) : ((fr[slot / 2] & 0xFFFF0000) | id);
+          }
+          break;
+        case 1:
+          if(slot == 0)
+          {
+            fr[0] = fr[1] = (mask << 16) | id;
+          }
+          else
+          {
+            fr[1] = (mask << 16) | id;
+          }
+          break;
+        case 2:
+          if(slot == 0)
+          {
+            fr[0] = fr[1] = id;
+          }
+          else
+          {
+            fr[1] = id;
+          }
+          break;
+        default:
+          fr[0] = id;
+          fr[1] = mask;
+          break;
+      }
+      
+      count[k]--;
+      
+      if((++slot == slotNumber[k]) || (count[k] == 0))
+      {
+        if(scale[k] == CAN_FilterScale_16bit)
+        {
+          Bank[bank].CAN_FilterIdLow      = (uint16_t)fr[0];
+          Bank[bank].CAN_FilterMaskIdLow  = (uint16_t)(fr[0] >> 16);
+          Bank[bank].CAN_FilterIdHigh     = (uint16_t)fr[1];
+          Bank[bank].CAN_FilterMaskIdHigh = (uint16_t)(fr[1] >> 16);
+        }
+        else
+        {
+          Bank[bank].CAN_FilterIdHigh     = (uint16_t)(fr[0] >> 16);
+          Bank[bank].CAN_FilterIdLow      = (uint16_t)fr[0];
+          Bank[bank].CAN_FilterMaskIdHigh = (uint16_t)(fr[1] >> 16);
+          Bank[bank].CAN_FilterMaskIdLow  = (uint16_t)fr[1];
+        }
+        
+        Bank[bank].CAN_FilterFIFOAssignment = CAN_Filter_FIFO0;
+        Bank[bank].CAN_FilterMode           = mode[k];
+        Bank[bank].CAN_FilterScale          = scale[k];
+        Bank[bank].CAN_FilterActivation     = ENABLE;
+        bank++;
+        slot = 0;
+      }
+    }
+  }
+  
+  return number;
+}
+
+/**
+  * @brief  Write the filter banks of all channels to the hardware.
+  * @param  None.
+  * @return None.
+  * @note   CAN1 takes the banks from 0 upwards and CAN2 the banks that follow,
+  *         the CAN2 start bank is moved to the split point.
+  */
+static void can_filter_update(void)
+{
+  CAN_FilterInitTypeDef unused = {0};
+  
+#ifdef STM32F10X_CL
+  /* CAN2 start bank can only be set from 1 to 27. */
+  uint32_t start = (can1FilterBankNumber > 0) ? can1FilterBankNumber : 1;
+  
+  CAN_SlaveStartBank(start);
+#endif /* STM32F10X_CL */
+  
+  for(uint32_t i = 0; i < CAN_FILTER_BANK_NUMBER; i++)
+  {
+    CAN_FilterInitTypeDef *bank = &unused;
+    
+    if(i < can1FilterBankNumber)
+    {
+      bank = &can1FilterBank[i];
+    }
+#ifdef STM32F10X_CL
+    else if((i >= start) && (i - start < can2FilterBankNumber))
+    {
+      bank = &can2FilterBank[i - start];
+    }
+#endif /* STM32F10X_CL */
+    
+    bank->CAN_FilterNumber = i;
+    CAN_FilterInit(bank);
+  }
+}
+
+/**
+  * @brief  Get the producer list of a configured channel.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return The list head, 0 if the channel is not configured.
+  */
+static CAN_Producer **can_producer_get(CAN_TypeDef *CANx)
+{
+  if((CANx == CAN1) && (can1InitFlag == true))
+  {
+    return &can1Producer;
+  }
+  
+#ifdef STM32F10X_CL
+  if((CANx == CAN2) && (can2InitFlag == true))
+  {
+    return &can2Producer;
+  }
+#endif /* STM32F10X_CL */
+  
+  return 0;
+}
+
+/**
+  * @brief  Fill a free mailbox from the first pending producer.
+  * @param  [in] CANx:     Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] State:    The transmit state of the channel.
+  * @param  [in] Producer: The producer list.
+  * @retval true:          A frame is loaded.
+  * @retval false:         No producer had a frame.
+  * @note   Called with the transmit interrupt masked or from it.
+  */
+CAN_RAMFUNC static bool can_producer_load(CAN_TypeDef *CANx, CAN_TxState *State, CAN_Producer *Producer)
+{
+  for(; Producer != 0; Producer = Producer->Next)
+  {
+    if(Producer->Pending == true)
+    {
+      CanTxMsg canTxMsg = Producer->Message;
+      
+      Producer->Pending = false;
+      
+      if(Producer->Fill(CANx, &canTxMsg) == true)
+      {
+        CAN_TRACE(CANx, CAN_TraceMailboxLoad, CAN_TRACE_ID(&canTxMsg));
+        can_transmit(CANx, State, &canTxMsg, CAN_TxSourceProducer, 0);
+        Producer->Loaded++;
+        
+        return true;
+      }
+      
+      Producer->Skipped++;
+    }
+  }
+  
+  return false;
+}
+
+/**
+  * @brief  Put a message into a mailbox and note what is in flight.
+  * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] State:   The transmit state of the channel.
+  * @param  [in] Message: The message.
+  * @param  [in] Source:  Where the message comes from.
+  * @param  [in] Handle:  Of a message of the transmit buffer, 0 for other sources.
+  * @return None.
+  */
+CAN_RAMFUNC static void can_transmit(CAN_TypeDef *CANx, CAN_TxState *State, const CanTxMsg *Message, CAN_TxSource Source, uint32_t Handle)
+{
+  State->InFlight.Source = Source;
+  State->InFlight.Handle = Handle;
+  State->InFlight.IDE    = Message->IDE;
+  State->InFlight.Id     = (Message->IDE == CAN_Id_Standard) ? Message->StdId : Message->ExtId;
+  State->Attempt         = 0;
+  State->LoadTick        = canTick;
+  State->Cancel          = false;
+  State->Preempt         = false;
+  State->Message         = *Message;
+  
+  if((State->RetryPending == true) && (State->RetryWait > 0))
+  {
+    State->RetryWait--;
+  }
+  
+  State->Mailbox = CAN_Transmit(CANx, (CanTxMsg *)Message);
+}
+
+/**
+  * @brief  Read the completion of the frame in flight, and clear its RQCP.
+  * @param  [in]  CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in]  State:      The transmit state of the channel.
+  * @param  [out] Completion: The completion.
+  * @retval true:             A frame completed.
+  * @retval false:            No frame completed, or it waits for a retry.
+  * @note   In software retransmit mode a frame that failed goes to the retry
+  *         slot, one frame at a time, until its retries are used up. A frame
+  *         cancelled for an urgent one goes there too, sent next.
+  *         Only the RQCP of this mailbox is cleared, the urgent mailbox may
+  *         complete at any time and keeps its status and interrupt.
+  */
+CAN_RAMFUNC static bool can_transmit_status(CAN_TypeDef *CANx, CAN_TxState *State, CAN_TxCompletion *Completion)
+{
+  if(State->Mailbox >= CAN_TxStatus_NoMailBox)
+  {
+    return false;
+  }
+  
+  uint32_t tsr = CANx->TSR >> (State->Mailbox * 8);
+  
+  if((tsr & CAN_TSR_RQCP0) == 0)
+  {
+    return false;
+  }
+  
+  CAN_ClearFlag(CANx, canFlagRqcp[State->Mailbox]);
+  
+  *Completion        = State->InFlight;
+  Completion->Time   = CAN_TIME();
+  Completion->Status = can_transmit_result(tsr);
+  
+  State->Mailbox = CAN_TxStatus_NoMailBox;
+  
+  /* ALST or TERR of an earlier attempt stay set in a cancelled request. */
+  if((Completion->Status != CAN_TxStatusOk) && (State->Preempt == true))
+  {
+    State->RetryPending    = true;
+    State->RetryAttempt    = State->Attempt;
+    State->RetryWait       = 0;
+    State->RetryMessage    = State->Message;
+    State->RetryCompletion = State->InFlight;
+    State->UrgentStatistics.Preempted++;
+    
+    return false;
+  }
+  
+  if((Completion->Status != CAN_TxStatusOk) && (State->Cancel == true))
+  {
+    Completion->Status = CAN_TxStatusTimeout;
+    State->Statistics.Timeout++;
+  }
+  
+  if(Completion->Status == CAN_TxStatusOk)
+  {
+    State->Statistics.Recovered += (State->Attempt > 0) ? 1 : 0;
+    
+    return true;
+  }
+  
+  State->Statistics.ArbitrationLost += (Completion->Status == CAN_TxStatusArbitrationLost) ? 1 : 0;
+  State->Statistics.Error           += (Completion->Status == CAN_TxStatusError) ? 1 : 0;
+  
+  if((State->Mode == CAN_RetransmitSoftware) && (Completion->Status <= CAN_TxStatusError))
+  {
+    if((State->Attempt < State->RetryLimit) && (State->RetryPending == false))
+    {
+      State->RetryPending    = true;
+      State->RetryAttempt    = State->Attempt + 1;
+      State->RetryWait       = (uint32_t)State->Backoff << State->Attempt;
+      State->RetryMessage    = State->Message;
+      State->RetryCompletion = State->InFlight;
+      State->Statistics.Retry++;
+      
+      return false;
+    }
+    
+    State->Statistics.GiveUp++;
+  }
+  
+  return true;
+}
+
+/**
+  * @brief  Decode the completion status of a mailbox.
+  * @param  [in] TSR: CAN_TSR shifted down to the bits of the mailbox.
+  * @return The status.
+  */
+CAN_RAMFUNC static CAN_TxStatus can_transmit_result(uint32_t TSR)
+{
+  if((TSR & CAN_TSR_TXOK0) != 0)
+  {
+    return CAN_TxStatusOk;
+  }
+  else if((TSR & CAN_TSR_ALST0) != 0)
+  {
+    return CAN_TxStatusArbitrationLost;
+  }
+  else if((TSR & CAN_TSR_TERR0) != 0)
+  {
+    return CAN_TxStatusError;
+  }
+  else
+  {
+    return CAN_TxStatusAborted;
+  }
+}
+
+/**
+  * @brief  Read the completion of the urgent frame, and clear its RQCP.
+  * @param  [in]  CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in]  State:      The transmit state of the channel.
+  * @param  [out] Completion: The completion.
+  * @retval true:             The urgent frame completed.
+  * @retval false:            No urgent frame completed.
+  */
+CAN_RAMFUNC static bool can_transmit_urgent(CAN_TypeDef *CANx, CAN_TxState *State, CAN_TxCompletion *Completion)
+{
+  if(State->UrgentMailbox >= CAN_TxStatus_NoMailBox)
+  {
+    return false;
+  }
+  
+  uint32_t tsr = CANx->TSR >> (State->UrgentMailbox * 8);
+  
+  if((tsr & CAN_TSR_RQCP0) == 0)
+  {
+    return false;
+  }
+  
+  CAN_ClearFlag(CANx, canFlagRqcp[State->UrgentMailbox]);
+  
+  *Completion        = State->UrgentCompletion;
+  Completion->Time   = CAN_TIME();
+  Completion->Status = can_transmit_result(tsr);
+  
+  State->UrgentMailbox                = CAN_TxStatus_NoMailBox;
+  State->UrgentStatistics.LatencyLast = Completion->Time - State->UrgentStart;
+  
+  if((Completion->Status != CAN_TxStatusOk) && (State->UrgentCancel == true))
+  {
+    Completion->Status = CAN_TxStatusTimeout;
+    State->UrgentStatistics.Timeout++;
+  }
+  
+  if(State->UrgentStatistics.LatencyLast > State->UrgentStatistics.LatencyMax)
+  {
+    State->UrgentStatistics.LatencyMax = State->UrgentStatistics.LatencyLast;
+  }
+  
+  return true;
+}
+
+/**
+  * @brief  Report a completion to the callback, or else to the completion buffer.
+  * @param  [in] CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] State:      The transmit state of the channel.
+  * @param  [in] Completion: The completion.
+  * @return None.
+  * @note   A completion is lost when the buffer is full.
+  */
+CAN_RAMFUNC static void can_transmit_complete(CAN_TypeDef *CANx, CAN_TxState *State, const CAN_TxCompletion *Completion)
+{
+  if((State->Callback == 0) || (State->Callback(CANx, Completion) != true))
+  {
+    if(RingBuffer_Avail(State->Buffer) / sizeof(CAN_TxCompletion) > 0)
+    {
+      RingBuffer_In(State->Buffer, Completion, sizeof(CAN_TxCompletion));
+    }
+  }
+}
+
+/**
+  * @brief  Put the frame of the retry slot back into a mailbox.
+  * @param  [in] CANx:  Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] State: The transmit state of the channel.
+  * @param  [in] Force: true when nothing else is queued, the backoff is cut short.
+  * @retval true:       The frame is in a mailbox.
+  * @retval false:      No retry is due.
+  */
+CAN_RAMFUNC static bool can_transmit_retry(CAN_TypeDef *CANx, CAN_TxState *State, bool Force)
+{
+  if((State->RetryPending != true) || ((State->RetryWait > 0) && (Force != true)))
+  {
+    return false;
+  }
+  
+  State->RetryPending = false;
+  State->Attempt      = State->RetryAttempt;
+  State->Message      = State->RetryMessage;
+  State->InFlight     = State->RetryCompletion;
+  State->LoadTick     = canTick;
+  State->Cancel       = false;
+  State->Preempt      = false;
+  
+  CAN_TRACE(CANx, CAN_TraceMailboxLoad, CAN_TRACE_ID(&State->Message));
+  State->Mailbox = CAN_Transmit(CANx, &State->Message);
+  
+  return true;
+}
+
+/**
+  * @brief  Cancel the requests in flight once they are pending longer than the timeout.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return None.
+  * @note   The queued and the urgent request are supervised each. A cancelled
+  *         request completes in the transmit interrupt, which reports it with
+  *         CAN_TxStatusTimeout and loads the next frame.
+  */
+static void can_transmit_watchdog(CAN_TypeDef *CANx)
+{
+  CAN_TxState *state = can_transmit_get(CANx);
+  
+  if((state == 0) || (state->Timeout == 0))
+  {
+    return;
+  }
+  
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  if((state->Mailbox < CAN_TxStatus_NoMailBox) && (state->Cancel != true) && (canTick - state->LoadTick > state->Timeout))
+  {
+    state->Cancel = true;
+    CAN_CancelTransmit(CANx, state->Mailbox);
+  }
+  
+  if((state->UrgentMailbox < CAN_TxStatus_NoMailBox) && (state->UrgentCancel != true) && (canTick - state->UrgentTick > state->Timeout))
+  {
+    state->UrgentCancel = true;
+    CAN_CancelTransmit(CANx, state->UrgentMailbox);
+  }
+  
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Receive a message from FIFO 0 of the CAN.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return None.
+  * @note   Called by the receive interrupt, or by CAN_PollReceive() with the
+  *         interrupts masked.
+  */
+CAN_RAMFUNC static void can_receive(CAN_TypeDef *CANx)
+{
+  CAN_PROFILE_START(start);
+  
+  if(CANx == CAN1)
+  {
+    CanRxMsg  canRxMsg = {0};
+    CanRxMsg *frame    = &canRxMsg;
+    
+    if(can1FrameMode == true)
+    {
+      frame = FramePool_Alloc();
+      
+      if(frame == 0)
+      {
+        CAN_FIFORelease(CAN1, CAN_FIFO0);
+        CAN_TRACE(CAN1, CAN_TraceDrop, CAN_TRACE_DROP_RX_POOL);
+        return;
+      }
+    }
+    
+    CAN_Receive(CAN1, CAN_FIFO0, frame);
+    CAN_TRACE(CAN1, CAN_TraceReceive, CAN_TRACE_ID(frame));
+    CAN_PROFILE_STOP(CAN1, CAN_ProfileRxCallback, start);
+    
+    if((can1ReceiveMessageCallback == 0) || (can1ReceiveMessageCallback(CAN1, frame) != true))
+    {
+      if(can1FrameMode == true)
+      {
+        uint8_t index = FramePool_GetIndex(frame);
+        
+        if(RingBuffer_In(can1RxFrameBuffer, &index, sizeof(index)) == 0)
+        {
+          CAN_TRACE(CAN1, CAN_TraceDrop, CAN_TRACE_DROP_RX_BUFFER);
+          FramePool_Free(frame);
+        }
+      }
+      else if(RingBuffer_Avail(can1RxBuffer) / sizeof(CanRxMsg) > 0)
+      {
+        RingBuffer_In(can1RxBuffer, frame, sizeof(CanRxMsg));
+      }
+      else
+      {
+        CAN_TRACE(CAN1, CAN_TraceDrop, CAN_TRACE_DROP_RX_BUFFER);
+      }
+      
+#ifdef RTE_CMSIS_RTOS2
+      can_rtos_receive(&can1Rtos);
+#endif /* RTE_CMSIS_RTOS2 */
+      
+      if(can1ReceiveFinishCallback != 0)
+      {
+        can1ReceiveFinishCallback();
+      }
+    }
+    else if(can1FrameMode == true)
+    {
+      FramePool_Free(frame);
+    }
+  }
+  
+#ifdef STM32F10X_CL
+  if(CANx == CAN2)
+  {
+    CanRxMsg  canRxMsg = {0};
+    CanRxMsg *frame    = &canRxMsg;
+    
+    if(can2FrameMode == true)
+    {
+      frame = FramePool_Alloc();
+      
+      if(frame == 0)
+      {
+        CAN_FIFORelease(CAN2, CAN_FIFO0);
+        CAN_TRACE(CAN2, CAN_TraceDrop, CAN_TRACE_DROP_RX_POOL);
+        return;
+      }
+    }
+    
+    CAN_Receive(CAN2, CAN_FIFO0, frame);
+    CAN_TRACE(CAN2, CAN_TraceReceive, CAN_TRACE_ID(frame));
+    CAN_PROFILE_STOP(CAN2, CAN_ProfileRxCallback, start);
+    
+    if((can2ReceiveMessageCallback == 0) || (can2ReceiveMessageCallback(CAN2, frame) != true))
+    {
+      if(can2FrameMode == true)
+      {
+        uint8_t index = FramePool_GetIndex(frame);
+        
+        if(RingBuffer_In(can2RxFrameBuffer, &index, sizeof(index)) == 0)
+        {
+          CAN_TRACE(CAN2, CAN_TraceDrop, CAN_TRACE_DROP_RX_BUFFER);
+          FramePool_Free(frame);
+        }
+      }
+      else if(RingBuffer_Avail(can2RxBuffer) / sizeof(CanRxMsg) > 0)
+      {
+        RingBuffer_In(can2RxBuffer, frame, sizeof(CanRxMsg));
+      }
+      else
+      {
+        CAN_TRACE(CAN2, CAN_TraceDrop, CAN_TRACE_DROP_RX_BUFFER);
+      }
+      
+#ifdef RTE_CMSIS_RTOS2
+      can_rtos_receive(&can2Rtos);
+#endif /* RTE_CMSIS_RTOS2 */
+      
+      if(can2ReceiveFinishCallback != 0)
+      {
+        can2ReceiveFinishCallback();
+      }
+    }
+    else if(can2FrameMode == true)
+    {
+      FramePool_Free(frame);
+    }
+  }
+#endif /* STM32F10X_CL */
+}
+
+/**
+  * @brief  Count a message of the receive interrupt, switch to polling after a burst.
+  * @param  [in] CANx:  Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] State: The receive state of the channel.
+  * @return None.
+  * @note   FIFO 0 full takes over from message pending, so a late poll costs
+  *         one interrupt per FIFO depth and no message.
+  */
+CAN_RAMFUNC static void can_receive_burst(CAN_TypeDef *CANx, CAN_RxState *State)
+{
+  State->Statistics.Interrupt++;
+  
+  if((State->Burst > 0) && (++State->Count >= State->Burst))
+  {
+    State->Polling = true;
+    State->Empty   = 0;
+    State->Statistics.Enter++;
+    
+    CAN_ITConfig(CANx, CAN_IT_FMP0, DISABLE);
+    CAN_ITConfig(CANx, CAN_IT_FF0, ENABLE);
+  }
+}
+
+#if CAN_POLL_MODE
+/**
+  * @brief  Count FIFO 0 overruns and bus-off entries, the error interrupts being off.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Poll: The polled mode state of the channel.
+  * @return None.
+  * @note   Automatic bus-off management brings the controller back, the
+  *         pending requests go on then, or time out with CAN_SetTransmitTimeout().
+  */
+static void can_poll_error(CAN_TypeDef *CANx, CAN_PollState *Poll)
+{
+  bool busOff = ((CANx->ESR & CAN_ESR_BOFF) != 0);
+  
+  if((CANx->RF0R & CAN_RF0R_FOVR0) != 0)
+  {
+    CAN_ClearITPendingBit(CANx, CAN_IT_FOV0);
+    Poll->Statistics.Overrun++;
+  }
+  
+  if((busOff == true) && (Poll->BusOff != true))
+  {
+    Poll->Statistics.BusOff++;
+  }
+  
+  Poll->BusOff = busOff;
+}
+#endif /* CAN_POLL_MODE */
+
+/**
+  * @brief  Get the receive state of a configured channel.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return The receive state, 0 if the channel is not configured.
+  */
+static CAN_RxState *can_receive_get(CAN_TypeDef *CANx)
+{
+  if((CANx == CAN1) && (can1InitFlag == true))
+  {
+    return &can1RxState;
+  }
+  
+#ifdef STM32F10X_CL
+  if((CANx == CAN2) && (can2InitFlag == true))
+  {
+    return &can2RxState;
+  }
+#endif /* STM32F10X_CL */
+  
+  return 0;
+}
+
+/**
+  * @brief  Start the transmission of the transmit buffer when the CAN is idle.
+  * @param  [in] CANx:   Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] State:  The transmit state of the channel.
+  * @param  [in] Buffer: The transmit buffer of the channel.
+  * @param  [in] Flag:   The transmit flag of the channel.
+  * @return None.
+  * @note   The transmit interrupt of an urgent frame may run while the CAN is
+  *         idle, the check and the load are done with the interrupts masked.
+  */
+static void can_transmit_start(CAN_TypeDef *CANx, CAN_TxState *State, RingBuffer *Buffer, volatile bool *Flag)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  if(*Flag == false)
+  {
+    *Flag = true;
+    
+    if(can_transmit_queue(CANx, State, Buffer, 0, 0) != true)
+    {
+      /* Every message was rejected by its rate limit. */
+      *Flag = false;
+    }
+  }
+  
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Load the next message of the transmit buffer, within the rate limits.
+  * @param  [in]     CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in]     State:      The transmit state of the channel.
+  * @param  [in]     Buffer:     The transmit buffer of the channel.
+  * @param  [in]     Completion: The completion of the frame done, 0 if none.
+  * @param  [in,out] Complete:   true while that completion is not reported, 0 if none.
+  * @retval true:                A message is in a mailbox.
+  * @retval false:               The transmit buffer is empty, deferred messages may wait for a token.
+  * @note   A deferred message is parked with its class, the messages behind it
+  *         go on, those of its class queue up behind it. A rejected message, or
+  *         a deferred one finding the parking of its class full, completes right
+  *         away, after the frame done so the completions stay in order.
+  */
+CAN_RAMFUNC static bool can_transmit_queue(CAN_TypeDef *CANx, CAN_TxState *State, RingBuffer *Buffer, const CAN_TxCompletion *Completion, bool *Complete)
+{
+  if((State->Parked > 0) && (can_transmit_parked(CANx, State) == true))
+  {
+    return true;
+  }
+  
+  CanTxMsg canTxMsg = {0};
+  
+  while(RingBuffer_Out(Buffer, &canTxMsg, sizeof(canTxMsg)) > 0)
+  {
+    CAN_RateClass *rate   = can_rate_class(State, &canTxMsg);
+    uint32_t       handle = State->HandleOut++;
+    
+    CAN_PROFILE_TX_START(CANx, CAN_PROFILE_QUEUE_MESSAGE);
+    
+    if((rate == 0) || ((rate->ParkedNumber == 0) && (can_rate_take(rate) == true)))
+    {
+      if(rate != 0)
+      {
+        rate->Statistics.Passed++;
+      }
+      
+      CAN_TRACE(CANx, CAN_TraceMailboxLoad, CAN_TRACE_ID(&canTxMsg));
+      can_transmit(CANx, State, &canTxMsg, CAN_TxSourceMessage, handle);
+      
+      return true;
+    }
+    
+    if((rate->Limit.Action == CAN_RateDefer) && (rate->ParkedNumber < CAN_RATE_DEFER_NUMBER))
+    {
+      uint32_t index = (rate->ParkedOut + rate->ParkedNumber) % CAN_RATE_DEFER_NUMBER;
+      
+      rate->Parked[index]       = canTxMsg;
+      rate->ParkedHandle[index] = handle;
+      rate->ParkedNumber++;
+      rate->Statistics.Deferred++;
+      State->Parked++;
+      
+      continue;
+    }
+    
+    if((Complete != 0) && (*Complete == true))
+    {
+      can_transmit_complete(CANx, State, Completion);
+      *Complete = false;
+    }
+    
+    CAN_TxCompletion throttled = {0};
+    
+    throttled.Source = CAN_TxSourceMessage;
+    throttled.Handle = handle;
+    throttled.IDE    = canTxMsg.IDE;
+    throttled.Id     = (canTxMsg.IDE == CAN_Id_Standard) ? canTxMsg.StdId : canTxMsg.ExtId;
+    throttled.Status = CAN_TxStatusThrottled;
+    throttled.Time   = CAN_TIME();
+    
+    rate->Statistics.Rejected++;
+    CAN_TRACE(CANx, CAN_TraceDrop, CAN_TRACE_DROP_TX_RATE);
+    can_transmit_complete(CANx, State, &throttled);
+  }
+  
+  return false;
+}
+
+/**
+  * @brief  Load the oldest deferred message of the first class that has a token.
+  * @param  [in] CANx:  Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] State: The transmit state of the channel.
+  * @retval true:       A message is in a mailbox.
+  * @retval false:      No class with deferred messages has a token.
+  */
+CAN_RAMFUNC static bool can_transmit_parked(CAN_TypeDef *CANx, CAN_TxState *State)
+{
+  for(uint32_t i = 0; i < CAN_RATE_CLASS_NUMBER; i++)
+  {
+    CAN_RateClass *rate = &State->Rate[i];
+    
+    if((rate->ParkedNumber > 0) && (can_rate_take(rate) == true))
+    {
+      uint32_t index = rate->ParkedOut;
+      
+      rate->ParkedOut = (rate->ParkedOut + 1) % CAN_RATE_DEFER_NUMBER;
+      rate->ParkedNumber--;
+      rate->Statistics.Passed++;
+      State->Parked--;
+      
+      CAN_TRACE(CANx, CAN_TraceMailboxLoad, CAN_TRACE_ID(&rate->Parked[index]));
+      can_transmit(CANx, State, &rate->Parked[index], CAN_TxSourceMessage, rate->ParkedHandle[index]);
+      
+      return true;
+    }
+  }
+  
+  return false;
+}
+
+/**
+  * @brief  Find the rate class of a message.
+  * @param  [in] State:   The transmit state of the channel.
+  * @param  [in] Message: The message.
+  * @return The first class matching the identifier, 0 if none.
+  */
+CAN_RAMFUNC static CAN_RateClass *can_rate_class(CAN_TxState *State, const CanTxMsg *Message)
+{
+  uint32_t id = (Message->IDE == CAN_Id_Standard) ? Message->StdId : Message->ExtId;
+  
+  for(uint32_t i = 0; i < CAN_RATE_CLASS_NUMBER; i++)
+  {
+    CAN_RateLimit *limit = &State->Rate[i].Limit;
+    
+    if((limit->Rate > 0) && (limit->IDE == Message->IDE) && (id >= limit->IdLow) && (id <= limit->IdHigh))
+    {
+      return &State->Rate[i];
+    }
+  }
+  
+  return 0;
+}
+
+/**
+  * @brief  Refill the bucket of a class for the ticks gone by and take a token.
+  * @param  [in] Class: The rate class.
+  * @retval true:       A token was taken, or the class was removed meanwhile.
+  * @retval false:      The bucket is empty.
+  */
+CAN_RAMFUNC static bool can_rate_take(CAN_RateClass *Class)
+{
+  if(Class->Limit.Rate == 0)
+  {
+    return true;
+  }
+  
+  uint32_t depth   = Class->Limit.Burst * 1000;
+  uint32_t elapsed = canTick - Class->Tick;
+  
+  Class->Tick = canTick;
+  
+  /* Compared before the product, a long idle time does not overflow. */
+  if(elapsed > (depth - Class->Token) / Class->Limit.Rate)
+  {
+    Class->Token = depth;
+  }
+  else
+  {
+    Class->Token += elapsed * Class->Limit.Rate;
+  }
+  
+  if(Class->Token < 1000)
+  {
+    return false;
+  }
+  
+  Class->Token -= 1000;
+  
+  return true;
+}
+
+/**
+  * @brief  Start an idle channel again when a deferred message may have its token.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return None.
+  * @note   With a frame in flight the transmit interrupt loads it instead.
+  */
+static void can_rate_resume(CAN_TypeDef *CANx)
+{
+  if((CANx == CAN1) && (can1InitFlag == true) && (can1TxState.Parked > 0))
+  {
+    can_transmit_start(CAN1, &can1TxState, can1TxBuffer, &can1TransmitFlag);
+  }
+  
+#ifdef STM32F10X_CL
+  if((CANx == CAN2) && (can2InitFlag == true) && (can2TxState.Parked > 0))
+  {
+    can_transmit_start(CAN2, &can2TxState, can2TxBuffer, &can2TransmitFlag);
+  }
+#endif /* STM32F10X_CL */
+}
+
+/**
+  * @brief  Drop the deferred messages of every class.
+  * @param  [in] State: The transmit state of the channel.
+  * @return None.
+  */
+static void can_rate_clear(CAN_TxState *State)
+{
+  for(uint32_t i = 0; i < CAN_RATE_CLASS_NUMBER; i++)
+  {
+    State->Rate[i].ParkedOut    = 0;
+    State->Rate[i].ParkedNumber = 0;
+  }
+  
+  State->Parked = 0;
+}
+
+/**
+  * @brief  Get the transmit state of a configured channel.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return The transmit state, 0 if the channel is not configured.
+  */
+static CAN_TxState *can_transmit_get(CAN_TypeDef *CANx)
+{
+  if((CANx == CAN1) && (can1InitFlag == true))
+  {
+    return &can1TxState;
+  }
+  
+#ifdef STM32F10X_CL
+  if((CANx == CAN2) && (can2InitFlag == true))
+  {
+    return &can2TxState;
+  }
+#endif /* STM32F10X_CL */
+  
+  return 0;
+}
+
+#if CAN_RAM_EXECUTE
+/**
+  * @brief  Move the vector table to RAM, once.
+  * @param  None.
+  * @return None.
+  * @note   The table in use is copied, so a table moved by a bootloader is kept.
+  *         Its entries point to the handlers placed in RAM by CAN_RAMFUNC.
+  */
+static void can_vector_relocate(void)
+{
+  if(SCB->VTOR != (uint32_t)canVectorTable)
+  {
+    const uint32_t *vector = (const uint32_t *)SCB->VTOR;
+    
+    for(uint32_t i = 0; i < CAN_VECTOR_NUMBER; i++)
+    {
+      canVectorTable[i] = vector[i];
+    }
+    
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    
+    SCB->VTOR = (uint32_t)canVectorTable;
+    __DSB();
+    
+    __set_PRIMASK(primask);
+  }
+}
+#endif /* CAN_RAM_EXECUTE */
+
+#ifdef RTE_CMSIS_RTOS2
+/**
+  * @brief  Create the CMSIS-RTOS2 objects of a channel.
+  * @param  [in] rtos: The channel.
+  * @return None.
+  */
+static void can_rtos_create(CAN_Rtos *rtos)
+{
+  static const osMutexAttr_t attr = {"CAN", osMutexPrioInherit, 0, 0};
+  
+  rtos->EventFlags = osEventFlagsNew(0);
+  rtos->TxMutex    = osMutexNew(&attr);
+  rtos->RxMutex    = osMutexNew(&attr);
+  rtos->RxThread   = 0;
+  rtos->RxCallback = 0;
+  rtos->TxWaiting  = false;
+  rtos->RxStamp    = 0;
+  
+  rtos->Statistics.Frames       = 0;
+  rtos->Statistics.Wakeups      = 0;
+  rtos->Statistics.LatencyLast  = 0;
+  rtos->Statistics.LatencyMax   = 0;
+  rtos->Statistics.LatencyTotal = 0;
+  
+  /* The cycle counter times the wakeup latency. */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+  * @brief  Delete the CMSIS-RTOS2 objects of a channel.
+  * @param  [in] rtos: The channel.
+  * @return None.
+  */
+static void can_rtos_delete(CAN_Rtos *rtos)
+{
+  if(rtos->RxThread != 0)
+  {
+    osThreadTerminate(rtos->RxThread);
+    rtos->RxThread = 0;
+  }
+  
+  osEventFlagsDelete(rtos->EventFlags);
+  osMutexDelete(rtos->TxMutex);
+  osMutexDelete(rtos->RxMutex);
+  
+  rtos->EventFlags = 0;
+  rtos->TxMutex    = 0;
+  rtos->RxMutex    = 0;
+}
+
+/**
+  * @brief  Signal a received message to the waiting thread, in the receive
+  *         interrupt.
+  * @param  [in] rtos: The channel.
+  * @return None.
+  */
+CAN_RAMFUNC static void can_rtos_receive(CAN_Rtos *rtos)
+{
+  if(rtos->EventFlags != 0)
+  {
+    if((osEventFlagsGet(rtos->EventFlags) & CAN_EVENT_RECEIVE) == 0)
+    {
+      rtos->RxStamp = DWT->CYCCNT;
+    }
+    
+    osEventFlagsSet(rtos->EventFlags, CAN_EVENT_RECEIVE);
+  }
+}
+
+/**
+  * @brief  Signal transmit buffer space to the waiting thread, in the
+  *         transmit interrupt.
+  * @param  [in] rtos: The channel.
+  * @return None.
+  */
+CAN_RAMFUNC static void can_rtos_transmit(CAN_Rtos *rtos)
+{
+  if((rtos->TxWaiting == true) && (rtos->EventFlags != 0))
+  {
+    osEventFlagsSet(rtos->EventFlags, CAN_EVENT_TRANSMIT);
+  }
+}
+
+/**
+  * @brief  Get the CMSIS-RTOS2 objects of a configured channel.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return The channel, 0 if not configured.
+  */
+static CAN_Rtos *can_rtos_get(CAN_TypeDef *CANx)
+{
+  if(CANx == CAN1)
+  {
+    if((can1InitFlag == true) && (can1Rtos.EventFlags != 0))
+    {
+      return &can1Rtos;
+    }
+  }
+  
+#ifdef STM32F10X_CL
+  if(CANx == CAN2)
+  {
+    if((can2InitFlag == true) && (can2Rtos.EventFlags != 0))
+    {
+      return &can2Rtos;
+    }
+  }
+#endif /* STM32F10X_CL */
+  
+  return 0;
+}
+
+/**
+  * @brief  Receive dispatch thread.
+  * @param  [in] argument: The CAN peripheral.
+  * @return None.
+  */
+static void can_rtos_thread(void *argument)
+{
+  CAN_TypeDef *CANx     = (CAN_TypeDef *)argument;
+  CanRxMsg     canRxMsg = {0};
+  
+  while(1)
+  {
+    CAN_Rtos *rtos = can_rtos_get(CANx);
+    
+    if(rtos == 0)
+    {
+      break;
+    }
+    
+    if(CAN_WaitReceiveMessage(CANx, &canRxMsg, 1, osWaitForever) == 1)
+    {
+      rtos->RxCallback(CANx, &canRxMsg);
+    }
+  }
+  
+  osThreadExit();
+}
+#endif /* RTE_CMSIS_RTOS2 */
@@ -37,11 +37,20 @@ extern "C" {
 #include "stm32f10x.h"
 #include <stdbool.h>
 
+#ifdef _RTE_
+#include "RTE_Components.h"
+#endif
+
+#ifdef RTE_CMSIS_RTOS2
+#include "cmsis_os2.h"
+#endif
+
 /* Macro definitions ---------------------------------------------------------*/
 
 /******************************* CAN1 Configure *******************************/
 #define CAN1_TX_BUFFER_SIZE        (16)
 #define CAN1_RX_BUFFER_SIZE        (16)
+#define CAN1_TX_COMPLETE_SIZE      (16)
 
 #define CAN1_TX_GPIO_CLOCK         RCC_APB2Periph_GPIOB
 #define CAN1_RX_GPIO_CLOCK         RCC_APB2Periph_GPIOB
@@ -62,6 +71,7 @@ extern "C" {
 /******************************* CAN2 Configure *******************************/
 #define CAN2_TX_BUFFER_SIZE        (16)
 #define CAN2_RX_BUFFER_SIZE        (16)
+#define CAN2_TX_COMPLETE_SIZE      (16)
 
 #define CAN2_TX_GPIO_CLOCK         RCC_APB2Periph_GPIOB
 #define CAN2_RX_GPIO_CLOCK         RCC_APB2Periph_GPIOB
@@ -79,6 +89,47 @@ extern "C" {
 /******************************************************************************/
 #endif /* STM32F10X_CL */
 
+/****************************** Filter Configure ******************************/
+#ifdef STM32F10X_CL
+#define CAN_FILTER_BANK_NUMBER     (28)
+#else
+#define CAN_FILTER_BANK_NUMBER     (14)
+#endif /* STM32F10X_CL */
+/******************************************************************************/
+
+/******************************* Rate Configure *******************************/
+#define CAN_RATE_CLASS_NUMBER      (4)   /* Token buckets of the transmit buffer, per channel. */
+#define CAN_RATE_DEFER_NUMBER      (4)   /* Messages deferred per class, a full class rejects. */
+/******************************************************************************/
+
+/******************************* Poll Configure *******************************/
+#ifndef CAN_POLL_MODE
+#define CAN_POLL_MODE              (0)   /* 1 to leave the CAN interrupts off, CAN_Poll() does their work. */
+#endif
+
+#define CAN_POLL_RECEIVE_NUMBER    (3)   /* Messages read per CAN_Poll(), the depth of FIFO 0. */
+#define CAN_POLL_RECEIVE_BUDGET    (16)  /* Messages taken per CAN_PollReceive() at most, the rest wait for the next call. */
+/******************************************************************************/
+
+/******************************* RAM Configure ********************************/
+#ifndef CAN_RAM_EXECUTE
+#define CAN_RAM_EXECUTE            (0)   /* 1 to run the interrupt handlers and the vector table from SRAM, with RING_BUFFER_RAM_EXECUTE. */
+#endif
+
+#if CAN_RAM_EXECUTE
+#define CAN_RAMFUNC                __attribute__((section("CAN_RAMFUNC")))  /* The scatter file places it in RAM. */
+#else
+#define CAN_RAMFUNC
+#endif /* CAN_RAM_EXECUTE */
+/******************************************************************************/
+
+#ifdef RTE_CMSIS_RTOS2
+/******************************* RTOS Configure *******************************/
+#define CAN_RX_THREAD_STACK_SIZE   (512)
+#define CAN_RX_THREAD_PRIORITY     osPriorityAboveNormal
+/******************************************************************************/
+#endif /* RTE_CMSIS_RTOS2 */
+
 /* Type definitions ----------------------------------------------------------*/
 typedef enum
 {
@@ -98,18 +149,155 @@ typedef enum
   CAN_BaudRate10K   = 600
 }CAN_BaudRate;
 
+typedef struct
+{
+  uint32_t IDE;   /*!< CAN_Id_Standard or CAN_Id_Extended. */
+  uint32_t Id;    /*!< Standard or extended identifier. */
+  uint32_t Mask;  /*!< Identifier bits that must match, all ones for a single ID. */
+}CAN_FilterId;
+
+typedef enum
+{
+  CAN_TxSourceMessage = 0,              /*!< The transmit message buffer. */
+  CAN_TxSourceFrame,                    /*!< The transmit frame buffer. */
+  CAN_TxSourceProducer,                 /*!< A transmit producer. */
+  CAN_TxSourceUrgent                    /*!< CAN_SendUrgent(). */
+}CAN_TxSource;
+
+typedef enum
+{
+  CAN_TxStatusOk = 0,                   /*!< TXOK, sent and acknowledged. */
+  CAN_TxStatusArbitrationLost,          /*!< ALST, not retransmitted. */
+  CAN_TxStatusError,                    /*!< TERR, not retransmitted. */
+  CAN_TxStatusAborted,                  /*!< Cancelled before it was sent. */
+  CAN_TxStatusTimeout,                  /*!< Cancelled by the transmit timeout. */
+  CAN_TxStatusThrottled                 /*!< Rejected by its rate limit, never loaded. */
+}CAN_TxStatus;
+
+typedef enum
+{
+  CAN_RetransmitNone = 0,               /*!< NART, a failed request completes with ALST or TERR. */
+  CAN_RetransmitHardware,               /*!< Retransmitted by the controller until sent. */
+  CAN_RetransmitSoftware                /*!< NART, retried by the driver a bounded number of times. */
+}CAN_Retransmit;
+
+typedef struct
+{
+  uint32_t ArbitrationLost;             /*!< Requests completed with ALST. */
+  uint32_t Error;                       /*!< Requests completed with TERR. */
+  uint32_t Retry;                       /*!< Requests repeated by the driver. */
+  uint32_t Recovered;                   /*!< Frames sent after a retry. */
+  uint32_t GiveUp;                      /*!< Frames reported failed in software retransmit mode. */
+  uint32_t Timeout;                     /*!< Requests cancelled by the transmit timeout. */
+}CAN_RetransmitStatistics;
+
+typedef enum
+{
+  CAN_RateDefer = 0,                    /*!< The frame waits for a token, up to CAN_RATE_DEFER_NUMBER per class, then as rejected. */
+  CAN_RateReject                        /*!< The frame completes with CAN_TxStatusThrottled. */
+}CAN_RateAction;
+
+typedef struct
+{
+  uint32_t       IDE;                   /*!< CAN_Id_Standard or CAN_Id_Extended. */
+  uint32_t       IdLow;                 /*!< First identifier of the class. */
+  uint32_t       IdHigh;                /*!< Last identifier of the class. */
+  uint32_t       Rate;                  /*!< Frames per 1000 ticks of CAN_Tick(), up to 1000000, 0 to remove the class. */
+  uint32_t       Burst;                 /*!< Frames sent back to back at most, 1 to 65535. */
+  CAN_RateAction Action;                /*!< For a frame without a token. */
+}CAN_RateLimit;
+
+typedef struct
+{
+  uint32_t Passed;                      /*!< Frames of the class put into a mailbox. */
+  uint32_t Deferred;                    /*!< Frames that waited for a token. */
+  uint32_t Rejected;                    /*!< Frames reported with CAN_TxStatusThrottled, deferred ones overflowing included. */
+}CAN_RateStatistics;
+
+typedef struct
+{
+  uint32_t Interrupt;                   /*!< Messages taken by the FIFO 0 message pending interrupt. */
+  uint32_t Polled;                      /*!< Messages taken by CAN_PollReceive(). */
+  uint32_t Full;                        /*!< FIFO 0 full interrupts while polling, a poll came late. */
+  uint32_t Enter;                       /*!< Switches to polling after a burst. */
+  uint32_t Leave;                       /*!< Switches back to the interrupt. */
+  uint32_t Budget;                      /*!< Calls of CAN_PollReceive() that stopped at CAN_POLL_RECEIVE_BUDGET. */
+}CAN_RxPollStatistics;
+
+#if CAN_POLL_MODE
+typedef struct
+{
+  uint32_t Number;                      /*!< Calls of CAN_Poll(). */
+  uint32_t Overrun;                     /*!< Polls that found FIFO 0 overrun, a message or more lost. */
+  uint32_t BusOff;                      /*!< Bus-off entries seen by the polls. */
+  uint32_t CyclesLast;                  /*!< Time of the last call, cycle counter. */
+  uint32_t CyclesMax;                   /*!< The longest call, the measured worst case. */
+}CAN_PollStatistics;
+#endif /* CAN_POLL_MODE */
+
+typedef struct
+{
+  uint32_t Number;                      /*!< Urgent frames put into a mailbox. */
+  uint32_t Busy;                        /*!< Urgent frames refused, one was still pending. */
+  uint32_t Preempted;                   /*!< Queued frames cancelled for them and sent again. */
+  uint32_t Timeout;                     /*!< Urgent frames cancelled by the transmit timeout. */
+  uint32_t LatencyLast;                 /*!< Call to request completed, cycle counter. */
+  uint32_t LatencyMax;
+}CAN_UrgentStatistics;
+
+typedef struct
+{
+  CAN_TxSource Source;
+  uint32_t     Handle;                  /*!< Of CAN_SendMessage(), for the message buffer only. */
+  uint32_t     IDE;
+  uint32_t     Id;
+  CAN_TxStatus Status;                  /*!< From the TSR bits of the mailbox. */
+  uint32_t     Time;                    /*!< Of the request completed interrupt, cycle counter. */
+}CAN_TxCompletion;
+
+/* A transmit object filled when a mailbox frees up instead of queued. */
+typedef struct CAN_Producer
+{
+  struct CAN_Producer *Next;                                            /*!< Owned by the driver once added. */
+  CanTxMsg             Message;                                         /*!< Identifier, IDE, RTR and DLC, copied before every fill. */
+  bool               (*Fill)(CAN_TypeDef *CANx, CanTxMsg *Message);     /*!< Writes the payload in interrupt context, false to skip this trigger. */
+  volatile bool        Pending;                                         /*!< Triggered and not loaded yet. */
+  uint32_t             Loaded;                                          /*!< Frames put into a mailbox. */
+  uint32_t             Coalesced;                                       /*!< Triggers merged into a pending one. */
+  uint32_t             Skipped;                                         /*!< Triggers the fill callback declined. */
+}CAN_Producer;
+
+#ifdef RTE_CMSIS_RTOS2
+typedef struct
+{
+  uint32_t Frames;        /*!< Frames taken by waiting threads. */
+  uint32_t Wakeups;       /*!< Waiting threads woken by the receive interrupt, one context switch each. */
+  uint32_t LatencyLast;   /*!< Receive interrupt to thread running, in CPU cycles. */
+  uint32_t LatencyMax;
+  uint64_t LatencyTotal;  /*!< Divided by Wakeups gives the average. */
+}CAN_RtosStatistics;
+#endif /* RTE_CMSIS_RTOS2 */
+
 /* Variable declarations -----------------------------------------------------*/
 /* Variable definitions ------------------------------------------------------*/
 /* Function declarations -----------------------------------------------------*/
 void CAN_Configure(CAN_TypeDef *CANx, CAN_WorkMode WorkMode, CAN_BaudRate BaudRate, uint32_t StdId, uint32_t ExtId);
 void CAN_Unconfigure(CAN_TypeDef *CANx);
 
+bool CAN_SetReceiveFilter(CAN_TypeDef *CANx, const CAN_FilterId *Filter, uint32_t Number);
+uint32_t CAN_GetFilterBankNumber(CAN_TypeDef *CANx);
+
 void CAN_SetTransmitFinishCallback(CAN_TypeDef *CANx, void (*Callback)(void));
 void CAN_SetReceiveFinishCallback(CAN_TypeDef *CANx, void (*Callback)(void));
+void CAN_SetReceiveMessageCallback(CAN_TypeDef *CANx, bool (*Callback)(CAN_TypeDef *CANx, const CanRxMsg *Message));
 
 uint32_t CAN_SetTransmitMessage(CAN_TypeDef *CANx, const CanTxMsg *Message, uint32_t Number);
 uint32_t CAN_GetReceiveMessage(CAN_TypeDef *CANx, CanRxMsg *Message, uint32_t Number);
 
+void CAN_SetReceiveFrameMode(CAN_TypeDef *CANx, bool Enable);
+CanRxMsg *CAN_GetReceiveFrame(CAN_TypeDef *CANx);
+bool CAN_SetTransmitFrame(CAN_TypeDef *CANx, CanRxMsg *Frame);
+
 uint32_t CAN_GetUsedTransmitBufferSize(CAN_TypeDef *CANx);
 uint32_t CAN_GetUsedReceiveBufferSize(CAN_TypeDef *CANx);
 uint32_t CAN_GetUnusedTransmitBufferSize(CAN_TypeDef *CANx);
@@ -125,6 +313,40 @@ void CAN_ClearReceiveBuffer(CAN_TypeDef *CANx);
 
 bool CAN_IsTransmitMessage(CAN_TypeDef *CANx);
 
+bool CAN_SendMessage(CAN_TypeDef *CANx, const CanTxMsg *Message, uint32_t *Handle);
+void CAN_SetTransmitCompleteCallback(CAN_TypeDef *CANx, bool (*Callback)(CAN_TypeDef *CANx, const CAN_TxCompletion *Completion));
+uint32_t CAN_GetTransmitCompletion(CAN_TypeDef *CANx, CAN_TxCompletion *Completion, uint32_t Number);
+
+bool CAN_SetRetransmit(CAN_TypeDef *CANx, CAN_Retransmit Mode, uint8_t Retry, uint8_t Backoff);
+void CAN_GetRetransmitStatistics(CAN_TypeDef *CANx, CAN_RetransmitStatistics *Statistics);
+bool CAN_SetTransmitTimeout(CAN_TypeDef *CANx, uint32_t Timeout);
+bool CAN_SendUrgent(CAN_TypeDef *CANx, const CanTxMsg *Message);
+void CAN_GetUrgentStatistics(CAN_TypeDef *CANx, CAN_UrgentStatistics *Statistics);
+bool CAN_SetRateLimit(CAN_TypeDef *CANx, uint32_t Class, const CAN_RateLimit *Limit);
+void CAN_GetRateStatistics(CAN_TypeDef *CANx, uint32_t Class, CAN_RateStatistics *Statistics);
+bool CAN_SetReceivePolling(CAN_TypeDef *CANx, uint32_t Burst, uint32_t Idle);
+uint32_t CAN_PollReceive(CAN_TypeDef *CANx);
+void CAN_GetReceivePollStatistics(CAN_TypeDef *CANx, CAN_RxPollStatistics *Statistics);
+void CAN_Tick(void);
+
+bool CAN_AddProducer(CAN_TypeDef *CANx, CAN_Producer *Producer);
+void CAN_RemoveProducer(CAN_TypeDef *CANx, CAN_Producer *Producer);
+bool CAN_TriggerProducer(CAN_TypeDef *CANx, CAN_Producer *Producer);
+
+uint32_t CAN_GetBitRate(CAN_BaudRate BaudRate);
+
+#if CAN_POLL_MODE
+void CAN_Poll(CAN_TypeDef *CANx);
+void CAN_GetPollStatistics(CAN_TypeDef *CANx, CAN_PollStatistics *Statistics);
+#endif /* CAN_POLL_MODE */
+
+#ifdef RTE_CMSIS_RTOS2
+uint32_t CAN_WaitTransmitMessage(CAN_TypeDef *CANx, const CanTxMsg *Message, uint32_t Number, uint32_t Timeout);
+uint32_t CAN_WaitReceiveMessage(CAN_TypeDef *CANx, CanRxMsg *Message, uint32_t Number, uint32_t Timeout);
+bool CAN_StartReceiveThread(CAN_TypeDef *CANx, void (*Callback)(CAN_TypeDef *CANx, const CanRxMsg *Message));
+void CAN_GetRtosStatistics(CAN_TypeDef *CANx, CAN_RtosStatistics *Statistics);
+#endif /* RTE_CMSIS_RTOS2 */
+
 /* Function definitions ------------------------------------------------------*/
 
 #ifdef __cplusplus
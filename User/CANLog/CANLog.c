@@ -0,0 +1,908 @@
+/**
+  ******************************************************************************
+  * @file    CANLog.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   candump and Vector ASC logging and timed replay of CAN frames.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+/* Header includes -----------------------------------------------------------*/
+#include "CANLog.h"
+#include <string.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define CAN_LOG_ASC_HEADER  "date Thu Jan 1 00:00:00.000 am 1970\nbase hex  timestamps absolute\nno internal events logged\n"
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct
+{
+  char     *Text;
+  uint32_t  Size;
+  uint32_t  Length;
+}CAN_LogWriter;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+static uint64_t (*canLogGetTime)(void) = 0;
+
+static CAN_LogEntry      canLog[CAN_LOG_SIZE];
+static volatile uint32_t canLogIn       = 0;
+static volatile uint32_t canLogOut      = 0;
+static volatile uint32_t canLogOverflow = 0;
+
+static const CAN_LogEntry     *canLogReplayEntry      = 0;
+static uint32_t                canLogReplayNumber     = 0;
+static uint32_t                canLogReplayIndex      = 0;
+static uint32_t                canLogReplaySpeed      = 0;
+static uint64_t                canLogReplayStart      = 0;
+static bool                    canLogReplayBusy       = false;
+static CAN_LogReplayStatistics canLogReplayStatistics = {0};
+
+/* Function declarations -----------------------------------------------------*/
+static uint64_t can_log_get_time(void);
+static uint8_t can_log_get_channel(CAN_TypeDef *CANx);
+static CAN_TypeDef *can_log_get_can(uint8_t Channel);
+
+static void can_log_put_char(CAN_LogWriter *Writer, char Char);
+static void can_log_put_text(CAN_LogWriter *Writer, const char *Text);
+static void can_log_put_decimal(CAN_LogWriter *Writer, uint64_t Value, uint32_t Width, char Fill);
+static void can_log_put_hex(CAN_LogWriter *Writer, uint32_t Value, uint32_t Digits);
+static void can_log_put_time(CAN_LogWriter *Writer, uint64_t Time, uint32_t Width, char Fill);
+
+static const char *can_log_skip_space(const char *Text);
+static const char *can_log_get_hex(const char *Text, uint32_t Max, uint32_t *Value, uint32_t *Digits);
+static const char *can_log_parse_time(const char *Text, uint64_t *Time);
+static bool can_log_parse_candump(const char *Line, CAN_LogEntry *Entry);
+static bool can_log_parse_asc(const char *Line, CAN_LogEntry *Entry);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Empty the log and set its clock.
+  * @param  [in] GetTime: Returns the time in microseconds, it must not wrap.
+  * @return None.
+  * @note   The replay is stopped.
+  */
+void CAN_Log_Init(uint64_t (*GetTime)(void))
+{
+  canLogGetTime    = GetTime;
+  canLogIn         = 0;
+  canLogOut        = 0;
+  canLogOverflow   = 0;
+  canLogReplayBusy = false;
+}
+
+/**
+  * @brief  Add a frame to the log.
+  * @param  [in] CANx:      Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Direction: CAN_LogRx or CAN_LogTx.
+  * @param  [in] Message:   The frame.
+  * @retval true:           Logged.
+  * @retval false:          The log is full, the frame is counted as an overflow.
+  * @note   Can be called from threads and interrupts.
+  */
+bool CAN_Log_Record(CAN_TypeDef *CANx, CAN_LogDirection Direction, const CanTxMsg *Message)
+{
+  uint64_t time   = can_log_get_time();
+  bool     result = false;
+  
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  if(canLogIn - canLogOut < CAN_LOG_SIZE)
+  {
+    CAN_LogEntry *entry = &canLog[canLogIn & (CAN_LOG_SIZE - 1)];
+    
+    entry->Time      = time;
+    entry->Channel   = can_log_get_channel(CANx);
+    entry->Direction = Direction;
+    entry->Message   = *Message;
+    
+    canLogIn++;
+    result = true;
+  }
+  else
+  {
+    canLogOverflow++;
+  }
+  
+  __set_PRIMASK(primask);
+  
+  return result;
+}
+
+/**
+  * @brief  Log a received frame, for CAN_SetReceiveMessageCallback().
+  * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Message: The received frame.
+  * @return false, the frame is still delivered to the receive buffer.
+  */
+bool CAN_Log_Input(CAN_TypeDef *CANx, const CanRxMsg *Message)
+{
+  CanTxMsg canTxMsg = {0};
+  
+  canTxMsg.StdId = Message->StdId;
+  canTxMsg.ExtId = Message->ExtId;
+  canTxMsg.IDE   = Message->IDE;
+  canTxMsg.RTR   = Message->RTR;
+  canTxMsg.DLC   = Message->DLC;
+  memcpy(canTxMsg.Data, Message->Data, sizeof(canTxMsg.Data));
+  
+  CAN_Log_Record(CANx, CAN_LogRx, &canTxMsg);
+  
+  return false;
+}
+
+/**
+  * @brief  Take the oldest frame of the log.
+  * @param  [out] Entry: The frame.
+  * @retval true:        A frame was taken.
+  * @retval false:       The log is empty.
+  * @note   One reader only.
+  */
+bool CAN_Log_Read(CAN_LogEntry *Entry)
+{
+  if(canLogIn == canLogOut)
+  {
+    return false;
+  }
+  
+  *Entry = canLog[canLogOut & (CAN_LOG_SIZE - 1)];
+  canLogOut++;
+  
+  return true;
+}
+
+/**
+  * @brief  Get the number of frames lost to a full log.
+  * @param  None.
+  * @return The number of frames.
+  */
+uint32_t CAN_Log_GetOverflowNumber(void)
+{
+  return canLogOverflow;
+}
+
+/**
+  * @brief  Format the file header of a log.
+  * @param  [in] Format: The log format.
+  * @param  [out] Text:  The header, terminated.
+  * @param  [in] Size:   The size of @Text, CAN_LOG_HEADER_SIZE is enough.
+  * @return The length of the header, 0 if there is none or it does not fit.
+  * @note   The ASC header has no real date, the time stamps are relative to the start of the log.
+  */
+uint32_t CAN_Log_FormatHeader(CAN_LogFormat Format, char *Text, uint32_t Size)
+{
+  CAN_LogWriter writer = {Text, Size, 0};
+  
+  if(Format == CAN_LogFormatAsc)
+  {
+    can_log_put_text(&writer, CAN_LOG_ASC_HEADER);
+  }
+  
+  if(writer.Length >= Size)
+  {
+    writer.Length = 0;
+  }
+  
+  if(Size > 0)
+  {
+    Text[writer.Length] = '\0';
+  }
+  
+  return writer.Length;
+}
+
+/**
+  * @brief  Format a frame as a line of a log.
+  * @param  [in] Format: The log format.
+  * @param  [in] Entry:  The frame.
+  * @param  [out] Line:  The line with its newline, terminated.
+  * @param  [in] Size:   The size of @Line, CAN_LOG_LINE_SIZE is enough.
+  * @return The length of the line, 0 if it does not fit.
+  * @note   No stdio, the line is built by hand.
+  */
+uint32_t CAN_Log_Format(CAN_LogFormat Format, const CAN_LogEntry *Entry, char *Line, uint32_t Size)
+{
+  CAN_LogWriter   writer  = {Line, Size, 0};
+  const CanTxMsg *message = &Entry->Message;
+  uint32_t        dlc     = (message->DLC > 8) ? 8 : message->DLC;
+  
+  if(Format == CAN_LogFormatCandump)
+  {
+    can_log_put_char(&writer, '(');
+    can_log_put_time(&writer, Entry->Time, 10, '0');
+    can_log_put_text(&writer, ") can");
+    can_log_put_decimal(&writer, Entry->Channel, 1, ' ');
+    can_log_put_char(&writer, ' ');
+    
+    if(message->IDE == CAN_Id_Standard)
+    {
+      can_log_put_hex(&writer, message->StdId, 3);
+    }
+    else
+    {
+      can_log_put_hex(&writer, message->ExtId, 8);
+    }
+    
+    can_log_put_char(&writer, '#');
+    
+    if(message->RTR == CAN_RTR_Remote)
+    {
+      can_log_put_char(&writer, 'R');
+      
+      if(dlc > 0)
+      {
+        can_log_put_decimal(&writer, dlc, 1, ' ');
+      }
+    }
+    else
+    {
+      for(uint32_t i = 0; i < dlc; i++)
+      {
+        can_log_put_hex(&writer, message->Data[i], 2);
+      }
+    }
+  }
+  else
+  {
+    can_log_put_time(&writer, Entry->Time, 4, ' ');
+    can_log_put_char(&writer, ' ');
+    can_log_put_decimal(&writer, Entry->Channel + 1, 1, ' ');
+    can_log_put_text(&writer, "  ");
+    
+    uint32_t start = writer.Length;
+    
+    if(message->IDE == CAN_Id_Standard)
+    {
+      can_log_put_hex(&writer, message->StdId, 1);
+    }
+    else
+    {
+      can_log_put_hex(&writer, message->ExtId, 1);
+      can_log_put_char(&writer, 'x');
+    }
+    
+    while(writer.Length - start < 16)
+    {
+      can_log_put_char(&writer, ' ');
+    }
+    
+    can_log_put_text(&writer, (Entry->Direction == CAN_LogTx) ? "Tx   " : "Rx   ");
+    can_log_put_text(&writer, (message->RTR == CAN_RTR_Remote) ? "r " : "d ");
+    can_log_put_hex(&writer, dlc, 1);
+    
+    if(message->RTR != CAN_RTR_Remote)
+    {
+      for(uint32_t i = 0; i < dlc; i++)
+      {
+        can_log_put_char(&writer, ' ');
+        can_log_put_hex(&writer, message->Data[i], 2);
+      }
+    }
+  }
+  
+  can_log_put_char(&writer, '\n');
+  
+  if(writer.Length >= Size)
+  {
+    writer.Length = 0;
+  }
+  
+  if(Size > 0)
+  {
+    Line[writer.Length] = '\0';
+  }
+  
+  return writer.Length;
+}
+
+/**
+  * @brief  Parse a line of a candump or Vector ASC log.
+  * @param  [in] Line:   The line.
+  * @param  [out] Entry: The frame.
+  * @retval true:        The line holds a classic CAN frame.
+  * @retval false:       Header, comment, event or CAN FD line, or a syntax error.
+  * @note   The format is told by the line itself, candump lines start with '('.
+  */
+bool CAN_Log_Parse(const char *Line, CAN_LogEntry *Entry)
+{
+  const char *text = can_log_skip_space(Line);
+  
+  memset(Entry, 0, sizeof(*Entry));
+  
+  if(*text == '(')
+  {
+    return can_log_parse_candump(text + 1, Entry);
+  }
+  else
+  {
+    return can_log_parse_asc(text, Entry);
+  }
+}
+
+/**
+  * @brief  Start replaying a log.
+  * @param  [in] Entry:  The frames, in time order.
+  * @param  [in] Number: The number of frames.
+  * @param  [in] Speed:  1 for the original timing, N for N times faster, CAN_LOG_REPLAY_FAST
+  *                      for as fast as the transmit buffer takes the frames.
+  * @return None.
+  * @note   The first frame is due now, channel 1 frames go to CAN2 on connectivity line
+  *         devices and to CAN1 otherwise. The frames must stay valid until the replay ends.
+  */
+void CAN_Log_ReplayStart(const CAN_LogEntry *Entry, uint32_t Number, uint32_t Speed)
+{
+  memset(&canLogReplayStatistics, 0, sizeof(canLogReplayStatistics));
+  
+  canLogReplayEntry  = Entry;
+  canLogReplayNumber = Number;
+  canLogReplayIndex  = 0;
+  canLogReplaySpeed  = Speed;
+  canLogReplayStart  = can_log_get_time();
+  canLogReplayBusy   = (Number > 0);
+}
+
+/**
+  * @brief  Stop the replay.
+  * @param  None.
+  * @return None.
+  */
+void CAN_Log_ReplayStop(void)
+{
+  canLogReplayBusy = false;
+}
+
+/**
+  * @brief  Send the frames of the replay that are due.
+  * @param  None.
+  * @retval true:  The replay goes on.
+  * @retval false: The replay is over or stopped.
+  * @note   The timing error is measured when a frame goes into the transmit buffer, call
+  *         as often as the wanted fidelity, or from the transmit finish callback for
+  *         CAN_LOG_REPLAY_FAST.
+  */
+bool CAN_Log_ReplayProcess(void)
+{
+  if(canLogReplayBusy != true)
+  {
+    return false;
+  }
+  
+  uint64_t now   = can_log_get_time();
+  uint64_t first = canLogReplayEntry[0].Time;
+  
+  while(canLogReplayIndex < canLogReplayNumber)
+  {
+    const CAN_LogEntry *entry = &canLogReplayEntry[canLogReplayIndex];
+    uint64_t            due   = now;
+    
+    if(canLogReplaySpeed != CAN_LOG_REPLAY_FAST)
+    {
+      due = canLogReplayStart + ((entry->Time > first) ? (entry->Time - first) / canLogReplaySpeed : 0);
+      
+      if(now < due)
+      {
+        break;
+      }
+    }
+    
+    if(CAN_SetTransmitMessage(can_log_get_can(entry->Channel), &entry->Message, 1) != 1)
+    {
+      canLogReplayStatistics.BufferFull++;
+      break;
+    }
+    
+    uint64_t error = now - due;
+    
+    if(error > canLogReplayStatistics.ErrorMax)
+    {
+      canLogReplayStatistics.ErrorMax = (error < UINT32_MAX) ? (uint32_t)error : UINT32_MAX;
+    }
+    
+    if(error > CAN_LOG_REPLAY_LATE)
+    {
+      canLogReplayStatistics.Late++;
+    }
+    
+    canLogReplayStatistics.ErrorTotal += error;
+    canLogReplayStatistics.Frames++;
+    canLogReplayStatistics.Duration    = now - canLogReplayStart;
+    canLogReplayIndex++;
+  }
+  
+  if(canLogReplayIndex >= canLogReplayNumber)
+  {
+    canLogReplayBusy = false;
+  }
+  
+  return canLogReplayBusy;
+}
+
+/**
+  * @brief  Is the replay going on.
+  * @param  None.
+  * @retval true:  Frames are left to send.
+  * @retval false: The replay is over or stopped.
+  */
+bool CAN_Log_IsReplayBusy(void)
+{
+  return canLogReplayBusy;
+}
+
+/**
+  * @brief  Get the statistics of the last replay.
+  * @param  [out] Statistics: The statistics.
+  * @return None.
+  */
+void CAN_Log_GetReplayStatistics(CAN_LogReplayStatistics *Statistics)
+{
+  *Statistics = canLogReplayStatistics;
+}
+
+/**
+  * @brief  Get the time of the log clock.
+  * @param  None.
+  * @return Microseconds, 0 without a clock.
+  */
+static uint64_t can_log_get_time(void)
+{
+  return (canLogGetTime != 0) ? canLogGetTime() : 0;
+}
+
+/**
+  * @brief  Get the channel of a CAN peripheral.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return 0 for CAN1, 1 for CAN2.
+  */
+static uint8_t can_log_get_channel(CAN_TypeDef *CANx)
+{
+#ifdef STM32F10X_CL
+  if(CANx == CAN2)
+  {
+    return 1;
+  }
+#endif /* STM32F10X_CL */
+  
+  return 0;
+}
+
+/**
+  * @brief  Get the CAN peripheral of a channel.
+  * @param  [in] Channel: 0 for CAN1, 1 for CAN2.
+  * @return CAN2 for channel 1 on connectivity line devices, CAN1 otherwise.
+  */
+static CAN_TypeDef *can_log_get_can(uint8_t Channel)
+{
+#ifdef STM32F10X_CL
+  if(Channel == 1)
+  {
+    return CAN2;
+  }
+#endif /* STM32F10X_CL */
+  
+  return CAN1;
+}
+
+/**
+  * @brief  Append a character, counting the length even past the end.
+  * @param  [in] Writer: The line.
+  * @param  [in] Char:   The character.
+  * @return None.
+  */
+static void can_log_put_char(CAN_LogWriter *Writer, char Char)
+{
+  if(Writer->Length + 1 < Writer->Size)
+  {
+    Writer->Text[Writer->Length] = Char;
+  }
+  
+  Writer->Length++;
+}
+
+/**
+  * @brief  Append a string.
+  * @param  [in] Writer: The line.
+  * @param  [in] Text:   The string.
+  * @return None.
+  */
+static void can_log_put_text(CAN_LogWriter *Writer, const char *Text)
+{
+  while(*Text != '\0')
+  {
+    can_log_put_char(Writer, *Text++);
+  }
+}
+
+/**
+  * @brief  Append a decimal number.
+  * @param  [in] Writer: The line.
+  * @param  [in] Value:  The number.
+  * @param  [in] Width:  The minimum number of characters.
+  * @param  [in] Fill:   Pads on the left up to @Width.
+  * @return None.
+  */
+static void can_log_put_decimal(CAN_LogWriter *Writer, uint64_t Value, uint32_t Width, char Fill)
+{
+  char     digit[20] = {0};
+  uint32_t number    = 0;
+  
+  do
+  {
+    digit[number++] = '0' + (char)(Value % 10);
+    Value /= 10;
+  }while(Value > 0);
+  
+  for(uint32_t i = number; i < Width; i++)
+  {
+    can_log_put_char(Writer, Fill);
+  }
+  
+  while(number > 0)
+  {
+    can_log_put_char(Writer, digit[--number]);
+  }
+}
+
+/**
+  * @brief  Append an upper case hexadecimal number.
+  * @param  [in] Writer: The line.
+  * @param  [in] Value:  The number.
+  * @param  [in] Digits: The minimum number of digits, padded with zeros.
+  * @return None.
+  */
+static void can_log_put_hex(CAN_LogWriter *Writer, uint32_t Value, uint32_t Digits)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  
+  uint32_t number = 1;
+  
+  while((number < 8) && ((Value >> (number * 4)) != 0))
+  {
+    number++;
+  }
+  
+  if(number < Digits)
+  {
+    number = Digits;
+  }
+  
+  while(number > 0)
+  {
+    number--;
+    can_log_put_char(Writer, hex[(Value >> (number * 4)) & 0xF]);
+  }
+}
+
+/**
+  * @brief  Append a time as seconds with 6 decimals.
+  * @param  [in] Writer: The line.
+  * @param  [in] Time:   Microseconds.
+  * @param  [in] Width:  The minimum number of characters of the seconds.
+  * @param  [in] Fill:   Pads the seconds on the left up to @Width.
+  * @return None.
+  */
+static void can_log_put_time(CAN_LogWriter *Writer, uint64_t Time, uint32_t Width, char Fill)
+{
+  can_log_put_decimal(Writer, Time / 1000000, Width, Fill);
+  can_log_put_char(Writer, '.');
+  can_log_put_decimal(Writer, Time % 1000000, 6, '0');
+}
+
+/**
+  * @brief  Skip spaces and tabs.
+  * @param  [in] Text: The text.
+  * @return The first other character.
+  */
+static const char *can_log_skip_space(const char *Text)
+{
+  while((*Text == ' ') || (*Text == '\t'))
+  {
+    Text++;
+  }
+  
+  return Text;
+}
+
+/**
+  * @brief  Read a hexadecimal number.
+  * @param  [in] Text:    The text.
+  * @param  [in] Max:     The most digits to read, up to 8.
+  * @param  [out] Value:  The number.
+  * @param  [out] Digits: The number of digits read.
+  * @return The character after the number.
+  */
+static const char *can_log_get_hex(const char *Text, uint32_t Max, uint32_t *Value, uint32_t *Digits)
+{
+  *Value  = 0;
+  *Digits = 0;
+  
+  while(*Digits < Max)
+  {
+    char     c     = *Text;
+    uint32_t digit = 0;
+    
+    if((c >= '0') && (c <= '9'))
+    {
+      digit = c - '0';
+    }
+    else if((c >= 'A') && (c <= 'F'))
+    {
+      digit = c - 'A' + 10;
+    }
+    else if((c >= 'a') && (c <= 'f'))
+    {
+      digit = c - 'a' + 10;
+    }
+    else
+    {
+      break;
+    }
+    
+    *Value = (*Value << 4) | digit;
+    (*Digits)++;
+    Text++;
+  }
+  
+  return Text;
+}
+
+/**
+  * @brief  Read a time in seconds with up to 6 decimals, more are ignored.
+  * @param  [in] Text:  The text.
+  * @param  [out] Time: Microseconds.
+  * @return The character after the time, 0 if there is no number.
+  */
+static const char *can_log_parse_time(const char *Text, uint64_t *Time)
+{
+  uint64_t second   = 0;
+  uint32_t fraction = 0;
+  uint32_t scale    = 1000000;
+  
+  if((*Text < '0') || (*Text > '9'))
+  {
+    return 0;
+  }
+  
+  while((*Text >= '0') && (*Text <= '9'))
+  {
+    second = second * 10 + (*Text++ - '0');
+  }
+  
+  if(*Text == '.')
+  {
+    Text++;
+    
+    while((*Text >= '0') && (*Text <= '9'))
+    {
+      if(scale > 1)
+      {
+        scale    /= 10;
+        fraction += (*Text - '0') * scale;
+      }
+      
+      Text++;
+    }
+  }
+  
+  *Time = second * 1000000 + fraction;
+  
+  return Text;
+}
+
+/**
+  * @brief  Parse a candump line, "(time) interface id#data".
+  * @param  [in] Line:   The line after the opening parenthesis.
+  * @param  [out] Entry: The frame.
+  * @retval true:        A frame was read.
+  * @retval false:       Syntax error or CAN FD frame.
+  * @note   The channel is the number ending the interface name, 0 without one. A trailing
+  *         T marks a transmitted frame.
+  */
+static bool can_log_parse_candump(const char *Line, CAN_LogEntry *Entry)
+{
+  CanTxMsg   *message = &Entry->Message;
+  const char *text    = can_log_parse_time(Line, &Entry->Time);
+  uint32_t    value   = 0;
+  uint32_t    digits  = 0;
+  
+  if((text == 0) || (*text != ')'))
+  {
+    return false;
+  }
+  
+  text = can_log_skip_space(text + 1);
+  
+  const char *name = text;
+  
+  while((*text != '\0') && (*text != ' ') && (*text != '\t'))
+  {
+    text++;
+  }
+  
+  if((text > name) && (text[-1] >= '0') && (text[-1] <= '9'))
+  {
+    Entry->Channel = text[-1] - '0';
+  }
+  
+  text = can_log_get_hex(can_log_skip_space(text), 8, &value, &digits);
+  
+  if((digits == 0) || (*text != '#') || (text[1] == '#'))
+  {
+    return false;
+  }
+  
+  if(digits > 3)
+  {
+    message->IDE   = CAN_Id_Extended;
+    message->ExtId = value & 0x1FFFFFFF;
+  }
+  else
+  {
+    message->IDE   = CAN_Id_Standard;
+    message->StdId = value & 0x7FF;
+  }
+  
+  text++;
+  
+  if((*text == 'R') || (*text == 'r'))
+  {
+    message->RTR = CAN_RTR_Remote;
+    text++;
+    
+    if((*text >= '0') && (*text <= '8'))
+    {
+      message->DLC = *text++ - '0';
+    }
+  }
+  else
+  {
+    message->RTR = CAN_RTR_Data;
+    
+    while(message->DLC < 8)
+    {
+      const char *next = can_log_get_hex((*text == '.') ? (text + 1) : text, 2, &value, &digits);
+      
+      if(digits < 2)
+      {
+        break;
+      }
+      
+      message->Data[message->DLC++] = value;
+      text = next;
+    }
+  }
+  
+  text = can_log_skip_space(text);
+  
+  Entry->Direction = (*text == 'T') ? CAN_LogTx : CAN_LogRx;
+  
+  return true;
+}
+
+/**
+  * @brief  Parse a Vector ASC line, "time channel id[x] Rx|Tx d dlc data" or "... r [dlc]".
+  * @param  [in] Line:   The line.
+  * @param  [out] Entry: The frame.
+  * @retval true:        A frame was read.
+  * @retval false:       Not a classic CAN frame line.
+  * @note   The identifiers must be hexadecimal, as in "base hex".
+  */
+static bool can_log_parse_asc(const char *Line, CAN_LogEntry *Entry)
+{
+  CanTxMsg   *message = &Entry->Message;
+  const char *text    = can_log_parse_time(Line, &Entry->Time);
+  uint32_t    value   = 0;
+  uint32_t    digits  = 0;
+  
+  if((text == 0) || ((*text != ' ') && (*text != '\t')))
+  {
+    return false;
+  }
+  
+  text = can_log_skip_space(text);
+  
+  if((*text < '1') || (*text > '9'))
+  {
+    return false;
+  }
+  
+  Entry->Channel = 0;
+  
+  while((*text >= '0') && (*text <= '9'))
+  {
+    Entry->Channel = Entry->Channel * 10 + (*text++ - '0');
+  }
+  
+  Entry->Channel--;
+  
+  text = can_log_get_hex(can_log_skip_space(text), 8, &value, &digits);
+  
+  if(digits == 0)
+  {
+    return false;
+  }
+  
+  if((*text == 'x') || (*text == 'X'))
+  {
+    message->IDE   = CAN_Id_Extended;
+    message->ExtId = value & 0x1FFFFFFF;
+    text++;
+  }
+  else
+  {
+    message->IDE   = CAN_Id_Standard;
+    message->StdId = value & 0x7FF;
+  }
+  
+  text = can_log_skip_space(text);
+  
+  if(((text[0] == 'R') || (text[0] == 'T')) && (text[1] == 'x'))
+  {
+    Entry->Direction = (text[0] == 'T') ? CAN_LogTx : CAN_LogRx;
+    text = can_log_skip_space(text + 2);
+  }
+  else
+  {
+    return false;
+  }
+  
+  if(*text == 'r')
+  {
+    message->RTR = CAN_RTR_Remote;
+    text = can_log_get_hex(can_log_skip_space(text + 1), 1, &value, &digits);
+    message->DLC = ((digits > 0) && (value <= 8)) ? value : 0;
+    
+    return true;
+  }
+  
+  if(*text != 'd')
+  {
+    return false;
+  }
+  
+  message->RTR = CAN_RTR_Data;
+  text = can_log_get_hex(can_log_skip_space(text + 1), 1, &value, &digits);
+  
+  if((digits == 0) || (value > 8))
+  {
+    return false;
+  }
+  
+  message->DLC = value;
+  
+  for(uint32_t i = 0; i < message->DLC; i++)
+  {
+    text = can_log_get_hex(can_log_skip_space(text), 2, &value, &digits);
+    
+    if(digits == 0)
+    {
+      return false;
+    }
+    
+    message->Data[i] = value;
+  }
+  
+  return true;
+}
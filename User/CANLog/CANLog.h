@@ -0,0 +1,107 @@
+/**
+  ******************************************************************************
+  * @file    CANLog.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for CANLog.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+#ifndef __CANLOG_H
+#define __CANLOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "CAN.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define CAN_LOG_SIZE          (64)    /* Frames kept until CAN_Log_Read(), a power of 2. */
+#define CAN_LOG_LINE_SIZE     (80)    /* Enough for any line of CAN_Log_Format(), with the terminator. */
+#define CAN_LOG_HEADER_SIZE   (128)   /* Enough for CAN_Log_FormatHeader(), with the terminator. */
+
+#define CAN_LOG_REPLAY_FAST   (0)     /* Speed of CAN_Log_ReplayStart() sending as fast as the buffer takes. */
+#define CAN_LOG_REPLAY_LATE   (1000)  /* Microseconds after its due time a frame counts as late. */
+
+/* Type definitions ----------------------------------------------------------*/
+typedef enum
+{
+  CAN_LogFormatCandump = 0,           /*!< can-utils candump -l: "(1.000000) can0 123#1122334455667788". */
+  CAN_LogFormatAsc                    /*!< Vector ASC: "   1.000000 1  123             Rx   d 8 11 22 ...". */
+}CAN_LogFormat;
+
+typedef enum
+{
+  CAN_LogRx = 0,
+  CAN_LogTx
+}CAN_LogDirection;
+
+typedef struct
+{
+  uint64_t Time;                      /*!< Microseconds. */
+  uint8_t  Channel;                   /*!< 0 for CAN1, 1 for CAN2. */
+  uint8_t  Direction;                 /*!< CAN_LogDirection. */
+  CanTxMsg Message;
+}CAN_LogEntry;
+
+typedef struct
+{
+  uint32_t Frames;                    /*!< Frames put in the transmit buffer. */
+  uint32_t BufferFull;                /*!< Times a due frame found the transmit buffer full. */
+  uint32_t Late;                      /*!< Frames sent more than CAN_LOG_REPLAY_LATE after their due time. */
+  uint32_t ErrorMax;                  /*!< Largest delay of a frame after its due time, in microseconds. */
+  uint64_t ErrorTotal;                /*!< Sum of those delays, in microseconds. */
+  uint64_t Duration;                  /*!< Start to the last frame sent, in microseconds. */
+}CAN_LogReplayStatistics;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+void CAN_Log_Init(uint64_t (*GetTime)(void));
+
+bool CAN_Log_Record(CAN_TypeDef *CANx, CAN_LogDirection Direction, const CanTxMsg *Message);
+bool CAN_Log_Input(CAN_TypeDef *CANx, const CanRxMsg *Message);
+bool CAN_Log_Read(CAN_LogEntry *Entry);
+uint32_t CAN_Log_GetOverflowNumber(void);
+
+uint32_t CAN_Log_FormatHeader(CAN_LogFormat Format, char *Text, uint32_t Size);
+uint32_t CAN_Log_Format(CAN_LogFormat Format, const CAN_LogEntry *Entry, char *Line, uint32_t Size);
+bool CAN_Log_Parse(const char *Line, CAN_LogEntry *Entry);
+
+void CAN_Log_ReplayStart(const CAN_LogEntry *Entry, uint32_t Number, uint32_t Speed);
+void CAN_Log_ReplayStop(void);
+bool CAN_Log_ReplayProcess(void);
+bool CAN_Log_IsReplayBusy(void);
+void CAN_Log_GetReplayStatistics(CAN_LogReplayStatistics *Statistics);
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CANLOG_H */
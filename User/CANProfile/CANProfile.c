@@ -0,0 +1,307 @@
+/**
+  ******************************************************************************
+  * @file    CANProfile.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Interrupt latency and execution time histograms of the CAN driver.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+/* Header includes -----------------------------------------------------------*/
+#include "CANProfile.h"
+#include <string.h>
+
+#if CAN_PROFILE_ENABLE
+
+#ifdef HOST_MODEL
+#include "Core.h"
+#endif /* HOST_MODEL */
+
+/* Macro definitions ---------------------------------------------------------*/
+#ifdef STM32F10X_CL
+#define CAN_PROFILE_CHANNEL_NUMBER (2)
+#else
+#define CAN_PROFILE_CHANNEL_NUMBER (1)
+#endif /* STM32F10X_CL */
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct
+{
+  CAN_ProfileHistogram Histogram[CAN_ProfileNumber];
+  uint32_t             Stamp[2][CAN_PROFILE_STAMP_SIZE];  /*!< Enqueue times of the buffered frames. */
+  volatile uint32_t    StampIn[2];
+  volatile uint32_t    StampOut[2];
+  uint32_t             InFlight;                          /*!< Enqueue time of the frame in the mailbox. */
+  bool                 InFlightValid;
+}CAN_Profile;
+
+/* Variable declarations -----------------------------------------------------*/
+static CAN_Profile canProfile[CAN_PROFILE_CHANNEL_NUMBER];
+
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+static CAN_Profile *can_profile_get(CAN_TypeDef *CANx);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Start the cycle counter and clear the histograms.
+  * @param  None.
+  * @return None.
+  * @note   On the host model the time comes from the host clock in nanoseconds.
+  */
+void CAN_Profile_Init(void)
+{
+#ifndef HOST_MODEL
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT       = 0;
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+#endif /* HOST_MODEL */
+  
+  CAN_Profile_Clear();
+}
+
+/**
+  * @brief  Clear the histograms.
+  * @param  None.
+  * @return None.
+  * @note   The enqueue times of frames still queued are kept.
+  */
+void CAN_Profile_Clear(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  for(uint32_t i = 0; i < CAN_PROFILE_CHANNEL_NUMBER; i++)
+  {
+    memset(canProfile[i].Histogram, 0, sizeof(canProfile[i].Histogram));
+  }
+  
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Get the time.
+  * @param  None.
+  * @return The cycle counter, or the host clock in nanoseconds on the host model.
+  */
+uint32_t CAN_Profile_GetTime(void)
+{
+#ifdef HOST_MODEL
+  return (uint32_t)Core_GetHostTime();
+#else
+  return DWT->CYCCNT;
+#endif /* HOST_MODEL */
+}
+
+/**
+  * @brief  Get the rate of CAN_Profile_GetTime().
+  * @param  None.
+  * @return Ticks per second.
+  */
+uint32_t CAN_Profile_GetFrequency(void)
+{
+#ifdef HOST_MODEL
+  return 1000000000;
+#else
+  return SystemCoreClock;
+#endif /* HOST_MODEL */
+}
+
+/**
+  * @brief  Add a time to a histogram.
+  * @param  [in] CANx:  Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Point: The measuring point.
+  * @param  [in] Ticks: The time.
+  * @return None.
+  * @note   Every histogram is written from one interrupt only.
+  */
+void CAN_Profile_Record(CAN_TypeDef *CANx, CAN_ProfilePoint Point, uint32_t Ticks)
+{
+  CAN_Profile *profile = can_profile_get(CANx);
+  
+  if(profile != 0)
+  {
+    CAN_ProfileHistogram *histogram = &profile->Histogram[Point];
+    
+    if((histogram->Count == 0) || (Ticks < histogram->Min))
+    {
+      histogram->Min = Ticks;
+    }
+    
+    if(Ticks > histogram->Max)
+    {
+      histogram->Max = Ticks;
+    }
+    
+    histogram->Count++;
+    histogram->Total += Ticks;
+    histogram->Bucket[(Ticks == 0) ? 0 : (31 - __CLZ(Ticks))]++;
+  }
+}
+
+/**
+  * @brief  Keep the enqueue time of frames put in a transmit buffer.
+  * @param  [in] CANx:   Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Queue:  CAN_PROFILE_QUEUE_MESSAGE or CAN_PROFILE_QUEUE_FRAME.
+  * @param  [in] Time:   The enqueue time.
+  * @param  [in] Number: Frames put in the buffer.
+  * @return None.
+  */
+void CAN_Profile_TransmitQueue(CAN_TypeDef *CANx, uint32_t Queue, uint32_t Time, uint32_t Number)
+{
+  CAN_Profile *profile = can_profile_get(CANx);
+  
+  if(profile != 0)
+  {
+    for(uint32_t i = 0; (i < Number) && (profile->StampIn[Queue] - profile->StampOut[Queue] < CAN_PROFILE_STAMP_SIZE); i++)
+    {
+      profile->Stamp[Queue][profile->StampIn[Queue] & (CAN_PROFILE_STAMP_SIZE - 1)] = Time;
+      profile->StampIn[Queue]++;
+    }
+  }
+}
+
+/**
+  * @brief  The oldest frame of a transmit buffer goes into a mailbox.
+  * @param  [in] CANx:  Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Queue: CAN_PROFILE_QUEUE_MESSAGE or CAN_PROFILE_QUEUE_FRAME.
+  * @return None.
+  */
+void CAN_Profile_TransmitStart(CAN_TypeDef *CANx, uint32_t Queue)
+{
+  CAN_Profile *profile = can_profile_get(CANx);
+  
+  if((profile != 0) && (profile->StampIn[Queue] != profile->StampOut[Queue]))
+  {
+    profile->InFlight      = profile->Stamp[Queue][profile->StampOut[Queue] & (CAN_PROFILE_STAMP_SIZE - 1)];
+    profile->InFlightValid = true;
+    profile->StampOut[Queue]++;
+  }
+}
+
+/**
+  * @brief  The request of the mailbox completed, sent or given up.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return None.
+  */
+void CAN_Profile_TransmitDone(CAN_TypeDef *CANx)
+{
+  CAN_Profile *profile = can_profile_get(CANx);
+  
+  if((profile != 0) && (profile->InFlightValid == true))
+  {
+    profile->InFlightValid = false;
+    CAN_Profile_Record(CANx, CAN_ProfileTxComplete, CAN_Profile_GetTime() - profile->InFlight);
+  }
+}
+
+/**
+  * @brief  Drop the enqueue times of a cleared transmit buffer.
+  * @param  [in] CANx:  Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Queue: CAN_PROFILE_QUEUE_MESSAGE or CAN_PROFILE_QUEUE_FRAME.
+  * @return None.
+  */
+void CAN_Profile_TransmitClear(CAN_TypeDef *CANx, uint32_t Queue)
+{
+  CAN_Profile *profile = can_profile_get(CANx);
+  
+  if(profile != 0)
+  {
+    profile->StampOut[Queue] = profile->StampIn[Queue];
+  }
+}
+
+/**
+  * @brief  Get a copy of a histogram.
+  * @param  [in] CANx:       Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Point:      The measuring point.
+  * @param  [out] Histogram: The histogram, in CAN_Profile_GetFrequency() ticks.
+  * @return None.
+  */
+void CAN_Profile_GetHistogram(CAN_TypeDef *CANx, CAN_ProfilePoint Point, CAN_ProfileHistogram *Histogram)
+{
+  CAN_Profile *profile = can_profile_get(CANx);
+  
+  memset(Histogram, 0, sizeof(*Histogram));
+  
+  if(profile != 0)
+  {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    
+    *Histogram = profile->Histogram[Point];
+    
+    __set_PRIMASK(primask);
+  }
+}
+
+/**
+  * @brief  Get an upper bound of a percentile of a histogram.
+  * @param  [in] Histogram: The histogram.
+  * @param  [in] Percent:   The percentile, 0 to 100.
+  * @return The upper end of the bucket holding the percentile, at most the maximum.
+  */
+uint32_t CAN_Profile_GetPercentile(const CAN_ProfileHistogram *Histogram, uint32_t Percent)
+{
+  uint64_t target = ((uint64_t)Histogram->Count * Percent + 99) / 100;
+  uint64_t count  = 0;
+  
+  for(uint32_t k = 0; k < CAN_PROFILE_BUCKET_NUMBER; k++)
+  {
+    count += Histogram->Bucket[k];
+    
+    if((count >= target) && (count > 0))
+    {
+      uint32_t upper = (k < 31) ? ((2UL << k) - 1) : UINT32_MAX;
+      
+      return (upper < Histogram->Max) ? upper : Histogram->Max;
+    }
+  }
+  
+  return Histogram->Max;
+}
+
+/**
+  * @brief  Get the profile of a channel.
+  * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+  * @return The profile, 0 for an unknown peripheral.
+  */
+static CAN_Profile *can_profile_get(CAN_TypeDef *CANx)
+{
+  if(CANx == CAN1)
+  {
+    return &canProfile[0];
+  }
+  
+#ifdef STM32F10X_CL
+  if(CANx == CAN2)
+  {
+    return &canProfile[1];
+  }
+#endif /* STM32F10X_CL */
+  
+  return 0;
+}
+
+#endif /* CAN_PROFILE_ENABLE */
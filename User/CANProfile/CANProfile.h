@@ -0,0 +1,114 @@
+/**
+  ******************************************************************************
+  * @file    CANProfile.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for CANProfile.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+#ifndef __CANPROFILE_H
+#define __CANPROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "stm32f10x.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#ifndef CAN_PROFILE_ENABLE
+#define CAN_PROFILE_ENABLE         (0)   /* 1 to build the instrumentation into the driver. */
+#endif
+
+#define CAN_PROFILE_BUCKET_NUMBER  (32)  /* Bucket k counts times from 2^k to 2^(k+1)-1 ticks, bucket 0 also 0. */
+#define CAN_PROFILE_STAMP_SIZE     (32)  /* Enqueue times kept per transmit buffer, a power of 2 above its size. */
+
+#define CAN_PROFILE_QUEUE_MESSAGE  (0)   /* The transmit message buffer. */
+#define CAN_PROFILE_QUEUE_FRAME    (1)   /* The transmit frame buffer. */
+
+#if CAN_PROFILE_ENABLE
+#define CAN_PROFILE_START(Start)                        uint32_t Start = CAN_Profile_GetTime()
+#define CAN_PROFILE_STOP(CANx, Point, Start)            CAN_Profile_Record(CANx, Point, CAN_Profile_GetTime() - (Start))
+#define CAN_PROFILE_TX_QUEUE(CANx, Queue, Time, Number) CAN_Profile_TransmitQueue(CANx, Queue, Time, Number)
+#define CAN_PROFILE_TX_START(CANx, Queue)               CAN_Profile_TransmitStart(CANx, Queue)
+#define CAN_PROFILE_TX_DONE(CANx)                       CAN_Profile_TransmitDone(CANx)
+#define CAN_PROFILE_TX_CLEAR(CANx, Queue)               CAN_Profile_TransmitClear(CANx, Queue)
+#else
+#define CAN_PROFILE_START(Start)
+#define CAN_PROFILE_STOP(CANx, Point, Start)
+#define CAN_PROFILE_TX_QUEUE(CANx, Queue, Time, Number)
+#define CAN_PROFILE_TX_START(CANx, Queue)
+#define CAN_PROFILE_TX_DONE(CANx)
+#define CAN_PROFILE_TX_CLEAR(CANx, Queue)
+#endif /* CAN_PROFILE_ENABLE */
+
+/* Type definitions ----------------------------------------------------------*/
+typedef enum
+{
+  CAN_ProfileTxIsr = 0,                 /*!< Transmit interrupt, entry to exit. */
+  CAN_ProfileRxIsr,                     /*!< FIFO 0 interrupt, entry to exit. */
+  CAN_ProfileRxCallback,                /*!< FIFO 0 interrupt entry to the receive callbacks. */
+  CAN_ProfileTxComplete,                /*!< Enqueue to the request completed interrupt. */
+  CAN_ProfileNumber
+}CAN_ProfilePoint;
+
+typedef struct
+{
+  uint32_t Count;
+  uint32_t Min;
+  uint32_t Max;
+  uint64_t Total;
+  uint32_t Bucket[CAN_PROFILE_BUCKET_NUMBER];
+}CAN_ProfileHistogram;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+#if CAN_PROFILE_ENABLE
+void CAN_Profile_Init(void);
+void CAN_Profile_Clear(void);
+
+uint32_t CAN_Profile_GetTime(void);
+uint32_t CAN_Profile_GetFrequency(void);
+
+void CAN_Profile_Record(CAN_TypeDef *CANx, CAN_ProfilePoint Point, uint32_t Ticks);
+void CAN_Profile_TransmitQueue(CAN_TypeDef *CANx, uint32_t Queue, uint32_t Time, uint32_t Number);
+void CAN_Profile_TransmitStart(CAN_TypeDef *CANx, uint32_t Queue);
+void CAN_Profile_TransmitDone(CAN_TypeDef *CANx);
+void CAN_Profile_TransmitClear(CAN_TypeDef *CANx, uint32_t Queue);
+
+void CAN_Profile_GetHistogram(CAN_TypeDef *CANx, CAN_ProfilePoint Point, CAN_ProfileHistogram *Histogram);
+uint32_t CAN_Profile_GetPercentile(const CAN_ProfileHistogram *Histogram, uint32_t Percent);
+#endif /* CAN_PROFILE_ENABLE */
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CANPROFILE_H */
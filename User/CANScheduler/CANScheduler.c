@@ -0,0 +1,284 @@
+/**
+  ******************************************************************************
+  * @file    CANScheduler.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Cyclic transmission of CAN messages on the timer wheel.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+/* Header includes -----------------------------------------------------------*/
+#include "CANScheduler.h"
+#include <string.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+/* Type definitions ----------------------------------------------------------*/
+/* Variable declarations -----------------------------------------------------*/
+static uint32_t (*canSchedulerGetTime)(void) = 0;
+
+static uint8_t canSchedulerLoad[CAN_SCHEDULER_WINDOW];  /* Releases on each tick of the window. */
+
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+static uint32_t can_scheduler_stagger(uint32_t Period);
+static void can_scheduler_load(uint32_t Period, uint32_t Offset, bool Add);
+static void can_scheduler_release(TimerWheel_Timer *Timer);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Initialize the scheduler.
+  * @param  [in] GetTime: Free running time in microseconds for the jitter, 0 for none.
+  * @return None.
+  * @note   Call it before adding messages. The releases run in TimerWheel_Tick(),
+  *         which SysTick_Handler() calls every TIMER_WHEEL_TICK.
+  */
+void CAN_Scheduler_Init(uint32_t (*GetTime)(void))
+{
+  canSchedulerGetTime = GetTime;
+  
+  memset(canSchedulerLoad, 0, sizeof(canSchedulerLoad));
+}
+
+/**
+  * @brief  Transmit a message every Period ticks.
+  * @param  [in] Entry:   The scheduler entry, kept by the caller until removed.
+  * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Message: The message, copied.
+  * @param  [in] Period:  Ticks between releases.
+  * @param  [in] Offset:  Releases fall on the ticks equal to it modulo Period,
+  *                       CAN_SCHEDULER_OFFSET_AUTO to spread the load.
+  * @param  [in] Update:  Called before each release to update the payload, 0 for none.
+  * @retval true:         Scheduled.
+  * @retval false:        Period is 0.
+  * @note   Not from the callbacks. An automatic offset puts the releases on the ticks
+  *         of the window with the fewest releases already, exact when Period divides
+  *         CAN_SCHEDULER_WINDOW. Adding the short periods first spreads them best.
+  */
+bool CAN_Scheduler_Add(CAN_SchedulerMessage *Entry, CAN_TypeDef *CANx, const CanTxMsg *Message, uint32_t Period, uint32_t Offset,
+                       void (*Update)(CAN_TypeDef *CANx, CanTxMsg *Message))
+{
+  if(Period == 0)
+  {
+    return false;
+  }
+  
+  if(Offset == CAN_SCHEDULER_OFFSET_AUTO)
+  {
+    Offset = can_scheduler_stagger(Period);
+  }
+  
+  Entry->CANx    = CANx;
+  Entry->Message = *Message;
+  Entry->Period  = Period;
+  Entry->Offset  = Offset % Period;
+  Entry->Update  = Update;
+  Entry->Last    = 0;
+  
+  memset(&Entry->Statistics, 0, sizeof(Entry->Statistics));
+  
+  can_scheduler_load(Entry->Period, Entry->Offset, true);
+  
+  uint32_t next = TimerWheel_GetTime() + 1;
+  
+  TimerWheel_InitTimer(&Entry->Timer, can_scheduler_release, Entry);
+  TimerWheel_Start(&Entry->Timer, next + (Entry->Offset + Period - next % Period) % Period);
+  
+  return true;
+}
+
+/**
+  * @brief  Stop transmitting a message.
+  * @param  [in] Entry: The scheduler entry.
+  * @return None.
+  * @note   Not from the callbacks.
+  */
+void CAN_Scheduler_Remove(CAN_SchedulerMessage *Entry)
+{
+  if(TimerWheel_IsRunning(&Entry->Timer) == true)
+  {
+    TimerWheel_Stop(&Entry->Timer);
+    can_scheduler_load(Entry->Period, Entry->Offset, false);
+  }
+}
+
+/**
+  * @brief  Get the most releases falling on one tick.
+  * @param  None.
+  * @return Releases on the most loaded tick of the window.
+  */
+uint32_t CAN_Scheduler_GetPeakLoad(void)
+{
+  uint32_t peak = 0;
+  
+  for(uint32_t i = 0; i < CAN_SCHEDULER_WINDOW; i++)
+  {
+    if(canSchedulerLoad[i] > peak)
+    {
+      peak = canSchedulerLoad[i];
+    }
+  }
+  
+  return peak;
+}
+
+/**
+  * @brief  Get the statistics of a message.
+  * @param  [in] Entry:       The scheduler entry.
+  * @param  [out] Statistics: The statistics.
+  * @return None.
+  */
+void CAN_Scheduler_GetStatistics(const CAN_SchedulerMessage *Entry, CAN_SchedulerStatistics *Statistics)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  *Statistics = Entry->Statistics;
+  
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Clear the statistics of a message.
+  * @param  [in] Entry: The scheduler entry.
+  * @return None.
+  */
+void CAN_Scheduler_ClearStatistics(CAN_SchedulerMessage *Entry)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  memset(&Entry->Statistics, 0, sizeof(Entry->Statistics));
+  
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Pick the offset whose releases fall on the least loaded ticks.
+  * @param  [in] Period: Ticks between releases.
+  * @return The offset, the lowest of the most loaded tick first, then of the total.
+  */
+static uint32_t can_scheduler_stagger(uint32_t Period)
+{
+  uint32_t offset  = 0;
+  uint32_t bestMax = UINT32_MAX;
+  uint32_t bestSum = UINT32_MAX;
+  
+  /* Period candidates of W / Period ticks each, O(W) in all. */
+  for(uint32_t i = 0; (i < Period) && (i < CAN_SCHEDULER_WINDOW); i++)
+  {
+    uint32_t max = 0;
+    uint32_t sum = 0;
+    
+    for(uint32_t t = i; t < CAN_SCHEDULER_WINDOW; t += Period)
+    {
+      max  = (canSchedulerLoad[t] > max) ? canSchedulerLoad[t] : max;
+      sum += canSchedulerLoad[t];
+    }
+    
+    if((max < bestMax) || ((max == bestMax) && (sum < bestSum)))
+    {
+      offset  = i;
+      bestMax = max;
+      bestSum = sum;
+    }
+  }
+  
+  return offset;
+}
+
+/**
+  * @brief  Count the releases of a message in the load of the window, or take them out.
+  * @param  [in] Period: Ticks between releases.
+  * @param  [in] Offset: Its offset.
+  * @param  [in] Add:    true to add, false to take out.
+  * @return None.
+  */
+static void can_scheduler_load(uint32_t Period, uint32_t Offset, bool Add)
+{
+  for(uint32_t t = Offset % CAN_SCHEDULER_WINDOW; t < CAN_SCHEDULER_WINDOW; t += Period)
+  {
+    if((Add == true) && (canSchedulerLoad[t] < UINT8_MAX))
+    {
+      canSchedulerLoad[t]++;
+    }
+    else if((Add != true) && (canSchedulerLoad[t] > 0))
+    {
+      canSchedulerLoad[t]--;
+    }
+  }
+}
+
+/**
+  * @brief  Release a message, in TimerWheel_Tick().
+  * @param  [in] Timer: The timer of the scheduler entry.
+  * @return None.
+  * @note   Runs in SysTick_Handler() while the application may send from the
+  *         main loop, CAN_SetTransmitMessage() masks interrupts around the enqueue.
+  */
+static void can_scheduler_release(TimerWheel_Timer *Timer)
+{
+  CAN_SchedulerMessage *entry = (CAN_SchedulerMessage *)Timer->Argument;
+  
+  /* From the due tick, not from now, so the releases do not drift. */
+  TimerWheel_Start(Timer, Timer->Expire + entry->Period);
+  
+  if(entry->Update != 0)
+  {
+    entry->Update(entry->CANx, &entry->Message);
+  }
+  
+  if(canSchedulerGetTime != 0)
+  {
+    uint32_t now = canSchedulerGetTime();
+    
+    if(entry->Statistics.Release + entry->Statistics.Overflow > 0)
+    {
+      int32_t jitter = (int32_t)(now - entry->Last - entry->Period * TIMER_WHEEL_TICK);
+      
+      if((entry->Statistics.JitterNumber == 0) || (jitter < entry->Statistics.JitterMin))
+      {
+        entry->Statistics.JitterMin = jitter;
+      }
+      
+      if((entry->Statistics.JitterNumber == 0) || (jitter > entry->Statistics.JitterMax))
+      {
+        entry->Statistics.JitterMax = jitter;
+      }
+      
+      entry->Statistics.JitterNumber++;
+      entry->Statistics.JitterTotal += (jitter < 0) ? -jitter : jitter;
+    }
+    
+    entry->Last = now;
+  }
+  
+  if(CAN_SetTransmitMessage(entry->CANx, &entry->Message, 1) > 0)
+  {
+    entry->Statistics.Release++;
+  }
+  else
+  {
+    entry->Statistics.Overflow++;
+  }
+}
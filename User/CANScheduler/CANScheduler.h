@@ -0,0 +1,90 @@
+/**
+  ******************************************************************************
+  * @file    CANScheduler.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for CANScheduler.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+#ifndef __CANSCHEDULER_H
+#define __CANSCHEDULER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "CAN.h"
+#include "TimerWheel.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define CAN_SCHEDULER_WINDOW       (1000)        /* Ticks the load is spread over, a multiple of the periods. */
+#define CAN_SCHEDULER_OFFSET_AUTO  (0xFFFFFFFF)  /* Pick the offset of the least loaded ticks. */
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Release;                     /*!< Frames handed to the driver. */
+  uint32_t Overflow;                    /*!< Releases lost to a full transmit buffer. */
+  uint32_t JitterNumber;                /*!< Intervals measured, with a time source. */
+  int32_t  JitterMin;                   /*!< Interval between two releases minus the period, in microseconds. */
+  int32_t  JitterMax;
+  uint64_t JitterTotal;                 /*!< Sum of the absolute deviations, divided by JitterNumber gives the mean. */
+}CAN_SchedulerStatistics;
+
+typedef struct
+{
+  TimerWheel_Timer          Timer;
+  CAN_TypeDef              *CANx;
+  CanTxMsg                  Message;
+  uint32_t                  Period;     /*!< Ticks between releases. */
+  uint32_t                  Offset;     /*!< Releases fall on the ticks equal to it modulo Period. */
+  void                    (*Update)(CAN_TypeDef *CANx, CanTxMsg *Message);
+  uint32_t                  Last;       /*!< Time of the last release, in microseconds. */
+  CAN_SchedulerStatistics   Statistics;
+}CAN_SchedulerMessage;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+void CAN_Scheduler_Init(uint32_t (*GetTime)(void));
+
+bool CAN_Scheduler_Add(CAN_SchedulerMessage *Entry, CAN_TypeDef *CANx, const CanTxMsg *Message, uint32_t Period, uint32_t Offset,
+                       void (*Update)(CAN_TypeDef *CANx, CanTxMsg *Message));
+void CAN_Scheduler_Remove(CAN_SchedulerMessage *Entry);
+
+uint32_t CAN_Scheduler_GetPeakLoad(void);
+
+void CAN_Scheduler_GetStatistics(const CAN_SchedulerMessage *Entry, CAN_SchedulerStatistics *Statistics);
+void CAN_Scheduler_ClearStatistics(CAN_SchedulerMessage *Entry);
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CANSCHEDULER_H */
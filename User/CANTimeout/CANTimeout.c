@@ -0,0 +1,262 @@
+/**
+  ******************************************************************************
+  * @file    CANTimeout.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Reception timeout supervision of cyclic CAN messages.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+/* Header includes -----------------------------------------------------------*/
+#include "CANTimeout.h"
+#include <string.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+/* Type definitions ----------------------------------------------------------*/
+/* Variable declarations -----------------------------------------------------*/
+static CAN_TimeoutEntry *canTimeoutHash[CAN_TIMEOUT_HASH_SIZE];
+
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+static uint32_t can_timeout_hash(uint32_t IDE, uint32_t Id);
+static void can_timeout_expire(TimerWheel_Timer *Timer);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Forget every supervised identifier.
+  * @param  None.
+  * @return None.
+  * @note   The timers of the entries still added must be stopped first, or the
+  *         timer wheel initialized again.
+  */
+void CAN_Timeout_Init(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  memset(canTimeoutHash, 0, sizeof(canTimeoutHash));
+  
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Supervise the reception of an identifier.
+  * @param  [in] Entry:    The supervision entry, kept by the caller until removed.
+  * @param  [in] CANx:     Where x can be 1 or 2 to select the CAN peripheral, 0 for both.
+  * @param  [in] IDE:      CAN_Id_Standard or CAN_Id_Extended.
+  * @param  [in] Id:       The identifier.
+  * @param  [in] Timeout:  Ticks allowed between two receptions, the first deadline is
+  *                        Timeout ticks from now. A reception may come anywhere within
+  *                        its tick, so the deadline is one tick later and the timeout
+  *                        is reported Timeout to Timeout + 1 ticks after it, never early.
+  * @param  [in] Callback: Called with Timeout true when the deadline passes, in
+  *                        TimerWheel_Tick(), and false on the next reception, in the
+  *                        receive interrupt, or in TimerWheel_Tick() right after the
+  *                        timeout callback when the frame came while it ran. 0 for none.
+  * @retval true:          Added.
+  * @retval false:         Timeout is 0.
+  * @note   Not from the callbacks.
+  */
+bool CAN_Timeout_Add(CAN_TimeoutEntry *Entry, CAN_TypeDef *CANx, uint32_t IDE, uint32_t Id, uint32_t Timeout,
+                     void (*Callback)(CAN_TimeoutEntry *Entry, bool Timeout))
+{
+  if(Timeout == 0)
+  {
+    return false;
+  }
+  
+  Entry->CANx     = CANx;
+  Entry->IDE      = IDE;
+  Entry->Id       = Id;
+  Entry->Timeout  = Timeout;
+  Entry->Callback = Callback;
+  Entry->Expired  = false;
+  Entry->Report   = false;
+  Entry->Last     = TimerWheel_GetTime();
+  Entry->Received = 0;
+  Entry->Expiry   = 0;
+  Entry->GapMax   = 0;
+  
+  TimerWheel_InitTimer(&Entry->Timer, can_timeout_expire, Entry);
+  
+  CAN_TimeoutEntry **bucket = &canTimeoutHash[can_timeout_hash(IDE, Id)];
+  
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  Entry->Next = *bucket;
+  *bucket     = Entry;
+  
+  TimerWheel_Start(&Entry->Timer, Entry->Last + Timeout + 1);
+  
+  __set_PRIMASK(primask);
+  
+  return true;
+}
+
+/**
+  * @brief  Stop supervising an identifier.
+  * @param  [in] Entry: The supervision entry.
+  * @return None.
+  * @note   Not from the callbacks.
+  */
+void CAN_Timeout_Remove(CAN_TimeoutEntry *Entry)
+{
+  CAN_TimeoutEntry **link = &canTimeoutHash[can_timeout_hash(Entry->IDE, Entry->Id)];
+  
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  while((*link != 0) && (*link != Entry))
+  {
+    link = &(*link)->Next;
+  }
+  
+  if(*link == Entry)
+  {
+    *link = Entry->Next;
+    TimerWheel_Stop(&Entry->Timer);
+  }
+  
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Push the deadline of a received identifier.
+  * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Message: The message received.
+  * @retval false:        Always, the message is left to the receive buffer.
+  * @note   The receive message callback, or called from it. O(1) for identifiers
+  *         spread over the buckets.
+  */
+bool CAN_Timeout_Input(CAN_TypeDef *CANx, const CanRxMsg *Message)
+{
+  uint32_t id  = (Message->IDE == CAN_Id_Standard) ? Message->StdId : Message->ExtId;
+  uint32_t now = TimerWheel_GetTime();
+  
+  for(CAN_TimeoutEntry *entry = canTimeoutHash[can_timeout_hash(Message->IDE, id)]; entry != 0; entry = entry->Next)
+  {
+    if((entry->Id == id) && (entry->IDE == Message->IDE) && ((entry->CANx == 0) || (entry->CANx == CANx)))
+    {
+      uint32_t primask = __get_PRIMASK();
+      __disable_irq();
+      
+      if((entry->Received > 0) && (now - entry->Last > entry->GapMax))
+      {
+        entry->GapMax = now - entry->Last;
+      }
+      
+      entry->Last = now;
+      entry->Received++;
+      
+      TimerWheel_Start(&entry->Timer, now + entry->Timeout + 1);
+      
+      /* While the timeout is being reported can_timeout_expire() reports the reception after it. */
+      bool recovered = (entry->Expired == true) && (entry->Report != true);
+      
+      entry->Expired = false;
+      
+      __set_PRIMASK(primask);
+      
+      if((recovered == true) && (entry->Callback != 0))
+      {
+        entry->Callback(entry, false);
+      }
+    }
+  }
+  
+  return false;
+}
+
+/**
+  * @brief  Determine whether an identifier is timed out.
+  * @param  [in] Entry: The supervision entry.
+  * @retval true:       Nothing received within Timeout.
+  * @retval false:      Received in time.
+  */
+bool CAN_Timeout_IsExpired(const CAN_TimeoutEntry *Entry)
+{
+  return Entry->Expired;
+}
+
+/**
+  * @brief  Get the bucket of an identifier.
+  * @param  [in] IDE: CAN_Id_Standard or CAN_Id_Extended.
+  * @param  [in] Id:  The identifier.
+  * @return The bucket.
+  */
+static uint32_t can_timeout_hash(uint32_t IDE, uint32_t Id)
+{
+  uint32_t key = Id ^ ((IDE == CAN_Id_Standard) ? 0 : 0x55);
+  
+  return (key ^ (key >> 6) ^ (key >> 12) ^ (key >> 18) ^ (key >> 24)) & (CAN_TIMEOUT_HASH_SIZE - 1);
+}
+
+/**
+  * @brief  Deadline of an identifier passed, in TimerWheel_Tick().
+  * @param  [in] Timer: The timer of the supervision entry.
+  * @return None.
+  * @note   Not started again, the next reception starts it. The callbacks run
+  *         unmasked, a frame received meanwhile only clears Expired and the
+  *         state is reported here until the callbacks caught up with it, so
+  *         they come in order and the last one matches Expired.
+  */
+static void can_timeout_expire(TimerWheel_Timer *Timer)
+{
+  CAN_TimeoutEntry *entry = (CAN_TimeoutEntry *)Timer->Argument;
+  
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  /* A frame received since the timer fired started it again. */
+  if(TimerWheel_IsRunning(Timer) == true)
+  {
+    __set_PRIMASK(primask);
+    return;
+  }
+  
+  entry->Expired = true;
+  entry->Expiry++;
+  entry->Report  = true;
+  
+  bool reported = false;
+  
+  while(entry->Expired != reported)
+  {
+    reported = entry->Expired;
+    
+    __set_PRIMASK(primask);
+    
+    if(entry->Callback != 0)
+    {
+      entry->Callback(entry, reported);
+    }
+    
+    __disable_irq();
+  }
+  
+  entry->Report = false;
+  
+  __set_PRIMASK(primask);
+}
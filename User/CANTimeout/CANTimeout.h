@@ -0,0 +1,82 @@
+/**
+  ******************************************************************************
+  * @file    CANTimeout.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for CANTimeout.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+#ifndef __CANTIMEOUT_H
+#define __CANTIMEOUT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "CAN.h"
+#include "TimerWheel.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define CAN_TIMEOUT_HASH_SIZE  (64)  /* Buckets of the identifier lookup, a power of 2. */
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct CAN_TimeoutEntry
+{
+  TimerWheel_Timer           Timer;
+  struct CAN_TimeoutEntry   *Next;      /*!< Next entry of the bucket. */
+  CAN_TypeDef               *CANx;      /*!< Channel, 0 for both. */
+  uint32_t                   IDE;       /*!< CAN_Id_Standard or CAN_Id_Extended. */
+  uint32_t                   Id;
+  uint32_t                   Timeout;   /*!< Ticks allowed between two receptions, and before the first one, reported 1 tick later at most. */
+  void                     (*Callback)(struct CAN_TimeoutEntry *Entry, bool Timeout);
+  volatile bool              Expired;   /*!< No frame within Timeout, until the next one. */
+  volatile bool              Report;    /*!< The timeout callbacks are under way, they report the receptions too. */
+  uint32_t                   Last;      /*!< Tick of the last reception. */
+  uint32_t                   Received;
+  uint32_t                   Expiry;    /*!< Timeouts. */
+  uint32_t                   GapMax;    /*!< Most ticks between two receptions. */
+}CAN_TimeoutEntry;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+void CAN_Timeout_Init(void);
+
+bool CAN_Timeout_Add(CAN_TimeoutEntry *Entry, CAN_TypeDef *CANx, uint32_t IDE, uint32_t Id, uint32_t Timeout,
+                     void (*Callback)(CAN_TimeoutEntry *Entry, bool Timeout));
+void CAN_Timeout_Remove(CAN_TimeoutEntry *Entry);
+
+bool CAN_Timeout_Input(CAN_TypeDef *CANx, const CanRxMsg *Message);
+bool CAN_Timeout_IsExpired(const CAN_TimeoutEntry *Entry);
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CANTIMEOUT_H */
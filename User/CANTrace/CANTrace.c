@@ -0,0 +1,165 @@
+/**
+  ******************************************************************************
+  * @file    CANTrace.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Binary event trace of the CAN driver in a RAM ring.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+/* Header includes -----------------------------------------------------------*/
+#include "CANTrace.h"
+#include <string.h>
+
+#if CAN_TRACE_ENABLE
+
+#ifdef HOST_MODEL
+#include "Core.h"
+#endif /* HOST_MODEL */
+
+/* Macro definitions ---------------------------------------------------------*/
+#define CAN_TRACE_ESR_FLAG      ((uint32_t)0x00000007)  /* EWGF, EPVF and BOFF. */
+
+#ifdef HOST_MODEL
+#define CAN_TRACE_TIME()        ((uint32_t)Core_GetHostTime())
+#else
+#define CAN_TRACE_TIME()        (DWT->CYCCNT)
+#endif /* HOST_MODEL */
+
+/* Type definitions ----------------------------------------------------------*/
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+static CAN_TraceBuffer canTraceBuffer;
+
+static volatile bool canTraceRun        = false;
+static uint32_t      canTraceErrorFlag[2] = {0};
+
+/* Function declarations -----------------------------------------------------*/
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Start the cycle counter and empty the trace.
+  * @param  None.
+  * @return None.
+  * @note   The trace stays stopped until CAN_Trace_Start().
+  */
+void CAN_Trace_Init(void)
+{
+#ifndef HOST_MODEL
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+#endif /* HOST_MODEL */
+  
+  canTraceRun = false;
+  
+  memset(&canTraceBuffer, 0, sizeof(canTraceBuffer));
+  memset(canTraceErrorFlag, 0, sizeof(canTraceErrorFlag));
+  
+  canTraceBuffer.Magic   = CAN_TRACE_MAGIC;
+  canTraceBuffer.Version = CAN_TRACE_VERSION;
+  canTraceBuffer.Size    = CAN_TRACE_SIZE;
+#ifdef HOST_MODEL
+  canTraceBuffer.Frequency = 1000000000;
+#else
+  canTraceBuffer.Frequency = SystemCoreClock;
+#endif /* HOST_MODEL */
+}
+
+/**
+  * @brief  Start recording.
+  * @param  None.
+  * @return None.
+  */
+void CAN_Trace_Start(void)
+{
+  canTraceRun = true;
+}
+
+/**
+  * @brief  Stop recording, the records stay in the ring.
+  * @param  None.
+  * @return None.
+  */
+void CAN_Trace_Stop(void)
+{
+  canTraceRun = false;
+}
+
+/**
+  * @brief  Add a record to the trace.
+  * @param  [in] Channel: 0 for CAN1, 1 for CAN2.
+  * @param  [in] Event:   The event.
+  * @param  [in] Data:    The data of the event.
+  * @return None.
+  * @note   Lock-free, the slot is reserved with LDREX/STREX so interrupts may nest.
+  *         Once full the ring keeps the newest CAN_TRACE_SIZE records.
+  */
+void CAN_Trace_Record(uint8_t Channel, CAN_TraceEvent Event, uint16_t Data)
+{
+  if(canTraceRun == true)
+  {
+    uint32_t index = 0;
+    
+    do
+    {
+      index = __LDREXW(&canTraceBuffer.Index);
+    }while(__STREXW(index + 1, &canTraceBuffer.Index) != 0);
+    
+    CAN_TraceRecord *record = &canTraceBuffer.Record[index & (CAN_TRACE_SIZE - 1)];
+    
+    record->Time    = CAN_TRACE_TIME();
+    record->Event   = (uint8_t)Event;
+    record->Channel = Channel;
+    record->Data    = Data;
+  }
+}
+
+/**
+  * @brief  Add a CAN_TraceErrorState record if the error state flags changed.
+  * @param  [in] Channel: 0 for CAN1, 1 for CAN2.
+  * @param  [in] ESR:     The error status register.
+  * @return None.
+  */
+void CAN_Trace_CheckError(uint8_t Channel, uint32_t ESR)
+{
+  uint32_t flag = ESR & CAN_TRACE_ESR_FLAG;
+  
+  if(flag != canTraceErrorFlag[Channel])
+  {
+    canTraceErrorFlag[Channel] = flag;
+    CAN_Trace_Record(Channel, CAN_TraceErrorState, (uint16_t)((ESR & 0x77) | ((ESR >> 8) & 0xFF00)));
+  }
+}
+
+/**
+  * @brief  Get the trace buffer, to dump it for Tools/CANTrace/cantrace.py.
+  * @param  None.
+  * @return The trace buffer.
+  * @note   Stop the trace before the dump for a consistent image.
+  */
+const CAN_TraceBuffer *CAN_Trace_GetBuffer(void)
+{
+  return &canTraceBuffer;
+}
+
+#endif /* CAN_TRACE_ENABLE */
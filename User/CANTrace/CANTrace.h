@@ -0,0 +1,127 @@
+/**
+  ******************************************************************************
+  * @file    CANTrace.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for CANTrace.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+#ifndef __CANTRACE_H
+#define __CANTRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "stm32f10x.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#ifndef CAN_TRACE_ENABLE
+#define CAN_TRACE_ENABLE          (0)           /* 1 to build the trace into the driver. */
+#endif
+
+#define CAN_TRACE_SIZE            (512)         /* Records in the ring, a power of 2. */
+#define CAN_TRACE_MAGIC           (0x43525443)  /* "CTRC" in memory. */
+#define CAN_TRACE_VERSION         (1)
+
+/* Data of CAN_TraceDrop. */
+#define CAN_TRACE_DROP_RX_BUFFER  (1)           /* Receive buffer full. */
+#define CAN_TRACE_DROP_RX_POOL    (2)           /* Frame pool empty. */
+#define CAN_TRACE_DROP_TX_BUFFER  (3)           /* Transmit buffer full. */
+#define CAN_TRACE_DROP_TX_RATE    (4)           /* Rejected by a transmit rate limit. */
+
+#if CAN_TRACE_ENABLE
+#define CAN_TRACE(CANx, Event, Data)  CAN_Trace_Record(((CANx) == CAN1) ? 0 : 1, Event, Data)
+#define CAN_TRACE_ERROR(CANx)         CAN_Trace_CheckError(((CANx) == CAN1) ? 0 : 1, (CANx)->ESR)
+#else
+#define CAN_TRACE(CANx, Event, Data)
+#define CAN_TRACE_ERROR(CANx)
+#endif /* CAN_TRACE_ENABLE */
+
+/* The identifier of a message, the low 16 bits for an extended one. */
+#define CAN_TRACE_ID(Message)         (uint16_t)(((Message)->IDE == CAN_Id_Standard) ? (Message)->StdId : (Message)->ExtId)
+
+/* RQCP, TXOK, ALST and TERR of the 3 mailboxes, 4 bits each. */
+#define CAN_TRACE_TSR(TSR)            (uint16_t)(((TSR) & 0x00F) | (((TSR) >> 4) & 0x0F0) | (((TSR) >> 8) & 0xF00))
+
+/* Type definitions ----------------------------------------------------------*/
+typedef enum
+{
+  CAN_TraceTxIsrEnter = 1,                      /*!< Data: CAN_TRACE_TSR() on entry. */
+  CAN_TraceTxIsrExit,
+  CAN_TraceRxIsrEnter,                          /*!< Data: messages pending in FIFO 0. */
+  CAN_TraceRxIsrExit,
+  CAN_TraceEnqueue,                             /*!< Data: frames put in the transmit buffer. */
+  CAN_TraceDequeue,                             /*!< Data: frames taken from the receive buffer. */
+  CAN_TraceDrop,                                /*!< Data: CAN_TRACE_DROP_xxx. */
+  CAN_TraceMailboxLoad,                         /*!< Data: CAN_TRACE_ID() of the frame. */
+  CAN_TraceReceive,                             /*!< Data: CAN_TRACE_ID() of the frame. */
+  CAN_TraceErrorState,                          /*!< Data: EWGF, EPVF, BOFF in bits 0-2, LEC in 4-6, TEC in 8-15. */
+  CAN_TraceUser                                 /*!< Data: free, from CAN_Trace_Record(). */
+}CAN_TraceEvent;
+
+/* 8 bytes per record. */
+typedef struct
+{
+  uint32_t Time;                                /*!< Cycle counter, host clock in nanoseconds on the host model. */
+  uint8_t  Event;                               /*!< CAN_TraceEvent. */
+  uint8_t  Channel;                             /*!< 0 for CAN1, 1 for CAN2. */
+  uint16_t Data;
+}CAN_TraceRecord;
+
+/* The RAM image a dump holds, little endian. */
+typedef struct
+{
+  uint32_t          Magic;                      /*!< CAN_TRACE_MAGIC. */
+  uint16_t          Version;                    /*!< CAN_TRACE_VERSION. */
+  uint16_t          Size;                       /*!< CAN_TRACE_SIZE. */
+  uint32_t          Frequency;                  /*!< Time ticks per second. */
+  volatile uint32_t Index;                      /*!< Records reserved so far, the next goes to Index % Size. */
+  CAN_TraceRecord   Record[CAN_TRACE_SIZE];
+}CAN_TraceBuffer;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+#if CAN_TRACE_ENABLE
+void CAN_Trace_Init(void);
+void CAN_Trace_Start(void);
+void CAN_Trace_Stop(void);
+
+void CAN_Trace_Record(uint8_t Channel, CAN_TraceEvent Event, uint16_t Data);
+void CAN_Trace_CheckError(uint8_t Channel, uint32_t ESR);
+
+const CAN_TraceBuffer *CAN_Trace_GetBuffer(void);
+#endif /* CAN_TRACE_ENABLE */
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CANTRACE_H */
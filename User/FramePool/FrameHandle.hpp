@@ -0,0 +1,191 @@
+/**
+  ******************************************************************************
+  * @file    FrameHandle.hpp
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Move-only C++ handle over frame pool frames.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __FRAMEHANDLE_HPP
+#define __FRAMEHANDLE_HPP
+
+/* Header includes -----------------------------------------------------------*/
+#include "FramePool.h"
+#include "CAN.h"
+
+/* Macro definitions ---------------------------------------------------------*/
+/* Type definitions ----------------------------------------------------------*/
+
+/**
+  * @brief  Sole owner of a frame pool frame.
+  * @note   Cannot be copied, only moved, so a frame has exactly one owner while it travels
+  *         through queues, dispatch and gateway code. The frame returns to the pool when
+  *         the owning handle is destroyed or reset, or when the driver takes it for transmit.
+  *         Needs C++11 (--cpp11 for ARMCC).
+  */
+class FrameHandle
+{
+public:
+  FrameHandle() : frame(0) {}
+  explicit FrameHandle(CanRxMsg *Frame) : frame(Frame) {}
+  FrameHandle(FrameHandle &&Other) : frame(Other.release()) {}
+  ~FrameHandle() { FramePool_Free(frame); }
+
+  FrameHandle(const FrameHandle &) = delete;
+  FrameHandle &operator=(const FrameHandle &) = delete;
+
+  FrameHandle &operator=(FrameHandle &&Other)
+  {
+    reset(Other.release());
+    return *this;
+  }
+
+  /**
+    * @brief  Allocate an empty frame from the pool.
+    * @return The handle, empty if the pool is exhausted.
+    */
+  static FrameHandle allocate() { return FrameHandle(FramePool_Alloc()); }
+
+  /**
+    * @brief  Take the oldest received frame of a channel in receive frame mode.
+    * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+    * @return The handle, empty if nothing was received.
+    */
+  static FrameHandle receive(CAN_TypeDef *CANx) { return FrameHandle(CAN_GetReceiveFrame(CANx)); }
+
+  /**
+    * @brief  Hand the frame to the driver for transmit.
+    * @param  [in] CANx: Where x can be 1 or 2 to select the CAN peripheral.
+    * @retval true:      The driver owns the frame, the handle is empty.
+    * @retval false:     The frame queue is full or the handle is empty, the handle keeps the frame.
+    */
+  bool transmit(CAN_TypeDef *CANx)
+  {
+    if((frame != 0) && (CAN_SetTransmitFrame(CANx, frame) == true))
+    {
+      frame = 0;
+      return true;
+    }
+
+    return false;
+  }
+
+  CanRxMsg *get() const { return frame; }
+  CanRxMsg *operator->() const { return frame; }
+  CanRxMsg &operator*() const { return *frame; }
+  explicit operator bool() const { return frame != 0; }
+
+  /**
+    * @brief  Give up ownership without freeing the frame.
+    * @return The frame, the caller must free it.
+    */
+  CanRxMsg *release()
+  {
+    CanRxMsg *temp = frame;
+    frame = 0;
+    return temp;
+  }
+
+  void reset(CanRxMsg *Frame = 0)
+  {
+    if(frame != Frame)
+    {
+      FramePool_Free(frame);
+      frame = Frame;
+    }
+  }
+
+private:
+  CanRxMsg *frame;
+};
+
+/**
+  * @brief  Single producer, single consumer queue of frame handles.
+  * @note   Holds one byte frame indices, so pushing and popping moves ownership without
+  *         touching the payload. One side may run in an interrupt. Size must be a power of 2.
+  */
+template<uint32_t Size>
+class FrameQueue
+{
+  static_assert((Size != 0) && ((Size & (Size - 1)) == 0), "Size must be a power of 2");
+
+public:
+  FrameQueue() : in(0), out(0) {}
+  ~FrameQueue() { while(pop()) {} }
+
+  FrameQueue(const FrameQueue &) = delete;
+  FrameQueue &operator=(const FrameQueue &) = delete;
+
+  /**
+    * @brief  Move a frame into the queue.
+    * @param  [in] Handle: The frame, emptied on success.
+    * @retval true:        Queued.
+    * @retval false:       Queue full or handle empty, the handle keeps the frame.
+    */
+  bool push(FrameHandle &Handle)
+  {
+    if((Handle.get() == 0) || (in - out >= Size))
+    {
+      return false;
+    }
+
+    index[in & (Size - 1)] = FramePool_GetIndex(Handle.release());
+    __DMB();
+    in = in + 1;
+
+    return true;
+  }
+
+  /**
+    * @brief  Move the oldest frame out of the queue.
+    * @return The handle, empty if the queue is empty.
+    */
+  FrameHandle pop()
+  {
+    if(in == out)
+    {
+      return FrameHandle();
+    }
+
+    CanRxMsg *frame = FramePool_GetFrame(index[out & (Size - 1)]);
+    __DMB();
+    out = out + 1;
+
+    return FrameHandle(frame);
+  }
+
+  uint32_t size() const { return in - out; }
+  bool empty() const { return in == out; }
+
+private:
+  uint8_t           index[Size];
+  volatile uint32_t in;
+  volatile uint32_t out;
+};
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+/* Function definitions ------------------------------------------------------*/
+
+#endif /* __FRAMEHANDLE_HPP */
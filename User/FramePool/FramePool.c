@@ -0,0 +1,180 @@
+/**
+  ******************************************************************************
+  * @file    FramePool.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Fixed size lock-free pool of CAN frames.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+/* Header includes -----------------------------------------------------------*/
+#include "FramePool.h"
+#include <stddef.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define FRAME_POOL_NULL  (0xFF)
+
+/* Type definitions ----------------------------------------------------------*/
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+static CanRxMsg framePool[FRAME_POOL_SIZE];
+static uint8_t  framePoolNext[FRAME_POOL_SIZE];
+
+static volatile uint32_t framePoolHead      = FRAME_POOL_NULL;
+static volatile uint32_t framePoolFree      = 0;
+static volatile uint32_t framePoolAllocFail = 0;
+
+/* Function declarations -----------------------------------------------------*/
+static void atomic_add(volatile uint32_t *value, int32_t add);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Initialize the frame pool, all frames are free.
+  * @param  None.
+  * @return None.
+  * @note   Call before any frame is allocated.
+  */
+void FramePool_Init(void)
+{
+  for(uint32_t i = 0; i < FRAME_POOL_SIZE; i++)
+  {
+    framePoolNext[i] = (i + 1 < FRAME_POOL_SIZE) ? (i + 1) : FRAME_POOL_NULL;
+  }
+
+  framePoolHead      = 0;
+  framePoolFree      = FRAME_POOL_SIZE;
+  framePoolAllocFail = 0;
+}
+
+/**
+  * @brief  Allocate a frame from the pool.
+  * @param  None.
+  * @return The frame, NULL if the pool is empty.
+  * @note   Lock-free, safe from thread and interrupt. An interrupt between the exclusive
+  *         load and store clears the monitor, so a head popped and pushed back by the
+  *         interrupt cannot be mistaken for the one loaded.
+  */
+CanRxMsg *FramePool_Alloc(void)
+{
+  uint32_t head = 0;
+
+  do
+  {
+    head = __LDREXW(&framePoolHead);
+
+    if(head == FRAME_POOL_NULL)
+    {
+      __CLREX();
+      atomic_add(&framePoolAllocFail, 1);
+      return NULL;
+    }
+  }while(__STREXW(framePoolNext[head], &framePoolHead) != 0);
+
+  atomic_add(&framePoolFree, -1);
+
+  return &framePool[head];
+}
+
+/**
+  * @brief  Return a frame to the pool.
+  * @param  [in] Frame: The frame, NULL is ignored.
+  * @return None.
+  * @note   Lock-free, safe from thread and interrupt.
+  */
+void FramePool_Free(CanRxMsg *Frame)
+{
+  uint32_t index = 0;
+  uint32_t head  = 0;
+
+  if(Frame == NULL)
+  {
+    return;
+  }
+
+  index = FramePool_GetIndex(Frame);
+
+  do
+  {
+    head = __LDREXW(&framePoolHead);
+    framePoolNext[index] = head;
+  }while(__STREXW(index, &framePoolHead) != 0);
+
+  atomic_add(&framePoolFree, 1);
+}
+
+/**
+  * @brief  Get the index of a pool frame.
+  * @param  [in] Frame: The frame.
+  * @return The index, from 0 to FRAME_POOL_SIZE - 1.
+  * @note   Queues hold one byte indices instead of frames.
+  */
+uint8_t FramePool_GetIndex(const CanRxMsg *Frame)
+{
+  return Frame - framePool;
+}
+
+/**
+  * @brief  Get a pool frame from its index.
+  * @param  [in] Index: The index, from 0 to FRAME_POOL_SIZE - 1.
+  * @return The frame.
+  */
+CanRxMsg *FramePool_GetFrame(uint8_t Index)
+{
+  return &framePool[Index];
+}
+
+/**
+  * @brief  Get the number of free frames.
+  * @param  None.
+  * @return The number of free frames.
+  */
+uint32_t FramePool_GetFreeNumber(void)
+{
+  return framePoolFree;
+}
+
+/**
+  * @brief  Get the number of failed allocations.
+  * @param  None.
+  * @return The number of allocations that found the pool empty.
+  */
+uint32_t FramePool_GetAllocFailNumber(void)
+{
+  return framePoolAllocFail;
+}
+
+/**
+  * @brief  Atomically add to a counter.
+  * @param  [in] value: The counter.
+  * @param  [in] add:   The value to add.
+  * @return None.
+  */
+static void atomic_add(volatile uint32_t *value, int32_t add)
+{
+  uint32_t temp = 0;
+
+  do
+  {
+    temp = __LDREXW(value) + add;
+  }while(__STREXW(temp, value) != 0);
+}
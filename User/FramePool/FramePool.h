@@ -0,0 +1,65 @@
+/**
+  ******************************************************************************
+  * @file    FramePool.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for FramePool.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __FRAMEPOOL_H
+#define __FRAMEPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "stm32f10x.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define FRAME_POOL_SIZE  (32)  /* Frames in the pool, up to 255. */
+
+/* Type definitions ----------------------------------------------------------*/
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+void FramePool_Init(void);
+
+CanRxMsg *FramePool_Alloc(void);
+void FramePool_Free(CanRxMsg *Frame);
+
+uint8_t FramePool_GetIndex(const CanRxMsg *Frame);
+CanRxMsg *FramePool_GetFrame(uint8_t Index);
+
+uint32_t FramePool_GetFreeNumber(void);
+uint32_t FramePool_GetAllocFailNumber(void);
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FRAMEPOOL_H */
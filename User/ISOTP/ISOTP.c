@@ -0,0 +1,820 @@
+/**
+  ******************************************************************************
+  * @file    ISOTP.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   ISO 15765-2 transport layer module source file.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+/* Header includes -----------------------------------------------------------*/
+#include "ISOTP.h"
+#include <string.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define ISOTP_PCI_SF  (0x0)
+#define ISOTP_PCI_FF  (0x1)
+#define ISOTP_PCI_CF  (0x2)
+#define ISOTP_PCI_FC  (0x3)
+
+#define ISOTP_FS_CTS    (0x0)
+#define ISOTP_FS_WAIT   (0x1)
+#define ISOTP_FS_OVFLW  (0x2)
+
+#define ISOTP_TICKS(ms)  (((ms) + ISOTP_TICK_PERIOD - 1) / ISOTP_TICK_PERIOD)
+
+#define min(a, b)  (((a) < (b)) ? (a) : (b))
+
+/* Type definitions ----------------------------------------------------------*/
+typedef enum
+{
+  ISOTP_StateIdle = 0,
+  ISOTP_StateWaitFlowControl,
+  ISOTP_StateConsecutive,
+  ISOTP_StateWaitBuffer,
+  ISOTP_StateHoldSingle
+}ISOTP_State;
+
+typedef struct
+{
+  ISOTP_Config     Config;
+  bool             Open;
+  
+  volatile uint8_t TxState;
+  const uint8_t   *TxData;
+  uint32_t         TxLength;
+  uint32_t         TxOffset;
+  uint32_t         TxTimer;
+  uint32_t         TxSTmin;
+  uint32_t         TxStart;
+  uint8_t          TxSn;
+  uint8_t          TxBlockSize;
+  uint8_t          TxBlockCount;
+  uint8_t          TxWaitCount;
+  
+  volatile uint8_t RxState;
+  uint32_t         RxLength;
+  uint32_t         RxOffset;
+  uint32_t         RxTimer;
+  uint32_t         RxStart;
+  uint8_t          RxSn;
+  uint8_t          RxBlockCount;
+  uint8_t          RxWaitCount;
+  uint8_t          RxHold[7];
+  uint8_t          RxHoldLength;
+  
+  ISOTP_Statistics Statistics;
+}ISOTP_Session;
+
+/* Variable declarations -----------------------------------------------------*/
+static ISOTP_Session     isotpSession[ISOTP_SESSION_NUMBER] = {0};
+static volatile uint32_t isotpTick                          = 0;
+
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+static bool isotp_send(ISOTP_Session *session, const uint8_t *data, uint32_t length);
+static bool isotp_send_flow_control(ISOTP_Session *session, uint8_t status);
+static void isotp_send_consecutive(ISOTP_Session *session);
+static void isotp_transmit_finish(uint32_t index, ISOTP_Result result);
+static void isotp_receive_finish(uint32_t index, ISOTP_Result result);
+static void isotp_receive_start(uint32_t index);
+static uint32_t isotp_stmin_to_ticks(uint8_t stmin);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Open an ISO-TP session.
+  * @param  [in] Session: Session number, from 0 to ISOTP_SESSION_NUMBER - 1.
+  * @param  [in] Config:  Session configuration.
+  * @retval true:         The session is open.
+  * @retval false:        Invalid session number or session already open.
+  * @note   The received frames reach the session through ISOTP_Input(), for
+  *         example by CAN_SetReceiveMessageCallback(CANx, ISOTP_Input).
+  *         Consecutive frames are pumped by ISOTP_Process(), for example by
+  *         CAN_SetTransmitFinishCallback(CANx, ISOTP_Process), and by
+  *         ISOTP_Tick() when the receiver asks for a separation time.
+  */
+bool ISOTP_Open(uint32_t Session, const ISOTP_Config *Config)
+{
+  if((Session >= ISOTP_SESSION_NUMBER) || (isotpSession[Session].Open == true))
+  {
+    return false;
+  }
+  
+  ISOTP_Session *session = &isotpSession[Session];
+  
+  memset(session, 0, sizeof(ISOTP_Session));
+  session->Config = *Config;
+  session->Open   = true;
+  
+  return true;
+}
+
+/**
+  * @brief  Close an ISO-TP session.
+  * @param  [in] Session: Session number.
+  * @return None.
+  * @note   Transfers in progress are dropped without callback.
+  */
+void ISOTP_Close(uint32_t Session)
+{
+  if(Session < ISOTP_SESSION_NUMBER)
+  {
+    isotpSession[Session].Open    = false;
+    isotpSession[Session].TxState = ISOTP_StateIdle;
+    isotpSession[Session].RxState = ISOTP_StateIdle;
+  }
+}
+
+/**
+  * @brief  Transmit a message.
+  * @param  [in] Session: Session number.
+  * @param  [in] Data:    The message, it must stay valid until the transmit
+  *                       finish callback is called.
+  * @param  [in] Length:  The length of the message, from 1 to 0xFFFFFFFF.
+  * @retval true:         The transmission has started.
+  * @retval false:        The session is busy or the transmit buffer is full.
+  * @note   The message is segmented straight from @Data, it is not copied.
+  */
+bool ISOTP_Transmit(uint32_t Session, const uint8_t *Data, uint32_t Length)
+{
+  if((Session >= ISOTP_SESSION_NUMBER) || (isotpSession[Session].Open != true) || (Length == 0))
+  {
+    return false;
+  }
+  
+  ISOTP_Session *session = &isotpSession[Session];
+  uint8_t        frame[8] = {0};
+  
+  if(session->TxState != ISOTP_StateIdle)
+  {
+    return false;
+  }
+  
+  if(Length <= 7)
+  {
+    frame[0] = (ISOTP_PCI_SF << 4) | Length;
+    memcpy(&frame[1], Data, Length);
+    
+    if(isotp_send(session, frame, Length + 1) != true)
+    {
+      return false;
+    }
+    
+    session->TxLength = Length;
+    session->TxStart  = isotpTick;
+    isotp_transmit_finish(Session, ISOTP_ResultOk);
+    
+    return true;
+  }
+  
+  session->TxData       = Data;
+  session->TxLength     = Length;
+  session->TxSn         = 1;
+  session->TxWaitCount  = 0;
+  session->TxTimer      = ISOTP_TICKS(ISOTP_TIMEOUT_BS);
+  session->TxStart      = isotpTick;
+  
+  if(Length <= 0xFFF)
+  {
+    frame[0] = (ISOTP_PCI_FF << 4) | (Length >> 8);
+    frame[1] = Length;
+    memcpy(&frame[2], Data, 6);
+    session->TxOffset = 6;
+  }
+  else
+  {
+    frame[0] = ISOTP_PCI_FF << 4;
+    frame[1] = 0;
+    frame[2] = Length >> 24;
+    frame[3] = Length >> 16;
+    frame[4] = Length >> 8;
+    frame[5] = Length;
+    memcpy(&frame[6], Data, 2);
+    session->TxOffset = 2;
+  }
+  
+  /* The state is set first, the flow control may arrive before the call returns. */
+  session->TxState = ISOTP_StateWaitFlowControl;
+  
+  if(isotp_send(session, frame, 8) != true)
+  {
+    session->TxState = ISOTP_StateIdle;
+    return false;
+  }
+  
+  return true;
+}
+
+/**
+  * @brief  Is the session transmitting?
+  * @param  [in] Session: Session number.
+  * @retval true:         A transmission is in progress.
+  * @retval false:        No transmission is in progress.
+  */
+bool ISOTP_IsTransmitBusy(uint32_t Session)
+{
+  if(Session < ISOTP_SESSION_NUMBER)
+  {
+    return isotpSession[Session].TxState != ISOTP_StateIdle;
+  }
+  
+  return false;
+}
+
+/**
+  * @brief  Is the session receiving?
+  * @param  [in] Session: Session number.
+  * @retval true:         A reception is in progress.
+  * @retval false:        No reception is in progress.
+  */
+bool ISOTP_IsReceiveBusy(uint32_t Session)
+{
+  if(Session < ISOTP_SESSION_NUMBER)
+  {
+    return isotpSession[Session].RxState != ISOTP_StateIdle;
+  }
+  
+  return false;
+}
+
+/**
+  * @brief  Set the receive buffer of a session.
+  * @param  [in] Session: Session number.
+  * @param  [in] Buffer:  The buffer, 0 when no buffer is available.
+  * @param  [in] Size:    The size of the buffer.
+  * @retval true:         The buffer is set.
+  * @retval false:        A reception is in progress into the current buffer.
+  * @note   It may be called from the receive finish callback to swap buffers.
+  *         While no buffer is set, first frames are answered by flow control
+  *         wait frames, and the reception resumes when a buffer is set. A
+  *         single frame is held meanwhile and delivered to the new buffer,
+  *         the receive finish callback is then called from here.
+  */
+bool ISOTP_SetReceiveBuffer(uint32_t Session, uint8_t *Buffer, uint32_t Size)
+{
+  if((Session >= ISOTP_SESSION_NUMBER) || (isotpSession[Session].Open != true))
+  {
+    return false;
+  }
+  
+  ISOTP_Session *session = &isotpSession[Session];
+  
+  if(session->RxState == ISOTP_StateConsecutive)
+  {
+    return false;
+  }
+  
+  session->Config.RxBuffer     = Buffer;
+  session->Config.RxBufferSize = Size;
+  
+  if((session->RxState == ISOTP_StateWaitBuffer) && (Buffer != 0))
+  {
+    isotp_receive_start(Session);
+  }
+  else if((session->RxState == ISOTP_StateHoldSingle) && (Buffer != 0))
+  {
+    if(session->RxHoldLength > Size)
+    {
+      isotp_receive_finish(Session, ISOTP_ResultOverflow);
+    }
+    else
+    {
+      memcpy(Buffer, session->RxHold, session->RxHoldLength);
+      isotp_receive_finish(Session, ISOTP_ResultOk);
+    }
+  }
+  
+  return true;
+}
+
+/**
+  * @brief  Feed a received frame to the ISO-TP sessions.
+  * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Message: The received frame.
+  * @retval true:         The frame belongs to a session and is consumed.
+  * @retval false:        The frame does not belong to any session.
+  */
+bool ISOTP_Input(CAN_TypeDef *CANx, const CanRxMsg *Message)
+{
+  uint32_t id = (Message->IDE == CAN_Id_Standard) ? Message->StdId : Message->ExtId;
+  
+  for(uint32_t i = 0; i < ISOTP_SESSION_NUMBER; i++)
+  {
+    ISOTP_Session *session = &isotpSession[i];
+    
+    if((session->Open != true) || (session->Config.CANx != CANx) ||
+       (session->Config.IDE != Message->IDE) || (session->Config.RxId != id))
+    {
+      continue;
+    }
+    
+    if((Message->RTR != CAN_RTR_Data) || (Message->DLC == 0))
+    {
+      return true;
+    }
+    
+    const uint8_t *data = Message->Data;
+    
+    switch(data[0] >> 4)
+    {
+      case ISOTP_PCI_SF:
+      {
+        uint32_t length = data[0] & 0x0F;
+        
+        if((length == 0) || (length > (uint32_t)(Message->DLC - 1)))
+        {
+          break;
+        }
+        
+        if(session->RxState != ISOTP_StateIdle)
+        {
+          isotp_receive_finish(i, ISOTP_ResultUnexpectedPdu);
+        }
+        
+        session->RxLength = length;
+        session->RxStart  = isotpTick;
+        
+        if(session->Config.RxBuffer == 0)
+        {
+          /* Held until a buffer is set, a single frame has no flow control to pause the sender. */
+          session->RxHoldLength = length;
+          session->RxState      = ISOTP_StateHoldSingle;
+          memcpy(session->RxHold, &data[1], length);
+        }
+        else if(length <= session->Config.RxBufferSize)
+        {
+          memcpy(session->Config.RxBuffer, &data[1], length);
+          isotp_receive_finish(i, ISOTP_ResultOk);
+        }
+        else
+        {
+          isotp_receive_finish(i, ISOTP_ResultOverflow);
+        }
+        break;
+      }
+      case ISOTP_PCI_FF:
+      {
+        uint32_t length = ((data[0] & 0x0F) << 8) | data[1];
+        uint32_t offset = 2;
+        
+        if(Message->DLC != 8)
+        {
+          break;
+        }
+        
+        if(length == 0)
+        {
+          length = ((uint32_t)data[2] << 24) | ((uint32_t)data[3] << 16) | ((uint32_t)data[4] << 8) | data[5];
+          offset = 6;
+        }
+        
+        if(length < 8)
+        {
+          break;
+        }
+        
+        if(session->RxState != ISOTP_StateIdle)
+        {
+          isotp_receive_finish(i, ISOTP_ResultUnexpectedPdu);
+        }
+        
+        session->RxLength     = length;
+        session->RxHoldLength = 8 - offset;
+        session->RxWaitCount  = 0;
+        session->RxStart      = isotpTick;
+        memcpy(session->RxHold, &data[offset], session->RxHoldLength);
+        
+        if(session->Config.RxBuffer != 0)
+        {
+          isotp_receive_start(i);
+        }
+        else
+        {
+          session->RxState = ISOTP_StateWaitBuffer;
+          session->RxTimer = ISOTP_TICKS(ISOTP_TIMEOUT_BR);
+          isotp_send_flow_control(session, ISOTP_FS_WAIT);
+        }
+        break;
+      }
+      case ISOTP_PCI_CF:
+      {
+        if(session->RxState != ISOTP_StateConsecutive)
+        {
+          break;
+        }
+        
+        if((data[0] & 0x0F) != session->RxSn)
+        {
+          isotp_receive_finish(i, ISOTP_ResultWrongSn);
+          break;
+        }
+        
+        uint32_t length = min(session->RxLength - session->RxOffset, 7);
+        
+        if(length > (uint32_t)(Message->DLC - 1))
+        {
+          break;
+        }
+        
+        memcpy(session->Config.RxBuffer + session->RxOffset, &data[1], length);
+        session->RxOffset += length;
+        session->RxSn      = (session->RxSn + 1) & 0x0F;
+        session->RxTimer   = ISOTP_TICKS(ISOTP_TIMEOUT_CR);
+        
+        if(session->RxOffset >= session->RxLength)
+        {
+          isotp_receive_finish(i, ISOTP_ResultOk);
+        }
+        else if((session->Config.BlockSize != 0) && (--session->RxBlockCount == 0))
+        {
+          session->RxBlockCount = session->Config.BlockSize;
+          isotp_send_flow_control(session, ISOTP_FS_CTS);
+        }
+        break;
+      }
+      case ISOTP_PCI_FC:
+      {
+        if((session->TxState != ISOTP_StateWaitFlowControl) || (Message->DLC < 3))
+        {
+          break;
+        }
+        
+        switch(data[0] & 0x0F)
+        {
+          case ISOTP_FS_CTS:
+            session->TxBlockSize  = data[1];
+            session->TxBlockCount = data[1];
+            session->TxSTmin      = isotp_stmin_to_ticks(data[2]);
+            session->TxWaitCount  = 0;
+            session->TxTimer      = 0;
+            session->TxState      = ISOTP_StateConsecutive;
+            isotp_send_consecutive(session);
+            break;
+          case ISOTP_FS_WAIT:
+            session->Statistics.FlowControlWait++;
+            
+            if(++session->TxWaitCount > ISOTP_WAIT_MAX)
+            {
+              isotp_transmit_finish(i, ISOTP_ResultWaitOverrun);
+            }
+            else
+            {
+              session->TxTimer = ISOTP_TICKS(ISOTP_TIMEOUT_BS);
+            }
+            break;
+          case ISOTP_FS_OVFLW:
+            isotp_transmit_finish(i, ISOTP_ResultOverflow);
+            break;
+          default:
+            isotp_transmit_finish(i, ISOTP_ResultUnexpectedPdu);
+            break;
+        }
+        break;
+      }
+      default:
+        break;
+    }
+    
+    return true;
+  }
+  
+  return false;
+}
+
+/**
+  * @brief  Pump the consecutive frames of all sessions.
+  * @param  None.
+  * @return None.
+  * @note   Meant as the CAN transmit finish callback: the transmit buffer is
+  *         refilled as soon as it runs empty, keeping the bus busy.
+  */
+void ISOTP_Process(void)
+{
+  for(uint32_t i = 0; i < ISOTP_SESSION_NUMBER; i++)
+  {
+    if((isotpSession[i].TxState == ISOTP_StateConsecutive) && (isotpSession[i].TxTimer == 0))
+    {
+      isotp_send_consecutive(&isotpSession[i]);
+    }
+  }
+}
+
+/**
+  * @brief  ISO-TP time base, to be called every ISOTP_TICK_PERIOD milliseconds.
+  * @param  None.
+  * @return None.
+  * @note   It must not preempt, or be preempted by, the CAN interrupts.
+  */
+void ISOTP_Tick(void)
+{
+  isotpTick++;
+  
+  for(uint32_t i = 0; i < ISOTP_SESSION_NUMBER; i++)
+  {
+    ISOTP_Session *session = &isotpSession[i];
+    
+    if(session->Open != true)
+    {
+      continue;
+    }
+    
+    if(session->TxState == ISOTP_StateWaitFlowControl)
+    {
+      if(--session->TxTimer == 0)
+      {
+        isotp_transmit_finish(i, ISOTP_ResultTimeoutBs);
+      }
+    }
+    else if(session->TxState == ISOTP_StateConsecutive)
+    {
+      if((session->TxTimer == 0) || (--session->TxTimer == 0))
+      {
+        isotp_send_consecutive(session);
+      }
+    }
+    
+    if(session->RxState == ISOTP_StateConsecutive)
+    {
+      if(--session->RxTimer == 0)
+      {
+        isotp_receive_finish(i, ISOTP_ResultTimeoutCr);
+      }
+    }
+    else if(session->RxState == ISOTP_StateWaitBuffer)
+    {
+      if(--session->RxTimer == 0)
+      {
+        if(++session->RxWaitCount > ISOTP_WAIT_MAX)
+        {
+          isotp_receive_finish(i, ISOTP_ResultWaitOverrun);
+        }
+        else
+        {
+          session->RxTimer = ISOTP_TICKS(ISOTP_TIMEOUT_BR);
+          isotp_send_flow_control(session, ISOTP_FS_WAIT);
+        }
+      }
+    }
+  }
+}
+
+/**
+  * @brief  Get the statistics of a session.
+  * @param  [in] Session:    Session number.
+  * @param  [in] Statistics: To store the statistics.
+  * @return None.
+  */
+void ISOTP_GetStatistics(uint32_t Session, ISOTP_Statistics *Statistics)
+{
+  if(Session < ISOTP_SESSION_NUMBER)
+  {
+    *Statistics = isotpSession[Session].Statistics;
+  }
+}
+
+/**
+  * @brief  Get the throughput of a transfer.
+  * @param  [in] Length: The payload of the transfer, in bytes.
+  * @param  [in] Time:   The duration of the transfer, in milliseconds.
+  * @return The throughput in byte/s, 0 if the duration is too short to tell.
+  */
+uint32_t ISOTP_GetThroughput(uint32_t Length, uint32_t Time)
+{
+  if(Time == 0)
+  {
+    return 0;
+  }
+  
+  return (uint32_t)(((uint64_t)Length * 1000) / Time);
+}
+
+/**
+  * @brief  Get the theoretical ISO-TP throughput limit of the bus.
+  * @param  [in] BaudRate: Communication baud rate.
+  * @param  [in] IDE:      CAN_Id_Standard or CAN_Id_Extended.
+  * @return The payload throughput in byte/s.
+  * @note   The limit is 7 bytes per 8-byte consecutive frame sent back to
+  *         back without bit stuffing: 111 bits per frame with a standard
+  *         identifier, 131 bits with an extended one, interframe space
+  *         included. Flow control frames are neglected.
+  */
+uint32_t ISOTP_GetThroughputLimit(CAN_BaudRate BaudRate, uint32_t IDE)
+{
+  uint32_t bits = (IDE == CAN_Id_Standard) ? 111 : 131;
+  
+  return (CAN_GetBitRate(BaudRate) * 7) / bits;
+}
+
+/**
+  * @brief  Send a frame of a session.
+  * @param  [in] session: The session.
+  * @param  [in] data:    The frame data.
+  * @param  [in] length:  The frame length.
+  * @retval true:         The frame is queued.
+  * @retval false:        The transmit buffer is full.
+  */
+static bool isotp_send(ISOTP_Session *session, const uint8_t *data, uint32_t length)
+{
+  CanTxMsg canTxMsg = {0};
+  
+  canTxMsg.StdId = session->Config.TxId;
+  canTxMsg.ExtId = session->Config.TxId;
+  canTxMsg.IDE   = session->Config.IDE;
+  canTxMsg.RTR   = CAN_RTR_Data;
+  canTxMsg.DLC   = length;
+  memcpy(canTxMsg.Data, data, length);
+  
+#if ISOTP_FRAME_PADDING
+  memset(&canTxMsg.Data[length], ISOTP_PADDING_BYTE, 8 - length);
+  canTxMsg.DLC = 8;
+#endif
+  
+  return CAN_SetTransmitMessage(session->Config.CANx, &canTxMsg, 1) == 1;
+}
+
+/**
+  * @brief  Send a flow control frame.
+  * @param  [in] session: The session.
+  * @param  [in] status:  Flow status.
+  * @retval true:         The frame is queued.
+  * @retval false:        The transmit buffer is full.
+  */
+static bool isotp_send_flow_control(ISOTP_Session *session, uint8_t status)
+{
+  uint8_t frame[3] = {(ISOTP_PCI_FC << 4) | status, session->Config.BlockSize, session->Config.STmin};
+  
+  return isotp_send(session, frame, sizeof(frame));
+}
+
+/**
+  * @brief  Send the consecutive frames allowed right now.
+  * @param  [in] session: The session.
+  * @return None.
+  * @note   Without separation time the transmit buffer is filled up to the
+  *         block size, otherwise one frame is sent per separation time.
+  */
+static void isotp_send_consecutive(ISOTP_Session *session)
+{
+  uint8_t frame[8] = {0};
+  
+  while(session->TxState == ISOTP_StateConsecutive)
+  {
+    uint32_t length = min(session->TxLength - session->TxOffset, 7);
+    
+    frame[0] = (ISOTP_PCI_CF << 4) | session->TxSn;
+    memcpy(&frame[1], session->TxData + session->TxOffset, length);
+    
+    if(isotp_send(session, frame, length + 1) != true)
+    {
+      return;
+    }
+    
+    session->TxOffset += length;
+    session->TxSn      = (session->TxSn + 1) & 0x0F;
+    
+    if(session->TxOffset >= session->TxLength)
+    {
+      isotp_transmit_finish(session - isotpSession, ISOTP_ResultOk);
+      return;
+    }
+    
+    if((session->TxBlockSize != 0) && (--session->TxBlockCount == 0))
+    {
+      session->TxTimer = ISOTP_TICKS(ISOTP_TIMEOUT_BS);
+      session->TxState = ISOTP_StateWaitFlowControl;
+      return;
+    }
+    
+    if(session->TxSTmin != 0)
+    {
+      /* The frame may have gone out late in the current tick, one more keeps the gap at STmin. */
+      session->TxTimer = session->TxSTmin + 1;
+      return;
+    }
+  }
+}
+
+/**
+  * @brief  End the transmission of a session.
+  * @param  [in] index:  Session number.
+  * @param  [in] result: The result.
+  * @return None.
+  */
+static void isotp_transmit_finish(uint32_t index, ISOTP_Result result)
+{
+  ISOTP_Session *session = &isotpSession[index];
+  
+  session->TxState = ISOTP_StateIdle;
+  
+  if(result == ISOTP_ResultOk)
+  {
+    session->Statistics.TransmitLength = session->TxLength;
+    session->Statistics.TransmitTime   = (isotpTick - session->TxStart) * ISOTP_TICK_PERIOD;
+  }
+  else
+  {
+    session->Statistics.Error++;
+  }
+  
+  if(session->Config.TransmitFinishCallback != 0)
+  {
+    session->Config.TransmitFinishCallback(index, result);
+  }
+}
+
+/**
+  * @brief  End the reception of a session.
+  * @param  [in] index:  Session number.
+  * @param  [in] result: The result.
+  * @return None.
+  */
+static void isotp_receive_finish(uint32_t index, ISOTP_Result result)
+{
+  ISOTP_Session *session = &isotpSession[index];
+  
+  session->RxState = ISOTP_StateIdle;
+  
+  if(result == ISOTP_ResultOk)
+  {
+    session->Statistics.ReceiveLength = session->RxLength;
+    session->Statistics.ReceiveTime   = (isotpTick - session->RxStart) * ISOTP_TICK_PERIOD;
+  }
+  else
+  {
+    session->Statistics.Error++;
+  }
+  
+  if(session->Config.ReceiveFinishCallback != 0)
+  {
+    session->Config.ReceiveFinishCallback(index, session->Config.RxBuffer, (result == ISOTP_ResultOk) ? session->RxLength : 0, result);
+  }
+}
+
+/**
+  * @brief  Start reassembling a segmented message into the receive buffer.
+  * @param  [in] index: Session number.
+  * @return None.
+  */
+static void isotp_receive_start(uint32_t index)
+{
+  ISOTP_Session *session = &isotpSession[index];
+  
+  if(session->RxLength > session->Config.RxBufferSize)
+  {
+    session->RxState = ISOTP_StateIdle;
+    session->Statistics.Error++;
+    isotp_send_flow_control(session, ISOTP_FS_OVFLW);
+    return;
+  }
+  
+  memcpy(session->Config.RxBuffer, session->RxHold, session->RxHoldLength);
+  session->RxOffset     = session->RxHoldLength;
+  session->RxSn         = 1;
+  session->RxBlockCount = session->Config.BlockSize;
+  session->RxTimer      = ISOTP_TICKS(ISOTP_TIMEOUT_CR);
+  session->RxState      = ISOTP_StateConsecutive;
+  isotp_send_flow_control(session, ISOTP_FS_CTS);
+}
+
+/**
+  * @brief  Convert a separation time to ticks.
+  * @param  [in] stmin: Separation time as coded in the flow control frame.
+  * @return The number of ticks, rounded up.
+  * @note   0xF1 to 0xF9 (100 to 900 us) take one tick, reserved values are
+  *         taken as 127 ms as required by ISO 15765-2. The consecutive frames
+  *         wait one tick more, so the gap is between STmin and STmin + 1 tick.
+  */
+static uint32_t isotp_stmin_to_ticks(uint8_t stmin)
+{
+  if(stmin <= 0x7F)
+  {
+    return ISOTP_TICKS(stmin);
+  }
+  
+  if((stmin >= 0xF1) && (stmin <= 0xF9))
+  {
+    return 1;
+  }
+  
+  return ISOTP_TICKS(0x7F);
+}
@@ -0,0 +1,116 @@
+/**
+  ******************************************************************************
+  * @file    ISOTP.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for ISOTP.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __ISOTP_H
+#define __ISOTP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "CAN.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define ISOTP_SESSION_NUMBER  (4)
+
+#define ISOTP_TICK_PERIOD     (1)     /* Milliseconds between ISOTP_Tick() calls. */
+#define ISOTP_TIMEOUT_BS      (1000)  /* N_Bs: Wait for flow control, in milliseconds. */
+#define ISOTP_TIMEOUT_CR      (1000)  /* N_Cr: Wait for consecutive frame, in milliseconds. */
+#define ISOTP_TIMEOUT_BR      (500)   /* N_Br: Interval of flow control wait frames, in milliseconds. */
+#define ISOTP_WAIT_MAX        (16)    /* Maximum number of flow control wait frames in a row. */
+
+#define ISOTP_FRAME_PADDING   (1)     /* Pad every frame to 8 bytes. */
+#define ISOTP_PADDING_BYTE    (0xCC)
+
+/* Type definitions ----------------------------------------------------------*/
+typedef enum
+{
+  ISOTP_ResultOk = 0,
+  ISOTP_ResultTimeoutBs,
+  ISOTP_ResultTimeoutCr,
+  ISOTP_ResultWrongSn,
+  ISOTP_ResultOverflow,
+  ISOTP_ResultWaitOverrun,
+  ISOTP_ResultUnexpectedPdu
+}ISOTP_Result;
+
+typedef struct
+{
+  CAN_TypeDef *CANx;          /*!< CAN peripheral used by the session. */
+  uint32_t     IDE;           /*!< CAN_Id_Standard or CAN_Id_Extended. */
+  uint32_t     TxId;          /*!< Identifier of the frames sent. */
+  uint32_t     RxId;          /*!< Identifier of the frames received. */
+  uint8_t      BlockSize;     /*!< Block size announced when receiving, 0 for no limit. */
+  uint8_t      STmin;         /*!< Separation time announced when receiving. */
+  uint8_t     *RxBuffer;      /*!< Buffer the received messages are reassembled in. */
+  uint32_t     RxBufferSize;  /*!< Size of the receive buffer. */
+
+  void (*TransmitFinishCallback)(uint32_t Session, ISOTP_Result Result);
+  void (*ReceiveFinishCallback)(uint32_t Session, const uint8_t *Data, uint32_t Length, ISOTP_Result Result);
+}ISOTP_Config;
+
+typedef struct
+{
+  uint32_t TransmitLength;    /*!< Payload of the last completed transmission, in bytes. */
+  uint32_t TransmitTime;      /*!< Duration of the last completed transmission, in milliseconds. */
+  uint32_t ReceiveLength;     /*!< Payload of the last completed reception, in bytes. */
+  uint32_t ReceiveTime;       /*!< Duration of the last completed reception, in milliseconds. */
+  uint32_t FlowControlWait;   /*!< Flow control wait frames received. */
+  uint32_t Error;             /*!< Transfers ended with an error. */
+}ISOTP_Statistics;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+bool ISOTP_Open(uint32_t Session, const ISOTP_Config *Config);
+void ISOTP_Close(uint32_t Session);
+
+bool ISOTP_Transmit(uint32_t Session, const uint8_t *Data, uint32_t Length);
+bool ISOTP_IsTransmitBusy(uint32_t Session);
+bool ISOTP_IsReceiveBusy(uint32_t Session);
+
+bool ISOTP_SetReceiveBuffer(uint32_t Session, uint8_t *Buffer, uint32_t Size);
+
+bool ISOTP_Input(CAN_TypeDef *CANx, const CanRxMsg *Message);
+void ISOTP_Process(void);
+void ISOTP_Tick(void);
+
+void ISOTP_GetStatistics(uint32_t Session, ISOTP_Statistics *Statistics);
+uint32_t ISOTP_GetThroughput(uint32_t Length, uint32_t Time);
+uint32_t ISOTP_GetThroughputLimit(CAN_BaudRate BaudRate, uint32_t IDE);
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ISOTP_H */
@@ -0,0 +1,916 @@
+/**
+  ******************************************************************************
+  * @file    J1939.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   SAE J1939 network and transport layer module source file.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+/* Header includes -----------------------------------------------------------*/
+#include "J1939.h"
+#include <string.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define J1939_TP_RTS    (16)
+#define J1939_TP_CTS    (17)
+#define J1939_TP_EOMA   (19)
+#define J1939_TP_BAM    (32)
+#define J1939_TP_ABORT  (255)
+
+#define J1939_ABORT_BUSY       (1)
+#define J1939_ABORT_RESOURCES  (2)
+#define J1939_ABORT_TIMEOUT    (3)
+#define J1939_ABORT_SEQUENCE   (7)
+
+/* Timeouts of J1939-21, in milliseconds. */
+#define J1939_TIMEOUT_TR  (200)
+#define J1939_TIMEOUT_T1  (750)
+#define J1939_TIMEOUT_T2  (1250)
+#define J1939_TIMEOUT_T3  (1250)
+#define J1939_TIMEOUT_T4  (1050)
+#define J1939_TIMEOUT_AC  (250)
+
+#define J1939_TICKS(ms)  (((ms) + J1939_TICK_PERIOD - 1) / J1939_TICK_PERIOD)
+
+#define min(a, b)  (((a) < (b)) ? (a) : (b))
+
+/* Type definitions ----------------------------------------------------------*/
+typedef enum
+{
+  J1939_StateIdle = 0,
+  J1939_StateBroadcast,
+  J1939_StateWaitCTS,
+  J1939_StateSendData,
+  J1939_StateWaitEoMA,
+  J1939_StateReceive
+}J1939_State;
+
+typedef enum
+{
+  J1939_ClaimIdle = 0,
+  J1939_ClaimWait,
+  J1939_ClaimDone,
+  J1939_ClaimFailed
+}J1939_Claim;
+
+typedef struct
+{
+  volatile uint8_t State;
+  uint8_t          Peer;       /*!< Source address when receiving, destination address when transmitting. */
+  uint8_t          Broadcast;  /*!< BAM session. */
+  uint8_t          Priority;
+  uint16_t         Packets;
+  uint16_t         Sequence;   /*!< Next packet, 256 once the last of 255 packets is done. */
+  uint16_t         WindowEnd;  /*!< Last packet of the current CTS window. */
+  uint32_t         PGN;
+  uint32_t         Length;
+  uint32_t         Timer;
+  uint32_t         Start;
+  const uint8_t   *TxData;
+  uint8_t         *RxData;
+}J1939_Session;
+
+/* Variable declarations -----------------------------------------------------*/
+static J1939_Config      j1939Config     = {0};
+static volatile uint8_t  j1939Address    = J1939_ADDRESS_NULL;
+static volatile uint8_t  j1939Claim      = J1939_ClaimIdle;
+static uint32_t          j1939ClaimTimer = 0;
+static uint8_t           j1939ClaimFirst = J1939_ADDRESS_NULL;  /*!< First address tried in the self-configurable range. */
+
+static J1939_Session     j1939TxSession[J1939_TX_SESSION_NUMBER] = {0};
+static J1939_Session     j1939RxSession[J1939_RX_SESSION_NUMBER] = {0};
+static uint8_t           j1939RxBuffer[J1939_RX_SESSION_NUMBER][J1939_MESSAGE_SIZE_MAX];
+
+static uint32_t          j1939Pgn[J1939_PGN_FILTER_NUMBER] = {0};
+static uint32_t          j1939PgnNumber                    = 0;
+
+static J1939_Statistics  j1939Statistics = {0};
+static volatile uint32_t j1939Tick       = 0;
+
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+static bool j1939_send(uint8_t priority, uint32_t pgn, uint8_t da, const uint8_t *data, uint32_t length);
+static bool j1939_send_cm(uint8_t da, uint8_t control, uint8_t b1, uint8_t b2, uint8_t b3, uint8_t b4, uint32_t pgn);
+static bool j1939_send_claim(void);
+static bool j1939_update_filter(void);
+static void j1939_input_claim(uint8_t sa, const uint8_t *data);
+static void j1939_input_cm(uint8_t sa, uint8_t da, const uint8_t *data);
+static void j1939_input_dt(uint8_t sa, uint8_t da, const uint8_t *data);
+static void j1939_send_data(J1939_Session *session);
+static void j1939_transmit_finish(J1939_Session *session, J1939_Result result);
+static void j1939_receive_finish(J1939_Session *session, J1939_Result result);
+static J1939_Session *j1939_find_rx(uint8_t sa, bool broadcast);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Initialize the J1939 layer and start claiming the address.
+  * @param  [in] Config: Configuration.
+  * @retval true:        The address claim has been sent.
+  * @retval false:       The address claim could not be sent.
+  * @note   The received frames reach the layer through J1939_Input(), for
+  *         example by CAN_SetReceiveMessageCallback(CANx, J1939_Input), and
+  *         data packets are pumped by J1939_Process(), for example by
+  *         CAN_SetTransmitFinishCallback(CANx, J1939_Process).
+  */
+bool J1939_Init(const J1939_Config *Config)
+{
+  j1939Config = *Config;
+  j1939Address = Config->Address;
+  j1939Claim = J1939_ClaimWait;
+  j1939ClaimTimer = J1939_TICKS(J1939_TIMEOUT_AC);
+  j1939ClaimFirst = J1939_ADDRESS_NULL;
+  
+  memset(j1939TxSession, 0, sizeof(j1939TxSession));
+  memset(j1939RxSession, 0, sizeof(j1939RxSession));
+  memset(&j1939Statistics, 0, sizeof(j1939Statistics));
+  
+  for(uint32_t i = 0; i < J1939_RX_SESSION_NUMBER; i++)
+  {
+    j1939RxSession[i].RxData = j1939RxBuffer[i];
+  }
+  
+  j1939_update_filter();
+  
+  return j1939_send_claim();
+}
+
+/**
+  * @brief  Get the claimed source address.
+  * @param  None.
+  * @return The address, J1939_ADDRESS_NULL while claiming or if no address
+  *         could be claimed.
+  */
+uint8_t J1939_GetAddress(void)
+{
+  return (j1939Claim == J1939_ClaimDone) ? j1939Address : J1939_ADDRESS_NULL;
+}
+
+/**
+  * @brief  Set the PGNs passed to the application.
+  * @param  [in] PGN:    The PGNs.
+  * @param  [in] Number: The number of PGNs, up to J1939_PGN_FILTER_NUMBER.
+  * @retval true:        The receive filter has been programmed.
+  * @retval false:       Too many PGNs, or not enough filter banks.
+  * @note   Each PGN takes one filter bank, together with four banks for the
+  *         request, address claim and transport protocol PGNs. PDU1 PGNs are
+  *         matched on the bits our address shares with the global address,
+  *         so most frames for other nodes never reach the CPU.
+  */
+bool J1939_SetReceivePGN(const uint32_t *PGN, uint32_t Number)
+{
+  if(Number > J1939_PGN_FILTER_NUMBER)
+  {
+    return false;
+  }
+  
+  for(uint32_t i = 0; i < Number; i++)
+  {
+    j1939Pgn[i] = PGN[i];
+  }
+  
+  j1939PgnNumber = Number;
+  
+  return j1939_update_filter();
+}
+
+/**
+  * @brief  Transmit a parameter group.
+  * @param  [in] PGN:      Parameter group number.
+  * @param  [in] Priority: Priority, from 0 to 7.
+  * @param  [in] DA:       Destination address, J1939_ADDRESS_GLOBAL to broadcast.
+  * @param  [in] Data:     The data, it must stay valid until the transmit
+  *                        finish callback is called when longer than 8 bytes.
+  * @param  [in] Length:   The length, up to J1939_MESSAGE_SIZE_MAX.
+  * @retval true:          The transmission has started.
+  * @retval false:         No address, no free session, or transmit buffer full.
+  * @note   More than 8 bytes are sent with BAM to the global address and with
+  *         RTS/CTS to a specific address.
+  */
+bool J1939_Transmit(uint32_t PGN, uint8_t Priority, uint8_t DA, const uint8_t *Data, uint32_t Length)
+{
+  if((j1939Claim != J1939_ClaimDone) || (Length > J1939_MESSAGE_SIZE_MAX))
+  {
+    return false;
+  }
+  
+  if(Length <= 8)
+  {
+    return j1939_send(Priority, PGN, DA, Data, Length);
+  }
+  
+  J1939_Session *session = 0;
+  
+  for(uint32_t i = 0; i < J1939_TX_SESSION_NUMBER; i++)
+  {
+    /* Only one session at a time per destination. */
+    if((j1939TxSession[i].State != J1939_StateIdle) && (j1939TxSession[i].Peer == DA))
+    {
+      return false;
+    }
+    
+    if((j1939TxSession[i].State == J1939_StateIdle) && (session == 0))
+    {
+      session = &j1939TxSession[i];
+    }
+  }
+  
+  if(session == 0)
+  {
+    return false;
+  }
+  
+  session->Peer      = DA;
+  session->Broadcast = (DA == J1939_ADDRESS_GLOBAL);
+  session->Priority  = Priority;
+  session->PGN      = PGN;
+  session->Length   = Length;
+  session->Packets  = (Length + 6) / 7;
+  session->Sequence = 1;
+  session->TxData   = Data;
+  session->Start    = j1939Tick;
+  
+  if(DA == J1939_ADDRESS_GLOBAL)
+  {
+    session->WindowEnd = session->Packets;
+    session->Timer     = J1939_TICKS(J1939_BAM_INTERVAL);
+    session->State     = J1939_StateBroadcast;
+    
+    if(j1939_send_cm(DA, J1939_TP_BAM, Length, Length >> 8, session->Packets, 0xFF, PGN) != true)
+    {
+      session->State = J1939_StateIdle;
+      return false;
+    }
+  }
+  else
+  {
+    session->Timer = J1939_TICKS(J1939_TIMEOUT_T3);
+    session->State = J1939_StateWaitCTS;
+    
+    if(j1939_send_cm(DA, J1939_TP_RTS, Length, Length >> 8, session->Packets, 0xFF, PGN) != true)
+    {
+      session->State = J1939_StateIdle;
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+/**
+  * @brief  Request a parameter group.
+  * @param  [in] PGN: Requested parameter group number.
+  * @param  [in] DA:  Destination address, J1939_ADDRESS_GLOBAL to ask all nodes.
+  * @retval true:     The request is queued.
+  * @retval false:    The request could not be queued.
+  */
+bool J1939_Request(uint32_t PGN, uint8_t DA)
+{
+  uint8_t data[3] = {PGN, PGN >> 8, PGN >> 16};
+  
+  if(j1939Claim != J1939_ClaimDone)
+  {
+    return false;
+  }
+  
+  return j1939_send(6, J1939_PGN_REQUEST, DA, data, sizeof(data));
+}
+
+/**
+  * @brief  Feed a received frame to the J1939 layer.
+  * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Message: The received frame.
+  * @retval true:         The frame is consumed.
+  * @retval false:        The frame is not a J1939 frame for this node.
+  */
+bool J1939_Input(CAN_TypeDef *CANx, const CanRxMsg *Message)
+{
+  if((CANx != j1939Config.CANx) || (Message->IDE != CAN_Id_Extended) || (Message->RTR != CAN_RTR_Data))
+  {
+    return false;
+  }
+  
+  uint32_t pgn = J1939_GetPGN(Message->ExtId);
+  uint8_t  sa  = J1939_GetSA(Message->ExtId);
+  uint8_t  da  = J1939_GetDA(Message->ExtId);
+  
+  /* The filter lets close addresses through, the rest is sorted out here. */
+  if((da != J1939_ADDRESS_GLOBAL) && (da != j1939Address))
+  {
+    return false;
+  }
+  
+  j1939Statistics.Frames++;
+  
+  switch(pgn)
+  {
+    case J1939_PGN_ADDRESS_CLAIM:
+      if(Message->DLC == 8)
+      {
+        j1939_input_claim(sa, Message->Data);
+      }
+      break;
+    case J1939_PGN_REQUEST:
+      if((Message->DLC >= 3) && ((Message->Data[0] | (Message->Data[1] << 8) | ((uint32_t)Message->Data[2] << 16)) == J1939_PGN_ADDRESS_CLAIM))
+      {
+        j1939_send_claim();
+      }
+      else if(j1939Config.ReceiveCallback != 0)
+      {
+        j1939Config.ReceiveCallback(pgn, sa, da, Message->Data, Message->DLC);
+      }
+      break;
+    case J1939_PGN_TP_CM:
+      if(Message->DLC == 8)
+      {
+        j1939_input_cm(sa, da, Message->Data);
+      }
+      break;
+    case J1939_PGN_TP_DT:
+      if(Message->DLC == 8)
+      {
+        j1939_input_dt(sa, da, Message->Data);
+      }
+      break;
+    default:
+      if(j1939Config.ReceiveCallback != 0)
+      {
+        j1939Config.ReceiveCallback(pgn, sa, da, Message->Data, Message->DLC);
+      }
+      break;
+  }
+  
+  return true;
+}
+
+/**
+  * @brief  Pump the data packets of the RTS/CTS sessions.
+  * @param  None.
+  * @return None.
+  * @note   Meant as the CAN transmit finish callback.
+  */
+void J1939_Process(void)
+{
+  for(uint32_t i = 0; i < J1939_TX_SESSION_NUMBER; i++)
+  {
+    if(j1939TxSession[i].State == J1939_StateSendData)
+    {
+      j1939_send_data(&j1939TxSession[i]);
+    }
+  }
+}
+
+/**
+  * @brief  J1939 time base, to be called every J1939_TICK_PERIOD milliseconds.
+  * @param  None.
+  * @return None.
+  * @note   It must not preempt, or be preempted by, the CAN interrupts.
+  */
+void J1939_Tick(void)
+{
+  j1939Tick++;
+  
+  if((j1939Claim == J1939_ClaimWait) && (--j1939ClaimTimer == 0))
+  {
+    j1939Claim = J1939_ClaimDone;
+    j1939_update_filter();
+    
+    if(j1939Config.AddressCallback != 0)
+    {
+      j1939Config.AddressCallback(j1939Address);
+    }
+  }
+  
+  for(uint32_t i = 0; i < J1939_TX_SESSION_NUMBER; i++)
+  {
+    J1939_Session *session = &j1939TxSession[i];
+    
+    switch(session->State)
+    {
+      case J1939_StateBroadcast:
+        if(--session->Timer == 0)
+        {
+          uint8_t  data[8] = {0};
+          uint32_t offset  = (session->Sequence - 1) * 7;
+          uint32_t length  = min(session->Length - offset, 7);
+          
+          data[0] = session->Sequence;
+          memcpy(&data[1], session->TxData + offset, length);
+          memset(&data[1 + length], 0xFF, 7 - length);
+          
+          if(j1939_send(7, J1939_PGN_TP_DT, J1939_ADDRESS_GLOBAL, data, 8) == true)
+          {
+            session->Sequence++;
+          }
+          
+          session->Timer = J1939_TICKS(J1939_BAM_INTERVAL);
+          
+          if(session->Sequence > session->Packets)
+          {
+            j1939_transmit_finish(session, J1939_ResultOk);
+          }
+        }
+        break;
+      case J1939_StateSendData:
+        j1939_send_data(session);
+        break;
+      case J1939_StateWaitCTS:
+      case J1939_StateWaitEoMA:
+        if(--session->Timer == 0)
+        {
+          j1939_send_cm(session->Peer, J1939_TP_ABORT, J1939_ABORT_TIMEOUT, 0xFF, 0xFF, 0xFF, session->PGN);
+          j1939Statistics.Timeout++;
+          j1939_transmit_finish(session, J1939_ResultTimeout);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  
+  for(uint32_t i = 0; i < J1939_RX_SESSION_NUMBER; i++)
+  {
+    J1939_Session *session = &j1939RxSession[i];
+    
+    if((session->State == J1939_StateReceive) && (--session->Timer == 0))
+    {
+      if(session->Broadcast != true)
+      {
+        j1939_send_cm(session->Peer, J1939_TP_ABORT, J1939_ABORT_TIMEOUT, 0xFF, 0xFF, 0xFF, session->PGN);
+      }
+      
+      j1939Statistics.Timeout++;
+      j1939_receive_finish(session, J1939_ResultTimeout);
+    }
+  }
+}
+
+/**
+  * @brief  Get the statistics of the J1939 layer.
+  * @param  [in] Statistics: To store the statistics.
+  * @return None.
+  * @note   Bytes / Time gives the multipacket reassembly rate.
+  */
+void J1939_GetStatistics(J1939_Statistics *Statistics)
+{
+  *Statistics = j1939Statistics;
+}
+
+/**
+  * @brief  Send a single frame.
+  * @param  [in] priority: Priority.
+  * @param  [in] pgn:      Parameter group number.
+  * @param  [in] da:       Destination address.
+  * @param  [in] data:     The data.
+  * @param  [in] length:   The length, up to 8.
+  * @retval true:          The frame is queued.
+  * @retval false:         The transmit buffer is full.
+  * @note   Called from J1939_Input() in the receive interrupt (CTS, EoMA, aborts,
+  *         address claims) and from the thread, CAN_SetTransmitMessage() masks
+  *         interrupts around the enqueue.
+  */
+static bool j1939_send(uint8_t priority, uint32_t pgn, uint8_t da, const uint8_t *data, uint32_t length)
+{
+  CanTxMsg canTxMsg = {0};
+  
+  canTxMsg.ExtId = J1939_MakeId(priority, pgn, da, j1939Address);
+  canTxMsg.IDE   = CAN_Id_Extended;
+  canTxMsg.RTR   = CAN_RTR_Data;
+  canTxMsg.DLC   = length;
+  memcpy(canTxMsg.Data, data, length);
+  
+  return CAN_SetTransmitMessage(j1939Config.CANx, &canTxMsg, 1) == 1;
+}
+
+/**
+  * @brief  Send a transport protocol connection management frame.
+  * @param  [in] da:      Destination address.
+  * @param  [in] control: Control byte.
+  * @param  [in] b1:      Byte 1.
+  * @param  [in] b2:      Byte 2.
+  * @param  [in] b3:      Byte 3.
+  * @param  [in] b4:      Byte 4.
+  * @param  [in] pgn:     PGN of the packeted message.
+  * @retval true:         The frame is queued.
+  * @retval false:        The transmit buffer is full.
+  */
+static bool j1939_send_cm(uint8_t da, uint8_t control, uint8_t b1, uint8_t b2, uint8_t b3, uint8_t b4, uint32_t pgn)
+{
+  uint8_t data[8] = {control, b1, b2, b3, b4, pgn, pgn >> 8, pgn >> 16};
+  
+  return j1939_send(7, J1939_PGN_TP_CM, da, data, sizeof(data));
+}
+
+/**
+  * @brief  Send the address claim, or cannot claim address.
+  * @param  None.
+  * @retval true:  The frame is queued.
+  * @retval false: The transmit buffer is full.
+  */
+static bool j1939_send_claim(void)
+{
+  uint8_t data[8] = {0};
+  
+  for(uint32_t i = 0; i < 8; i++)
+  {
+    data[i] = j1939Config.Name >> (i * 8);
+  }
+  
+  return j1939_send(6, J1939_PGN_ADDRESS_CLAIM, J1939_ADDRESS_GLOBAL, data, sizeof(data));
+}
+
+/**
+  * @brief  Program the receive filter from the PGNs and the address.
+  * @param  None.
+  * @retval true:  The filter has been programmed.
+  * @retval false: Not enough filter banks.
+  */
+static bool j1939_update_filter(void)
+{
+  static const uint32_t protocol[4] = {J1939_PGN_REQUEST, J1939_PGN_ADDRESS_CLAIM, J1939_PGN_TP_CM, J1939_PGN_TP_DT};
+  
+  CAN_FilterId filter[4 + J1939_PGN_FILTER_NUMBER] = {0};
+  uint32_t     number                              = 0;
+  
+  for(uint32_t i = 0; i < 4 + j1939PgnNumber; i++)
+  {
+    uint32_t pgn = (i < 4) ? protocol[i] : j1939Pgn[i - 4];
+    
+    filter[number].IDE = CAN_Id_Extended;
+    
+    if(((pgn >> 8) & 0xFF) < 240)
+    {
+      /* One bank for both our and the global address: only their common DA bits are compared. */
+      filter[number].Id   = (pgn << 8) | ((uint32_t)j1939Address << 8);
+      filter[number].Mask = 0x03FF0000 | ((uint32_t)(~(j1939Address ^ J1939_ADDRESS_GLOBAL) & 0xFF) << 8);
+    }
+    else
+    {
+      filter[number].Id   = pgn << 8;
+      filter[number].Mask = 0x03FFFF00;
+    }
+    
+    number++;
+  }
+  
+  return CAN_SetReceiveFilter(j1939Config.CANx, filter, number);
+}
+
+/**
+  * @brief  Handle a received address claim.
+  * @param  [in] sa:   Source address.
+  * @param  [in] data: NAME of the claiming node.
+  * @return None.
+  */
+static void j1939_input_claim(uint8_t sa, const uint8_t *data)
+{
+  uint64_t name = 0;
+  bool     lap  = false;
+  
+  if((sa != j1939Address) || (j1939Claim == J1939_ClaimFailed))
+  {
+    return;
+  }
+  
+  for(uint32_t i = 0; i < 8; i++)
+  {
+    name |= (uint64_t)data[i] << (i * 8);
+  }
+  
+  /* The lower NAME wins the address. */
+  if(j1939Config.Name < name)
+  {
+    j1939_send_claim();
+    return;
+  }
+  
+  if((j1939Config.Name >> 63) != 0)
+  {
+    /* Arbitrary address capable: move on in the self-configurable range 128 to 247,
+       giving up after one full lap whether or not the preferred address lies in it. */
+    j1939Address = ((j1939Address < 128) || (j1939Address >= 247)) ? 128 : (j1939Address + 1);
+    
+    lap = (j1939Address == j1939Config.Address) || (j1939Address == j1939ClaimFirst);
+    
+    if(j1939ClaimFirst == J1939_ADDRESS_NULL)
+    {
+      j1939ClaimFirst = j1939Address;
+    }
+    
+    if(lap != true)
+    {
+      j1939Claim = J1939_ClaimWait;
+      j1939ClaimTimer = J1939_TICKS(J1939_TIMEOUT_AC);
+      j1939_send_claim();
+      return;
+    }
+  }
+  
+  j1939Address = J1939_ADDRESS_NULL;
+  j1939Claim = J1939_ClaimFailed;
+  j1939_send_claim();
+  
+  if(j1939Config.AddressCallback != 0)
+  {
+    j1939Config.AddressCallback(J1939_ADDRESS_NULL);
+  }
+}
+
+/**
+  * @brief  Handle a received connection management frame.
+  * @param  [in] sa:   Source address.
+  * @param  [in] da:   Destination address.
+  * @param  [in] data: Frame data.
+  * @return None.
+  */
+static void j1939_input_cm(uint8_t sa, uint8_t da, const uint8_t *data)
+{
+  uint32_t pgn    = data[5] | (data[6] << 8) | ((uint32_t)data[7] << 16);
+  uint32_t length = data[1] | (data[2] << 8);
+  
+  switch(data[0])
+  {
+    case J1939_TP_RTS:
+    case J1939_TP_BAM:
+    {
+      bool           broadcast = (data[0] == J1939_TP_BAM);
+      J1939_Session *session   = j1939_find_rx(sa, broadcast);
+      
+      if(broadcast != (da == J1939_ADDRESS_GLOBAL))
+      {
+        break;
+      }
+      
+      /* A new announcement from the same node replaces the session in progress. */
+      if(session == 0)
+      {
+        for(uint32_t i = 0; (session == 0) && (i < J1939_RX_SESSION_NUMBER); i++)
+        {
+          if(j1939RxSession[i].State == J1939_StateIdle)
+          {
+            session = &j1939RxSession[i];
+          }
+        }
+      }
+      
+      if((session == 0) || (length > J1939_MESSAGE_SIZE_MAX) || (length < 9) || (data[3] != (length + 6) / 7))
+      {
+        if(broadcast != true)
+        {
+          j1939_send_cm(sa, J1939_TP_ABORT, J1939_ABORT_RESOURCES, 0xFF, 0xFF, 0xFF, pgn);
+        }
+        break;
+      }
+      
+      session->Peer      = sa;
+      session->Broadcast = broadcast;
+      session->PGN      = pgn;
+      session->Length   = length;
+      session->Packets  = data[3];
+      session->Sequence = 1;
+      session->Start    = j1939Tick;
+      session->Timer    = J1939_TICKS(J1939_TIMEOUT_T1);
+      session->State    = J1939_StateReceive;
+      
+      if(broadcast != true)
+      {
+        uint8_t window = min(min(session->Packets, J1939_CTS_PACKETS), data[4]);
+        
+        session->WindowEnd = window;
+        session->Timer     = J1939_TICKS(J1939_TIMEOUT_T2);
+        j1939_send_cm(sa, J1939_TP_CTS, window, 1, 0xFF, 0xFF, pgn);
+      }
+      else
+      {
+        session->WindowEnd = session->Packets;
+      }
+      break;
+    }
+    case J1939_TP_CTS:
+    case J1939_TP_EOMA:
+    case J1939_TP_ABORT:
+    {
+      for(uint32_t i = 0; i < J1939_TX_SESSION_NUMBER; i++)
+      {
+        J1939_Session *session = &j1939TxSession[i];
+        
+        if((session->State == J1939_StateIdle) || (session->Peer != sa) || (session->PGN != pgn))
+        {
+          continue;
+        }
+        
+        if(data[0] == J1939_TP_ABORT)
+        {
+          j1939Statistics.Abort++;
+          j1939_transmit_finish(session, J1939_ResultAbort);
+        }
+        else if(data[0] == J1939_TP_EOMA)
+        {
+          if(session->State == J1939_StateWaitEoMA)
+          {
+            j1939_transmit_finish(session, J1939_ResultOk);
+          }
+        }
+        else if(data[1] == 0)
+        {
+          /* Hold the connection open. */
+          session->Timer = J1939_TICKS(J1939_TIMEOUT_T4);
+          session->State = J1939_StateWaitCTS;
+        }
+        else if((data[2] >= 1) && (data[2] <= session->Packets))
+        {
+          session->Sequence  = data[2];
+          session->WindowEnd = min(data[2] + data[1] - 1, session->Packets);
+          session->State     = J1939_StateSendData;
+          j1939_send_data(session);
+        }
+        break;
+      }
+      
+      for(uint32_t i = 0; (data[0] == J1939_TP_ABORT) && (i < J1939_RX_SESSION_NUMBER); i++)
+      {
+        J1939_Session *session = &j1939RxSession[i];
+        
+        if((session->State == J1939_StateReceive) && (session->Peer == sa) && (session->PGN == pgn))
+        {
+          j1939Statistics.Abort++;
+          j1939_receive_finish(session, J1939_ResultAbort);
+        }
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/**
+  * @brief  Handle a received data transfer frame.
+  * @param  [in] sa:   Source address.
+  * @param  [in] da:   Destination address.
+  * @param  [in] data: Frame data.
+  * @return None.
+  */
+static void j1939_input_dt(uint8_t sa, uint8_t da, const uint8_t *data)
+{
+  J1939_Session *session = j1939_find_rx(sa, da == J1939_ADDRESS_GLOBAL);
+  
+  if(session == 0)
+  {
+    return;
+  }
+  
+  j1939Statistics.Packets++;
+  
+  if(data[0] != session->Sequence)
+  {
+    if(session->Broadcast != true)
+    {
+      j1939_send_cm(sa, J1939_TP_ABORT, J1939_ABORT_SEQUENCE, 0xFF, 0xFF, 0xFF, session->PGN);
+    }
+    
+    j1939Statistics.Abort++;
+    j1939_receive_finish(session, J1939_ResultAbort);
+    return;
+  }
+  
+  uint32_t offset = (session->Sequence - 1) * 7;
+  
+  memcpy(session->RxData + offset, &data[1], min(session->Length - offset, 7));
+  session->Timer = J1939_TICKS(J1939_TIMEOUT_T1);
+  
+  if(session->Sequence++ < session->WindowEnd)
+  {
+    return;
+  }
+  
+  if(session->Sequence > session->Packets)
+  {
+    if(session->Broadcast != true)
+    {
+      j1939_send_cm(sa, J1939_TP_EOMA, session->Length, session->Length >> 8, session->Packets, 0xFF, session->PGN);
+    }
+    
+    j1939_receive_finish(session, J1939_ResultOk);
+  }
+  else
+  {
+    uint8_t window = min(session->Packets - session->Sequence + 1, J1939_CTS_PACKETS);
+    
+    session->WindowEnd = session->Sequence + window - 1;
+    session->Timer     = J1939_TICKS(J1939_TIMEOUT_T2);
+    j1939_send_cm(sa, J1939_TP_CTS, window, session->Sequence, 0xFF, 0xFF, session->PGN);
+  }
+}
+
+/**
+  * @brief  Send the data packets of the current CTS window.
+  * @param  [in] session: The session.
+  * @return None.
+  */
+static void j1939_send_data(J1939_Session *session)
+{
+  while(session->Sequence <= session->WindowEnd)
+  {
+    uint8_t  data[8] = {0};
+    uint32_t offset  = (session->Sequence - 1) * 7;
+    uint32_t length  = min(session->Length - offset, 7);
+    
+    data[0] = session->Sequence;
+    memcpy(&data[1], session->TxData + offset, length);
+    memset(&data[1 + length], 0xFF, 7 - length);
+    
+    if(j1939_send(7, J1939_PGN_TP_DT, session->Peer, data, 8) != true)
+    {
+      return;
+    }
+    
+    session->Sequence++;
+  }
+  
+  session->Timer = J1939_TICKS(J1939_TIMEOUT_T3);
+  session->State = (session->Sequence > session->Packets) ? J1939_StateWaitEoMA : J1939_StateWaitCTS;
+}
+
+/**
+  * @brief  End a transmit session.
+  * @param  [in] session: The session.
+  * @param  [in] result:  The result.
+  * @return None.
+  */
+static void j1939_transmit_finish(J1939_Session *session, J1939_Result result)
+{
+  session->State = J1939_StateIdle;
+  
+  if(j1939Config.TransmitFinishCallback != 0)
+  {
+    j1939Config.TransmitFinishCallback(session->PGN, session->Peer, result);
+  }
+}
+
+/**
+  * @brief  End a receive session.
+  * @param  [in] session: The session.
+  * @param  [in] result:  The result.
+  * @return None.
+  */
+static void j1939_receive_finish(J1939_Session *session, J1939_Result result)
+{
+  session->State = J1939_StateIdle;
+  
+  if(result != J1939_ResultOk)
+  {
+    return;
+  }
+  
+  j1939Statistics.Messages++;
+  j1939Statistics.Bytes += session->Length;
+  j1939Statistics.Time  += (j1939Tick - session->Start) * J1939_TICK_PERIOD;
+  
+  if(j1939Config.ReceiveCallback != 0)
+  {
+    j1939Config.ReceiveCallback(session->PGN, session->Peer, session->Broadcast ? J1939_ADDRESS_GLOBAL : j1939Address,
+                                session->RxData, session->Length);
+  }
+}
+
+/**
+  * @brief  Find the receive session of a node.
+  * @param  [in] sa:        Source address of the node.
+  * @param  [in] broadcast: Look for a BAM session instead of an RTS/CTS one.
+  * @return The session, 0 if none.
+  */
+static J1939_Session *j1939_find_rx(uint8_t sa, bool broadcast)
+{
+  for(uint32_t i = 0; i < J1939_RX_SESSION_NUMBER; i++)
+  {
+    J1939_Session *session = &j1939RxSession[i];
+    
+    if((session->State == J1939_StateReceive) && (session->Peer == sa) && (session->Broadcast == broadcast))
+    {
+      return session;
+    }
+  }
+  
+  return 0;
+}
@@ -0,0 +1,175 @@
+/**
+  ******************************************************************************
+  * @file    J1939.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for J1939.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __J1939_H
+#define __J1939_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "CAN.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define J1939_TX_SESSION_NUMBER  (2)
+#define J1939_RX_SESSION_NUMBER  (2)
+#define J1939_MESSAGE_SIZE_MAX   (1785)  /* 255 packets of 7 bytes. */
+#define J1939_PGN_FILTER_NUMBER  (8)     /* Application PGNs programmed into the filter. */
+
+#define J1939_TICK_PERIOD        (1)     /* Milliseconds between J1939_Tick() calls. */
+#define J1939_BAM_INTERVAL       (50)    /* Interval of BAM data packets, in milliseconds. */
+#define J1939_CTS_PACKETS        (16)    /* Packets requested per CTS when receiving. */
+
+#define J1939_ADDRESS_GLOBAL     (0xFF)
+#define J1939_ADDRESS_NULL       (0xFE)
+
+#define J1939_PGN_REQUEST        (0x0EA00)
+#define J1939_PGN_ADDRESS_CLAIM  (0x0EE00)
+#define J1939_PGN_TP_CM          (0x0EC00)
+#define J1939_PGN_TP_DT          (0x0EB00)
+
+/* Type definitions ----------------------------------------------------------*/
+typedef enum
+{
+  J1939_ResultOk = 0,
+  J1939_ResultAbort,
+  J1939_ResultTimeout,
+  J1939_ResultNoAddress
+}J1939_Result;
+
+typedef struct
+{
+  CAN_TypeDef *CANx;            /*!< CAN peripheral used. */
+  uint64_t     Name;            /*!< 64-bit NAME, bit 63 set for an arbitrary address capable ECU. */
+  uint8_t      Address;         /*!< Preferred source address. */
+
+  void (*ReceiveCallback)(uint32_t PGN, uint8_t SA, uint8_t DA, const uint8_t *Data, uint32_t Length);
+  void (*TransmitFinishCallback)(uint32_t PGN, uint8_t DA, J1939_Result Result);
+  void (*AddressCallback)(uint8_t Address);
+}J1939_Config;
+
+typedef struct
+{
+  uint32_t Frames;              /*!< Frames taken by the layer. */
+  uint32_t Packets;             /*!< TP.DT packets received. */
+  uint32_t Messages;            /*!< Multipacket messages reassembled. */
+  uint32_t Bytes;               /*!< Bytes of the reassembled messages. */
+  uint32_t Time;                /*!< Time spent reassembling them, in milliseconds. */
+  uint32_t Abort;               /*!< Sessions aborted, by either side. */
+  uint32_t Timeout;             /*!< Sessions timed out. */
+}J1939_Statistics;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+bool J1939_Init(const J1939_Config *Config);
+uint8_t J1939_GetAddress(void);
+
+bool J1939_SetReceivePGN(const uint32_t *PGN, uint32_t Number);
+
+bool J1939_Transmit(uint32_t PGN, uint8_t Priority, uint8_t DA, const uint8_t *Data, uint32_t Length);
+bool J1939_Request(uint32_t PGN, uint8_t DA);
+
+bool J1939_Input(CAN_TypeDef *CANx, const CanRxMsg *Message);
+void J1939_Process(void);
+void J1939_Tick(void);
+
+void J1939_GetStatistics(J1939_Statistics *Statistics);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Get the PGN of an identifier.
+  * @param  [in] ExtId: Extended identifier.
+  * @return The PGN, with the PS field cleared for PDU1 formats.
+  */
+static inline uint32_t J1939_GetPGN(uint32_t ExtId)
+{
+  uint32_t pgn = (ExtId >> 8) & 0x3FFFF;
+
+  return (((pgn >> 8) & 0xFF) < 240) ? (pgn & 0x3FF00) : pgn;
+}
+
+/**
+  * @brief  Get the source address of an identifier.
+  * @param  [in] ExtId: Extended identifier.
+  * @return The source address.
+  */
+static inline uint8_t J1939_GetSA(uint32_t ExtId)
+{
+  return ExtId & 0xFF;
+}
+
+/**
+  * @brief  Get the destination address of an identifier.
+  * @param  [in] ExtId: Extended identifier.
+  * @return The destination address, global for PDU2 formats.
+  */
+static inline uint8_t J1939_GetDA(uint32_t ExtId)
+{
+  return (((ExtId >> 16) & 0xFF) < 240) ? ((ExtId >> 8) & 0xFF) : J1939_ADDRESS_GLOBAL;
+}
+
+/**
+  * @brief  Get the priority of an identifier.
+  * @param  [in] ExtId: Extended identifier.
+  * @return The priority, 0 is the highest.
+  */
+static inline uint8_t J1939_GetPriority(uint32_t ExtId)
+{
+  return (ExtId >> 26) & 0x07;
+}
+
+/**
+  * @brief  Build an identifier.
+  * @param  [in] Priority: Priority, from 0 to 7.
+  * @param  [in] PGN:      Parameter group number.
+  * @param  [in] DA:       Destination address, ignored for PDU2 formats.
+  * @param  [in] SA:       Source address.
+  * @return The extended identifier.
+  */
+static inline uint32_t J1939_MakeId(uint8_t Priority, uint32_t PGN, uint8_t DA, uint8_t SA)
+{
+  uint32_t id = ((uint32_t)(Priority & 0x07) << 26) | ((PGN & 0x3FFFF) << 8) | SA;
+
+  if(((PGN >> 8) & 0xFF) < 240)
+  {
+    id = (id & ~0xFF00UL) | ((uint32_t)DA << 8);
+  }
+
+  return id;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __J1939_H */
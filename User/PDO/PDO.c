@@ -0,0 +1,597 @@
+/**
+  ******************************************************************************
+  * @file    PDO.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   CANopen process data object module source file.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+/* Header includes -----------------------------------------------------------*/
+#include "PDO.h"
+#include <string.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define PDO_DUMMY_INDEX_MAX  (0x0007)  /* Indexes 0x0001 to 0x0007 are the dummy data types. */
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct
+{
+  uint8_t *Data;                /*!< Address of the object. */
+  uint8_t  Length;              /*!< Bytes of the object copied. */
+  uint8_t  Offset;              /*!< Byte offset in the frame, byte aligned entries. */
+  uint8_t  Shift;               /*!< Bit offset in the frame, other entries. */
+  uint8_t  Bits;                /*!< Bit length, 0 for byte aligned entries. */
+}PDO_Copy;
+
+typedef struct
+{
+  volatile bool Valid;
+  volatile bool Pending;        /*!< RPDO waiting for SYNC, or TPDO waiting for SYNC with type 0. */
+  uint8_t       TransmissionType;
+  uint8_t       SyncCount;
+  uint16_t      CobId;
+  uint8_t       DLC;
+  uint8_t       CopyNumber;
+  PDO_Copy      Copy[PDO_MAPPING_NUMBER];
+  uint8_t       Buffer[8];      /*!< Synchronous RPDO data until the next SYNC. */
+}PDO_Channel;
+
+/* Variable declarations -----------------------------------------------------*/
+static CAN_TypeDef      *pdoCANx         = 0;
+static const PDO_Object *pdoObject       = 0;
+static uint32_t          pdoObjectNumber = 0;
+
+static PDO_Channel       pdoRPDO[PDO_RPDO_NUMBER] = {0};
+static PDO_Channel       pdoTPDO[PDO_TPDO_NUMBER] = {0};
+
+static PDO_Statistics    pdoStatistics = {0};
+
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+static bool pdo_compile(PDO_Channel *channel, const PDO_Config *config, bool receive);
+static const PDO_Object *pdo_find(uint16_t index, uint8_t subindex);
+static void pdo_copy(uint8_t *dst, const uint8_t *src, uint32_t length);
+static void pdo_pack(const PDO_Channel *channel, uint8_t *data);
+static void pdo_unpack(const PDO_Channel *channel, const uint8_t *data);
+static bool pdo_send(PDO_Channel *channel);
+static void pdo_sync(void);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Initialize the PDO engine.
+  * @param  [in] CANx:   Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Object: Object dictionary entries that can be mapped, it must
+  *                      stay valid while the engine is used.
+  * @param  [in] Number: The number of entries.
+  * @return None.
+  * @note   All PDOs are invalid until configured. The received frames reach
+  *         the engine through PDO_Input(), for example by
+  *         CAN_SetReceiveMessageCallback(CANx, PDO_Input).
+  */
+void PDO_Init(CAN_TypeDef *CANx, const PDO_Object *Object, uint32_t Number)
+{
+  pdoCANx         = CANx;
+  pdoObject       = Object;
+  pdoObjectNumber = Number;
+  
+  memset(pdoRPDO, 0, sizeof(pdoRPDO));
+  memset(pdoTPDO, 0, sizeof(pdoTPDO));
+  
+  PDO_ClearStatistics();
+  
+  /* The cycle counter times the queueing of the TPDOs at a SYNC. */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+  * @brief  Configure a receive PDO.
+  * @param  [in] Pdo:    The RPDO, from 0 to PDO_RPDO_NUMBER - 1.
+  * @param  [in] Config: Communication and mapping parameters.
+  * @retval true:        The RPDO is configured.
+  * @retval false:       Unknown object, object too small or mapping longer
+  *                      than 64 bits. The RPDO is left invalid.
+  * @note   The mapping is compiled here into copy descriptors, receiving the
+  *         RPDO only runs them. Dummy entries skip bits of the frame.
+  *         Synchronous RPDOs are applied at the next SYNC.
+  */
+bool PDO_ConfigureRPDO(uint32_t Pdo, const PDO_Config *Config)
+{
+  if(Pdo >= PDO_RPDO_NUMBER)
+  {
+    return false;
+  }
+  
+  return pdo_compile(&pdoRPDO[Pdo], Config, true);
+}
+
+/**
+  * @brief  Configure a transmit PDO.
+  * @param  [in] Pdo:    The TPDO, from 0 to PDO_TPDO_NUMBER - 1.
+  * @param  [in] Config: Communication and mapping parameters.
+  * @retval true:        The TPDO is configured.
+  * @retval false:       Unknown object, object too small, dummy entry or
+  *                      mapping longer than 64 bits. The TPDO is left invalid.
+  * @note   Synchronous TPDOs are sent from PDO_Input() when the SYNC arrives,
+  *         every TransmissionType SYNC for types 1 to 240, and at the next
+  *         SYNC after PDO_TransmitTPDO() for type 0.
+  */
+bool PDO_ConfigureTPDO(uint32_t Pdo, const PDO_Config *Config)
+{
+  if(Pdo >= PDO_TPDO_NUMBER)
+  {
+    return false;
+  }
+  
+  return pdo_compile(&pdoTPDO[Pdo], Config, false);
+}
+
+/**
+  * @brief  Trigger a transmit PDO.
+  * @param  [in] Pdo: The TPDO, from 0 to PDO_TPDO_NUMBER - 1.
+  * @retval true:     The TPDO is queued, or will be at the next SYNC.
+  * @retval false:    Invalid or cyclic synchronous TPDO, or transmit buffer full.
+  */
+bool PDO_TransmitTPDO(uint32_t Pdo)
+{
+  if((Pdo >= PDO_TPDO_NUMBER) || (pdoTPDO[Pdo].Valid != true))
+  {
+    return false;
+  }
+  
+  PDO_Channel *channel = &pdoTPDO[Pdo];
+  
+  if(channel->TransmissionType == 0)
+  {
+    channel->Pending = true;
+    return true;
+  }
+  else if(channel->TransmissionType <= PDO_TYPE_SYNC_MAX)
+  {
+    return false;
+  }
+  else
+  {
+    return pdo_send(channel);
+  }
+}
+
+/**
+  * @brief  Pass a received frame to the PDO engine.
+  * @param  [in] CANx:    Where x can be 1 or 2 to select the CAN peripheral.
+  * @param  [in] Message: The received frame.
+  * @retval true:         The frame is consumed.
+  * @retval false:        The frame is neither the SYNC nor a configured RPDO.
+  */
+bool PDO_Input(CAN_TypeDef *CANx, const CanRxMsg *Message)
+{
+  if((CANx != pdoCANx) || (Message->IDE != CAN_Id_Standard) || (Message->RTR != CAN_RTR_Data))
+  {
+    return false;
+  }
+  
+  if(Message->StdId == PDO_SYNC_ID)
+  {
+    pdo_sync();
+    return true;
+  }
+  
+  for(uint32_t i = 0; i < PDO_RPDO_NUMBER; i++)
+  {
+    PDO_Channel *channel = &pdoRPDO[i];
+    
+    if((channel->Valid != true) || (channel->CobId != Message->StdId))
+    {
+      continue;
+    }
+    
+    if(Message->DLC < channel->DLC)
+    {
+      pdoStatistics.LengthError++;
+    }
+    else if(channel->TransmissionType <= PDO_TYPE_SYNC_MAX)
+    {
+      memcpy(channel->Buffer, Message->Data, sizeof(channel->Buffer));
+      channel->Pending = true;
+      pdoStatistics.Receive++;
+    }
+    else
+    {
+      pdo_unpack(channel, Message->Data);
+      pdoStatistics.Receive++;
+    }
+    
+    return true;
+  }
+  
+  return false;
+}
+
+/**
+  * @brief  Get the identifiers the PDO engine receives.
+  * @param  [out] Filter: At least 1 + PDO_RPDO_NUMBER entries.
+  * @return The number of entries written: the SYNC and the valid RPDOs.
+  * @note   Pass them to CAN_SetReceiveFilter(), together with the identifiers
+  *         of the other services of the node.
+  */
+uint32_t PDO_GetReceiveFilter(CAN_FilterId *Filter)
+{
+  uint32_t number = 0;
+  
+  Filter[number].IDE  = CAN_Id_Standard;
+  Filter[number].Id   = PDO_SYNC_ID;
+  Filter[number].Mask = 0x7FF;
+  number++;
+  
+  for(uint32_t i = 0; i < PDO_RPDO_NUMBER; i++)
+  {
+    if(pdoRPDO[i].Valid == true)
+    {
+      Filter[number].IDE  = CAN_Id_Standard;
+      Filter[number].Id   = pdoRPDO[i].CobId;
+      Filter[number].Mask = 0x7FF;
+      number++;
+    }
+  }
+  
+  return number;
+}
+
+/**
+  * @brief  Get the PDO statistics.
+  * @param  [out] Statistics: The statistics.
+  * @return None.
+  */
+void PDO_GetStatistics(PDO_Statistics *Statistics)
+{
+  *Statistics = pdoStatistics;
+}
+
+/**
+  * @brief  Clear the PDO statistics.
+  * @param  None.
+  * @return None.
+  */
+void PDO_ClearStatistics(void)
+{
+  memset(&pdoStatistics, 0, sizeof(pdoStatistics));
+  pdoStatistics.QueueTimeMin = UINT32_MAX;
+}
+
+/**
+  * @brief  Compile the mapping of a PDO into copy descriptors.
+  * @param  [in] channel: The PDO.
+  * @param  [in] config:  Communication and mapping parameters.
+  * @param  [in] receive: RPDO, dummy entries are allowed.
+  * @retval true:         The PDO is valid.
+  * @retval false:        The mapping is wrong, the PDO is invalid.
+  * @note   Byte aligned entries of objects lying back to back in memory are
+  *         merged into one descriptor.
+  */
+static bool pdo_compile(PDO_Channel *channel, const PDO_Config *config, bool receive)
+{
+  PDO_Channel compiled = {0};
+  uint32_t    bit      = 0;
+  
+  channel->Valid = false;
+  
+  if(((config->CobId & PDO_COB_ID_INVALID) != 0) || (config->CobId > 0x7FF) || (config->MappingNumber > PDO_MAPPING_NUMBER))
+  {
+    return false;
+  }
+  
+  for(uint32_t i = 0; i < config->MappingNumber; i++)
+  {
+    uint16_t index    = config->Mapping[i] >> 16;
+    uint8_t  subindex = (config->Mapping[i] >> 8) & 0xFF;
+    uint8_t  bits     = config->Mapping[i] & 0xFF;
+    
+    if((bits == 0) || (bit + bits > 64))
+    {
+      return false;
+    }
+    
+    if((index != 0) && (index <= PDO_DUMMY_INDEX_MAX))
+    {
+      if(receive != true)
+      {
+        return false;
+      }
+      
+      bit += bits;
+      continue;
+    }
+    
+    const PDO_Object *object = pdo_find(index, subindex);
+    
+    if((object == 0) || (object->Size * 8 < bits))
+    {
+      return false;
+    }
+    
+    PDO_Copy *last = (compiled.CopyNumber > 0) ? &compiled.Copy[compiled.CopyNumber - 1] : 0;
+    
+    if(((bit % 8) == 0) && ((bits % 8) == 0))
+    {
+      if((last != 0) && (last->Bits == 0) && (last->Offset + last->Length == bit / 8) && (last->Data + last->Length == (uint8_t *)object->Data))
+      {
+        last->Length += bits / 8;
+      }
+      else
+      {
+        PDO_Copy *copy = &compiled.Copy[compiled.CopyNumber++];
+        
+        copy->Data   = object->Data;
+        copy->Length = bits / 8;
+        copy->Offset = bit / 8;
+      }
+    }
+    else
+    {
+      PDO_Copy *copy = &compiled.Copy[compiled.CopyNumber++];
+      
+      copy->Data   = object->Data;
+      copy->Length = (bits + 7) / 8;
+      copy->Shift  = bit;
+      copy->Bits   = bits;
+    }
+    
+    bit += bits;
+  }
+  
+  compiled.TransmissionType = config->TransmissionType;
+  compiled.CobId            = config->CobId;
+  compiled.DLC              = (bit + 7) / 8;
+  
+  *channel = compiled;
+  channel->Valid = true;
+  
+  return true;
+}
+
+/**
+  * @brief  Find an object dictionary entry.
+  * @param  [in] index:    Index.
+  * @param  [in] subindex: Sub-index.
+  * @return The entry, 0 if not found.
+  */
+static const PDO_Object *pdo_find(uint16_t index, uint8_t subindex)
+{
+  for(uint32_t i = 0; i < pdoObjectNumber; i++)
+  {
+    if((pdoObject[i].Index == index) && (pdoObject[i].SubIndex == subindex))
+    {
+      return &pdoObject[i];
+    }
+  }
+  
+  return 0;
+}
+
+/**
+  * @brief  Copy the bytes of a byte aligned entry.
+  * @param  [out] dst:    Destination.
+  * @param  [in]  src:    Source.
+  * @param  [in]  length: The length, up to 8.
+  * @return None.
+  * @note   The usual sizes are copied with single unaligned loads and stores.
+  */
+static void pdo_copy(uint8_t *dst, const uint8_t *src, uint32_t length)
+{
+  switch(length)
+  {
+    case 1:
+      *dst = *src;
+      break;
+    case 2:
+      memcpy(dst, src, 2);
+      break;
+    case 4:
+      memcpy(dst, src, 4);
+      break;
+    case 8:
+      memcpy(dst, src, 8);
+      break;
+    default:
+      memcpy(dst, src, length);
+      break;
+  }
+}
+
+/**
+  * @brief  Pack the mapped objects into a frame.
+  * @param  [in]  channel: The TPDO.
+  * @param  [out] data:    The frame data, 8 bytes cleared.
+  * @return None.
+  */
+static void pdo_pack(const PDO_Channel *channel, uint8_t *data)
+{
+  uint64_t word = 0;
+  
+  for(uint32_t i = 0; i < channel->CopyNumber; i++)
+  {
+    const PDO_Copy *copy = &channel->Copy[i];
+    
+    if(copy->Bits == 0)
+    {
+      pdo_copy(&data[copy->Offset], copy->Data, copy->Length);
+    }
+    else
+    {
+      uint64_t value = 0;
+      
+      memcpy(&value, copy->Data, copy->Length);
+      word |= (value & ((1ULL << copy->Bits) - 1)) << copy->Shift;
+    }
+  }
+  
+  if(word != 0)
+  {
+    uint64_t frame;
+    
+    memcpy(&frame, data, sizeof(frame));
+    frame |= word;
+    memcpy(data, &frame, sizeof(frame));
+  }
+}
+
+/**
+  * @brief  Unpack a frame into the mapped objects.
+  * @param  [in] channel: The RPDO.
+  * @param  [in] data:    The frame data, 8 bytes.
+  * @return None.
+  */
+static void pdo_unpack(const PDO_Channel *channel, const uint8_t *data)
+{
+  uint64_t frame;
+  
+  memcpy(&frame, data, sizeof(frame));
+  
+  for(uint32_t i = 0; i < channel->CopyNumber; i++)
+  {
+    const PDO_Copy *copy = &channel->Copy[i];
+    
+    if(copy->Bits == 0)
+    {
+      pdo_copy(copy->Data, &data[copy->Offset], copy->Length);
+    }
+    else
+    {
+      uint64_t value = (frame >> copy->Shift) & ((1ULL << copy->Bits) - 1);
+      
+      memcpy(copy->Data, &value, copy->Length);
+    }
+  }
+}
+
+/**
+  * @brief  Pack and queue a transmit PDO.
+  * @param  [in] channel: The TPDO.
+  * @retval true:         The TPDO is queued.
+  * @retval false:        The transmit buffer is full.
+  * @note   Called from PDO_Input() in the receive interrupt on SYNC and from
+  *         PDO_TransmitTPDO() in the application. CAN_SetTransmitMessage() masks
+  *         interrupts around the enqueue, the counters are masked here too.
+  */
+static bool pdo_send(PDO_Channel *channel)
+{
+  CanTxMsg canTxMsg = {0};
+  
+  canTxMsg.StdId = channel->CobId;
+  canTxMsg.IDE   = CAN_Id_Standard;
+  canTxMsg.RTR   = CAN_RTR_Data;
+  canTxMsg.DLC   = channel->DLC;
+  pdo_pack(channel, canTxMsg.Data);
+  
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  bool result = (CAN_SetTransmitMessage(pdoCANx, &canTxMsg, 1) == 1);
+  
+  if(result == true)
+  {
+    pdoStatistics.Transmit++;
+  }
+  else
+  {
+    pdoStatistics.Lost++;
+  }
+  
+  __set_PRIMASK(primask);
+  
+  return result;
+}
+
+/**
+  * @brief  Handle a SYNC: send the synchronous TPDOs due, then apply the
+  *         synchronous RPDOs received since the previous SYNC.
+  * @param  None.
+  * @return None.
+  */
+static void pdo_sync(void)
+{
+  uint32_t start = DWT->CYCCNT;
+  bool     sent  = false;
+  
+  pdoStatistics.Sync++;
+  
+  for(uint32_t i = 0; i < PDO_TPDO_NUMBER; i++)
+  {
+    PDO_Channel *channel = &pdoTPDO[i];
+    
+    if((channel->Valid != true) || (channel->TransmissionType > PDO_TYPE_SYNC_MAX))
+    {
+      continue;
+    }
+    
+    if(channel->TransmissionType == 0)
+    {
+      if(channel->Pending != true)
+      {
+        continue;
+      }
+      
+      channel->Pending = false;
+    }
+    else if(++channel->SyncCount < channel->TransmissionType)
+    {
+      continue;
+    }
+    else
+    {
+      channel->SyncCount = 0;
+    }
+    
+    pdo_send(channel);
+    sent = true;
+  }
+  
+  if(sent == true)
+  {
+    uint32_t time = DWT->CYCCNT - start;
+    
+    pdoStatistics.QueueTimeLast = time;
+    
+    if(time < pdoStatistics.QueueTimeMin)
+    {
+      pdoStatistics.QueueTimeMin = time;
+    }
+    
+    if(time > pdoStatistics.QueueTimeMax)
+    {
+      pdoStatistics.QueueTimeMax = time;
+    }
+  }
+  
+  for(uint32_t i = 0; i < PDO_RPDO_NUMBER; i++)
+  {
+    PDO_Channel *channel = &pdoRPDO[i];
+    
+    if((channel->Valid == true) && (channel->Pending == true))
+    {
+      channel->Pending = false;
+      pdo_unpack(channel, channel->Buffer);
+    }
+  }
+}
@@ -0,0 +1,109 @@
+/**
+  ******************************************************************************
+  * @file    PDO.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for PDO.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __PDO_H
+#define __PDO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "CAN.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define PDO_RPDO_NUMBER     (4)
+#define PDO_TPDO_NUMBER     (4)
+#define PDO_MAPPING_NUMBER  (8)       /* Mapped objects per PDO. */
+
+#define PDO_SYNC_ID         (0x080)
+
+#define PDO_COB_ID_INVALID  (1UL << 31)
+
+/* Transmission types. */
+#define PDO_TYPE_SYNC_MAX   (240)     /* 1 to 240: every n-th SYNC. */
+#define PDO_TYPE_EVENT      (254)     /* Event driven, manufacturer specific. */
+#define PDO_TYPE_EVENT_DEV  (255)     /* Event driven, device profile specific. */
+
+/* Mapping entry as in the PDO mapping objects: index, sub-index, bit length. */
+#define PDO_MAPPING(index, subindex, bits)  (((uint32_t)(index) << 16) | ((uint32_t)(subindex) << 8) | (bits))
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct
+{
+  uint16_t Index;
+  uint8_t  SubIndex;
+  uint8_t  Size;                      /*!< Size of the object, in bytes. */
+  void    *Data;                      /*!< Address of the object, little endian. */
+}PDO_Object;
+
+typedef struct
+{
+  uint32_t CobId;                     /*!< 11-bit COB-ID, PDO_COB_ID_INVALID to disable. */
+  uint8_t  TransmissionType;
+  uint8_t  MappingNumber;
+  uint32_t Mapping[PDO_MAPPING_NUMBER];
+}PDO_Config;
+
+typedef struct
+{
+  uint32_t Sync;                      /*!< SYNC messages received. */
+  uint32_t Receive;                   /*!< RPDOs received. */
+  uint32_t Transmit;                  /*!< TPDOs queued. */
+  uint32_t Lost;                      /*!< TPDOs not queued, transmit buffer full. */
+  uint32_t LengthError;               /*!< RPDOs shorter than their mapping, ignored. */
+  uint32_t QueueTimeLast;             /*!< PDO_Input() taking the SYNC to the last TPDO queued, in CPU cycles. */
+  uint32_t QueueTimeMin;              /*!< Interrupt entry, buffering and the bus come on top. */
+  uint32_t QueueTimeMax;
+}PDO_Statistics;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+void PDO_Init(CAN_TypeDef *CANx, const PDO_Object *Object, uint32_t Number);
+
+bool PDO_ConfigureRPDO(uint32_t Pdo, const PDO_Config *Config);
+bool PDO_ConfigureTPDO(uint32_t Pdo, const PDO_Config *Config);
+
+bool PDO_TransmitTPDO(uint32_t Pdo);
+
+bool PDO_Input(CAN_TypeDef *CANx, const CanRxMsg *Message);
+uint32_t PDO_GetReceiveFilter(CAN_FilterId *Filter);
+
+void PDO_GetStatistics(PDO_Statistics *Statistics);
+void PDO_ClearStatistics(void);
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PDO_H */
@@ -101,7 +101,7 @@ void RingBuffer_Free(RingBuffer *fifo)
   *         the FIFO depending on the free space, and returns the number
   *         of bytes copied.
   */
-uint32_t RingBuffer_In(RingBuffer *fifo, const void *in, uint32_t len)
+RING_BUFFER_RAMFUNC uint32_t RingBuffer_In(RingBuffer *fifo, const void *in, uint32_t len)
 {
   len = min(len, RingBuffer_Avail(fifo));
 
@@ -126,7 +126,7 @@ uint32_t RingBuffer_In(RingBuffer *fifo, const void *in, uint32_t len)
   * @note   This function copies at most @len bytes from the FIFO into
   *         the @out and returns the number of copied bytes.
   */
-uint32_t RingBuffer_Out(RingBuffer *fifo, void *out, uint32_t len)
+RING_BUFFER_RAMFUNC uint32_t RingBuffer_Out(RingBuffer *fifo, void *out, uint32_t len)
 {
   len = min(len, RingBuffer_Len(fifo));
 
@@ -42,6 +42,16 @@ extern "C" {
 #define RING_BUFFER_MALLOC(size)  malloc(size)
 #define RING_BUFFER_FREE(block)   free(block)
 
+#ifndef RING_BUFFER_RAM_EXECUTE
+#define RING_BUFFER_RAM_EXECUTE   (0)  /* 1 to run RingBuffer_In and RingBuffer_Out from SRAM, set together with CAN_RAM_EXECUTE. */
+#endif
+
+#if RING_BUFFER_RAM_EXECUTE
+#define RING_BUFFER_RAMFUNC       __attribute__((section("CAN_RAMFUNC")))  /* The scatter file places it in RAM. */
+#else
+#define RING_BUFFER_RAMFUNC
+#endif /* RING_BUFFER_RAM_EXECUTE */
+
 /* Type definitions ----------------------------------------------------------*/
 typedef struct
 {
@@ -0,0 +1,276 @@
+/**
+  ******************************************************************************
+  * @file    TimerWheel.c
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Hierarchical timer wheel with O(1) start, stop and tick.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+/* Header includes -----------------------------------------------------------*/
+#include "TimerWheel.h"
+#include <string.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define TIMER_WHEEL_SLOT_NUMBER  (1UL << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_SLOT_MASK    (TIMER_WHEEL_SLOT_NUMBER - 1)
+
+/* Type definitions ----------------------------------------------------------*/
+/* Variable declarations -----------------------------------------------------*/
+static TimerWheel_Timer *timerWheelSlot[TIMER_WHEEL_LEVEL_NUMBER][TIMER_WHEEL_SLOT_NUMBER];
+
+static volatile uint32_t timerWheelTime = 0;  /* The last tick processed. */
+static uint32_t          timerWheelNext = 1;  /* The next tick to process. */
+
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+static void timer_wheel_insert(TimerWheel_Timer *Timer);
+static void timer_wheel_remove(TimerWheel_Timer *Timer);
+static void timer_wheel_cascade(uint32_t Level, uint32_t Index);
+
+/* Function definitions ------------------------------------------------------*/
+
+/**
+  * @brief  Stop every timer and restart the time at 0.
+  * @param  None.
+  * @return None.
+  * @note   The timers still running are forgotten, not stopped.
+  */
+void TimerWheel_Init(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  memset(timerWheelSlot, 0, sizeof(timerWheelSlot));
+  
+  timerWheelTime = 0;
+  timerWheelNext = 1;
+  
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Initialize a timer, stopped.
+  * @param  [in] Timer:    The timer.
+  * @param  [in] Callback: Called when it fires, in TimerWheel_Tick().
+  * @param  [in] Argument: Kept in the timer for the callback.
+  * @return None.
+  */
+void TimerWheel_InitTimer(TimerWheel_Timer *Timer, void (*Callback)(TimerWheel_Timer *Timer), void *Argument)
+{
+  Timer->Next     = 0;
+  Timer->Link     = 0;
+  Timer->Expire   = 0;
+  Timer->Callback = Callback;
+  Timer->Argument = Argument;
+}
+
+/**
+  * @brief  Start a timer, or move it when it is running.
+  * @param  [in] Timer:  The timer.
+  * @param  [in] Expire: Tick it fires at. A tick already gone fires on the next tick,
+  *                      one beyond TIMER_WHEEL_MAX_DELAY fires after that delay.
+  * @return None.
+  * @note   O(1), can be called from interrupts and from the timer callbacks.
+  */
+void TimerWheel_Start(TimerWheel_Timer *Timer, uint32_t Expire)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  if(Timer->Link != 0)
+  {
+    timer_wheel_remove(Timer);
+  }
+  
+  Timer->Expire = Expire;
+  timer_wheel_insert(Timer);
+  
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Stop a timer.
+  * @param  [in] Timer: The timer.
+  * @return None.
+  * @note   O(1), can be called from interrupts and from the timer callbacks.
+  */
+void TimerWheel_Stop(TimerWheel_Timer *Timer)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  if(Timer->Link != 0)
+  {
+    timer_wheel_remove(Timer);
+  }
+  
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Determine whether a timer is running.
+  * @param  [in] Timer: The timer.
+  * @retval true:       Running.
+  * @retval false:      Stopped or fired.
+  */
+bool TimerWheel_IsRunning(const TimerWheel_Timer *Timer)
+{
+  return (Timer->Link != 0);
+}
+
+/**
+  * @brief  Get the time.
+  * @param  None.
+  * @return The last tick processed.
+  */
+uint32_t TimerWheel_GetTime(void)
+{
+  return timerWheelTime;
+}
+
+/**
+  * @brief  Advance the time by one tick and run the callbacks of the timers due.
+  * @param  None.
+  * @return None.
+  * @note   Called every TIMER_WHEEL_TICK, from SysTick_Handler(). Costs O(1) plus
+  *         the timers due; every 2^6 ticks one slot of the next level is moved down.
+  */
+void TimerWheel_Tick(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  
+  /* At the wrap of a level the slot of the level above now due moves down. */
+  for(uint32_t level = 1; level < TIMER_WHEEL_LEVEL_NUMBER; level++)
+  {
+    if(((timerWheelNext >> (TIMER_WHEEL_SLOT_BITS * (level - 1))) & TIMER_WHEEL_SLOT_MASK) != 0)
+    {
+      break;
+    }
+    
+    timer_wheel_cascade(level, (timerWheelNext >> (TIMER_WHEEL_SLOT_BITS * level)) & TIMER_WHEEL_SLOT_MASK);
+  }
+  
+  timerWheelTime = timerWheelNext++;
+  
+  TimerWheel_Timer **slot = &timerWheelSlot[0][timerWheelTime & TIMER_WHEEL_SLOT_MASK];
+  
+  /* Timers started by the callbacks go to other slots. */
+  while(*slot != 0)
+  {
+    TimerWheel_Timer *timer = *slot;
+    
+    timer_wheel_remove(timer);
+    
+    __set_PRIMASK(primask);
+    timer->Callback(timer);
+    __disable_irq();
+  }
+  
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Put a timer in the slot of its expiry.
+  * @param  [in] Timer: The timer, stopped.
+  * @return None.
+  * @note   Interrupts disabled.
+  */
+static void timer_wheel_insert(TimerWheel_Timer *Timer)
+{
+  uint32_t delay = Timer->Expire - timerWheelNext;
+  uint32_t level = 0;
+  
+  if((int32_t)delay < 0)
+  {
+    Timer->Expire = timerWheelNext;
+    delay         = 0;
+  }
+  else if(delay > TIMER_WHEEL_MAX_DELAY)
+  {
+    Timer->Expire = timerWheelNext + TIMER_WHEEL_MAX_DELAY;
+    delay         = TIMER_WHEEL_MAX_DELAY;
+  }
+  
+  while((level < TIMER_WHEEL_LEVEL_NUMBER - 1) && (delay >= (1UL << (TIMER_WHEEL_SLOT_BITS * (level + 1)))))
+  {
+    level++;
+  }
+  
+  TimerWheel_Timer **slot = &timerWheelSlot[level][(Timer->Expire >> (TIMER_WHEEL_SLOT_BITS * level)) & TIMER_WHEEL_SLOT_MASK];
+  
+  Timer->Next = *slot;
+  Timer->Link = slot;
+  
+  if(*slot != 0)
+  {
+    (*slot)->Link = &Timer->Next;
+  }
+  
+  *slot = Timer;
+}
+
+/**
+  * @brief  Take a timer out of its slot.
+  * @param  [in] Timer: The timer, running.
+  * @return None.
+  * @note   Interrupts disabled.
+  */
+static void timer_wheel_remove(TimerWheel_Timer *Timer)
+{
+  *Timer->Link = Timer->Next;
+  
+  if(Timer->Next != 0)
+  {
+    Timer->Next->Link = Timer->Link;
+  }
+  
+  Timer->Next = 0;
+  Timer->Link = 0;
+}
+
+/**
+  * @brief  Move the timers of a slot to the levels below.
+  * @param  [in] Level: The level, 1 and above.
+  * @param  [in] Index: The slot.
+  * @return None.
+  * @note   Interrupts disabled.
+  */
+static void timer_wheel_cascade(uint32_t Level, uint32_t Index)
+{
+  TimerWheel_Timer *timer = timerWheelSlot[Level][Index];
+  
+  timerWheelSlot[Level][Index] = 0;
+  
+  while(timer != 0)
+  {
+    TimerWheel_Timer *next = timer->Next;
+    
+    timer->Next = 0;
+    timer->Link = 0;
+    timer_wheel_insert(timer);
+    
+    timer = next;
+  }
+}
@@ -0,0 +1,78 @@
+/**
+  ******************************************************************************
+  * @file    TimerWheel.h
+  * @author  XinLi
+  * @version v1.0
+  * @date    19-October-2026
+  * @brief   Header file for TimerWheel.c module.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>Copyright &copy; 2018 XinLi</center></h2>
+  *
+  * This program is free software: you can redistribute it and/or modify
+  * it under the terms of the GNU General Public License as published by
+  * the Free Software Foundation, either version 3 of the License, or
+  * (at your option) any later version.
+  *
+  * This program is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  * GNU General Public License for more details.
+  *
+  * You should have received a copy of the GNU General Public License
+  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+  *
+  ******************************************************************************
+  */
+
+
+#ifndef __TIMERWHEEL_H
+#define __TIMERWHEEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Header includes -----------------------------------------------------------*/
+#include "stm32f10x.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macro definitions ---------------------------------------------------------*/
+#define TIMER_WHEEL_TICK          (1000)  /* Microseconds per tick, the period TimerWheel_Tick() is called with. */
+#define TIMER_WHEEL_SLOT_BITS     (6)     /* 2^6 slots per level. */
+#define TIMER_WHEEL_LEVEL_NUMBER  (4)     /* Levels, delays up to 2^(6*4)-1 ticks. */
+
+#define TIMER_WHEEL_MAX_DELAY     ((1UL << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVEL_NUMBER)) - 1)
+
+/* Type definitions ----------------------------------------------------------*/
+typedef struct TimerWheel_Timer
+{
+  struct TimerWheel_Timer  *Next;
+  struct TimerWheel_Timer **Link;       /*!< The pointer to this timer in its slot, 0 when stopped. */
+  uint32_t                  Expire;     /*!< Tick it fires at. */
+  void                    (*Callback)(struct TimerWheel_Timer *Timer);
+  void                     *Argument;
+}TimerWheel_Timer;
+
+/* Variable declarations -----------------------------------------------------*/
+/* Variable definitions ------------------------------------------------------*/
+/* Function declarations -----------------------------------------------------*/
+void TimerWheel_Init(void);
+
+void TimerWheel_InitTimer(TimerWheel_Timer *Timer, void (*Callback)(TimerWheel_Timer *Timer), void *Argument);
+void TimerWheel_Start(TimerWheel_Timer *Timer, uint32_t Expire);
+void TimerWheel_Stop(TimerWheel_Timer *Timer);
+bool TimerWheel_IsRunning(const TimerWheel_Timer *Timer);
+
+uint32_t TimerWheel_GetTime(void);
+void TimerWheel_Tick(void);
+
+/* Function definitions ------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TIMERWHEEL_H */
@@ -29,6 +29,12 @@
 /* Header includes -----------------------------------------------------------*/
 #include "main.h"
 #include "CAN.h"
+#include "TimerWheel.h"
+
+#ifdef CAN_BENCHMARK
+#include "Benchmark.h"
+#include "CANProfile.h"
+#endif
 
 #ifdef _RTE_
 #include "RTE_Components.h"
@@ -39,6 +45,11 @@
 #endif
 
 /* Macro definitions ---------------------------------------------------------*/
+#ifdef CAN_BENCHMARK
+#ifndef BENCHMARK_LOOPBACK
+#define BENCHMARK_LOOPBACK (1)  /* 0 to run against a second board built with BENCHMARK_ECHO. */
+#endif
+#endif
 /* Type definitions ----------------------------------------------------------*/
 /* Variable declarations -----------------------------------------------------*/
 /* Variable definitions ------------------------------------------------------*/
@@ -48,6 +59,14 @@ static CanRxMsg canRxMsg = {0};
 /* Function declarations -----------------------------------------------------*/
 static void SystemClock_Config(void);
 
+#ifdef CAN_BENCHMARK
+static void Benchmark_Main(void);
+#endif
+
+#ifdef RTE_CMSIS_RTOS2_RTX5
+static void Tick_Timer(void *argument);
+#endif
+
 /* Function definitions ------------------------------------------------------*/
 
 /**
@@ -61,13 +80,30 @@ int main(void)
   SystemClock_Config();
   SystemCoreClockUpdate();
 
-  /* Add your application code here. */
-  CAN_Configure(CAN1, CAN_WorkModeLoopBack, CAN_BaudRate250K, 0xAA55, 0x55AA);
+#ifndef RTE_CMSIS_RTOS2_RTX5
+  /* SysTick_Handler() runs TimerWheel_Tick() and CAN_Tick() every TIMER_WHEEL_TICK. */
+  SysTick_Config(SystemCoreClock / 1000000 * TIMER_WHEEL_TICK);
+#endif
 
 #ifdef RTE_CMSIS_RTOS2
-  /* Initialize CMSIS-RTOS2. */
+  /* Initialize CMSIS-RTOS2, before CAN_Configure() creates its objects. */
   osKernelInitialize();
+#endif
+
+#ifdef CAN_BENCHMARK
+  /* Run the benchmark instead, it does not return. */
+  Benchmark_Main();
+#endif
+
+  /* Add your application code here. */
+  CAN_Configure(CAN1, CAN_WorkModeLoopBack, CAN_BaudRate250K, 0xAA55, 0x55AA);
 
+#ifdef RTE_CMSIS_RTOS2_RTX5
+  /* SysTick belongs to RTX5, SysTick_Handler() is not built, a timer runs the ticks. */
+  osTimerStart(osTimerNew(Tick_Timer, osTimerPeriodic, NULL, NULL), osKernelGetTickFreq() * TIMER_WHEEL_TICK / 1000000);
+#endif
+
+#ifdef RTE_CMSIS_RTOS2
   /* Create thread functions that start executing,
      Example: osThreadNew(app_main, NULL, NULL). */
 
@@ -101,6 +137,21 @@ int main(void)
   }
 }
 
+#ifdef RTE_CMSIS_RTOS2_RTX5
+/**
+  * @brief  Periodic timer in place of SysTick_Handler(), every TIMER_WHEEL_TICK.
+  * @param  [in] argument: Not used.
+  * @return None.
+  * @note   Runs in the RTX5 timer thread, CAN_Tick() supervises the transmit
+  *         requests and refills the transmit rate limits.
+  */
+static void Tick_Timer(void *argument)
+{
+  TimerWheel_Tick();
+  CAN_Tick();
+}
+#endif
+
 /**
   * @brief  System Clock Configuration.
   *         The system clock is configured as follow:
@@ -219,6 +270,62 @@ static void SystemClock_Config(void)
   }
 }
 
+#ifdef CAN_BENCHMARK
+/**
+  * @brief  Benchmark program, the results go out on ITM stimulus port 0 as JSON lines.
+  *         Built with BENCHMARK_ECHO the board answers the frames of the other one.
+  * @param  None.
+  * @return None.
+  */
+static void Benchmark_Main(void)
+{
+#ifdef BENCHMARK_ECHO
+  CAN_Configure(CAN1, CAN_WorkModeNormal, CAN_BaudRate1000K, 0, 0);
+  Benchmark_Echo(CAN1);
+  
+  /* Infinite loop. */
+  while(1)
+  {
+  }
+#else
+  static char text[BENCHMARK_TEXT_SIZE];
+  
+  Benchmark_Config config = {0};
+  Benchmark_Result result = {0};
+  
+  config.CANx      = CAN1;
+  config.BaudRate  = CAN_BaudRate1000K;
+  config.LoopBack  = (BENCHMARK_LOOPBACK != 0);
+  config.Frames    = 1000;
+  config.Duration  = 1000;
+  config.Interval  = 1000;
+  
+  CAN_Configure(CAN1, (config.LoopBack == true) ? CAN_WorkModeLoopBack : CAN_WorkModeNormal, config.BaudRate, 0, 0);
+  
+#if CAN_PROFILE_ENABLE
+  /* Interrupt times in cycles, compare builds with and without CAN_RAM_EXECUTE and RING_BUFFER_RAM_EXECUTE. */
+  CAN_Profile_Init();
+#endif
+  
+  /* Infinite loop. */
+  while(1)
+  {
+    for(uint32_t scenario = BenchmarkBurstTx; scenario < BenchmarkNumber; scenario++)
+    {
+      config.Scenario = (Benchmark_Scenario)scenario;
+      
+      Benchmark_Run(&config, &result);
+      
+      for(uint32_t i = 0, length = Benchmark_Format(&config, &result, text, sizeof(text)); i < length; i++)
+      {
+        ITM_SendChar(text[i]);
+      }
+    }
+  }
+#endif
+}
+#endif
+
 #ifdef USE_FULL_ASSERT
 /**
   * @brief  Reports the name of the source file and the source line number
@@ -30,6 +30,8 @@
 
 /* Header includes -----------------------------------------------------------*/
 #include "stm32f10x_it.h"
+#include "TimerWheel.h"
+#include "CAN.h"
 
 #ifdef _RTE_
 #include "RTE_Components.h"
@@ -146,6 +148,8 @@ void PendSV_Handler(void)
   */
 void SysTick_Handler(void)
 {
+  TimerWheel_Tick();
+  CAN_Tick();
 }
 #endif
 